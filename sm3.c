@@ -1,4 +1,35 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
 #include "sm3.h"
+#include <stdlib.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Linux内核加密接口（AF_ALG），编译时定义SM3_NO_AFALG可关闭
+#if defined(__linux__) && !defined(SM3_NO_AFALG)
+#define SM3_HAVE_AFALG 1
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <linux/if_alg.h>
+
+#define SM3_AFALG_CHUNK (1u << 20)   // 每次送入内核的长度（同时作为管道扩容目标）
+#define SM3_AFALG_MIN_LEN (1u << 16) // sm3_hash交给内核计算的最小长度
+
+static int afalg_enabled(void);
+static int afalg_hash(const unsigned char* input, size_t len, unsigned char output[SM3_DIGEST_SIZE]);
+#endif
+
+// 把按本机字节序载入的32bit字转换为大端序数值
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define SM3_LOAD_BE32(v) (v)
+#else
+#define SM3_LOAD_BE32(v) (((v) >> 24) | (((v) >> 8) & 0xff00) | (((v) << 8) & 0xff0000) | ((v) << 24))
+#endif
 
 // SM3初始向量（GM/T 0004-2012标准）
 // 这些常量是SM3算法的初始状态值，基于中国国家密码管理局的标准设定
@@ -60,22 +91,16 @@ void sm3_init(SM3_CTX* ctx) {
     memset(ctx->buffer, 0, SM3_BLOCK_SIZE);
 }
 
-// 压缩函数（处理单个512bit分组）
+// 压缩核心：W[0~15]已按大端序载入消息字，在此基础上完成扩展与64轮迭代
 // 这是SM3算法的核心函数，对每个消息分组进行压缩计算，更新哈希状态
-static void sm3_compress(SM3_CTX* ctx, const unsigned char block[SM3_BLOCK_SIZE]) {
-    uint32_t W[68] = { 0 }, W1[64] = { 0 };
+static void sm3_compress_words(uint32_t state[8], uint32_t W[68]) {
+    uint32_t W1[64];
     uint32_t A, B, C, D, E, F, G, H;
     uint32_t SS1, SS2, TT1, TT2;
     int j;
 
-    // 步骤1：生成W[0~67] - 消息扩展过程
+    // 步骤1：生成W[16~67] - 消息扩展过程
     // 将512位的消息分组扩展为132个字（68+64），用于后续的压缩轮运算
-    for (j = 0; j < 16; j++) {
-        W[j] = (uint32_t)block[j * 4] << 24 |
-            (uint32_t)block[j * 4 + 1] << 16 |
-            (uint32_t)block[j * 4 + 2] << 8 |
-            (uint32_t)block[j * 4 + 3];
-    }
     for (j = 16; j < 68; j++) {
         W[j] = p1(W[j - 16] ^ W[j - 9] ^ ROTLEFT(W[j - 3], 15)) ^
             ROTLEFT(W[j - 13], 7) ^ W[j - 6];
@@ -88,8 +113,8 @@ static void sm3_compress(SM3_CTX* ctx, const unsigned char block[SM3_BLOCK_SIZE]
 
     // 步骤3：初始化压缩变量
     // 将当前哈希状态赋值给工作变量，用于本轮压缩计算
-    A = ctx->state[0]; B = ctx->state[1]; C = ctx->state[2]; D = ctx->state[3];
-    E = ctx->state[4]; F = ctx->state[5]; G = ctx->state[6]; H = ctx->state[7];
+    A = state[0]; B = state[1]; C = state[2]; D = state[3];
+    E = state[4]; F = state[5]; G = state[6]; H = state[7];
 
     // 步骤4：64轮迭代（严格遵循标准）
     // 每轮使用不同的消息字和常数，通过布尔函数和置换函数更新工作变量
@@ -107,8 +132,73 @@ static void sm3_compress(SM3_CTX* ctx, const unsigned char block[SM3_BLOCK_SIZE]
 
     // 步骤5：与初始状态异或
     // 将工作变量的结果与原始哈希状态进行异或，得到新的哈希状态
-    ctx->state[0] ^= A; ctx->state[1] ^= B; ctx->state[2] ^= C; ctx->state[3] ^= D;
-    ctx->state[4] ^= E; ctx->state[5] ^= F; ctx->state[6] ^= G; ctx->state[7] ^= H;
+    state[0] ^= A; state[1] ^= B; state[2] ^= C; state[3] ^= D;
+    state[4] ^= E; state[5] ^= F; state[6] ^= G; state[7] ^= H;
+}
+
+// 压缩单个512bit分组（直接作用于状态寄存器）
+static void sm3_compress_one(uint32_t state[8], const unsigned char block[SM3_BLOCK_SIZE]) {
+    uint32_t W[68];
+    for (int j = 0; j < 16; j++) {
+        W[j] = (uint32_t)block[j * 4] << 24 |
+            (uint32_t)block[j * 4 + 1] << 16 |
+            (uint32_t)block[j * 4 + 2] << 8 |
+            (uint32_t)block[j * 4 + 3];
+    }
+    sm3_compress_words(state, W);
+}
+
+// 复制一个分组并压缩：每个消息字只从源地址载入一次，
+// 同一份寄存器值既写入目标地址，又经字节序转换后作为W[j]参与压缩
+static void sm3_copy_compress_one(uint32_t state[8], unsigned char* dst, const unsigned char* src) {
+    uint32_t W[68];
+#if defined(__AVX2__)
+    const __m256i bswap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    __m256i lo = _mm256_loadu_si256((const __m256i*)src);
+    __m256i hi = _mm256_loadu_si256((const __m256i*)(src + 32));
+    _mm256_storeu_si256((__m256i*)dst, lo);
+    _mm256_storeu_si256((__m256i*)(dst + 32), hi);
+    _mm256_storeu_si256((__m256i*)W, _mm256_shuffle_epi8(lo, bswap));
+    _mm256_storeu_si256((__m256i*)(W + 8), _mm256_shuffle_epi8(hi, bswap));
+#else
+    for (int j = 0; j < 16; j++) {
+        uint32_t v;
+        memcpy(&v, src + j * 4, 4);
+        memcpy(dst + j * 4, &v, 4);
+        W[j] = SM3_LOAD_BE32(v);
+    }
+#endif
+    sm3_compress_words(state, W);
+}
+
+// 连续压缩多个分组
+// 供多路并行、中间状态复用等扩展模块直接驱动压缩函数，不经过上下文缓冲区
+void sm3_compress_blocks(uint32_t state[8], const unsigned char* blocks, size_t nblocks) {
+    for (size_t i = 0; i < nblocks; i++) {
+        sm3_compress_one(state, blocks + i * SM3_BLOCK_SIZE);
+    }
+}
+
+// 32字节输入的迭代哈希：分组后半部分（0x80填充、长度256bit）为常量字，
+// 每次迭代直接以上一次的状态字作为W[0~7]，不经过字节序转换与上下文
+void sm3_hash32_iterate(uint32_t x[8], uint64_t n) {
+    uint32_t W[68];
+    uint32_t state[8];
+    for (uint64_t i = 0; i < n; i++) {
+        memcpy(W, x, 8 * sizeof(uint32_t));
+        W[8] = 0x80000000;
+        memset(W + 9, 0, 6 * sizeof(uint32_t));
+        W[15] = SM3_DIGEST_SIZE * 8;
+        memcpy(state, SM3_IV, sizeof(SM3_IV));
+        sm3_compress_words(state, W);
+        memcpy(x, state, sizeof(state));
+    }
+}
+
+// 压缩函数（处理单个512bit分组，更新上下文状态）
+static void sm3_compress(SM3_CTX* ctx, const unsigned char block[SM3_BLOCK_SIZE]) {
+    sm3_compress_one(ctx->state, block);
 }
 
 // 更新哈希计算
@@ -117,12 +207,43 @@ void sm3_update(SM3_CTX* ctx, const unsigned char* data, size_t len) {
     size_t idx = ctx->bitlen / 8 % SM3_BLOCK_SIZE;
     ctx->bitlen += len * 8;  // 总长度按bit统计
 
-    for (size_t i = 0; i < len; i++) {
-        ctx->buffer[idx++] = data[i];
-        if (idx == SM3_BLOCK_SIZE) {
-            sm3_compress(ctx, ctx->buffer);
-            idx = 0;
-        }
+    // 先补齐缓冲区中的残留分组
+    if (idx > 0) {
+        size_t n = SM3_BLOCK_SIZE - idx < len ? SM3_BLOCK_SIZE - idx : len;
+        memcpy(ctx->buffer + idx, data, n);
+        data += n;
+        len -= n;
+        if (idx + n < SM3_BLOCK_SIZE) return;
+        sm3_compress(ctx, ctx->buffer);
+    }
+    // 完整分组直接从输入压缩，不经缓冲区中转
+    sm3_compress_blocks(ctx->state, data, len / SM3_BLOCK_SIZE);
+    memcpy(ctx->buffer, data + len / SM3_BLOCK_SIZE * SM3_BLOCK_SIZE, len % SM3_BLOCK_SIZE);
+}
+
+// 复制并更新哈希计算
+// 把src的len字节复制到dst，同时吸收进哈希；完整分组在一次载入中完成复制与压缩
+void sm3_copy_and_update(SM3_CTX* ctx, unsigned char* dst, const unsigned char* src, size_t len) {
+    size_t idx = ctx->bitlen / 8 % SM3_BLOCK_SIZE;
+    size_t head = idx > 0 ? SM3_BLOCK_SIZE - idx : 0;
+
+    if (head > len) head = len;
+    if (head > 0) {
+        memcpy(dst, src, head);
+        sm3_update(ctx, dst, head);
+        dst += head;
+        src += head;
+        len -= head;
+    }
+    ctx->bitlen += (uint64_t)(len / SM3_BLOCK_SIZE * SM3_BLOCK_SIZE) * 8;
+    for (; len >= SM3_BLOCK_SIZE; len -= SM3_BLOCK_SIZE) {
+        sm3_copy_compress_one(ctx->state, dst, src);
+        dst += SM3_BLOCK_SIZE;
+        src += SM3_BLOCK_SIZE;
+    }
+    if (len > 0) {
+        memcpy(dst, src, len);
+        sm3_update(ctx, dst, len);
     }
 }
 
@@ -163,6 +284,10 @@ void sm3_final(SM3_CTX* ctx, unsigned char digest[SM3_DIGEST_SIZE]) {
 // 完整哈希计算（一步完成）
 // 该函数提供了简化的接口，适用于一次性计算整个消息的哈希值
 void sm3_hash(const unsigned char* input, size_t len, unsigned char output[SM3_DIGEST_SIZE]) {
+#ifdef SM3_HAVE_AFALG
+    // 内核后端仅用于大块数据，短消息的系统调用开销远超计算本身
+    if (len >= SM3_AFALG_MIN_LEN && afalg_enabled() && afalg_hash(input, len, output) == 0) return;
+#endif
     SM3_CTX ctx;
     sm3_init(&ctx);
     sm3_update(&ctx, input, len);
@@ -189,20 +314,192 @@ void sm3_print_hash(const unsigned char digest[SM3_DIGEST_SIZE]) {
     printf("\n");
 }
 
+// -------------------------- 内核加密后端（AF_ALG） --------------------------
+// 内核启用CONFIG_CRYPTO_SM3（及架构优化实现）时，文件页可经splice直接送入内核计算，
+// 数据不进入用户态。后端只服务于整体计算接口（sm3_file_hash/sm3_hash）：
+// SM3_CTX按值复制用作中间状态（HMAC、多路并行等），无法挂接内核会话，流式接口始终在用户态计算
+// 后端选择与探测结果可被多个线程同时读写，均以原子操作访问（各值独立，relaxed即可）
+static int sm3_backend = SM3_BACKEND_AUTO;
+
+void sm3_set_backend(int backend) {
+#ifdef SM3_HAVE_AFALG
+    __atomic_store_n(&sm3_backend, backend, __ATOMIC_RELAXED);
+#else
+    sm3_backend = backend;
+#endif
+}
+
+#ifdef SM3_HAVE_AFALG
+
+// 打开一个SM3运算会话，失败返回-1
+static int afalg_open(void) {
+    struct sockaddr_alg sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.salg_family = AF_ALG;
+    strcpy((char*)sa.salg_type, "hash");
+    strcpy((char*)sa.salg_name, "sm3");
+
+    int tfm = socket(AF_ALG, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (tfm < 0) return -1;
+    if (bind(tfm, (struct sockaddr*)&sa, sizeof(sa)) != 0) {
+        close(tfm);
+        return -1;
+    }
+    int op = accept(tfm, NULL, 0);
+    close(tfm);                      // 运算会话持有算法实例的引用
+    return op;
+}
+
+// 读取内核计算结果（之前的数据均带MSG_MORE发送，读取时内核完成填充）
+static int afalg_result(int op, unsigned char output[SM3_DIGEST_SIZE]) {
+    ssize_t n;
+    do n = read(op, output, SM3_DIGEST_SIZE); while (n < 0 && errno == EINTR);
+    return n == SM3_DIGEST_SIZE ? 0 : -1;
+}
+
+// 内核是否提供SM3：auto模式下仅在存在非通用C实现（如sm3-avx、sm3-ce）时启用，
+// 通用实现与用户态速度相当，系统调用开销得不偿失
+static int afalg_state = -1;        // -1未探测，0不可用，1可用但仅通用实现，2可用且有优化实现
+
+// 多个线程可能同时探测，结果相同；探测完成后才一次性写入afalg_state
+static int afalg_probe(void) {
+    int state = __atomic_load_n(&afalg_state, __ATOMIC_RELAXED);
+    if (state >= 0) return state;
+    int op = afalg_open();
+    if (op < 0) {
+        __atomic_store_n(&afalg_state, 0, __ATOMIC_RELAXED);
+        return 0;
+    }
+    close(op);
+
+    state = 1;
+    FILE* f = fopen("/proc/crypto", "r");
+    if (f != NULL) {
+        char line[256];
+        int is_sm3 = 0;
+        while (fgets(line, sizeof(line), f) != NULL) {
+            char key[64], val[128];
+            if (sscanf(line, "%63s : %127s", key, val) != 2) continue;
+            if (strcmp(key, "name") == 0) is_sm3 = strcmp(val, "sm3") == 0;
+            else if (is_sm3 && strcmp(key, "driver") == 0 && strcmp(val, "sm3-generic") != 0) state = 2;
+        }
+        fclose(f);
+    }
+    __atomic_store_n(&afalg_state, state, __ATOMIC_RELAXED);
+    return state;
+}
+
+static int afalg_enabled(void) {
+    int backend = __atomic_load_n(&sm3_backend, __ATOMIC_RELAXED);
+    if (backend == SM3_BACKEND_SOFT) return 0;
+    if (backend == SM3_BACKEND_AFALG) return afalg_probe() > 0;
+    return afalg_probe() == 2;
+}
+
+// 文件经管道splice进内核，全程零拷贝
+static int afalg_file_hash(int fd, uint64_t size, unsigned char output[SM3_DIGEST_SIZE]) {
+    int p[2];
+    int op = afalg_open();
+    int ret = 0;
+    loff_t off = 0;
+    if (op < 0) return -1;
+    if (pipe2(p, O_CLOEXEC) != 0) {
+        close(op);
+        return -1;
+    }
+    fcntl(p[1], F_SETPIPE_SZ, (int)SM3_AFALG_CHUNK);
+
+    while ((uint64_t)off < size && ret == 0) {
+        size_t want = size - (uint64_t)off < SM3_AFALG_CHUNK ? (size_t)(size - (uint64_t)off) : SM3_AFALG_CHUNK;
+        ssize_t in = splice(fd, &off, p[1], NULL, want, SPLICE_F_MOVE);
+        if (in < 0 && errno == EINTR) continue;
+        if (in <= 0) {
+            ret = -1;
+            break;
+        }
+        for (size_t left = (size_t)in; left > 0;) {
+            ssize_t out = splice(p[0], NULL, op, NULL, left, SPLICE_F_MOVE | SPLICE_F_MORE);
+            if (out < 0 && errno == EINTR) continue;
+            if (out <= 0) {
+                ret = -1;
+                break;
+            }
+            left -= (size_t)out;
+        }
+    }
+    if (ret == 0) ret = afalg_result(op, output);
+    close(p[0]);
+    close(p[1]);
+    close(op);
+    return ret;
+}
+
+// 内存数据分段送入内核
+static int afalg_hash(const unsigned char* input, size_t len, unsigned char output[SM3_DIGEST_SIZE]) {
+    int op = afalg_open();
+    int ret = 0;
+    if (op < 0) return -1;
+    while (len > 0) {
+        size_t n = len < SM3_AFALG_CHUNK ? len : SM3_AFALG_CHUNK;
+        ssize_t sent = send(op, input, n, MSG_MORE);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) {
+            ret = -1;
+            break;
+        }
+        input += sent;
+        len -= (size_t)sent;
+    }
+    if (ret == 0) ret = afalg_result(op, output);
+    close(op);
+    return ret;
+}
+#endif
+
+int sm3_afalg_available(void) {
+#ifdef SM3_HAVE_AFALG
+    return afalg_probe() > 0;
+#else
+    return 0;
+#endif
+}
+
+const char* sm3_backend_name(void) {
+#ifdef SM3_HAVE_AFALG
+    if (afalg_enabled()) return afalg_probe() == 2 ? "AF_ALG（内核优化实现）" : "AF_ALG（内核通用实现）";
+#endif
+    return "用户态";
+}
+
 // 计算文件哈希
-// 读取文件内容并计算SM3哈希值，适用于大文件的完整性校验
+// 读取文件内容并计算SM3哈希值，适用于大文件的完整性校验；内核后端可用时以零拷贝方式计算
 int sm3_file_hash(const char* filename, unsigned char output[SM3_DIGEST_SIZE]) {
     FILE* f = fopen(filename, "rb");
     if (!f) return -1;
 
+#ifdef SM3_HAVE_AFALG
+    struct stat sb;
+    if (afalg_enabled() && fstat(fileno(f), &sb) == 0 && S_ISREG(sb.st_mode) &&
+        afalg_file_hash(fileno(f), (uint64_t)sb.st_size, output) == 0) {
+        fclose(f);
+        return 0;
+    }
+    // 内核计算失败时回到用户态从头计算（splice使用独立偏移，文件位置未移动）
+#endif
+
     SM3_CTX ctx;
     sm3_init(&ctx);
-    unsigned char buf[4096];
+    unsigned char* buf = (unsigned char*)malloc(65536);
     size_t n;
-    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+    if (buf == NULL) {
+        fclose(f);
+        return -1;
+    }
+    while ((n = fread(buf, 1, 65536, f)) > 0) {
         sm3_update(&ctx, buf, n);
     }
     sm3_final(&ctx, output);
+    free(buf);
     fclose(f);
     return 0;
 }
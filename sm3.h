@@ -26,6 +26,22 @@ void sm3_init(SM3_CTX* ctx);
 void sm3_update(SM3_CTX* ctx, const unsigned char* data, size_t len);
 void sm3_final(SM3_CTX* ctx, unsigned char digest[SM3_DIGEST_SIZE]);
 void sm3_hash(const unsigned char* input, size_t len, unsigned char output[SM3_DIGEST_SIZE]);
+// 复制len字节到dst并同时吸收进哈希（每个分组只从src读取一次），dst与src不得重叠
+void sm3_copy_and_update(SM3_CTX* ctx, unsigned char* dst, const unsigned char* src, size_t len);
+
+// 底层压缩接口（供扩展模块复用中间状态）
+void sm3_compress_blocks(uint32_t state[8], const unsigned char* blocks, size_t nblocks);
+// 32字节消息的单分组哈希迭代n次：x为摘要的8个大端字，原地替换为SM3^n(x)
+void sm3_hash32_iterate(uint32_t x[8], uint64_t n);
+
+// 计算后端选择：仅作用于整体计算接口（sm3_file_hash、sm3_hash），流式接口始终在用户态计算
+// AUTO：内核提供优化SM3实现时使用AF_ALG，否则用户态；AFALG：内核可用即使用；SOFT：始终用户态
+#define SM3_BACKEND_AUTO 0
+#define SM3_BACKEND_SOFT 1
+#define SM3_BACKEND_AFALG 2
+void sm3_set_backend(int backend);
+int sm3_afalg_available(void);
+const char* sm3_backend_name(void);
 
 // 辅助工具接口
 char* sm3_hash_to_string(const unsigned char digest[SM3_DIGEST_SIZE]);
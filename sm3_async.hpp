@@ -0,0 +1,559 @@
+// sm3_async.hpp - 基于C++20协程的异步文件与流哈希（头文件实现，需链接sm3.c）
+//
+//   sm3::digest d = co_await sm3::hash_file_async("a.bin");           // 默认使用本线程的io_reactor
+//   sm3::digest e = co_await sm3::hash_stream(source);                 // 任意异步字节源
+//   sm3::digest f = sm3::sync_wait(sm3::hash_file_async("a.bin"));    // 非协程代码中驱动到完成
+//
+// 读取时协程挂起，I/O完成（io_uring）或描述符可读（epoll）后由io_reactor恢复并计算该缓冲，不阻塞线程；
+// 计算当前缓冲前先发起下一次读取，磁盘I/O与哈希计算重叠
+// io_reactor本身不持有线程：由调用者的事件循环驱动run_once，或把native_handle()加入自己的epoll/poll，
+// 可读时调用run_once(false)；协程恢复默认在调用run_once的线程上内联执行，set_executor可改为投递到任意执行器
+// 发起读取与run_once可以在不同线程上进行（内部加锁）
+// I/O错误以std::system_error抛出
+#ifndef SM3_ASYNC_HPP
+#define SM3_ASYNC_HPP
+
+extern "C" {
+#include "sm3.h"
+}
+#include <array>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace sm3 {
+
+using digest = std::array<unsigned char, SM3_DIGEST_SIZE>;
+
+constexpr size_t async_buffer_size = 128 * 1024;    // 每次读取的字节数（双缓冲）
+
+// -------------------------- 协程任务 --------------------------
+// 惰性启动：被co_await时才开始执行，完成后对称转移回等待者
+template <class T>
+class task {
+public:
+    struct promise_type {
+        std::coroutine_handle<> continuation = std::noop_coroutine();
+        std::optional<T> value;
+        std::exception_ptr error;
+
+        task get_return_object() { return task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        struct final_awaiter {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                return h.promise().continuation;
+            }
+            void await_resume() noexcept {}
+        };
+        final_awaiter final_suspend() noexcept { return {}; }
+        void return_value(T v) { value.emplace(std::move(v)); }
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    task(task&& o) noexcept : h_(std::exchange(o.h_, nullptr)) {}
+    task& operator=(task&& o) noexcept {
+        if (this != &o) {
+            if (h_) h_.destroy();
+            h_ = std::exchange(o.h_, nullptr);
+        }
+        return *this;
+    }
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+    ~task() {
+        if (h_) h_.destroy();
+    }
+
+    bool await_ready() const noexcept { return !h_ || h_.done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+        h_.promise().continuation = caller;
+        return h_;
+    }
+    T await_resume() { return result(); }
+
+    // 供sync_wait等驱动者使用
+    void start() { h_.resume(); }
+    bool done() const noexcept { return h_.done(); }
+    T result() {
+        if (h_.promise().error) std::rethrow_exception(h_.promise().error);
+        return std::move(*h_.promise().value);
+    }
+
+private:
+    explicit task(std::coroutine_handle<promise_type> h) : h_(h) {}
+    std::coroutine_handle<promise_type> h_;
+};
+
+// -------------------------- 流哈希 --------------------------
+// Source需提供read(unsigned char* buf, size_t len)，返回可co_await的对象，结果为读到的字节数（0表示结束）
+// 读取应在read()调用时即发起（如io_reactor::read），这样下一次读取与当前缓冲的计算重叠；
+// 同一时刻只有一个读取未完成，顺序读取的源（管道、套接字、文件当前位置）可以直接使用
+template <class Source>
+task<digest> hash_stream(Source& src, size_t buffer_size = async_buffer_size) {
+    std::vector<unsigned char> a(buffer_size), b(buffer_size);
+    unsigned char* cur = a.data();
+    unsigned char* other = b.data();
+    SM3_CTX ctx;
+    digest d;
+
+    sm3_init(&ctx);
+    size_t n = co_await src.read(cur, buffer_size);
+    while (n > 0) {
+        auto next = src.read(other, buffer_size);
+        sm3_update(&ctx, cur, n);
+        n = co_await next;
+        std::swap(cur, other);
+    }
+    sm3_final(&ctx, d.data());
+    co_return d;
+}
+
+#ifdef __linux__
+// -------------------------- I/O反应器 --------------------------
+class io_reactor;
+
+// 一次读取操作：构造时即发起，co_await得到读到的字节数；未完成时析构会取消该读取并等待内核释放缓冲
+class read_op {
+public:
+    read_op(const read_op&) = delete;
+    read_op& operator=(const read_op&) = delete;
+    ~read_op();
+
+    bool await_ready();
+    bool await_suspend(std::coroutine_handle<> h);
+    size_t await_resume() const {
+        if (result_ < 0) throw std::system_error((int)-result_, std::generic_category(), "sm3: read");
+        return (size_t)result_;
+    }
+
+private:
+    friend class io_reactor;
+    read_op(io_reactor& r, int fd, void* buf, size_t len, int64_t offset);
+
+    io_reactor& r_;
+    int fd_;
+    void* buf_;
+    size_t len_;
+    int64_t offset_;
+    int64_t result_ = 0;
+    bool done_ = false;
+    std::coroutine_handle<> waiter_;
+};
+
+// 默认使用io_uring（内核不支持或被禁用时改用epoll）：
+//   io_uring：所有读取（含普通文件）异步提交，完成后恢复
+//   epoll：管道、套接字等待可读后读取；普通文件无法等待就绪，按偏移同步pread（数据通常已在页缓存中）
+class io_reactor {
+public:
+    explicit io_reactor(unsigned entries = 64, bool use_uring = true) {
+        if (use_uring && uring_setup(entries) == 0) return;
+        ep_ = epoll_create1(EPOLL_CLOEXEC);
+        if (ep_ < 0) throw std::system_error(errno, std::generic_category(), "sm3: epoll_create1");
+    }
+    io_reactor(const io_reactor&) = delete;
+    io_reactor& operator=(const io_reactor&) = delete;
+    ~io_reactor() {
+        if (ring_fd_ >= 0) {
+            if (sqes_ != nullptr) munmap(sqes_, sqes_size_);
+            if (cq_ptr_ != nullptr && cq_ptr_ != sq_ptr_) munmap(cq_ptr_, cq_size_);
+            if (sq_ptr_ != nullptr) munmap(sq_ptr_, sq_size_);
+            close(ring_fd_);
+        }
+        if (ep_ >= 0) close(ep_);
+    }
+
+    bool uses_uring() const noexcept { return ring_fd_ >= 0; }
+    // 可加入调用者事件循环的描述符：可读时表示有完成事件待处理
+    int native_handle() const noexcept { return ring_fd_ >= 0 ? ring_fd_ : ep_; }
+    // 协程恢复方式，默认在run_once中内联恢复
+    void set_executor(std::function<void(std::coroutine_handle<>)> exec) { exec_ = std::move(exec); }
+    size_t pending() const {
+        std::lock_guard<std::mutex> g(mu_);
+        return inflight_;
+    }
+
+    // 从fd读取最多len字节：offset >= 0时按偏移读取（不改变文件位置），否则从当前位置读取
+    read_op read(int fd, void* buf, size_t len, int64_t offset) { return read_op(*this, fd, buf, len, offset); }
+
+    // 处理已完成的读取并恢复等待者，wait为真时至少等到一个完成事件（无未完成读取时立即返回），返回完成数
+    // 取消读取时顺带收割的其他完成项也在这里恢复
+    size_t run_once(bool wait = true) {
+        std::vector<std::coroutine_handle<>> ready;
+        size_t n;
+        {
+            std::lock_guard<std::mutex> g(mu_);
+            if (completed_ > 0) wait = false;
+        }
+        if (ring_fd_ >= 0) uring_poll(wait);
+        else epoll_poll(wait);
+        {
+            std::lock_guard<std::mutex> g(mu_);
+            for (read_op* op : ready_) ready.push_back(std::exchange(op->waiter_, nullptr));
+            ready_.clear();
+            n = std::exchange(completed_, 0);
+        }
+        for (auto h : ready) {
+            if (exec_) exec_(h);
+            else h.resume();
+        }
+        return n;
+    }
+
+private:
+    friend class read_op;
+
+    // ---------- io_uring（直接使用系统调用，不依赖liburing） ----------
+    int uring_setup(unsigned entries) {
+        io_uring_params p = {};
+        int fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+        if (fd < 0) return -1;
+        // 需要单次映射与IORING_FEAT_RW_CUR_POS（offset为-1时从当前位置读取，内核5.6起）
+        if (!(p.features & IORING_FEAT_SINGLE_MMAP) || !(p.features & IORING_FEAT_RW_CUR_POS)) {
+            close(fd);
+            return -1;
+        }
+        ring_fd_ = fd;
+        sq_size_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cq_size_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        if (cq_size_ > sq_size_) sq_size_ = cq_size_;
+        cq_size_ = sq_size_;
+        sqes_size_ = p.sq_entries * sizeof(io_uring_sqe);
+        void* sq = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (sq != MAP_FAILED) sq_ptr_ = cq_ptr_ = (unsigned char*)sq;
+        if (sqes != MAP_FAILED) sqes_ = (io_uring_sqe*)sqes;
+        if (sq_ptr_ == nullptr || sqes_ == nullptr) {
+            if (sqes_ != nullptr) munmap(sqes_, sqes_size_);
+            if (sq_ptr_ != nullptr) munmap(sq_ptr_, sq_size_);
+            sq_ptr_ = cq_ptr_ = nullptr;
+            sqes_ = nullptr;
+            close(fd);
+            ring_fd_ = -1;
+            return -1;
+        }
+        sq_head_ = (unsigned*)(sq_ptr_ + p.sq_off.head);
+        sq_tail_ = (unsigned*)(sq_ptr_ + p.sq_off.tail);
+        sq_mask_ = *(unsigned*)(sq_ptr_ + p.sq_off.ring_mask);
+        sq_entries_ = p.sq_entries;
+        sq_array_ = (unsigned*)(sq_ptr_ + p.sq_off.array);
+        cq_head_ = (unsigned*)(cq_ptr_ + p.cq_off.head);
+        cq_tail_ = (unsigned*)(cq_ptr_ + p.cq_off.tail);
+        cq_mask_ = *(unsigned*)(cq_ptr_ + p.cq_off.ring_mask);
+        cqes_ = (io_uring_cqe*)(cq_ptr_ + p.cq_off.cqes);
+        return 0;
+    }
+
+    int uring_enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+        int r;
+        do {
+            r = (int)syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete, flags, nullptr, 0);
+        } while (r < 0 && errno == EINTR);
+        return r;
+    }
+
+    // 写入一个提交项并立即提交（调用者持有锁）；提交环已满时先提交已有项
+    void uring_push(uint8_t opcode, int fd, uint64_t addr, uint32_t len, uint64_t off, uint64_t user_data) {
+        unsigned tail = *sq_tail_;
+        while (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+            if (uring_enter(tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE), 0, 0) < 0) sched_yield();
+        }
+        unsigned idx = tail & sq_mask_;
+        io_uring_sqe* sqe = &sqes_[idx];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = opcode;
+        sqe->fd = fd;
+        sqe->addr = addr;
+        sqe->len = len;
+        sqe->off = off;
+        sqe->user_data = user_data;
+        sq_array_[idx] = idx;
+        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+        // 提交失败（如完成环暂满）时提交项留在环中，由下一次io_uring_enter提交
+        uring_enter(tail + 1 - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE), 0, 0);
+    }
+
+    // 收割完成环（调用者持有锁与收割权）：记录结果，等待者放入ready_由run_once恢复
+    void uring_reap() {
+        unsigned head = *cq_head_, tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            io_uring_cqe* cqe = &cqes_[head & cq_mask_];
+            read_op* op = (read_op*)(uintptr_t)cqe->user_data;
+            if (op == nullptr) continue;                   // 取消请求本身的完成项
+            op->result_ = cqe->res;
+            op->done_ = true;
+            inflight_--;
+            completed_++;
+            if (op->waiter_) ready_.push_back(op);
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    }
+
+    // 同一时刻只有一个线程在io_uring_enter中等待并收割（cancel也经此收割），
+    // 否则等待者可能在完成项已被其他线程取走后阻塞
+    void uring_poll(bool wait) {
+        std::unique_lock<std::mutex> g(mu_);
+        while (reaping_) {
+            if (!wait) return;
+            reaped_cv_.wait(g);
+        }
+        if (inflight_ == 0 || (wait && completed_ > 0)) return;
+        reaping_ = true;
+        unsigned to_submit = *sq_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+        g.unlock();
+        bool empty = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE) == *cq_head_;
+        if (to_submit > 0 || (wait && empty)) {
+            uring_enter(to_submit, wait && empty ? 1 : 0, wait && empty ? IORING_ENTER_GETEVENTS : 0);
+        }
+        g.lock();
+        uring_reap();
+        reaping_ = false;
+        reaped_cv_.notify_all();
+    }
+
+    // ---------- epoll ----------
+    // 尝试读取（调用者持有锁），数据未就绪返回false
+    static bool try_read(read_op& op) {
+        ssize_t r;
+        do {
+            r = op.offset_ >= 0 ? pread(op.fd_, op.buf_, op.len_, (off_t)op.offset_) : ::read(op.fd_, op.buf_, op.len_);
+        } while (r < 0 && errno == EINTR);
+        if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return false;
+        op.result_ = r < 0 ? -errno : r;
+        op.done_ = true;
+        return true;
+    }
+
+    // 登记等待可读（调用者持有锁），描述符不支持epoll（普通文件）时返回false
+    bool epoll_arm(read_op& op) {
+        epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLONESHOT;
+        ev.data.fd = op.fd_;
+        if (epoll_ctl(ep_, EPOLL_CTL_MOD, op.fd_, &ev) != 0 && epoll_ctl(ep_, EPOLL_CTL_ADD, op.fd_, &ev) != 0) return false;
+        waiting_[op.fd_] = &op;
+        return true;
+    }
+
+    void epoll_poll(bool wait) {
+        epoll_event evs[32];
+        {
+            std::lock_guard<std::mutex> g(mu_);
+            if (inflight_ == 0) return;
+        }
+        int m = epoll_wait(ep_, evs, 32, wait ? -1 : 0);
+
+        std::lock_guard<std::mutex> g(mu_);
+        for (int i = 0; i < m; i++) {
+            // 按描述符查找等待者，已取消的读取不会被访问
+            auto it = waiting_.find(evs[i].data.fd);
+            if (it == waiting_.end()) continue;
+            read_op* op = it->second;
+            waiting_.erase(it);
+            // 阻塞模式的描述符在可读后读取也会立即返回
+            if (!try_read(*op)) {
+                epoll_arm(*op);
+                continue;
+            }
+            inflight_--;
+            completed_++;
+            if (op->waiter_) ready_.push_back(op);
+        }
+    }
+
+    // ---------- 读取操作 ----------
+    void start(read_op& op) {
+        std::lock_guard<std::mutex> g(mu_);
+        if (ring_fd_ >= 0) {
+            uint32_t len = op.len_ > 0x7ffff000 ? 0x7ffff000 : (uint32_t)op.len_;
+            inflight_++;
+            uring_push(IORING_OP_READ, op.fd_, (uint64_t)(uintptr_t)op.buf_, len, (uint64_t)op.offset_,
+                (uint64_t)(uintptr_t)&op);
+            return;
+        }
+        // 非阻塞描述符先直接尝试，阻塞的管道与套接字先等待可读
+        int fl = fcntl(op.fd_, F_GETFL);
+        if (fl >= 0 && (fl & O_NONBLOCK) && try_read(op)) return;
+        if (epoll_arm(op)) {
+            inflight_++;
+            return;
+        }
+        try_read(op);                                      // 普通文件：同步读取
+        if (!op.done_) {
+            op.result_ = -EAGAIN;
+            op.done_ = true;
+        }
+    }
+
+    void cancel(read_op& op) {
+        std::unique_lock<std::mutex> g(mu_);
+        if (op.done_) {
+            // 已完成但等待者尚未被run_once恢复（协程在此之前被销毁）
+            if (op.waiter_) {
+                for (auto it = ready_.begin(); it != ready_.end(); ++it) {
+                    if (*it == &op) {
+                        ready_.erase(it);
+                        break;
+                    }
+                }
+            }
+            return;
+        }
+        op.waiter_ = nullptr;
+        if (ring_fd_ < 0) {
+            waiting_.erase(op.fd_);
+            op.done_ = true;
+            inflight_--;
+            return;
+        }
+        // 内核可能仍在写入缓冲：提交取消请求并阻塞等到该读取的完成项；
+        // 期间收割到的其他读取只记录结果，其等待者留给run_once恢复（不在析构函数中恢复无关协程）
+        uring_push(IORING_OP_ASYNC_CANCEL, -1, (uint64_t)(uintptr_t)&op, 0, 0, 0);
+        while (!op.done_) {
+            if (reaping_) {
+                reaped_cv_.wait(g);                        // 其他线程正在收割，由它记录该读取的完成
+                continue;
+            }
+            reaping_ = true;
+            g.unlock();
+            uring_enter(0, 1, IORING_ENTER_GETEVENTS);
+            g.lock();
+            uring_reap();
+            reaping_ = false;
+            reaped_cv_.notify_all();
+        }
+    }
+
+    mutable std::mutex mu_;
+    size_t inflight_ = 0;
+    size_t completed_ = 0;                                 // 上次run_once之后收割的完成数
+    std::vector<read_op*> ready_;                          // 已完成、等待者待run_once恢复的读取
+    bool reaping_ = false;                                 // 有线程正在等待并收割完成环
+    std::condition_variable reaped_cv_;
+    std::function<void(std::coroutine_handle<>)> exec_;
+
+    int ring_fd_ = -1;
+    unsigned char* sq_ptr_ = nullptr;
+    unsigned char* cq_ptr_ = nullptr;
+    size_t sq_size_ = 0, cq_size_ = 0, sqes_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    unsigned *sq_head_ = nullptr, *sq_tail_ = nullptr, *sq_array_ = nullptr;
+    unsigned sq_mask_ = 0, sq_entries_ = 0;
+    unsigned *cq_head_ = nullptr, *cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+
+    int ep_ = -1;
+    std::unordered_map<int, read_op*> waiting_;            // 等待可读的描述符
+};
+
+inline read_op::read_op(io_reactor& r, int fd, void* buf, size_t len, int64_t offset)
+    : r_(r), fd_(fd), buf_(buf), len_(len), offset_(offset) {
+    r_.start(*this);
+}
+
+inline read_op::~read_op() {
+    r_.cancel(*this);
+}
+
+inline bool read_op::await_ready() {
+    std::lock_guard<std::mutex> g(r_.mu_);
+    return done_;
+}
+
+inline bool read_op::await_suspend(std::coroutine_handle<> h) {
+    std::lock_guard<std::mutex> g(r_.mu_);
+    if (done_) return false;
+    waiter_ = h;
+    return true;
+}
+
+// 本线程的默认反应器
+inline io_reactor& default_reactor() {
+    thread_local io_reactor r;
+    return r;
+}
+
+// 描述符字节源：offset >= 0时从该偏移起按偏移读取，否则从当前位置顺序读取
+class fd_source {
+public:
+    // 读取完成后按实际字节数推进偏移（同一时刻只有一个读取未完成）
+    struct read_awaiter {
+        read_op op;
+        int64_t* offset;
+        bool await_ready() { return op.await_ready(); }
+        bool await_suspend(std::coroutine_handle<> h) { return op.await_suspend(h); }
+        size_t await_resume() {
+            size_t n = op.await_resume();
+            if (*offset >= 0) *offset += (int64_t)n;
+            return n;
+        }
+    };
+
+    fd_source(io_reactor& r, int fd, int64_t offset = -1) : r_(r), fd_(fd), offset_(offset) {}
+    read_awaiter read(unsigned char* buf, size_t len) { return read_awaiter{ r_.read(fd_, buf, len, offset_), &offset_ }; }
+
+private:
+    io_reactor& r_;
+    int fd_;
+    int64_t offset_;
+};
+
+// 计算描述符剩余内容（管道、套接字或文件当前位置起）的摘要，描述符由调用者关闭
+inline task<digest> hash_fd_async(int fd, io_reactor& r = default_reactor(), size_t buffer_size = async_buffer_size) {
+    fd_source src(r, fd);
+    co_return co_await hash_stream(src, buffer_size);
+}
+
+// 计算文件的摘要
+inline task<digest> hash_file_async(std::string path, io_reactor& r = default_reactor(),
+    size_t buffer_size = async_buffer_size) {
+    struct fd_guard {
+        int fd;
+        ~fd_guard() {
+            if (fd >= 0) close(fd);
+        }
+    } f{ open(path.c_str(), O_RDONLY | O_CLOEXEC) };
+    struct stat st;
+    if (f.fd < 0) throw std::system_error(errno, std::generic_category(), path);
+    // 普通文件按偏移读取，不依赖文件位置
+    bool regular = fstat(f.fd, &st) == 0 && S_ISREG(st.st_mode);
+    if (regular) posix_fadvise(f.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    fd_source src(r, f.fd, regular ? 0 : -1);
+    co_return co_await hash_stream(src, buffer_size);
+}
+
+// 在当前线程上驱动反应器直到任务完成（协程恢复需为内联执行，或执行器最终恢复了该任务）
+template <class T>
+T sync_wait(task<T> t, io_reactor& r = default_reactor()) {
+    t.start();
+    while (!t.done()) {
+        if (r.run_once(true) == 0) sched_yield();
+    }
+    return t.result();
+}
+#endif
+
+}  // namespace sm3
+
+#endif
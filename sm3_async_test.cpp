@@ -0,0 +1,216 @@
+// sm3_async_test.cpp - sm3_async.hpp的回归测试（Linux，C++20）
+// 文件、管道、取消与执行器四组用例，分别在io_uring与epoll两种反应器上运行
+// 编译：gcc -O2 -c sm3.c && g++ -std=c++20 -O2 -o sm3_async_test sm3_async_test.cpp sm3.o -lpthread
+#include "sm3_async.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <thread>
+#include <unistd.h>
+
+static const char* result_text(bool ok) { return ok ? "通过" : "失败"; }
+
+static std::vector<unsigned char> pattern(size_t len, unsigned seed) {
+    std::vector<unsigned char> v(len);
+    for (size_t i = 0; i < len; i++) v[i] = (unsigned char)((i * 131 + seed) ^ (i >> 7));
+    return v;
+}
+
+static bool write_all(int fd, const unsigned char* p, size_t len) {
+    while (len > 0) {
+        ssize_t w = write(fd, p, len);
+        if (w <= 0) return false;
+        p += w;
+        len -= (size_t)w;
+    }
+    return true;
+}
+
+// 在反应器上驱动任务直到完成
+template <class T>
+static T drive(sm3::task<T>& t, sm3::io_reactor& r) {
+    t.start();
+    while (!t.done()) {
+        if (r.run_once(true) == 0) sched_yield();
+    }
+    return t.result();
+}
+
+// 不同长度（含空文件、恰为缓冲整数倍与非整数倍）的文件与sm3_file_hash一致；不存在的文件抛出system_error
+static bool file_case(sm3::io_reactor& r) {
+    const size_t sizes[] = { 0, 1, 55, 64, sm3::async_buffer_size, 2 * sm3::async_buffer_size, 3 * sm3::async_buffer_size + 17 };
+    char path[] = "/tmp/sm3_async_test_XXXXXX";
+    int fd = mkstemp(path);
+    bool ok = fd >= 0;
+    for (size_t s = 0; ok && s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        auto data = pattern(sizes[s], (unsigned)s);
+        ok &= ftruncate(fd, 0) == 0 && pwrite(fd, data.data(), data.size(), 0) == (ssize_t)data.size();
+        unsigned char ref[SM3_DIGEST_SIZE];
+        ok &= sm3_file_hash(path, ref) == 0;
+        auto t = sm3::hash_file_async(path, r);
+        sm3::digest d = drive(t, r);
+        ok &= memcmp(d.data(), ref, SM3_DIGEST_SIZE) == 0;
+    }
+    if (fd >= 0) {
+        close(fd);
+        unlink(path);
+    }
+
+    bool thrown = false;
+    try {
+        auto t = sm3::hash_file_async("/nonexistent/sm3_async_test", r);
+        drive(t, r);
+    }
+    catch (const std::system_error&) {
+        thrown = true;
+    }
+    return ok && thrown && r.pending() == 0;
+}
+
+// 写端分多次写入并关闭，读端异步计算的摘要与整体计算一致
+static bool pipe_case(sm3::io_reactor& r) {
+    int p[2];
+    if (pipe(p) != 0) return false;
+    auto data = pattern(1000003, 7);
+    std::thread writer([&] {
+        for (size_t off = 0; off < data.size(); off += 40000) {
+            write_all(p[1], data.data() + off, std::min<size_t>(40000, data.size() - off));
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        close(p[1]);
+    });
+    auto t = sm3::hash_fd_async(p[0], r);
+    sm3::digest d = drive(t, r);
+    writer.join();
+    close(p[0]);
+    unsigned char ref[SM3_DIGEST_SIZE];
+    sm3_hash(data.data(), data.size(), ref);
+    return memcmp(d.data(), ref, SM3_DIGEST_SIZE) == 0 && r.pending() == 0;
+}
+
+// 销毁在空管道上等待的任务会取消其读取；取消期间完成的其他读取不在析构中恢复，而是由之后的run_once恢复
+static bool cancel_case(sm3::io_reactor& r) {
+    int idle[2], busy[2];
+    if (pipe(idle) != 0) return false;
+    if (pipe(busy) != 0) {
+        close(idle[0]);
+        close(idle[1]);
+        return false;
+    }
+    int resumed = 0;
+    r.set_executor([&](std::coroutine_handle<> h) {
+        resumed++;
+        h.resume();
+    });
+    auto data = pattern(1000, 3);
+    bool ok = write_all(busy[1], data.data(), data.size());
+    close(busy[1]);
+
+    auto other = sm3::hash_fd_async(busy[0], r);
+    other.start();
+    {
+        auto t = sm3::hash_fd_async(idle[0], r);
+        t.start();
+        ok &= !t.done() && r.pending() >= 1;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));     // 使other的读取先完成
+    }
+    ok &= resumed == 0;
+    while (!other.done()) {
+        if (r.run_once(true) == 0) sched_yield();
+    }
+    sm3::digest d = other.result();
+    unsigned char ref[SM3_DIGEST_SIZE];
+    sm3_hash(data.data(), data.size(), ref);
+    ok &= memcmp(d.data(), ref, SM3_DIGEST_SIZE) == 0 && resumed > 0 && r.pending() == 0;
+    r.set_executor(nullptr);
+    for (int fd : { idle[0], idle[1], busy[0] }) close(fd);
+    return ok;
+}
+
+// 执行器把恢复投递到另一线程：协程在该线程上继续，后续读取也从该线程发起
+// 使用管道（epoll模式下普通文件同步读取，不经过执行器）
+static bool executor_case(sm3::io_reactor& r) {
+    int p[2];
+    if (pipe(p) != 0) return false;
+    std::mutex mu;
+    std::condition_variable cv;
+    std::deque<std::coroutine_handle<>> queue;
+    bool stop = false;
+    std::thread worker([&] {
+        std::unique_lock<std::mutex> g(mu);
+        for (;;) {
+            cv.wait(g, [&] { return stop || !queue.empty(); });
+            if (queue.empty()) break;
+            auto h = queue.front();
+            queue.pop_front();
+            g.unlock();
+            h.resume();
+            g.lock();
+        }
+    });
+    r.set_executor([&](std::coroutine_handle<> h) {
+        std::lock_guard<std::mutex> g(mu);
+        queue.push_back(h);
+        cv.notify_one();
+    });
+
+    auto data = pattern(5 * sm3::async_buffer_size + 99, 11);
+    std::thread writer([&] {
+        write_all(p[1], data.data(), data.size());
+        close(p[1]);
+    });
+    std::atomic<bool> finished{ false };
+    std::thread::id resumed_on;
+    sm3::digest d{};
+    // 协程形参而非捕获：lambda对象在协程挂起期间不必存活
+    auto body = [](sm3::io_reactor& r, int fd, sm3::digest* d, std::thread::id* on, std::atomic<bool>* fin) -> sm3::task<int> {
+        *d = co_await sm3::hash_fd_async(fd, r);
+        *on = std::this_thread::get_id();
+        fin->store(true);
+        co_return 0;
+    };
+    {
+        auto t = body(r, p[0], &d, &resumed_on, &finished);
+        t.start();
+        while (!finished.load()) {
+            if (r.run_once(true) == 0) sched_yield();
+        }
+        {
+            std::lock_guard<std::mutex> g(mu);
+            stop = true;
+            cv.notify_one();
+        }
+        worker.join();                                     // 等协程在工作线程上到达最终挂起点后再销毁
+    }
+    writer.join();
+    close(p[0]);
+    r.set_executor(nullptr);
+    unsigned char ref[SM3_DIGEST_SIZE];
+    sm3_hash(data.data(), data.size(), ref);
+    return memcmp(d.data(), ref, SM3_DIGEST_SIZE) == 0 && resumed_on != std::this_thread::get_id() && r.pending() == 0;
+}
+
+int main() {
+    int failed = 0;
+    for (bool use_uring : { true, false }) {
+        sm3::io_reactor r(64, use_uring);
+        printf("=== 反应器：%s ===\n", r.uses_uring() ? "io_uring" : "epoll");
+        if (use_uring && !r.uses_uring()) printf("  内核不支持io_uring，改用epoll\n");
+        bool ok = file_case(r);
+        printf("  文件：%s\n", result_text(ok));
+        failed += !ok;
+        ok = pipe_case(r);
+        printf("  管道：%s\n", result_text(ok));
+        failed += !ok;
+        ok = cancel_case(r);
+        printf("  取消：%s\n", result_text(ok));
+        failed += !ok;
+        ok = executor_case(r);
+        printf("  执行器：%s\n", result_text(ok));
+        failed += !ok;
+    }
+    printf("结论：%s\n", result_text(failed == 0));
+    return failed == 0 ? 0 : 1;
+}
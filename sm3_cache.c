@@ -0,0 +1,169 @@
+// sm3_cache.c - 分片组相联缓存实现
+#include "sm3_cache.h"
+#include <stdlib.h>
+
+// 缓存项之后紧跟value_size字节的值与key_max字节的键，项大小按8字节对齐
+typedef struct {
+    uint64_t tag;                        // 键指纹，0表示空位
+    uint32_t stamp;                      // 最近一次命中或写入时的分片时钟
+    uint32_t key_len;
+} CACHE_ENTRY;
+
+// 键指纹：每次吸收8字节，乘法混合后做一次末尾扩散
+static uint64_t cache_fingerprint(const unsigned char* p, size_t len) {
+    uint64_t h = 0x9e3779b97f4a7c15ULL ^ ((uint64_t)len * 0xff51afd7ed558ccdULL);
+    for (; len >= 8; len -= 8, p += 8) {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        h = (h ^ w) * 0x100000001b3ULL;
+        h ^= h >> 29;
+    }
+    if (len > 0) {
+        uint64_t w = 0;
+        memcpy(&w, p, len);
+        h = (h ^ w) * 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h | 1;
+}
+
+static CACHE_ENTRY* cache_entry(const SM3_CACHE* cache, unsigned char* set, int way) {
+    return (CACHE_ENTRY*)(set + (size_t)way * cache->stride);
+}
+
+static unsigned char* entry_value(CACHE_ENTRY* e) {
+    return (unsigned char*)(e + 1);
+}
+
+static unsigned char* entry_key(const SM3_CACHE* cache, CACHE_ENTRY* e) {
+    return (unsigned char*)(e + 1) + cache->value_size;
+}
+
+// 定位分片与组
+static SM3_CACHE_SHARD* cache_locate(SM3_CACHE* cache, uint64_t tag, unsigned char** set) {
+    SM3_CACHE_SHARD* sh = &cache->shards[tag >> 60 & (SM3_CACHE_SHARDS - 1)];
+    *set = sh->entries + (size_t)((tag >> 1) % sh->nsets) * SM3_CACHE_WAYS * cache->stride;    // 指纹最低位恒为1，不参与选组
+    return sh;
+}
+
+// 在组内查找（调用者持有分片锁）
+static CACHE_ENTRY* cache_lookup(const SM3_CACHE* cache, unsigned char* set, uint64_t tag, const unsigned char* key, size_t key_len) {
+    for (int w = 0; w < SM3_CACHE_WAYS; w++) {
+        CACHE_ENTRY* e = cache_entry(cache, set, w);
+        if (e->tag == tag && e->key_len == key_len && memcmp(entry_key(cache, e), key, key_len) == 0) return e;
+    }
+    return NULL;
+}
+
+int sm3_cache_init(SM3_CACHE* cache, size_t capacity, size_t key_max, size_t value_size) {
+    size_t per_shard = (capacity + SM3_CACHE_SHARDS - 1) / SM3_CACHE_SHARDS;
+    size_t nsets = (per_shard + SM3_CACHE_WAYS - 1) / SM3_CACHE_WAYS;
+    int s;
+
+    memset(cache, 0, sizeof(*cache));
+    if (nsets == 0) nsets = 1;
+    cache->key_max = key_max;
+    cache->value_size = value_size;
+    cache->stride = (sizeof(CACHE_ENTRY) + value_size + key_max + 7) / 8 * 8;
+    for (s = 0; s < SM3_CACHE_SHARDS; s++) {
+        SM3_CACHE_SHARD* sh = &cache->shards[s];
+        sh->nsets = nsets;
+        sh->entries = (unsigned char*)calloc(nsets * SM3_CACHE_WAYS, cache->stride);
+        if (sh->entries == NULL) break;
+        SM3_LOCK_INIT(&sh->lock);
+    }
+    if (s < SM3_CACHE_SHARDS) {
+        for (int i = 0; i < s; i++) {
+            SM3_LOCK_FREE(&cache->shards[i].lock);
+            free(cache->shards[i].entries);
+        }
+        return -1;
+    }
+    return 0;
+}
+
+void sm3_cache_free(SM3_CACHE* cache) {
+    for (int s = 0; s < SM3_CACHE_SHARDS; s++) {
+        SM3_LOCK_FREE(&cache->shards[s].lock);
+        free(cache->shards[s].entries);
+        cache->shards[s].entries = NULL;
+    }
+}
+
+int sm3_cache_get(SM3_CACHE* cache, const unsigned char* key, size_t key_len, unsigned char* value) {
+    uint64_t tag = cache_fingerprint(key, key_len);
+    unsigned char* set;
+    SM3_CACHE_SHARD* sh = cache_locate(cache, tag, &set);
+    CACHE_ENTRY* e;
+
+    SM3_LOCK_ACQUIRE(&sh->lock);
+    e = cache_lookup(cache, set, tag, key, key_len);
+    if (e != NULL) {
+        memcpy(value, entry_value(e), cache->value_size);
+        e->stamp = ++sh->clock;
+        sh->hits++;
+    }
+    else sh->misses++;
+    SM3_LOCK_RELEASE(&sh->lock);
+    return e != NULL;
+}
+
+void sm3_cache_put(SM3_CACHE* cache, const unsigned char* key, size_t key_len, const unsigned char* value) {
+    uint64_t tag = cache_fingerprint(key, key_len);
+    unsigned char* set;
+    SM3_CACHE_SHARD* sh = cache_locate(cache, tag, &set);
+
+    SM3_LOCK_ACQUIRE(&sh->lock);
+    if (cache_lookup(cache, set, tag, key, key_len) == NULL) {
+        // 选择空位，否则替换时钟值最旧的项（按与当前时钟的差值比较，时钟回绕后仍正确）
+        CACHE_ENTRY* e = cache_entry(cache, set, 0);
+        for (int w = 0; w < SM3_CACHE_WAYS; w++) {
+            CACHE_ENTRY* c = cache_entry(cache, set, w);
+            if (c->tag == 0) {
+                e = c;
+                break;
+            }
+            if (sh->clock - c->stamp > sh->clock - e->stamp) e = c;
+        }
+        if (e->tag != 0) sh->evictions++;
+        e->tag = tag;
+        e->stamp = ++sh->clock;
+        e->key_len = (uint32_t)key_len;
+        memcpy(entry_value(e), value, cache->value_size);
+        memcpy(entry_key(cache, e), key, key_len);
+    }
+    SM3_LOCK_RELEASE(&sh->lock);
+}
+
+void sm3_cache_bypass(SM3_CACHE* cache, size_t hint) {
+    SM3_CACHE_SHARD* sh = &cache->shards[hint & (SM3_CACHE_SHARDS - 1)];
+    SM3_LOCK_ACQUIRE(&sh->lock);
+    sh->bypassed++;
+    SM3_LOCK_RELEASE(&sh->lock);
+}
+
+void sm3_cache_stats(SM3_CACHE* cache, SM3_CACHE_STATS* stats) {
+    memset(stats, 0, sizeof(*stats));
+    for (int s = 0; s < SM3_CACHE_SHARDS; s++) {
+        SM3_CACHE_SHARD* sh = &cache->shards[s];
+        SM3_LOCK_ACQUIRE(&sh->lock);
+        stats->hits += sh->hits;
+        stats->misses += sh->misses;
+        stats->bypassed += sh->bypassed;
+        stats->evictions += sh->evictions;
+        SM3_LOCK_RELEASE(&sh->lock);
+    }
+}
+
+void sm3_cache_clear(SM3_CACHE* cache) {
+    for (int s = 0; s < SM3_CACHE_SHARDS; s++) {
+        SM3_CACHE_SHARD* sh = &cache->shards[s];
+        SM3_LOCK_ACQUIRE(&sh->lock);
+        memset(sh->entries, 0, sh->nsets * SM3_CACHE_WAYS * cache->stride);
+        sh->clock = 0;
+        sh->hits = sh->misses = sh->bypassed = sh->evictions = 0;
+        SM3_LOCK_RELEASE(&sh->lock);
+    }
+}
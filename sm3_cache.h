@@ -0,0 +1,51 @@
+// sm3_cache.h - 库内部使用的分片组相联缓存（不属于公开接口）
+#ifndef SM3_CACHE_H
+#define SM3_CACHE_H
+
+#include "sm3.h"
+#include "sm3_lock.h"
+
+// 以字节串为键、定长字节串为值；容量在初始化时固定，分片加锁，可被多个线程同时使用
+// 键指纹的高4位选分片，其余位选组；每个分片为4路组相联表，组满时替换最久未命中的项
+// 命中前逐字节比较完整的键，指纹碰撞不会返回错误的值
+// 用法：sm3_cache_get未命中时由调用者在锁外计算值，再以sm3_cache_put写入
+
+#define SM3_CACHE_SHARDS 16              // 分片数（2的幂）
+#define SM3_CACHE_WAYS 4                 // 组相联路数
+
+typedef struct {
+    SM3_LOCK lock;
+    uint32_t clock;
+    uint64_t hits, misses, bypassed, evictions;
+    size_t nsets;
+    unsigned char* entries;              // nsets * SM3_CACHE_WAYS项，每项stride字节
+    char pad[64];                        // 相邻分片的锁不在同一缓存行
+} SM3_CACHE_SHARD;
+
+typedef struct {
+    SM3_CACHE_SHARD shards[SM3_CACHE_SHARDS];
+    size_t key_max, value_size, stride;
+} SM3_CACHE;
+
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t bypassed;
+    uint64_t evictions;
+} SM3_CACHE_STATS;
+
+// capacity为项数上限（向上取整到分片与组的整数倍），key_max为键的最大字节数。失败返回-1
+int sm3_cache_init(SM3_CACHE* cache, size_t capacity, size_t key_max, size_t value_size);
+void sm3_cache_free(SM3_CACHE* cache);
+// 查找：命中时复制值并返回1，否则计为未命中并返回0。key_len不得超过key_max
+int sm3_cache_get(SM3_CACHE* cache, const unsigned char* key, size_t key_len, unsigned char* value);
+// 写入计算好的值；计算期间已被其他线程写入时不重复写入
+void sm3_cache_put(SM3_CACHE* cache, const unsigned char* key, size_t key_len, const unsigned char* value);
+// 记录一次未经过缓存的计算（如键超过key_max），hint用于分散到各分片
+void sm3_cache_bypass(SM3_CACHE* cache, size_t hint);
+// 统计（各分片累加）
+void sm3_cache_stats(SM3_CACHE* cache, SM3_CACHE_STATS* stats);
+// 清空缓存项与统计
+void sm3_cache_clear(SM3_CACHE* cache);
+
+#endif
@@ -0,0 +1,157 @@
+// sm3_chain.c - SM3哈希链实现
+// 链元素在内部始终以8个大端字表示，只在输入输出时转换字节序
+#include "sm3_chain.h"
+#include "sm3_mb.h"
+
+static void load_words(uint32_t w[8], const unsigned char in[SM3_DIGEST_SIZE]) {
+    for (int i = 0; i < 8; i++) {
+        w[i] = (uint32_t)in[i * 4] << 24 | (uint32_t)in[i * 4 + 1] << 16 |
+            (uint32_t)in[i * 4 + 2] << 8 | (uint32_t)in[i * 4 + 3];
+    }
+}
+
+static void store_words(const uint32_t w[8], unsigned char out[SM3_DIGEST_SIZE]) {
+    for (int i = 0; i < 8; i++) {
+        out[i * 4] = (unsigned char)(w[i] >> 24);
+        out[i * 4 + 1] = (unsigned char)(w[i] >> 16);
+        out[i * 4 + 2] = (unsigned char)(w[i] >> 8);
+        out[i * 4 + 3] = (unsigned char)w[i];
+    }
+}
+
+void sm3_chain_iterate(const unsigned char seed[SM3_DIGEST_SIZE], uint64_t n, unsigned char out[SM3_DIGEST_SIZE]) {
+    uint32_t x[8];
+    load_words(x, seed);
+    sm3_hash32_iterate(x, n);
+    store_words(x, out);
+}
+
+void sm3_chain_iterate_many(const unsigned char seeds[][SM3_DIGEST_SIZE], size_t count, uint64_t n,
+    unsigned char outs[][SM3_DIGEST_SIZE]) {
+    uint32_t x[8][SM3_MB_LANES];
+    for (size_t i = 0; i < count; i += SM3_MB_LANES) {
+        size_t batch = count - i < SM3_MB_LANES ? count - i : SM3_MB_LANES;
+        if (batch == 1) {
+            sm3_chain_iterate(seeds[i], n, outs[i]);
+            break;
+        }
+        for (size_t l = 0; l < SM3_MB_LANES; l++) {
+            uint32_t w[8];
+            load_words(w, seeds[i + (l < batch ? l : 0)]);     // 空闲通道重复第一条链，结果丢弃
+            for (int j = 0; j < 8; j++) x[j][l] = w[j];
+        }
+        sm3_mb_hash32_iterate(x, n);
+        for (size_t l = 0; l < batch; l++) {
+            uint32_t w[8];
+            for (int j = 0; j < 8; j++) w[j] = x[j][l];
+            store_words(w, outs[i + l]);
+        }
+    }
+}
+
+void sm3_chain_generate(const unsigned char seed[SM3_DIGEST_SIZE], uint64_t n, unsigned char out[][SM3_DIGEST_SIZE]) {
+    uint32_t x[8];
+    load_words(x, seed);
+    memcpy(out[0], seed, SM3_DIGEST_SIZE);
+    for (uint64_t i = 1; i <= n; i++) {
+        sm3_hash32_iterate(x, 1);
+        store_words(x, out[i]);
+    }
+}
+
+uint64_t sm3_chain_verify(const unsigned char anchor[SM3_DIGEST_SIZE], const unsigned char x[SM3_DIGEST_SIZE], uint64_t max_steps) {
+    uint32_t a[8], w[8];
+    load_words(a, anchor);
+    load_words(w, x);
+    for (uint64_t d = 1; d <= max_steps; d++) {
+        sm3_hash32_iterate(w, 1);
+        if (memcmp(w, a, sizeof(a)) == 0) return d;
+    }
+    return 0;
+}
+
+size_t sm3_chain_verify_many(const unsigned char anchors[][SM3_DIGEST_SIZE], const unsigned char xs[][SM3_DIGEST_SIZE],
+    size_t count, uint64_t max_steps, uint64_t steps[]) {
+    uint32_t x[8][SM3_MB_LANES], a[8][SM3_MB_LANES];
+    size_t valid = 0;
+
+    for (size_t i = 0; i < count; i += SM3_MB_LANES) {
+        size_t batch = count - i < SM3_MB_LANES ? count - i : SM3_MB_LANES;
+        size_t open = batch;
+        if (batch == 1) {
+            steps[i] = sm3_chain_verify(anchors[i], xs[i], max_steps);
+            valid += steps[i] != 0;
+            break;
+        }
+        for (size_t l = 0; l < SM3_MB_LANES; l++) {
+            uint32_t w[8], v[8];
+            size_t k = i + (l < batch ? l : 0);
+            load_words(w, xs[k]);
+            load_words(v, anchors[k]);
+            for (int j = 0; j < 8; j++) {
+                x[j][l] = w[j];
+                a[j][l] = v[j];
+            }
+            if (l < batch) steps[i + l] = 0;
+        }
+        // 逐步推进全部通道，全部通道都已匹配时提前结束
+        for (uint64_t d = 1; d <= max_steps && open > 0; d++) {
+            sm3_mb_hash32_iterate(x, 1);
+            for (size_t l = 0; l < batch; l++) {
+                int eq = 1;
+                if (steps[i + l] != 0) continue;
+                for (int j = 0; j < 8; j++) eq &= x[j][l] == a[j][l];
+                if (eq) {
+                    steps[i + l] = d;
+                    open--;
+                    valid++;
+                }
+            }
+        }
+    }
+    return valid;
+}
+
+// -------------------------- 逆序遍历 --------------------------
+int sm3_chain_walk_init(SM3_CHAIN_WALK* walk, const unsigned char seed[SM3_DIGEST_SIZE], uint64_t n) {
+    uint32_t x[8];
+    if (n == 0) return -1;
+    load_words(walk->val[0], seed);
+    walk->pos[0] = 0;
+    walk->top = 0;
+    walk->next = n - 1;
+    walk->remaining = n;
+    memcpy(x, walk->val[0], sizeof(x));
+    sm3_hash32_iterate(x, n);
+    store_words(x, walk->anchor);
+    return 0;
+}
+
+int sm3_chain_walk_next(SM3_CHAIN_WALK* walk, unsigned char out[SM3_DIGEST_SIZE], uint64_t* pos) {
+    uint64_t p = walk->next;
+    if (walk->remaining == 0) return 0;
+
+    // 从栈顶检查点出发，每次前进剩余距离的一半（向上取整）并保存为新检查点
+    while (walk->pos[walk->top] < p) {
+        int t = walk->top;
+        uint64_t d = p - walk->pos[t];
+        uint64_t step = d - d / 2;
+        memcpy(walk->val[t + 1], walk->val[t], sizeof(walk->val[t]));
+        sm3_hash32_iterate(walk->val[t + 1], step);
+        walk->pos[t + 1] = walk->pos[t] + step;
+        walk->top = t + 1;
+    }
+    store_words(walk->val[walk->top], out);
+    if (pos) *pos = p;
+
+    // 输出后丢弃该检查点（位置0的种子在最后一次输出后同样丢弃）
+    if (walk->top > 0) walk->top--;
+    walk->remaining--;
+    walk->next = p - 1;
+    return 1;
+}
+
+void sm3_chain_walk_clear(SM3_CHAIN_WALK* walk) {
+    volatile unsigned char* p = (volatile unsigned char*)walk;
+    for (size_t i = 0; i < sizeof(*walk); i++) p[i] = 0;
+}
@@ -0,0 +1,46 @@
+// sm3_chain.h - SM3哈希链（S/KEY式一次性口令、哈希链承诺）
+#ifndef SM3_CHAIN_H
+#define SM3_CHAIN_H
+
+#include "sm3.h"
+
+// 链元素 x_0 = seed，x_{i+1} = SM3(x_i)，锚点（公开值）为 x_n
+// 每一步都是32字节输入的单分组哈希，状态以字的形式在迭代之间传递（见sm3_hash32_iterate）
+
+// SM3^n(seed)
+void sm3_chain_iterate(const unsigned char seed[SM3_DIGEST_SIZE], uint64_t n, unsigned char out[SM3_DIGEST_SIZE]);
+// count条独立链各迭代n次，每8条一组在多路并行通道上计算
+void sm3_chain_iterate_many(const unsigned char seeds[][SM3_DIGEST_SIZE], size_t count, uint64_t n,
+    unsigned char outs[][SM3_DIGEST_SIZE]);
+// 生成整条链 out[0..n]（需要n+1个元素的空间）
+void sm3_chain_generate(const unsigned char seed[SM3_DIGEST_SIZE], uint64_t n, unsigned char out[][SM3_DIGEST_SIZE]);
+
+// 校验：若存在1 <= d <= max_steps使 SM3^d(x) == anchor，返回d，否则返回0
+// OTP服务端保存上次接受的元素作为锚点，max_steps允许客户端跳过若干个口令
+uint64_t sm3_chain_verify(const unsigned char anchor[SM3_DIGEST_SIZE], const unsigned char x[SM3_DIGEST_SIZE], uint64_t max_steps);
+// 批量校验count对(锚点, 候选值)，steps[i]为各自的d（0表示失败），返回通过的数量
+size_t sm3_chain_verify_many(const unsigned char anchors[][SM3_DIGEST_SIZE], const unsigned char xs[][SM3_DIGEST_SIZE],
+    size_t count, uint64_t max_steps, uint64_t steps[]);
+
+// -------------------------- 逆序遍历（检查点） --------------------------
+// 按 x_{n-1}, x_{n-2}, ..., x_0 的顺序输出链元素，只保存O(log n)个检查点：
+// 检查点栈中位置严格递增，取下一个元素时从最近的检查点出发，每次前进剩余距离的一半并压入新检查点，
+// 直到到达目标位置。栈深度不超过log2(n)+2，总计算量O(n log n)，即每个元素均摊O(log n)次哈希
+#define SM3_CHAIN_MAX_PEBBLES 66
+
+typedef struct {
+    uint64_t pos[SM3_CHAIN_MAX_PEBBLES];
+    uint32_t val[SM3_CHAIN_MAX_PEBBLES][8];
+    int top;                                   // 栈顶下标（-1表示已遍历完毕）
+    uint64_t next;                             // 下一个输出的位置
+    uint64_t remaining;                        // 尚未输出的元素数
+    unsigned char anchor[SM3_DIGEST_SIZE];     // x_n
+} SM3_CHAIN_WALK;
+
+// 初始化并计算锚点x_n（n次哈希）；n为0时返回-1
+int sm3_chain_walk_init(SM3_CHAIN_WALK* walk, const unsigned char seed[SM3_DIGEST_SIZE], uint64_t n);
+// 输出下一个元素及其位置（可为NULL），遍历完毕返回0，否则返回1
+int sm3_chain_walk_next(SM3_CHAIN_WALK* walk, unsigned char out[SM3_DIGEST_SIZE], uint64_t* pos);
+void sm3_chain_walk_clear(SM3_CHAIN_WALK* walk);
+
+#endif
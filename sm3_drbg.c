@@ -0,0 +1,268 @@
+// sm3_drbg.c - SM3 Hash_DRBG实现
+// Hashgen的各输出块互不依赖（输入为V+i），按8个一组送入多路并行压缩；
+// 输入块只在构造时写入一次，之后各通道的计数直接在分组中的55字节大端整数上递增
+#ifdef _WIN32
+#define _CRT_RAND_S
+#endif
+#include "sm3_drbg.h"
+#include "sm3_mb.h"
+#include <stdlib.h>
+#include <time.h>
+
+#ifdef _WIN32
+#define DRBG_THREAD_LOCAL __declspec(thread)
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#define DRBG_THREAD_LOCAL __thread
+#endif
+
+#define DRBG_SEED_BITS (SM3_DRBG_SEED_LEN * 8)      // 440
+#define DRBG_OS_ENTROPY 48                          // 线程本地生成器每次取得的熵（字节）
+
+// 大端整数加法：dst(dlen字节) += src(slen字节，按低位对齐)，溢出部分丢弃
+static void add_be(unsigned char* dst, size_t dlen, const unsigned char* src, size_t slen) {
+    unsigned int carry = 0;
+    for (size_t i = 0; i < dlen; i++) {
+        unsigned int s = dst[dlen - 1 - i] + carry + (i < slen ? src[slen - 1 - i] : 0);
+        dst[dlen - 1 - i] = (unsigned char)s;
+        carry = s >> 8;
+    }
+}
+
+static void add_u64(unsigned char* dst, size_t dlen, uint64_t v) {
+    unsigned char b[8];
+    for (int i = 0; i < 8; i++) b[i] = (unsigned char)(v >> (56 - 8 * i));
+    add_be(dst, dlen, b, 8);
+}
+
+static void store_state(const uint32_t state[8], unsigned char out[SM3_DIGEST_SIZE]) {
+    for (int i = 0; i < 8; i++) {
+        out[i * 4] = (unsigned char)(state[i] >> 24);
+        out[i * 4 + 1] = (unsigned char)(state[i] >> 16);
+        out[i * 4 + 2] = (unsigned char)(state[i] >> 8);
+        out[i * 4 + 3] = (unsigned char)state[i];
+    }
+}
+
+// Hash_df(prefix || in1 || in2 || in3, 440)，输入可分段给出，prefix小于0时省略前缀字节
+static void hash_df(unsigned char out[SM3_DRBG_SEED_LEN], int prefix,
+    const unsigned char* in1, size_t len1, const unsigned char* in2, size_t len2,
+    const unsigned char* in3, size_t len3) {
+    unsigned char head[5], digest[SM3_DIGEST_SIZE];
+    head[1] = (unsigned char)(DRBG_SEED_BITS >> 24);
+    head[2] = (unsigned char)(DRBG_SEED_BITS >> 16);
+    head[3] = (unsigned char)(DRBG_SEED_BITS >> 8);
+    head[4] = (unsigned char)DRBG_SEED_BITS;
+    for (size_t off = 0, ct = 1; off < SM3_DRBG_SEED_LEN; off += SM3_DIGEST_SIZE, ct++) {
+        SM3_CTX ctx;
+        size_t n = SM3_DRBG_SEED_LEN - off < SM3_DIGEST_SIZE ? SM3_DRBG_SEED_LEN - off : SM3_DIGEST_SIZE;
+        head[0] = (unsigned char)ct;
+        sm3_init(&ctx);
+        sm3_update(&ctx, head, 5);
+        if (prefix >= 0) {
+            unsigned char p = (unsigned char)prefix;
+            sm3_update(&ctx, &p, 1);
+        }
+        if (len1) sm3_update(&ctx, in1, len1);
+        if (len2) sm3_update(&ctx, in2, len2);
+        if (len3) sm3_update(&ctx, in3, len3);
+        sm3_final(&ctx, digest);
+        memcpy(out + off, digest, n);
+    }
+    memset(digest, 0, sizeof(digest));
+}
+
+// 由新的V得到C = Hash_df(0x00 || V)，并重置计数
+static void derive_c(SM3_DRBG* drbg) {
+    hash_df(drbg->C, 0x00, drbg->V, SM3_DRBG_SEED_LEN, NULL, 0, NULL, 0);
+    drbg->reseed_counter = 1;
+}
+
+void sm3_drbg_init(SM3_DRBG* drbg, const unsigned char* entropy, size_t entropy_len,
+    const unsigned char* nonce, size_t nonce_len, const unsigned char* pers, size_t pers_len) {
+    hash_df(drbg->V, -1, entropy, entropy_len, nonce, nonce_len, pers, pers_len);
+    derive_c(drbg);
+    drbg->buf_pos = drbg->buf_len = 0;
+}
+
+void sm3_drbg_reseed(SM3_DRBG* drbg, const unsigned char* entropy, size_t entropy_len,
+    const unsigned char* add, size_t add_len) {
+    unsigned char v[SM3_DRBG_SEED_LEN];
+    memcpy(v, drbg->V, sizeof(v));
+    hash_df(drbg->V, 0x01, v, sizeof(v), entropy, entropy_len, add, add_len);
+    derive_c(drbg);
+    memset(v, 0, sizeof(v));
+}
+
+// Hashgen：输出SM3(V) || SM3(V+1) || ... 的前len字节
+// 分组 = data(55) || 0x80 || 64bit长度440，单次压缩即得一个输出块
+static void hashgen(const unsigned char V[SM3_DRBG_SEED_LEN], unsigned char* out, size_t len) {
+    unsigned char blocks[SM3_MB_LANES][SM3_BLOCK_SIZE];
+    const unsigned char* bp[SM3_MB_LANES];
+    uint32_t st[8][SM3_MB_LANES];
+    SM3_CTX iv;
+    size_t nblocks = (len + SM3_DIGEST_SIZE - 1) / SM3_DIGEST_SIZE;
+
+    sm3_init(&iv);
+    for (size_t l = 0; l < SM3_MB_LANES; l++) {
+        memcpy(blocks[l], V, SM3_DRBG_SEED_LEN);
+        memset(blocks[l] + SM3_DRBG_SEED_LEN, 0, SM3_BLOCK_SIZE - SM3_DRBG_SEED_LEN);
+        blocks[l][SM3_DRBG_SEED_LEN] = 0x80;
+        blocks[l][SM3_BLOCK_SIZE - 2] = (unsigned char)(DRBG_SEED_BITS >> 8);
+        blocks[l][SM3_BLOCK_SIZE - 1] = (unsigned char)DRBG_SEED_BITS;
+        add_u64(blocks[l], SM3_DRBG_SEED_LEN, l);
+        bp[l] = blocks[l];
+    }
+
+    for (size_t i = 0; i < nblocks; i += SM3_MB_LANES) {
+        size_t batch = nblocks - i < SM3_MB_LANES ? nblocks - i : SM3_MB_LANES;
+        unsigned char digest[SM3_DIGEST_SIZE];
+
+        if (batch == 1) {
+            uint32_t s[8];
+            memcpy(s, iv.state, sizeof(s));
+            sm3_compress_blocks(s, blocks[0], 1);
+            store_state(s, digest);
+            memcpy(out + i * SM3_DIGEST_SIZE, digest, len - i * SM3_DIGEST_SIZE);
+            break;
+        }
+        for (size_t l = 0; l < SM3_MB_LANES; l++) {
+            for (int w = 0; w < 8; w++) st[w][l] = iv.state[w];
+        }
+        sm3_mb_compress(st, bp);
+        for (size_t l = 0; l < batch; l++) {
+            uint32_t s[8];
+            size_t off = (i + l) * SM3_DIGEST_SIZE;
+            for (int w = 0; w < 8; w++) s[w] = st[w][l];
+            store_state(s, digest);
+            memcpy(out + off, digest, len - off < SM3_DIGEST_SIZE ? len - off : SM3_DIGEST_SIZE);
+        }
+        // 下一组：每个通道的计数加8
+        for (size_t l = 0; l < SM3_MB_LANES; l++) add_u64(blocks[l], SM3_DRBG_SEED_LEN, SM3_MB_LANES);
+    }
+    memset(blocks, 0, sizeof(blocks));
+    memset(st, 0, sizeof(st));
+}
+
+int sm3_drbg_generate(SM3_DRBG* drbg, unsigned char* out, size_t len, const unsigned char* add, size_t add_len) {
+    unsigned char h[SM3_DIGEST_SIZE];
+    SM3_CTX ctx;
+    unsigned char p;
+
+    if (len > SM3_DRBG_MAX_REQUEST) return -1;
+    if (drbg->reseed_counter > SM3_DRBG_RESEED_INTERVAL) return SM3_DRBG_NEED_RESEED;
+
+    if (add_len > 0) {
+        // w = Hash(0x02 || V || additional_input)，V = V + w
+        p = 0x02;
+        sm3_init(&ctx);
+        sm3_update(&ctx, &p, 1);
+        sm3_update(&ctx, drbg->V, SM3_DRBG_SEED_LEN);
+        sm3_update(&ctx, add, add_len);
+        sm3_final(&ctx, h);
+        add_be(drbg->V, SM3_DRBG_SEED_LEN, h, SM3_DIGEST_SIZE);
+    }
+    if (len > 0) hashgen(drbg->V, out, len);
+
+    // H = Hash(0x03 || V)，V = V + H + C + reseed_counter
+    p = 0x03;
+    sm3_init(&ctx);
+    sm3_update(&ctx, &p, 1);
+    sm3_update(&ctx, drbg->V, SM3_DRBG_SEED_LEN);
+    sm3_final(&ctx, h);
+    add_be(drbg->V, SM3_DRBG_SEED_LEN, h, SM3_DIGEST_SIZE);
+    add_be(drbg->V, SM3_DRBG_SEED_LEN, drbg->C, SM3_DRBG_SEED_LEN);
+    add_u64(drbg->V, SM3_DRBG_SEED_LEN, drbg->reseed_counter);
+    drbg->reseed_counter++;
+    memset(h, 0, sizeof(h));
+    return 0;
+}
+
+int sm3_drbg_read(SM3_DRBG* drbg, unsigned char* out, size_t len) {
+    while (len > 0) {
+        size_t n;
+        if (drbg->buf_pos == drbg->buf_len) {
+            int ret = sm3_drbg_generate(drbg, drbg->buf, SM3_DRBG_BUF_SIZE, NULL, 0);
+            if (ret != 0) return ret;
+            drbg->buf_pos = 0;
+            drbg->buf_len = SM3_DRBG_BUF_SIZE;
+        }
+        n = drbg->buf_len - drbg->buf_pos < len ? drbg->buf_len - drbg->buf_pos : len;
+        memcpy(out, drbg->buf + drbg->buf_pos, n);
+        // 已取走的输出立即清除，不留在缓冲区中
+        memset(drbg->buf + drbg->buf_pos, 0, n);
+        drbg->buf_pos += n;
+        out += n;
+        len -= n;
+    }
+    return 0;
+}
+
+void sm3_drbg_clear(SM3_DRBG* drbg) {
+    volatile unsigned char* p = (volatile unsigned char*)drbg;
+    for (size_t i = 0; i < sizeof(*drbg); i++) p[i] = 0;
+}
+
+// -------------------------- 线程本地生成器 --------------------------
+static int os_entropy(unsigned char* buf, size_t len) {
+#ifdef _WIN32
+    for (size_t i = 0; i < len; i += 4) {
+        unsigned int v;
+        if (rand_s(&v) != 0) return -1;
+        for (size_t b = 0; b < 4 && i + b < len; b++) buf[i + b] = (unsigned char)(v >> (8 * b));
+    }
+    return 0;
+#else
+    int fd = open("/dev/urandom", O_RDONLY);
+    size_t got = 0;
+    if (fd < 0) return -1;
+    while (got < len) {
+        ssize_t r = read(fd, buf + got, len - got);
+        if (r <= 0) break;
+        got += (size_t)r;
+    }
+    close(fd);
+    return got == len ? 0 : -1;
+#endif
+}
+
+static DRBG_THREAD_LOCAL SM3_DRBG tls_drbg;
+static DRBG_THREAD_LOCAL int tls_ready;
+#ifndef _WIN32
+static DRBG_THREAD_LOCAL pid_t tls_pid;     // 播种时的进程号；fork后子进程继承了父进程的状态，进程号变化时重新实例化
+#endif
+
+int sm3_random_bytes(unsigned char* out, size_t len) {
+    unsigned char seed[DRBG_OS_ENTROPY];
+    int ret;
+
+#ifndef _WIN32
+    pid_t pid = getpid();
+    if (tls_ready && tls_pid != pid) {
+        sm3_drbg_clear(&tls_drbg);
+        tls_ready = 0;
+    }
+#else
+    uint64_t pid = 0;
+#endif
+    if (!tls_ready) {
+        // nonce：时间、进程号与本线程状态地址（区分同一时刻初始化的线程与fork出的进程）
+        uint64_t nonce[3] = { (uint64_t)time(NULL), (uint64_t)pid, (uint64_t)(uintptr_t)&tls_drbg };
+        static const char pers[] = "sm3_random_bytes";
+        if (os_entropy(seed, sizeof(seed)) != 0) return -1;
+        sm3_drbg_init(&tls_drbg, seed, sizeof(seed), (const unsigned char*)nonce, sizeof(nonce),
+            (const unsigned char*)pers, sizeof(pers) - 1);
+        tls_ready = 1;
+#ifndef _WIN32
+        tls_pid = pid;
+#endif
+    }
+    while ((ret = sm3_drbg_read(&tls_drbg, out, len)) == SM3_DRBG_NEED_RESEED) {
+        // 重新播种后从头重新填充out
+        if (os_entropy(seed, sizeof(seed)) != 0) return -1;
+        sm3_drbg_reseed(&tls_drbg, seed, sizeof(seed), NULL, 0);
+    }
+    memset(seed, 0, sizeof(seed));
+    return ret;
+}
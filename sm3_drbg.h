@@ -0,0 +1,44 @@
+// sm3_drbg.h - 基于SM3的Hash_DRBG（NIST SP 800-90A Rev.1 10.1.1，GM/T 0105）
+#ifndef SM3_DRBG_H
+#define SM3_DRBG_H
+
+#include "sm3.h"
+
+// 内部状态V、C为seedlen = 440bit（55字节），与SHA-256相同
+// Hashgen对V、V+1、V+2...分别哈希：55字节输入加填充恰好一个分组，
+// 因此每个输出块只需从初始向量压缩一次，8个输出块在多路并行通道上同时计算
+#define SM3_DRBG_SEED_LEN 55
+#define SM3_DRBG_MAX_REQUEST 65536                  // 单次generate最多输出2^19bit
+#define SM3_DRBG_RESEED_INTERVAL (1ULL << 48)       // 超过该请求次数后必须重新播种
+#define SM3_DRBG_BUF_SIZE 4096                      // sm3_drbg_read的输出缓冲（16轮8路输出块）
+
+#define SM3_DRBG_NEED_RESEED 1                      // generate/read返回值：需要先调用reseed
+
+typedef struct {
+    unsigned char V[SM3_DRBG_SEED_LEN];
+    unsigned char C[SM3_DRBG_SEED_LEN];
+    uint64_t reseed_counter;
+    unsigned char buf[SM3_DRBG_BUF_SIZE];           // 已生成、尚未取走的输出
+    size_t buf_pos, buf_len;
+} SM3_DRBG;
+
+// 实例化：相同的(entropy, nonce, pers)在任何平台上得到相同的输出序列，可用于可复现的测试数据
+// 生产用途entropy应来自可靠熵源且不少于32字节；nonce、pers可为空
+void sm3_drbg_init(SM3_DRBG* drbg, const unsigned char* entropy, size_t entropy_len,
+    const unsigned char* nonce, size_t nonce_len, const unsigned char* pers, size_t pers_len);
+void sm3_drbg_reseed(SM3_DRBG* drbg, const unsigned char* entropy, size_t entropy_len,
+    const unsigned char* add, size_t add_len);
+// 标准generate：len超过SM3_DRBG_MAX_REQUEST返回-1，需要重新播种返回SM3_DRBG_NEED_RESEED，成功返回0
+// 直接输出，不经过缓冲区（缓冲区中尚未取走的数据保留）
+int sm3_drbg_generate(SM3_DRBG* drbg, unsigned char* out, size_t len, const unsigned char* add, size_t add_len);
+// 缓冲读取：每次按SM3_DRBG_BUF_SIZE调用generate填充缓冲区，小块读取均摊V更新的开销；len不限
+// 相同的读取序列得到相同的输出。需要重新播种时返回SM3_DRBG_NEED_RESEED，此时out不完整，重新播种后应重新读取
+int sm3_drbg_read(SM3_DRBG* drbg, unsigned char* out, size_t len);
+// 清除内部状态与缓冲区
+void sm3_drbg_clear(SM3_DRBG* drbg);
+
+// 线程本地生成器：每个线程首次调用时从操作系统熵源实例化（Linux/Unix读取/dev/urandom，Windows使用rand_s），
+// 达到重播种间隔时自动重新播种。用于生产随机数（如一次性随机数），获取熵失败返回-1
+int sm3_random_bytes(unsigned char* out, size_t len);
+
+#endif
@@ -0,0 +1,508 @@
+// sm3_filter.c - 基于SM3摘要的Bloom / Cuckoo过滤器实现
+// 一个摘要提供全部探测位置；批量接口先预取目标缓存行，掩盖随机访存延迟
+#include "sm3_filter.h"
+#include "sm3_mb.h"
+#include <stdlib.h>
+#include <math.h>
+
+#ifdef _WIN32
+#include <malloc.h>
+#include <xmmintrin.h>
+#define FILTER_PREFETCH(p) _mm_prefetch((const char*)(p), _MM_HINT_T0)
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define FILTER_PREFETCH(p) __builtin_prefetch((p))
+#endif
+
+#define FILTER_PREFETCH_DIST 16        // 批量处理时提前预取的元素数
+#define FILTER_HASH_BATCH 1024         // 键批量哈希的分组大小
+#define FILTER_HEADER_SIZE 64          // 文件头大小（保持数据区按缓存行对齐）
+#define CUCKOO_SLOTS 4                 // 每桶指纹数
+#define CUCKOO_MAX_KICKS 500           // 单次插入最多踢出次数
+
+// 序列化文件头（本机字节序）
+typedef struct {
+    char magic[8];           // "SM3BLOOM" 或 "SM3CUCKO"
+    uint32_t version;
+    uint32_t param;          // Bloom：k；Cuckoo：暂存指纹
+    uint64_t size;           // Bloom：块数；Cuckoo：桶数
+    uint64_t count;
+    uint64_t extra;          // Cuckoo：暂存指纹所在桶
+    unsigned char reserved[FILTER_HEADER_SIZE - 40];
+} FILTER_HEADER;
+
+// -------------------------- 公共辅助函数 --------------------------
+static uint64_t load_be64(const unsigned char* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) v = (v << 8) | p[i];
+    return v;
+}
+
+// 将64bit哈希值均匀映射到[0, n)（乘法取高位，避免取模）
+static uint64_t reduce_range(uint64_t h, uint64_t n) {
+#if defined(__SIZEOF_INT128__)
+    return (uint64_t)(((unsigned __int128)h * n) >> 64);
+#else
+    return h % n;
+#endif
+}
+
+// 按缓存行对齐分配内存
+static void* filter_alloc(size_t size) {
+#ifdef _WIN32
+    void* p = _aligned_malloc(size, 64);
+#else
+    void* p = NULL;
+    if (posix_memalign(&p, 64, size) != 0) p = NULL;
+#endif
+    if (p != NULL) memset(p, 0, size);
+    return p;
+}
+
+static void filter_release(void* p, void* map_base, size_t map_len) {
+    if (map_base != NULL) {
+#ifdef _WIN32
+        (void)map_len;
+        free(map_base);
+#else
+        munmap(map_base, map_len);
+#endif
+    }
+    else if (p != NULL) {
+#ifdef _WIN32
+        _aligned_free(p);
+#else
+        free(p);
+#endif
+    }
+}
+
+// 写出文件头与数据区
+static int filter_save(const char* path, const FILTER_HEADER* hdr, const void* data, size_t len) {
+    FILE* f = fopen(path, "wb");
+    if (f == NULL) return -1;
+    int ok = fwrite(hdr, sizeof(*hdr), 1, f) == 1 && fwrite(data, 1, len, f) == len;
+    if (fclose(f) != 0) ok = 0;
+    return ok ? 0 : -1;
+}
+
+// 只读映射文件并校验文件头；Windows下读入内存代替映射
+static int filter_map(const char* path, const char* magic, FILTER_HEADER* hdr, void** base, size_t* len) {
+#ifdef _WIN32
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) return -1;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size < FILTER_HEADER_SIZE) {
+        fclose(f);
+        return -1;
+    }
+    void* p = malloc((size_t)size);
+    if (p == NULL || fread(p, 1, (size_t)size, f) != (size_t)size) {
+        free(p);
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+    *len = (size_t)size;
+#else
+    int fd = open(path, O_RDONLY);
+    struct stat sb;
+    if (fd < 0) return -1;
+    if (fstat(fd, &sb) != 0 || sb.st_size < FILTER_HEADER_SIZE) {
+        close(fd);
+        return -1;
+    }
+    void* p = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return -1;
+    *len = (size_t)sb.st_size;
+#endif
+    memcpy(hdr, p, sizeof(*hdr));
+    if (memcmp(hdr->magic, magic, 8) != 0 || hdr->version != 1) {
+        filter_release(NULL, p, *len);
+        return -1;
+    }
+    *base = p;
+    return 0;
+}
+
+// -------------------------- 分块Bloom过滤器 --------------------------
+// 块内第i个探测位置：摘要第64+9i比特起的9个比特
+static uint32_t bloom_bit(const unsigned char* d, uint32_t i) {
+    uint32_t off = 64 + 9 * i;
+    uint32_t v = (uint32_t)d[off >> 3] << 8 | d[(off >> 3) + 1];
+    return (v >> (7 - (off & 7))) & 0x1ff;
+}
+
+static uint64_t* bloom_block(const SM3_BLOOM* bf, const unsigned char* d) {
+    return bf->bits + reduce_range(load_be64(d), bf->nblocks) * 8;
+}
+
+int sm3_bloom_init(SM3_BLOOM* bf, uint64_t expected_items, double fp_rate) {
+    memset(bf, 0, sizeof(*bf));
+    if (expected_items == 0) expected_items = 1;
+    if (fp_rate <= 0.0 || fp_rate >= 1.0) return -1;
+
+    // 标准Bloom公式：m = -n ln(p) / (ln2)^2，k = m/n * ln2
+    double ln2 = 0.6931471805599453;
+    double m = -(double)expected_items * log(fp_rate) / (ln2 * ln2);
+    int k = (int)(m / (double)expected_items * ln2 + 0.5);
+    if (k < 1) k = 1;
+    if (k > SM3_BLOOM_MAX_K) k = SM3_BLOOM_MAX_K;
+
+    bf->k = (uint32_t)k;
+    bf->nblocks = (uint64_t)(m / 512.0) + 1;
+    bf->bits = (uint64_t*)filter_alloc((size_t)bf->nblocks * SM3_BLOCK_SIZE);
+    return bf->bits ? 0 : -1;
+}
+
+void sm3_bloom_free(SM3_BLOOM* bf) {
+    filter_release(bf->bits, bf->map_base, bf->map_len);
+    memset(bf, 0, sizeof(*bf));
+}
+
+int sm3_bloom_add_digest(SM3_BLOOM* bf, const unsigned char digest[SM3_DIGEST_SIZE]) {
+    if (bf->readonly) return -1;
+    uint64_t* blk = bloom_block(bf, digest);
+    for (uint32_t i = 0; i < bf->k; i++) {
+        uint32_t b = bloom_bit(digest, i);
+        blk[b >> 6] |= (uint64_t)1 << (b & 63);
+    }
+    bf->count++;
+    return 0;
+}
+
+int sm3_bloom_query_digest(const SM3_BLOOM* bf, const unsigned char digest[SM3_DIGEST_SIZE]) {
+    const uint64_t* blk = bloom_block(bf, digest);
+    for (uint32_t i = 0; i < bf->k; i++) {
+        uint32_t b = bloom_bit(digest, i);
+        if (!(blk[b >> 6] & ((uint64_t)1 << (b & 63)))) return 0;
+    }
+    return 1;
+}
+
+int sm3_bloom_add(SM3_BLOOM* bf, const unsigned char* key, size_t len) {
+    unsigned char d[SM3_DIGEST_SIZE];
+    sm3_hash(key, len, d);
+    return sm3_bloom_add_digest(bf, d);
+}
+
+int sm3_bloom_query(const SM3_BLOOM* bf, const unsigned char* key, size_t len) {
+    unsigned char d[SM3_DIGEST_SIZE];
+    sm3_hash(key, len, d);
+    return sm3_bloom_query_digest(bf, d);
+}
+
+int sm3_bloom_add_digests(SM3_BLOOM* bf, const unsigned char digests[][SM3_DIGEST_SIZE], size_t n) {
+    if (bf->readonly) return -1;
+    for (size_t i = 0; i < n && i < FILTER_PREFETCH_DIST; i++) FILTER_PREFETCH(bloom_block(bf, digests[i]));
+    for (size_t i = 0; i < n; i++) {
+        if (i + FILTER_PREFETCH_DIST < n) FILTER_PREFETCH(bloom_block(bf, digests[i + FILTER_PREFETCH_DIST]));
+        sm3_bloom_add_digest(bf, digests[i]);
+    }
+    return 0;
+}
+
+void sm3_bloom_query_digests(const SM3_BLOOM* bf, const unsigned char digests[][SM3_DIGEST_SIZE], size_t n,
+    unsigned char results[]) {
+    for (size_t i = 0; i < n && i < FILTER_PREFETCH_DIST; i++) FILTER_PREFETCH(bloom_block(bf, digests[i]));
+    for (size_t i = 0; i < n; i++) {
+        if (i + FILTER_PREFETCH_DIST < n) FILTER_PREFETCH(bloom_block(bf, digests[i + FILTER_PREFETCH_DIST]));
+        results[i] = (unsigned char)sm3_bloom_query_digest(bf, digests[i]);
+    }
+}
+
+int sm3_bloom_add_many(SM3_BLOOM* bf, const unsigned char* const keys[], const size_t lens[], size_t n) {
+    unsigned char (*d)[SM3_DIGEST_SIZE] = (unsigned char (*)[SM3_DIGEST_SIZE])malloc(FILTER_HASH_BATCH * SM3_DIGEST_SIZE);
+    if (d == NULL || bf->readonly) {
+        free(d);
+        return -1;
+    }
+    for (size_t base = 0; base < n; base += FILTER_HASH_BATCH) {
+        size_t cnt = (n - base < FILTER_HASH_BATCH) ? n - base : FILTER_HASH_BATCH;
+        sm3_mb_hash(keys + base, lens + base, cnt, d);
+        sm3_bloom_add_digests(bf, (const unsigned char (*)[SM3_DIGEST_SIZE])d, cnt);
+    }
+    free(d);
+    return 0;
+}
+
+void sm3_bloom_query_many(const SM3_BLOOM* bf, const unsigned char* const keys[], const size_t lens[], size_t n,
+    unsigned char results[]) {
+    unsigned char (*d)[SM3_DIGEST_SIZE] = (unsigned char (*)[SM3_DIGEST_SIZE])malloc(FILTER_HASH_BATCH * SM3_DIGEST_SIZE);
+    if (d == NULL) {
+        for (size_t i = 0; i < n; i++) results[i] = (unsigned char)sm3_bloom_query(bf, keys[i], lens[i]);
+        return;
+    }
+    for (size_t base = 0; base < n; base += FILTER_HASH_BATCH) {
+        size_t cnt = (n - base < FILTER_HASH_BATCH) ? n - base : FILTER_HASH_BATCH;
+        sm3_mb_hash(keys + base, lens + base, cnt, d);
+        sm3_bloom_query_digests(bf, (const unsigned char (*)[SM3_DIGEST_SIZE])d, cnt, results + base);
+    }
+    free(d);
+}
+
+int sm3_bloom_save(const SM3_BLOOM* bf, const char* path) {
+    FILTER_HEADER hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, "SM3BLOOM", 8);
+    hdr.version = 1;
+    hdr.param = bf->k;
+    hdr.size = bf->nblocks;
+    hdr.count = bf->count;
+    return filter_save(path, &hdr, bf->bits, (size_t)bf->nblocks * SM3_BLOCK_SIZE);
+}
+
+int sm3_bloom_map(SM3_BLOOM* bf, const char* path) {
+    FILTER_HEADER hdr;
+    void* base;
+    size_t len;
+    memset(bf, 0, sizeof(*bf));
+    if (filter_map(path, "SM3BLOOM", &hdr, &base, &len) != 0) return -1;
+    // 先除后比较：构造的超大size使乘法回绕时不能通过长度检查
+    if (hdr.param < 1 || hdr.param > SM3_BLOOM_MAX_K || hdr.size == 0 || len < FILTER_HEADER_SIZE ||
+        hdr.size > (len - FILTER_HEADER_SIZE) / SM3_BLOCK_SIZE) {
+        filter_release(NULL, base, len);
+        return -1;
+    }
+    bf->k = hdr.param;
+    bf->nblocks = hdr.size;
+    bf->count = hdr.count;
+    bf->bits = (uint64_t*)((unsigned char*)base + FILTER_HEADER_SIZE);
+    bf->map_base = base;
+    bf->map_len = len;
+    bf->readonly = 1;
+    return 0;
+}
+
+// -------------------------- Cuckoo过滤器 --------------------------
+// 指纹取摘要第8~9字节（0保留为空位标记）
+static uint16_t cuckoo_fp(const unsigned char* d) {
+    uint16_t fp = (uint16_t)(d[8] << 8 | d[9]);
+    return fp ? fp : 1;
+}
+
+// 备用桶：对称变换，alt(alt(i)) == i
+static uint64_t cuckoo_alt(const SM3_CUCKOO* cf, uint64_t bucket, uint16_t fp) {
+    return (bucket ^ ((uint64_t)fp * 0x5bd1e995u)) & (cf->nbuckets - 1);
+}
+
+static uint64_t cuckoo_bucket(const SM3_CUCKOO* cf, const unsigned char* d) {
+    return load_be64(d) & (cf->nbuckets - 1);
+}
+
+static int bucket_has(const SM3_CUCKOO* cf, uint64_t b, uint16_t fp) {
+    const uint16_t* s = cf->slots + b * CUCKOO_SLOTS;
+    return s[0] == fp || s[1] == fp || s[2] == fp || s[3] == fp;
+}
+
+static int bucket_put(SM3_CUCKOO* cf, uint64_t b, uint16_t fp) {
+    uint16_t* s = cf->slots + b * CUCKOO_SLOTS;
+    for (int i = 0; i < CUCKOO_SLOTS; i++) {
+        if (s[i] == 0) {
+            s[i] = fp;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int bucket_del(SM3_CUCKOO* cf, uint64_t b, uint16_t fp) {
+    uint16_t* s = cf->slots + b * CUCKOO_SLOTS;
+    for (int i = 0; i < CUCKOO_SLOTS; i++) {
+        if (s[i] == fp) {
+            s[i] = 0;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int sm3_cuckoo_init(SM3_CUCKOO* cf, uint64_t capacity) {
+    memset(cf, 0, sizeof(*cf));
+    uint64_t need = capacity / CUCKOO_SLOTS * 100 / 95 + 1;
+    cf->nbuckets = 1;
+    while (cf->nbuckets < need) cf->nbuckets <<= 1;
+    cf->slots = (uint16_t*)filter_alloc((size_t)cf->nbuckets * CUCKOO_SLOTS * sizeof(uint16_t));
+    return cf->slots ? 0 : -1;
+}
+
+void sm3_cuckoo_free(SM3_CUCKOO* cf) {
+    filter_release(cf->slots, cf->map_base, cf->map_len);
+    memset(cf, 0, sizeof(*cf));
+}
+
+// 插入：两个候选桶都满时随机踢出一个指纹到它的备用桶，直到找到空位或达到踢出上限
+// 踢出失败的指纹放入暂存位，此后过滤器视为已满
+int sm3_cuckoo_add_digest(SM3_CUCKOO* cf, const unsigned char digest[SM3_DIGEST_SIZE]) {
+    if (cf->readonly || cf->victim_fp != 0) return -1;
+    uint16_t fp = cuckoo_fp(digest);
+    uint64_t b1 = cuckoo_bucket(cf, digest);
+    uint64_t b2 = cuckoo_alt(cf, b1, fp);
+    if (bucket_put(cf, b1, fp) || bucket_put(cf, b2, fp)) {
+        cf->count++;
+        return 0;
+    }
+
+    uint64_t rnd = load_be64(digest + 16) | 1;   // 踢出位置的伪随机源（xorshift）
+    uint64_t b = ((rnd >> 1) & 1) ? b1 : b2;       // 最低位被置1，起始桶取次低位
+    for (int kick = 0; kick < CUCKOO_MAX_KICKS; kick++) {
+        rnd ^= rnd << 13;
+        rnd ^= rnd >> 7;
+        rnd ^= rnd << 17;
+        uint16_t* s = cf->slots + b * CUCKOO_SLOTS + (rnd % CUCKOO_SLOTS);
+        uint16_t t = *s;
+        *s = fp;
+        fp = t;
+        b = cuckoo_alt(cf, b, fp);
+        if (bucket_put(cf, b, fp)) {
+            cf->count++;
+            return 0;
+        }
+    }
+    cf->victim_fp = fp;
+    cf->victim_bucket = b;
+    cf->count++;
+    return 0;
+}
+
+int sm3_cuckoo_query_digest(const SM3_CUCKOO* cf, const unsigned char digest[SM3_DIGEST_SIZE]) {
+    uint16_t fp = cuckoo_fp(digest);
+    uint64_t b1 = cuckoo_bucket(cf, digest);
+    uint64_t b2 = cuckoo_alt(cf, b1, fp);
+    if (bucket_has(cf, b1, fp) || bucket_has(cf, b2, fp)) return 1;
+    return cf->victim_fp == fp && (cf->victim_bucket == b1 || cf->victim_bucket == b2);
+}
+
+int sm3_cuckoo_remove_digest(SM3_CUCKOO* cf, const unsigned char digest[SM3_DIGEST_SIZE]) {
+    if (cf->readonly) return -1;
+    uint16_t fp = cuckoo_fp(digest);
+    uint64_t b1 = cuckoo_bucket(cf, digest);
+    uint64_t b2 = cuckoo_alt(cf, b1, fp);
+    if (cf->victim_fp == fp && (cf->victim_bucket == b1 || cf->victim_bucket == b2)) {
+        cf->victim_fp = 0;
+    }
+    else if (!bucket_del(cf, b1, fp) && !bucket_del(cf, b2, fp)) {
+        return -1;
+    }
+    cf->count--;
+    // 删除后尝试把暂存指纹放回桶中
+    if (cf->victim_fp != 0) {
+        uint64_t vb = cf->victim_bucket;
+        if (bucket_put(cf, vb, cf->victim_fp) || bucket_put(cf, cuckoo_alt(cf, vb, cf->victim_fp), cf->victim_fp)) {
+            cf->victim_fp = 0;
+        }
+    }
+    return 0;
+}
+
+int sm3_cuckoo_add(SM3_CUCKOO* cf, const unsigned char* key, size_t len) {
+    unsigned char d[SM3_DIGEST_SIZE];
+    sm3_hash(key, len, d);
+    return sm3_cuckoo_add_digest(cf, d);
+}
+
+int sm3_cuckoo_query(const SM3_CUCKOO* cf, const unsigned char* key, size_t len) {
+    unsigned char d[SM3_DIGEST_SIZE];
+    sm3_hash(key, len, d);
+    return sm3_cuckoo_query_digest(cf, d);
+}
+
+int sm3_cuckoo_remove(SM3_CUCKOO* cf, const unsigned char* key, size_t len) {
+    unsigned char d[SM3_DIGEST_SIZE];
+    sm3_hash(key, len, d);
+    return sm3_cuckoo_remove_digest(cf, d);
+}
+
+// 预取元素的两个候选桶
+static void cuckoo_prefetch(const SM3_CUCKOO* cf, const unsigned char* d) {
+    uint64_t b1 = cuckoo_bucket(cf, d);
+    FILTER_PREFETCH(cf->slots + b1 * CUCKOO_SLOTS);
+    FILTER_PREFETCH(cf->slots + cuckoo_alt(cf, b1, cuckoo_fp(d)) * CUCKOO_SLOTS);
+}
+
+size_t sm3_cuckoo_add_digests(SM3_CUCKOO* cf, const unsigned char digests[][SM3_DIGEST_SIZE], size_t n) {
+    size_t failed = 0;
+    for (size_t i = 0; i < n && i < FILTER_PREFETCH_DIST; i++) cuckoo_prefetch(cf, digests[i]);
+    for (size_t i = 0; i < n; i++) {
+        if (i + FILTER_PREFETCH_DIST < n) cuckoo_prefetch(cf, digests[i + FILTER_PREFETCH_DIST]);
+        if (sm3_cuckoo_add_digest(cf, digests[i]) != 0) failed++;
+    }
+    return failed;
+}
+
+void sm3_cuckoo_query_digests(const SM3_CUCKOO* cf, const unsigned char digests[][SM3_DIGEST_SIZE], size_t n,
+    unsigned char results[]) {
+    for (size_t i = 0; i < n && i < FILTER_PREFETCH_DIST; i++) cuckoo_prefetch(cf, digests[i]);
+    for (size_t i = 0; i < n; i++) {
+        if (i + FILTER_PREFETCH_DIST < n) cuckoo_prefetch(cf, digests[i + FILTER_PREFETCH_DIST]);
+        results[i] = (unsigned char)sm3_cuckoo_query_digest(cf, digests[i]);
+    }
+}
+
+size_t sm3_cuckoo_add_many(SM3_CUCKOO* cf, const unsigned char* const keys[], const size_t lens[], size_t n) {
+    unsigned char (*d)[SM3_DIGEST_SIZE] = (unsigned char (*)[SM3_DIGEST_SIZE])malloc(FILTER_HASH_BATCH * SM3_DIGEST_SIZE);
+    size_t failed = 0;
+    if (d == NULL) return n;
+    for (size_t base = 0; base < n; base += FILTER_HASH_BATCH) {
+        size_t cnt = (n - base < FILTER_HASH_BATCH) ? n - base : FILTER_HASH_BATCH;
+        sm3_mb_hash(keys + base, lens + base, cnt, d);
+        failed += sm3_cuckoo_add_digests(cf, (const unsigned char (*)[SM3_DIGEST_SIZE])d, cnt);
+    }
+    free(d);
+    return failed;
+}
+
+void sm3_cuckoo_query_many(const SM3_CUCKOO* cf, const unsigned char* const keys[], const size_t lens[], size_t n,
+    unsigned char results[]) {
+    unsigned char (*d)[SM3_DIGEST_SIZE] = (unsigned char (*)[SM3_DIGEST_SIZE])malloc(FILTER_HASH_BATCH * SM3_DIGEST_SIZE);
+    if (d == NULL) {
+        for (size_t i = 0; i < n; i++) results[i] = (unsigned char)sm3_cuckoo_query(cf, keys[i], lens[i]);
+        return;
+    }
+    for (size_t base = 0; base < n; base += FILTER_HASH_BATCH) {
+        size_t cnt = (n - base < FILTER_HASH_BATCH) ? n - base : FILTER_HASH_BATCH;
+        sm3_mb_hash(keys + base, lens + base, cnt, d);
+        sm3_cuckoo_query_digests(cf, (const unsigned char (*)[SM3_DIGEST_SIZE])d, cnt, results + base);
+    }
+    free(d);
+}
+
+int sm3_cuckoo_save(const SM3_CUCKOO* cf, const char* path) {
+    FILTER_HEADER hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, "SM3CUCKO", 8);
+    hdr.version = 1;
+    hdr.param = cf->victim_fp;
+    hdr.size = cf->nbuckets;
+    hdr.count = cf->count;
+    hdr.extra = cf->victim_bucket;
+    return filter_save(path, &hdr, cf->slots, (size_t)cf->nbuckets * CUCKOO_SLOTS * sizeof(uint16_t));
+}
+
+int sm3_cuckoo_map(SM3_CUCKOO* cf, const char* path) {
+    FILTER_HEADER hdr;
+    void* base;
+    size_t len;
+    memset(cf, 0, sizeof(*cf));
+    if (filter_map(path, "SM3CUCKO", &hdr, &base, &len) != 0) return -1;
+    if (hdr.size == 0 || (hdr.size & (hdr.size - 1)) != 0 || hdr.param > 0xffff || len < FILTER_HEADER_SIZE ||
+        hdr.size > (len - FILTER_HEADER_SIZE) / (CUCKOO_SLOTS * sizeof(uint16_t))) {
+        filter_release(NULL, base, len);
+        return -1;
+    }
+    cf->nbuckets = hdr.size;
+    cf->count = hdr.count;
+    cf->victim_fp = (uint16_t)hdr.param;
+    cf->victim_bucket = hdr.extra & (hdr.size - 1);
+    cf->slots = (uint16_t*)((unsigned char*)base + FILTER_HEADER_SIZE);
+    cf->map_base = base;
+    cf->map_len = len;
+    cf->readonly = 1;
+    return 0;
+}
@@ -0,0 +1,74 @@
+// sm3_filter.h - 基于SM3摘要的近似成员过滤器（Bloom / Cuckoo）
+#ifndef SM3_FILTER_H
+#define SM3_FILTER_H
+
+#include "sm3.h"
+
+// 所有探测位置均从一个256bit摘要中切分得到：
+//   Bloom ：前64bit选择一个64字节（缓存行）块，其后每9bit给出块内一个比特位置，最多21个探测
+//   Cuckoo：前64bit选择主桶，其后16bit为指纹，备用桶由主桶与指纹异或得到
+// 调用者已持有摘要时可直接使用 *_digest 接口，无需再次哈希
+
+#define SM3_BLOOM_MAX_K 21
+
+// 分块Bloom过滤器
+typedef struct {
+    uint64_t nblocks;        // 64字节块数
+    uint32_t k;              // 每个元素设置的比特数
+    uint64_t count;          // 已插入元素数
+    uint64_t* bits;          // 位数组（nblocks * 8个64bit字）
+    void* map_base;          // 映射文件时的映射起始地址
+    size_t map_len;
+    int readonly;            // 只读映射时禁止插入
+} SM3_BLOOM;
+
+// 4路组相联Cuckoo过滤器（16bit指纹，支持删除）
+typedef struct {
+    uint64_t nbuckets;       // 桶数（2的幂）
+    uint64_t count;
+    uint16_t* slots;         // nbuckets * 4个指纹，0表示空位
+    uint64_t victim_bucket;  // 踢出链失败时暂存的指纹（保证已插入元素不丢失）
+    uint16_t victim_fp;      // 0表示暂存位为空
+    void* map_base;
+    size_t map_len;
+    int readonly;
+} SM3_CUCKOO;
+
+// Bloom过滤器：按预期元素数与误判率初始化，成功返回0
+int sm3_bloom_init(SM3_BLOOM* bf, uint64_t expected_items, double fp_rate);
+void sm3_bloom_free(SM3_BLOOM* bf);
+int sm3_bloom_add_digest(SM3_BLOOM* bf, const unsigned char digest[SM3_DIGEST_SIZE]);
+int sm3_bloom_query_digest(const SM3_BLOOM* bf, const unsigned char digest[SM3_DIGEST_SIZE]);
+int sm3_bloom_add(SM3_BLOOM* bf, const unsigned char* key, size_t len);
+int sm3_bloom_query(const SM3_BLOOM* bf, const unsigned char* key, size_t len);
+// 批量接口：先预取全部目标缓存行再访问；键经多路并行接口批量哈希
+int sm3_bloom_add_digests(SM3_BLOOM* bf, const unsigned char digests[][SM3_DIGEST_SIZE], size_t n);
+void sm3_bloom_query_digests(const SM3_BLOOM* bf, const unsigned char digests[][SM3_DIGEST_SIZE], size_t n,
+    unsigned char results[]);
+int sm3_bloom_add_many(SM3_BLOOM* bf, const unsigned char* const keys[], const size_t lens[], size_t n);
+void sm3_bloom_query_many(const SM3_BLOOM* bf, const unsigned char* const keys[], const size_t lens[], size_t n,
+    unsigned char results[]);
+// 序列化：保存为文件，或以只读方式映射文件（不复制位数组）
+int sm3_bloom_save(const SM3_BLOOM* bf, const char* path);
+int sm3_bloom_map(SM3_BLOOM* bf, const char* path);
+
+// Cuckoo过滤器：按容量初始化（负载率约95%时插入开始失败），成功返回0
+int sm3_cuckoo_init(SM3_CUCKOO* cf, uint64_t capacity);
+void sm3_cuckoo_free(SM3_CUCKOO* cf);
+int sm3_cuckoo_add_digest(SM3_CUCKOO* cf, const unsigned char digest[SM3_DIGEST_SIZE]);
+int sm3_cuckoo_query_digest(const SM3_CUCKOO* cf, const unsigned char digest[SM3_DIGEST_SIZE]);
+int sm3_cuckoo_remove_digest(SM3_CUCKOO* cf, const unsigned char digest[SM3_DIGEST_SIZE]);
+int sm3_cuckoo_add(SM3_CUCKOO* cf, const unsigned char* key, size_t len);
+int sm3_cuckoo_query(const SM3_CUCKOO* cf, const unsigned char* key, size_t len);
+int sm3_cuckoo_remove(SM3_CUCKOO* cf, const unsigned char* key, size_t len);
+// 批量接口：返回插入失败的元素数；查询结果写入results
+size_t sm3_cuckoo_add_digests(SM3_CUCKOO* cf, const unsigned char digests[][SM3_DIGEST_SIZE], size_t n);
+void sm3_cuckoo_query_digests(const SM3_CUCKOO* cf, const unsigned char digests[][SM3_DIGEST_SIZE], size_t n,
+    unsigned char results[]);
+size_t sm3_cuckoo_add_many(SM3_CUCKOO* cf, const unsigned char* const keys[], const size_t lens[], size_t n);
+void sm3_cuckoo_query_many(const SM3_CUCKOO* cf, const unsigned char* const keys[], const size_t lens[], size_t n,
+    unsigned char results[]);
+int sm3_cuckoo_save(const SM3_CUCKOO* cf, const char* path);
+int sm3_cuckoo_map(SM3_CUCKOO* cf, const char* path);
+
+#endif
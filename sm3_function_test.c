@@ -1,4 +1,16 @@
 #include "sm3.h"
+#include "sm3_mb.h"
+#include "sm3_filter.h"
+#include "sm3_tree.h"
+#include "sm3_pool.h"
+#include "sm3_hmac.h"
+#include "sm3_kdf.h"
+#include "sm3_sm2.h"
+#include "sm3_drbg.h"
+#include "sm3_chain.h"
+#include "sm3_xmss.h"
+#include "sm3_pow.h"
+#include "sm3_memo.h"
 #include <string.h>
 #include <time.h>
 #include <stdlib.h>
@@ -8,6 +20,7 @@
 #include <wchar.h>  // 用于控制台字体配置
 #else
 #include <sys/time.h>
+#include <sys/wait.h>
 #include <unistd.h>
 #endif
 
@@ -36,15 +49,19 @@ static void init_windows_console() {
 
 // -------------------------- 核心修复2：辅助工具函数（支撑大作业测试） --------------------------
 // 生成指定长度的随机字节流（抗碰撞测试用）
-// 该函数动态分配内存，生成指定长度的随机数据，用于测试哈希函数的抗碰撞性
+// 数据取自固定种子的SM3 Hash_DRBG，任何平台上都是同一序列，失败用例可以复现
 static unsigned char* generate_random_input(size_t len) {
+    static SM3_DRBG drbg;
+    static int seeded = 0;
     if (len == 0) return NULL;
     unsigned char* data = (unsigned char*)malloc(len);
     if (data == NULL) return NULL;
-    for (size_t i = 0; i < len; i++) {
-        // 修复：使用更安全的类型转换，确保生成0-255范围内的随机字节
-        data[i] = (unsigned char)(rand() & 0xFF);  // 0~255随机字节
+    if (!seeded) {
+        static const char seed[] = "sm3_function_test";
+        sm3_drbg_init(&drbg, (const unsigned char*)seed, sizeof(seed) - 1, NULL, 0, NULL, 0);
+        seeded = 1;
     }
+    sm3_drbg_read(&drbg, data, len);
     return data;
 }
 
@@ -83,16 +100,20 @@ static int count_bit_diff(const unsigned char* h1, const unsigned char* h2) {
     return diff_count;
 }
 
-// 自定义strdup替代函数（解决VS中strdup弃用警告）
-// 由于Visual Studio将strdup标记为不安全，这里提供自定义实现
-static char* my_strdup(const char* str) {
-    if (str == NULL) return NULL;
-    size_t len = strlen(str) + 1;
-    char* new_str = (char*)malloc(len);
-    if (new_str != NULL) {
-        memcpy(new_str, str, len);
-    }
-    return new_str;
+// 碰撞检测记录：二进制摘要 + 样本信息
+typedef struct {
+    unsigned char hash[SM3_DIGEST_SIZE];
+    int index;        // 样本序号（从0开始）
+    size_t len;       // 输入长度
+} HASH_RECORD;
+
+// 按摘要排序（摘要相同再按样本序号），排序后相同摘要必然相邻
+static int hash_record_cmp(const void* a, const void* b) {
+    const HASH_RECORD* x = (const HASH_RECORD*)a;
+    const HASH_RECORD* y = (const HASH_RECORD*)b;
+    int c = memcmp(x->hash, y->hash, SM3_DIGEST_SIZE);
+    if (c != 0) return c;
+    return x->index - y->index;
 }
 
 // -------------------------- 大作业测试1：标准测试用例（保留原始逻辑） --------------------------
@@ -216,14 +237,15 @@ static void collision_resistance_test() {
     const size_t MIN_LEN = 16;     // 最小输入长度（字节）
     const size_t MAX_LEN = 256;    // 最大输入长度（字节）
 
-    // 存储所有哈希值（修复：正确初始化）
-    char** hash_records = (char**)calloc(TEST_COUNT, sizeof(char*));
+    // 存储所有哈希值（二进制摘要，排序后检测相邻重复，复杂度O(n log n)）
+    HASH_RECORD* hash_records = (HASH_RECORD*)calloc(TEST_COUNT, sizeof(HASH_RECORD));
     if (hash_records == NULL) {
         printf("内存分配失败，测试终止\n");
         return;
     }
 
     int collision_count = 0;
+    int record_count = 0;
     uint64_t start_ms = 0;
 #ifdef _WIN32
     start_ms = GetTickCount64();  // Windows高精度计时
@@ -246,30 +268,30 @@ static void collision_resistance_test() {
         }
 
         // 计算哈希值
-        unsigned char hash[SM3_DIGEST_SIZE];
-        sm3_hash(input_data, input_len, hash);
-        hash_records[i] = my_strdup(sm3_hash_to_string(hash));
-
-        // 检测碰撞（与之前所有样本对比）
-        if (hash_records[i] != NULL) {
-            for (int j = 0; j < i; j++) {
-                if (hash_records[j] != NULL && strcmp(hash_records[i], hash_records[j]) == 0) {
-                    collision_count++;
-                    printf("发现碰撞：第%d组与第%d组输入哈希值相同\n", i + 1, j + 1);
-                    printf("  第%d组输入长度：%zu字节，哈希值：%s\n", i + 1, input_len, hash_records[i]);
-                }
-            }
-        }
+        HASH_RECORD* rec = &hash_records[record_count++];
+        sm3_hash(input_data, input_len, rec->hash);
+        rec->index = i;
+        rec->len = input_len;
 
         free(input_data);  // 释放输入数据内存
     }
 
+    // 检测碰撞（排序后比较相邻记录）
+    qsort(hash_records, record_count, sizeof(HASH_RECORD), hash_record_cmp);
+    for (int i = 1; i < record_count; i++) {
+        if (hash_equal(hash_records[i].hash, hash_records[i - 1].hash)) {
+            collision_count++;
+            printf("发现碰撞：第%d组与第%d组输入哈希值相同\n", hash_records[i].index + 1, hash_records[i - 1].index + 1);
+            printf("  第%d组输入长度：%zu字节，哈希值：%s\n", hash_records[i].index + 1, hash_records[i].len,
+                sm3_hash_to_string(hash_records[i].hash));
+        }
+    }
+
     // 计算测试耗时
     uint64_t cost_ms = 0;
 #ifdef _WIN32
     cost_ms = GetTickCount64() - start_ms;
 #else
-    struct timeval tv;
     gettimeofday(&tv, NULL);
     cost_ms = (tv.tv_sec * 1000 + tv.tv_usec / 1000) - start_ms;
 #endif
@@ -284,9 +306,6 @@ static void collision_resistance_test() {
     printf("========================================================================\n\n");
 
     // 释放内存
-    for (int i = 0; i < TEST_COUNT; i++) {
-        if (hash_records[i] != NULL) free(hash_records[i]);
-    }
     free(hash_records);
 }
 
@@ -372,6 +391,1313 @@ static void avalanche_effect_test() {
     printf("========================================================================\n\n");
 }
 
+// -------------------------- 扩展测试：多路并行接口一致性 --------------------------
+// 随机长度（含0字节、跨分组、带未对齐前缀的中间状态）的多条消息经多路并行接口计算，
+// 结果必须与逐条调用sm3_hash/sm3_update完全一致
+static void multi_buffer_test() {
+    printf("=== 五、多路并行接口一致性测试 ===\n");
+
+    const int ROUNDS = 100;
+    const size_t MAX_MSGS = 40;
+    int mismatch = 0, total = 0;
+    srand(2024);
+
+    for (int r = 0; r < ROUNDS; r++) {
+        size_t n = 1 + (size_t)rand() % MAX_MSGS;
+        const unsigned char* data[40];
+        size_t lens[40];
+        SM3_CTX ctxs[40];
+        const SM3_CTX* cptr[40];
+        unsigned char digests[40][SM3_DIGEST_SIZE];
+        unsigned char expect[SM3_DIGEST_SIZE];
+
+        for (size_t i = 0; i < n; i++) {
+            lens[i] = (size_t)rand() % ((rand() & 1) ? 200 : 3000);
+            data[i] = generate_random_input(lens[i] ? lens[i] : 1);
+            unsigned char prefix[100];
+            size_t plen = (size_t)rand() % sizeof(prefix);
+            for (size_t k = 0; k < plen; k++) prefix[k] = (unsigned char)rand();
+            sm3_init(&ctxs[i]);
+            sm3_update(&ctxs[i], prefix, plen);
+            cptr[i] = &ctxs[i];
+        }
+
+        sm3_mb_hash(data, lens, n, digests);
+        for (size_t i = 0; i < n; i++) {
+            sm3_hash(data[i], lens[i], expect);
+            if (!hash_equal(expect, digests[i])) mismatch++;
+            total++;
+        }
+
+        sm3_mb_finish(cptr, data, lens, n, digests);
+        for (size_t i = 0; i < n; i++) {
+            SM3_CTX c = ctxs[i];
+            sm3_update(&c, data[i], lens[i]);
+            sm3_final(&c, expect);
+            if (!hash_equal(expect, digests[i])) mismatch++;
+            total++;
+            free((void*)data[i]);
+        }
+    }
+
+    // 多流调度器：30个流交错追加随机长度数据，结果与逐流顺序计算一致
+    {
+        SM3_MB_SCHED sched;
+        SM3_MB_STREAM streams[30];
+        SM3_CTX refs[30];
+        unsigned char buf[300];
+        sm3_mb_sched_init(&sched, 16384);
+        for (int i = 0; i < 30; i++) {
+            sm3_mb_stream_init(&streams[i]);
+            sm3_init(&refs[i]);
+        }
+        for (int k = 0; k < 3000; k++) {
+            int i = rand() % 30;
+            size_t len = (size_t)rand() % sizeof(buf);
+            for (size_t b = 0; b < len; b++) buf[b] = (unsigned char)rand();
+            sm3_mb_stream_update(&sched, &streams[i], buf, len);
+            sm3_update(&refs[i], buf, len);
+        }
+        for (int i = 0; i < 30; i++) {
+            unsigned char got[SM3_DIGEST_SIZE], expect[SM3_DIGEST_SIZE];
+            sm3_mb_stream_final(&sched, &streams[i], got);
+            sm3_final(&refs[i], expect);
+            if (!hash_equal(expect, got)) mismatch++;
+            total++;
+            sm3_mb_stream_free(&sched, &streams[i]);
+        }
+    }
+
+    printf("  并行通道数：%d\n", SM3_MB_LANES);
+    printf("  比对次数：%d，不一致次数：%d\n", total, mismatch);
+    printf("  结论：%s\n", mismatch == 0 ? "通过" : "失败");
+    printf("========================================================================\n\n");
+}
+
+// -------------------------- 扩展测试：Bloom / Cuckoo过滤器 --------------------------
+// 插入N个键后检查：已插入键必须全部命中（无漏判），未插入键的误判率接近设计值；
+// 保存并映射文件后查询结果不变，文件头大小字段被篡改时拒绝映射；Cuckoo过滤器删除后不再命中
+// 改写过滤器文件头中的大小字段（偏移16，本机字节序）
+static int filter_patch_size(const char* path, uint64_t size) {
+    FILE* f = fopen(path, "r+b");
+    int ok = f != NULL && fseek(f, 16, SEEK_SET) == 0 && fwrite(&size, sizeof(size), 1, f) == 1;
+    if (f != NULL && fclose(f) != 0) ok = 0;
+    return ok;
+}
+
+static void filter_test() {
+    printf("=== 六、Bloom / Cuckoo过滤器测试 ===\n");
+
+    const size_t N = 100000;
+    const double FP_RATE = 0.01;
+    unsigned char (*keys)[16] = (unsigned char (*)[16])malloc(N * 2 * 16);
+    const unsigned char** kp = (const unsigned char**)malloc(N * 2 * sizeof(*kp));
+    size_t* lens = (size_t*)malloc(N * 2 * sizeof(size_t));
+    unsigned char* res = (unsigned char*)malloc(N * 2);
+    SM3_BLOOM bf, bf_map;
+    SM3_CUCKOO cf, cf_map;
+    int pass = 1;
+
+    if (keys == NULL || kp == NULL || lens == NULL || res == NULL ||
+        sm3_bloom_init(&bf, N, FP_RATE) != 0 || sm3_cuckoo_init(&cf, N) != 0) {
+        printf("内存分配失败，测试跳过\n");
+        free(keys); free(kp); free(lens); free(res);
+        return;
+    }
+    // 前N个键插入，后N个键只用于查询误判
+    for (size_t i = 0; i < N * 2; i++) {
+        snprintf((char*)keys[i], 16, "key-%09zu", i);
+        kp[i] = keys[i];
+        lens[i] = strlen((const char*)keys[i]);
+    }
+    sm3_bloom_add_many(&bf, kp, lens, N);
+    size_t cuckoo_failed = sm3_cuckoo_add_many(&cf, kp, lens, N);
+
+    size_t miss = 0, fp = 0;
+    sm3_bloom_query_many(&bf, kp, lens, N * 2, res);
+    for (size_t i = 0; i < N; i++) miss += !res[i];
+    for (size_t i = N; i < N * 2; i++) fp += res[i];
+    double bloom_fp = (double)fp / N;
+    printf("Bloom：k=%u，块数=%llu，漏判=%zu，误判率=%.4f（设计值%.4f）\n", bf.k,
+        (unsigned long long)bf.nblocks, miss, bloom_fp, FP_RATE);
+    if (miss != 0 || bloom_fp > FP_RATE * 2) pass = 0;
+
+    miss = fp = 0;
+    sm3_cuckoo_query_many(&cf, kp, lens, N * 2, res);
+    for (size_t i = 0; i < N; i++) miss += !res[i];
+    for (size_t i = N; i < N * 2; i++) fp += res[i];
+    printf("Cuckoo：桶数=%llu，插入失败=%zu，漏判=%zu，误判率=%.4f\n",
+        (unsigned long long)cf.nbuckets, cuckoo_failed, miss, (double)fp / N);
+    if (cuckoo_failed != 0 || miss != 0 || (double)fp / N > 0.001) pass = 0;
+
+    // 序列化后映射查询
+    if (sm3_bloom_save(&bf, "filter_test.bloom") == 0 && sm3_bloom_map(&bf_map, "filter_test.bloom") == 0) {
+        size_t diff = 0;
+        for (size_t i = 0; i < N * 2; i += 97) {
+            diff += sm3_bloom_query(&bf, kp[i], lens[i]) != sm3_bloom_query(&bf_map, kp[i], lens[i]);
+        }
+        printf("Bloom映射文件查询差异：%zu\n", diff);
+        if (diff != 0 || sm3_bloom_add(&bf_map, kp[0], lens[0]) == 0) pass = 0;
+        sm3_bloom_free(&bf_map);
+    }
+    else {
+        printf("Bloom保存或映射失败\n");
+        pass = 0;
+    }
+    // 文件头中构造的块数使"块数×块大小"回绕为小值时必须拒绝映射
+    if (!filter_patch_size("filter_test.bloom", (1ULL << 58) + 1) || sm3_bloom_map(&bf_map, "filter_test.bloom") == 0) {
+        printf("Bloom损坏文件头未被拒绝\n");
+        if (bf_map.bits != NULL) sm3_bloom_free(&bf_map);
+        pass = 0;
+    }
+    remove("filter_test.bloom");
+
+    if (sm3_cuckoo_save(&cf, "filter_test.cuckoo") == 0 && sm3_cuckoo_map(&cf_map, "filter_test.cuckoo") == 0) {
+        size_t diff = 0;
+        for (size_t i = 0; i < N * 2; i += 97) {
+            diff += sm3_cuckoo_query(&cf, kp[i], lens[i]) != sm3_cuckoo_query(&cf_map, kp[i], lens[i]);
+        }
+        printf("Cuckoo映射文件查询差异：%zu\n", diff);
+        if (diff != 0) pass = 0;
+        sm3_cuckoo_free(&cf_map);
+    }
+    else {
+        printf("Cuckoo保存或映射失败\n");
+        pass = 0;
+    }
+    if (!filter_patch_size("filter_test.cuckoo", 1ULL << 63) || sm3_cuckoo_map(&cf_map, "filter_test.cuckoo") == 0) {
+        printf("Cuckoo损坏文件头未被拒绝\n");
+        if (cf_map.slots != NULL) sm3_cuckoo_free(&cf_map);
+        pass = 0;
+    }
+    remove("filter_test.cuckoo");
+
+    // 删除前一半键后，后一半仍必须命中
+    size_t removed_fail = 0;
+    for (size_t i = 0; i < N / 2; i++) removed_fail += sm3_cuckoo_remove(&cf, kp[i], lens[i]) != 0;
+    miss = 0;
+    for (size_t i = N / 2; i < N; i++) miss += !sm3_cuckoo_query(&cf, kp[i], lens[i]);
+    printf("Cuckoo删除：删除失败=%zu，剩余键漏判=%zu\n", removed_fail, miss);
+    if (removed_fail != 0 || miss != 0) pass = 0;
+
+    printf("  结论：%s\n", pass ? "通过" : "失败");
+    printf("========================================================================\n\n");
+    sm3_bloom_free(&bf);
+    sm3_cuckoo_free(&cf);
+    free(keys); free(kp); free(lens); free(res);
+}
+
+// -------------------------- 扩展测试：融合复制哈希 --------------------------
+// 随机长度、随机分段、随机对齐偏移下，sm3_copy_and_update的复制结果必须与源数据一致，
+// 摘要必须与sm3_hash一致（覆盖缓冲区残留、整分组快速路径与尾部）
+static void copy_update_test() {
+    printf("=== 七、融合复制哈希测试 ===\n");
+
+    const int ROUNDS = 200;
+    int mismatch = 0;
+    srand(2025);
+
+    for (int r = 0; r < ROUNDS; r++) {
+        size_t len = (size_t)rand() % 5000;
+        size_t src_off = (size_t)rand() % 8, dst_off = (size_t)rand() % 8;
+        unsigned char* src = generate_random_input(len + 8);
+        unsigned char* dst = (unsigned char*)malloc(len + 8);
+        unsigned char expect[SM3_DIGEST_SIZE], got[SM3_DIGEST_SIZE];
+        SM3_CTX ctx;
+        if (src == NULL || dst == NULL) {
+            free(src); free(dst);
+            mismatch++;
+            continue;
+        }
+
+        sm3_init(&ctx);
+        for (size_t done = 0; done < len;) {
+            size_t n = 1 + (size_t)rand() % 300;
+            if (n > len - done) n = len - done;
+            sm3_copy_and_update(&ctx, dst + dst_off + done, src + src_off + done, n);
+            done += n;
+        }
+        sm3_final(&ctx, got);
+        sm3_hash(src + src_off, len, expect);
+        if (!hash_equal(expect, got) || memcmp(src + src_off, dst + dst_off, len) != 0) mismatch++;
+        free(src);
+        free(dst);
+    }
+
+    printf("  比对次数：%d，不一致次数：%d\n", ROUNDS, mismatch);
+    printf("  结论：%s\n", mismatch == 0 ? "通过" : "失败");
+    printf("========================================================================\n\n");
+}
+
+// -------------------------- 扩展测试：树哈希 --------------------------
+// 与按定义逐层计算的结果比对；按2^k个叶子对齐分段后各段子树根合并必须等于整体树根；
+// 文件区间接口与内存接口结果一致
+static unsigned char tree_ref_nodes[64][SM3_DIGEST_SIZE];
+
+static void tree_reference(const unsigned char* data, size_t len, size_t leaf, unsigned char out[SM3_DIGEST_SIZE]) {
+    size_t n = len == 0 ? 1 : (len + leaf - 1) / leaf;
+    unsigned char buf[1 + 4096];
+    for (size_t i = 0; i < n; i++) {
+        size_t l = len - i * leaf < leaf ? len - i * leaf : leaf;
+        buf[0] = 0x00;
+        memcpy(buf + 1, data + i * leaf, l);
+        sm3_hash(buf, l + 1, tree_ref_nodes[i]);
+    }
+    // 逐层合并：每层两两配对，落单的节点原样上移（与"左侧取最大2的幂"划分等价）
+    while (n > 1) {
+        size_t m = 0;
+        for (size_t i = 0; i + 1 < n; i += 2) {
+            buf[0] = 0x01;
+            memcpy(buf + 1, tree_ref_nodes[i], SM3_DIGEST_SIZE);
+            memcpy(buf + 1 + SM3_DIGEST_SIZE, tree_ref_nodes[i + 1], SM3_DIGEST_SIZE);
+            sm3_hash(buf, 1 + 2 * SM3_DIGEST_SIZE, tree_ref_nodes[m++]);
+        }
+        if (n % 2) memcpy(tree_ref_nodes[m++], tree_ref_nodes[n - 1], SM3_DIGEST_SIZE);
+        n = m;
+    }
+    memcpy(out, tree_ref_nodes[0], SM3_DIGEST_SIZE);
+}
+
+static void tree_hash_test() {
+    printf("=== 八、树哈希测试 ===\n");
+
+    const size_t LEAF = 256;
+    int mismatch = 0, total = 0;
+    srand(2026);
+
+    for (int r = 0; r < 100; r++) {
+        size_t len = (size_t)rand() % (LEAF * 40);
+        unsigned char* data = generate_random_input(len + 1);
+        unsigned char expect[SM3_DIGEST_SIZE], got[SM3_DIGEST_SIZE];
+        if (data == NULL) continue;
+
+        tree_reference(data, len, LEAF, expect);
+        sm3_tree_hash(data, len, LEAF, got);
+        mismatch += !hash_equal(expect, got);
+        total++;
+
+        // 按2^k个叶子分段计算子树根后合并
+        size_t seg = LEAF << (rand() % 4);
+        unsigned char parts[64][SM3_DIGEST_SIZE];
+        size_t nparts = 0;
+        for (size_t off = 0; off < len || nparts == 0; off += seg) {
+            size_t l = len - off < seg ? len - off : seg;
+            sm3_tree_hash(data + off, l, LEAF, parts[nparts++]);
+        }
+        sm3_tree_root((const unsigned char (*)[SM3_DIGEST_SIZE])parts, nparts, got);
+        mismatch += !hash_equal(expect, got);
+        total++;
+
+        if (r % 10 == 0) {
+            FILE* f = fopen("tree_test.bin", "wb");
+            if (f != NULL) {
+                fwrite(data, 1, len, f);
+                fclose(f);
+                sm3_tree_file_hash("tree_test.bin", 0, UINT64_MAX, LEAF, got);
+                mismatch += !hash_equal(expect, got);
+                total++;
+                remove("tree_test.bin");
+            }
+        }
+        free(data);
+    }
+
+    printf("  比对次数：%d，不一致次数：%d\n", total, mismatch);
+    printf("  结论：%s\n", mismatch == 0 ? "通过" : "失败");
+    printf("========================================================================\n\n");
+}
+
+// -------------------------- 扩展测试：NUMA感知线程池 --------------------------
+typedef struct {
+    SM3_POOL* pool;
+    const unsigned char* const* data;
+    const size_t* lens;
+    size_t n;
+    unsigned char (*digests)[SM3_DIGEST_SIZE];
+} POOL_NESTED_ARG;
+
+// 在任务内提交并等待批量哈希
+static void pool_nested_task(SM3_POOL_WORKER* w, void* arg) {
+    POOL_NESTED_ARG* a = (POOL_NESTED_ARG*)arg;
+    (void)w;
+    sm3_pool_hash_batch(a->pool, a->data, a->lens, a->n, a->digests);
+}
+
+// 批量消息、多文件与树哈希三条并行路径的结果必须与单线程接口一致；
+// 在任务内等待本组任务时不得死锁（单线程池上也能完成）
+static void pool_test() {
+    printf("=== 九、NUMA感知线程池测试 ===\n");
+
+    SM3_POOL* pool = sm3_pool_create(4, 64 * 1024);
+    int mismatch = 0, total = 0;
+    if (pool == NULL) {
+        printf("  线程池创建失败\n");
+        printf("  结论：失败\n");
+        return;
+    }
+    printf("  节点数：%d，线程数：%d\n", sm3_pool_nodes(pool), sm3_pool_threads(pool));
+    srand(2027);
+
+    // 批量消息
+    const size_t N = 3000;
+    const unsigned char** data = (const unsigned char**)malloc(N * sizeof(*data));
+    size_t* lens = (size_t*)malloc(N * sizeof(size_t));
+    unsigned char (*digests)[SM3_DIGEST_SIZE] = (unsigned char (*)[SM3_DIGEST_SIZE])malloc(N * SM3_DIGEST_SIZE);
+    if (data != NULL && lens != NULL && digests != NULL) {
+        for (size_t i = 0; i < N; i++) {
+            lens[i] = (size_t)rand() % 500;
+            data[i] = generate_random_input(lens[i] + 1);
+        }
+        sm3_pool_hash_batch(pool, data, lens, N, digests);
+        for (size_t i = 0; i < N; i++) {
+            unsigned char expect[SM3_DIGEST_SIZE];
+            sm3_hash(data[i], lens[i], expect);
+            mismatch += !hash_equal(expect, digests[i]);
+            total++;
+        }
+
+        // 单线程池：唯一的工作线程在任务内等待本组任务
+        SM3_POOL* single = sm3_pool_create(1, 64 * 1024);
+        POOL_NESTED_ARG nested = { single, data, lens, N, digests };
+        SM3_POOL_GROUP group = { 0 };
+        memset(digests, 0, N * SM3_DIGEST_SIZE);
+        if (single != NULL) {
+            if (sm3_pool_submit_group(single, -1, pool_nested_task, &nested, &group) != 0) pool_nested_task(NULL, &nested);
+            sm3_pool_wait_group(single, &group);
+            sm3_pool_destroy(single);
+        }
+        else mismatch++;
+        for (size_t i = 0; i < N; i++) {
+            unsigned char expect[SM3_DIGEST_SIZE];
+            sm3_hash(data[i], lens[i], expect);
+            mismatch += !hash_equal(expect, digests[i]);
+            total++;
+            free((void*)data[i]);
+        }
+    }
+    free(data); free(lens); free(digests);
+
+    // 多文件与树哈希（文件大于线程本地缓冲，覆盖分段读取）
+    const char* names[3] = { "pool_test_0.bin", "pool_test_1.bin", "pool_test_2.bin" };
+    const size_t sizes[3] = { 0, 1000, 300 * 1024 + 17 };
+    unsigned char file_digests[3][SM3_DIGEST_SIZE];
+    int status[3];
+    for (int i = 0; i < 3; i++) {
+        FILE* f = fopen(names[i], "wb");
+        unsigned char* buf = generate_random_input(sizes[i] + 1);
+        if (f != NULL && buf != NULL) fwrite(buf, 1, sizes[i], f);
+        if (f != NULL) fclose(f);
+        free(buf);
+    }
+    sm3_pool_file_hashes(pool, names, 3, file_digests, status);
+    for (int i = 0; i < 3; i++) {
+        unsigned char expect[SM3_DIGEST_SIZE], got[SM3_DIGEST_SIZE];
+        sm3_file_hash(names[i], expect);
+        mismatch += status[i] != 0 || !hash_equal(expect, file_digests[i]);
+        total++;
+
+        sm3_tree_file_hash(names[i], 0, UINT64_MAX, 1024, expect);
+        mismatch += sm3_pool_tree_file_hash(pool, names[i], 1024, got) != 0 || !hash_equal(expect, got);
+        total++;
+        remove(names[i]);
+    }
+    sm3_pool_destroy(pool);
+
+    printf("  比对次数：%d，不一致次数：%d\n", total, mismatch);
+    printf("  结论：%s\n", mismatch == 0 ? "通过" : "失败");
+    printf("========================================================================\n\n");
+}
+
+// -------------------------- 扩展测试：HMAC-SM3 --------------------------
+// 标准构造的参考值（Python hmac + hashlib sm3）；密钥对象、流式分段与一次性接口结果一致；
+// 篡改消息或标签后校验失败
+static void hmac_test() {
+    printf("=== 十、HMAC-SM3测试 ===\n");
+
+    static const struct {
+        const char* key;
+        size_t key_len;
+        const char* msg;
+        size_t msg_len;
+        const char* expect;
+    } vectors[] = {
+        { "key", 3, "The quick brown fox jumps over the lazy dog", 43,
+          "bd4a34077888162b210645b8ebf74b9af357303789357a27c7fc457244ebd398" },
+        { "\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b", 20, "Hi There", 8,
+          "51b00d1fb49832bfb01c3ce27848e59f871d9ba938dc563b338ca964755cce70" },
+        { "", 0, "", 0,
+          "0d23f72ba15e9c189a879aefc70996b06091de6e64d31b7a84004356dd915261" },
+    };
+    int pass = 1;
+
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+        unsigned char mac[SM3_HMAC_SIZE];
+        hmac_sm3((const unsigned char*)vectors[i].key, vectors[i].key_len,
+            (const unsigned char*)vectors[i].msg, vectors[i].msg_len, mac);
+        int ok = strcmp(sm3_hash_to_string(mac), vectors[i].expect) == 0;
+        printf("  用例%zu：%s\n", i + 1, ok ? "通过" : "失败");
+        pass &= ok;
+    }
+
+    // 长密钥（超过分组长度先哈希）、长消息
+    {
+        unsigned char key[100], msg[200], mac[SM3_HMAC_SIZE];
+        memset(key, 'k', sizeof(key));
+        memset(msg, 'a', sizeof(msg));
+        hmac_sm3(key, sizeof(key), msg, sizeof(msg), mac);
+        int ok = strcmp(sm3_hash_to_string(mac), "82e796c503d209191f7418c84b8093afe656be04f9d845bec51acb7712b69c0f") == 0;
+        printf("  用例4（100字节密钥）：%s\n", ok ? "通过" : "失败");
+        pass &= ok;
+    }
+
+    // 密钥对象复用、流式分段、校验
+    srand(2028);
+    int mismatch = 0;
+    for (int r = 0; r < 50; r++) {
+        unsigned char key[150], expect[SM3_HMAC_SIZE], mac[SM3_HMAC_SIZE];
+        size_t key_len = (size_t)rand() % sizeof(key);
+        size_t len = (size_t)rand() % 1000;
+        unsigned char* msg = generate_random_input(len + 1);
+        SM3_HMAC_KEY hk;
+        SM3_HMAC_CTX hc;
+        if (msg == NULL) continue;
+        for (size_t b = 0; b < key_len; b++) key[b] = (unsigned char)rand();
+
+        hmac_sm3(key, key_len, msg, len, expect);
+        hmac_sm3_key_init(&hk, key, key_len);
+        hmac_sm3_mac(&hk, msg, len, mac);
+        mismatch += !hash_equal(expect, mac);
+
+        hmac_sm3_init(&hc, &hk);
+        for (size_t done = 0; done < len;) {
+            size_t n = 1 + (size_t)rand() % 100;
+            if (n > len - done) n = len - done;
+            hmac_sm3_update(&hc, msg + done, n);
+            done += n;
+        }
+        hmac_sm3_final(&hc, mac);
+        mismatch += !hash_equal(expect, mac);
+
+        mismatch += !hmac_sm3_verify(&hk, msg, len, expect);
+        expect[r % SM3_HMAC_SIZE] ^= 0x01;
+        mismatch += hmac_sm3_verify(&hk, msg, len, expect);
+        hmac_sm3_key_clear(&hk);
+        free(msg);
+    }
+    printf("  随机比对：不一致%d次\n", mismatch);
+    pass &= mismatch == 0;
+
+    // 批量接口：4个密钥交错（含相邻同密钥），结果与逐条计算一致；篡改的标签被识别
+    {
+        const size_t N = 600;
+        SM3_HMAC_KEY hks[4];
+        const SM3_HMAC_KEY** keys = (const SM3_HMAC_KEY**)malloc(N * sizeof(*keys));
+        const unsigned char** msgs = (const unsigned char**)malloc(N * sizeof(*msgs));
+        size_t* lens = (size_t*)malloc(N * sizeof(size_t));
+        unsigned char (*macs)[SM3_HMAC_SIZE] = (unsigned char (*)[SM3_HMAC_SIZE])malloc(N * SM3_HMAC_SIZE);
+        int* results = (int*)malloc(N * sizeof(int));
+        size_t bad = 0;
+        if (keys != NULL && msgs != NULL && lens != NULL && macs != NULL && results != NULL) {
+            for (int k = 0; k < 4; k++) {
+                unsigned char kb[20];
+                for (int b = 0; b < 20; b++) kb[b] = (unsigned char)rand();
+                hmac_sm3_key_init(&hks[k], kb, 5 * (size_t)k + 1);
+            }
+            for (size_t i = 0; i < N; i++) {
+                keys[i] = &hks[(rand() % 3 == 0) ? (size_t)(rand() % 4) : (i / 7) % 4];
+                lens[i] = (size_t)rand() % 300;
+                msgs[i] = generate_random_input(lens[i] + 1);
+            }
+            hmac_sm3_many(keys, msgs, lens, N, macs);
+            for (size_t i = 0; i < N; i++) {
+                unsigned char expect[SM3_HMAC_SIZE];
+                hmac_sm3_mac(keys[i], msgs[i], lens[i], expect);
+                bad += !hash_equal(expect, macs[i]);
+            }
+            macs[17][3] ^= 0x80;
+            size_t valid = hmac_sm3_verify_many(keys, msgs, lens, N, (const unsigned char (*)[SM3_HMAC_SIZE])macs, results);
+            bad += valid != N - 1 || results[17] != 0 || results[16] != 1;
+            for (size_t i = 0; i < N; i++) free((void*)msgs[i]);
+        }
+        else {
+            bad = 1;
+        }
+        printf("  批量签名/校验：%s\n", bad == 0 ? "通过" : "失败");
+        pass &= bad == 0;
+        free(keys); free(msgs); free(lens); free(macs); free(results);
+    }
+
+    // 多密钥接口：同一消息、不同密钥数与消息长度（覆盖一个/两个填充分组、多个密钥组）
+    {
+        SM3_HMAC_KEY mk[21];
+        const SM3_HMAC_KEY* mkp[21];
+        unsigned char macs[21][SM3_HMAC_SIZE], expect[SM3_HMAC_SIZE];
+        static const size_t msg_lens[] = { 0, 1, 55, 56, 63, 64, 119, 120, 1000 };
+        size_t bad = 0;
+        for (int k = 0; k < 21; k++) {
+            unsigned char kb[70];
+            for (int b = 0; b < 70; b++) kb[b] = (unsigned char)rand();
+            hmac_sm3_key_init(&mk[k], kb, (size_t)(k * 7) % 71);
+            mkp[k] = &mk[k];
+        }
+        for (size_t m = 0; m < sizeof(msg_lens) / sizeof(msg_lens[0]); m++) {
+            unsigned char* msg = generate_random_input(msg_lens[m] + 1);
+            for (size_t nk = 1; nk <= 21; nk += 4) {
+                hmac_sm3_multikey(mkp, nk, msg, msg_lens[m], macs);
+                for (size_t k = 0; k < nk; k++) {
+                    hmac_sm3_mac(mkp[k], msg, msg_lens[m], expect);
+                    bad += !hash_equal(expect, macs[k]);
+                }
+            }
+            free(msg);
+        }
+        printf("  多密钥同消息：%s\n", bad == 0 ? "通过" : "失败");
+        pass &= bad == 0;
+    }
+
+    printf("  结论：%s\n", pass ? "通过" : "失败");
+    printf("========================================================================\n\n");
+}
+
+// -------------------------- 扩展测试：SM2密钥派生函数 --------------------------
+// 参考值为派生结果的SM3摘要（Python hashlib sm3逐计数器计算）；
+// 各种Z长度（计数器落在分组内不同位置、跨分组）与输出长度下与逐计数器计算一致
+static void kdf_sm3_naive(const unsigned char* z, size_t zlen, unsigned char* key, size_t klen) {
+    for (uint32_t ct = 1; (size_t)(ct - 1) * SM3_DIGEST_SIZE < klen; ct++) {
+        unsigned char c[4] = { (unsigned char)(ct >> 24), (unsigned char)(ct >> 16), (unsigned char)(ct >> 8), (unsigned char)ct };
+        unsigned char digest[SM3_DIGEST_SIZE];
+        SM3_CTX ctx;
+        size_t off = (size_t)(ct - 1) * SM3_DIGEST_SIZE;
+        sm3_init(&ctx);
+        sm3_update(&ctx, z, zlen);
+        sm3_update(&ctx, c, 4);
+        sm3_final(&ctx, digest);
+        memcpy(key + off, digest, klen - off < SM3_DIGEST_SIZE ? klen - off : SM3_DIGEST_SIZE);
+    }
+}
+
+static void kdf_test() {
+    printf("=== 十一、密钥派生函数测试（SM2 KDF / PBKDF2 / HKDF） ===\n");
+
+    static const struct {
+        size_t zlen;          // Z为 0,1,2,...（"abc"用例单独给出）
+        size_t klen;
+        const char* expect;   // SM3(KDF(Z, klen))
+    } vectors[] = {
+        { 3, 19, "fec455d03e32a38f27f171e173c20417acb1bde65f9ae81ef0f5af448925d4e6" },
+        { 64, 1000, "b92e9d653106dfd0848ad4c42fa99498dcbe88a9bb18b5f67c85ce8a7561d9cb" },
+        { 58, 333, "6631d750bda6a97be740e629d734436aa2779496ba464970f73668adc3f4f00d" },
+    };
+    unsigned char z[200], key[1000], ref[1000], digest[SM3_DIGEST_SIZE];
+    int pass = 1;
+
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+        if (i == 0) memcpy(z, "abc", 3);
+        else for (size_t b = 0; b < vectors[i].zlen; b++) z[b] = (unsigned char)b;
+        int ok = sm3_kdf(z, vectors[i].zlen, key, vectors[i].klen) == 0;
+        sm3_hash(key, vectors[i].klen, digest);
+        ok &= strcmp(sm3_hash_to_string(digest), vectors[i].expect) == 0;
+        printf("  用例%zu（|Z|=%zu，klen=%zu）：%s\n", i + 1, vectors[i].zlen, vectors[i].klen, ok ? "通过" : "失败");
+        pass &= ok;
+    }
+
+    // Z长度0~199覆盖计数器在尾部分组中的全部位置；输出长度覆盖单个摘要、截断与不足8路的批次
+    srand(2029);
+    for (size_t b = 0; b < sizeof(z); b++) z[b] = (unsigned char)rand();
+    int mismatch = 0;
+    for (size_t zlen = 0; zlen < sizeof(z); zlen++) {
+        size_t klen = zlen % 5 == 0 ? 32 : 1 + (size_t)rand() % sizeof(key);
+        sm3_kdf(z, zlen, key, klen);
+        kdf_sm3_naive(z, zlen, ref, klen);
+        mismatch += memcmp(key, ref, klen) != 0;
+    }
+
+    // 分段吸收Z的上下文接口
+    {
+        SM3_CTX zctx;
+        sm3_init(&zctx);
+        sm3_update(&zctx, z, 64);
+        sm3_update(&zctx, z + 64, 64);
+        sm3_kdf_ctx(&zctx, key, 257);
+        kdf_sm3_naive(z, 128, ref, 257);
+        mismatch += memcmp(key, ref, 257) != 0;
+    }
+    printf("  随机比对：不一致%d次\n", mismatch);
+    pass &= mismatch == 0;
+
+    // PBKDF2-HMAC-SM3：参考值由Python hashlib.pbkdf2_hmac('sm3', ...)计算
+    static const struct {
+        const char* pass;
+        const char* salt;
+        uint32_t iter;
+        size_t klen;
+        const char* expect;   // klen超过32字节时为前32字节
+    } pbkdf2_vectors[] = {
+        { "password", "salt", 1, 32, "4612f922a1fdcefaf4312fc6f8f3322b489cbf24f2ea361b44c2bd8fa2c6dcb0" },
+        { "password", "salt", 1000, 100, "e8b635a41dfe5aaab7cf828cff6f3608e22cac59ba16edd70e000b293d00bc91" },
+        { "passwordPASSWORDpassword", "saltSALTsaltSALTsaltSALTsaltSALTsalt", 4096, 40,
+          "3b6282ac8519f059e465abff0ea37b0dbfe6c672a76e6b805312d53900db6307" },
+    };
+    for (size_t i = 0; i < sizeof(pbkdf2_vectors) / sizeof(pbkdf2_vectors[0]); i++) {
+        int ok = sm3_pbkdf2((const unsigned char*)pbkdf2_vectors[i].pass, strlen(pbkdf2_vectors[i].pass),
+            (const unsigned char*)pbkdf2_vectors[i].salt, strlen(pbkdf2_vectors[i].salt),
+            pbkdf2_vectors[i].iter, key, pbkdf2_vectors[i].klen) == 0;
+        ok &= strcmp(sm3_hash_to_string(key), pbkdf2_vectors[i].expect) == 0;
+        printf("  PBKDF2用例%zu（c=%u，dkLen=%zu）：%s\n", i + 1, pbkdf2_vectors[i].iter, pbkdf2_vectors[i].klen, ok ? "通过" : "失败");
+        pass &= ok;
+    }
+    {
+        // 用例2的最后一块只取4字节
+        static const unsigned char tail[4] = { 0xb4, 0xc4, 0xfc, 0x8c };
+        int ok = memcmp(key + 96, tail, 4) == 0 && sm3_pbkdf2(z, 1, z, 1, 0, key, 32) == -1;
+        pass &= ok;
+    }
+
+    // 批量接口：口令长度跨越分组长度，输出块数不是通道数的整数倍，结果与逐个派生一致
+    {
+        const unsigned char* passes[11];
+        const unsigned char* salts[11];
+        size_t pass_lens[11], salt_lens[11];
+        unsigned char* outs[11];
+        unsigned char (*bufs)[70] = (unsigned char (*)[70])malloc(11 * 70);
+        int bad = bufs == NULL;
+        for (int i = 0; i < 11 && !bad; i++) {
+            passes[i] = z + i * 9;
+            pass_lens[i] = (size_t)(i * 13) % 90;
+            salts[i] = z + 100 + i;
+            salt_lens[i] = (size_t)i * 7;
+            outs[i] = bufs[i];
+        }
+        if (!bad) {
+            bad |= sm3_pbkdf2_many(passes, pass_lens, salts, salt_lens, 11, 37, outs, 70) != 0;
+            for (int i = 0; i < 11; i++) {
+                sm3_pbkdf2(passes[i], pass_lens[i], salts[i], salt_lens[i], 37, ref, 70);
+                bad |= memcmp(ref, outs[i], 70) != 0;
+            }
+        }
+        free(bufs);
+        printf("  PBKDF2批量派生：%s\n", bad ? "失败" : "通过");
+        pass &= !bad;
+    }
+
+    // HKDF-SM3：RFC 5869用例1~3的输入，参考值由Python hmac（sm3）计算
+    {
+        unsigned char ikm[80], salt[80], info[80], prk[SM3_DIGEST_SIZE], okm[82];
+        static const char* prk_expect[3] = {
+            "e0d6f7b0bd056327b7659f1f39ad850561fbcf4fb10fb58e88eafa55cf7cd01e",
+            "1a43a7fedb2d111eb33babd0d256c272aa3262cdb12e6b43d4321ae8888485d5",
+            "004fc37143377d072d74e82ff480e8d7937ec607411bc1ec65dd34401871ff9c",
+        };
+        static const char* okm_expect[3] = {      // OKM的前32字节
+            "c69fe91b7aaee2dd5718d72dcaee0cce93f1b8e41f792da51261b6a517e68b36",
+            "c1226236bbdefa7921f9febe27b864f33e449201b436d8844ea53f58170dd642",
+            "c8c91a38ae2fb3b023a7c38ce9f0748f28230d59b6b950ba3ba949bf0d713a57",
+        };
+        static const size_t sizes[3][4] = { { 22, 13, 10, 42 }, { 80, 80, 80, 82 }, { 22, 0, 0, 42 } };
+        for (int c = 0; c < 3; c++) {
+            for (int b = 0; b < 80; b++) {
+                ikm[b] = c == 1 ? (unsigned char)b : 0x0b;
+                salt[b] = (unsigned char)(c == 1 ? 0x60 + b : b);
+                info[b] = (unsigned char)(c == 1 ? 0xb0 + b : 0xf0 + b);
+            }
+            sm3_hkdf_extract(salt, sizes[c][1], ikm, sizes[c][0], prk);
+            int ok = strcmp(sm3_hash_to_string(prk), prk_expect[c]) == 0;
+            ok &= sm3_hkdf(salt, sizes[c][1], ikm, sizes[c][0], info, sizes[c][2], okm, sizes[c][3]) == 0;
+            ok &= strcmp(sm3_hash_to_string(okm), okm_expect[c]) == 0;
+            printf("  HKDF用例%d：%s\n", c + 1, ok ? "通过" : "失败");
+            pass &= ok;
+        }
+        pass &= sm3_hkdf(NULL, 0, ikm, 1, NULL, 0, okm, SM3_HKDF_MAX_OUT + 1) == -1;
+    }
+
+    // TLS 1.3 HKDF-Expand-Label，批量标签与逐个派生一致
+    {
+        SM3_HMAC_KEY secret;
+        unsigned char th[SM3_DIGEST_SIZE], out[6][100], ref_out[100];
+        unsigned char* outs[6];
+        static const char* labels[6] = { "c hs traffic", "s hs traffic", "key", "iv", "finished", "exp master" };
+        static const size_t out_lens[6] = { 32, 32, 16, 12, 32, 100 };
+        int ok;
+        for (int b = 0; b < SM3_DIGEST_SIZE; b++) ref[b] = (unsigned char)b;
+        sm3_hkdf_prk_init(&secret, ref, SM3_DIGEST_SIZE);
+        sm3_str_hash("hello", th);
+        ok = sm3_hkdf_expand_label(&secret, "c hs traffic", th, sizeof(th), out[0], 32) == 0;
+        ok &= strcmp(sm3_hash_to_string(out[0]), "92beaaa8bd5571c179214f5284bb3e28752acbebea1752d015806e300f1a690b") == 0;
+        ok &= sm3_hkdf_expand_label(&secret, "key", NULL, 0, out[0], 16) == 0;
+        ok &= strncmp(sm3_hash_to_string(out[0]), "61239cba001ad7626f97e79fe461368f", 32) == 0;
+        for (int j = 0; j < 6; j++) outs[j] = out[j];
+        ok &= sm3_hkdf_expand_label_many(&secret, labels, th, sizeof(th), 6, outs, out_lens) == 0;
+        for (int j = 0; j < 6; j++) {
+            sm3_hkdf_expand_label(&secret, labels[j], th, sizeof(th), ref_out, out_lens[j]);
+            ok &= memcmp(ref_out, out[j], out_lens[j]) == 0;
+        }
+        hmac_sm3_key_clear(&secret);
+        printf("  HKDF-Expand-Label（单个/批量）：%s\n", ok ? "通过" : "失败");
+        pass &= ok;
+    }
+
+    printf("  结论：%s\n", pass ? "通过" : "失败");
+    printf("========================================================================\n\n");
+}
+
+// -------------------------- 扩展测试：SM2身份杂凑值与ZA缓存 --------------------------
+// 参考值为Python hashlib sm3对 ENTL || ID || a || b || xG || yG || xA || yA 的计算结果
+static void sm2_za_naive(const unsigned char* uid, size_t uid_len, const unsigned char* pub, unsigned char za[SM3_DIGEST_SIZE]) {
+    static const char* curve_hex =
+        "FFFFFFFEFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF00000000FFFFFFFFFFFFFFFC"
+        "28E9FA9E9D9F5E344D5A9E4BCF6509A7F39789F515AB8F92DDBCBD414D940E93"
+        "32C4AE2C1F1981195F9904466A39C9948FE30BBFF2660BE1715A4589334C74C7"
+        "BC3736A2F4F6779C59BDCEE36B692153D0A9877CC62A474002DF32E52139F0A0";
+    unsigned char curve[128], entl[2] = { (unsigned char)((uid_len * 8) >> 8), (unsigned char)(uid_len * 8) };
+    SM3_CTX ctx;
+    for (int i = 0; i < 128; i++) {
+        unsigned int v;
+        sscanf(curve_hex + 2 * i, "%2x", &v);
+        curve[i] = (unsigned char)v;
+    }
+    sm3_init(&ctx);
+    sm3_update(&ctx, entl, 2);
+    sm3_update(&ctx, uid, uid_len);
+    sm3_update(&ctx, curve, sizeof(curve));
+    sm3_update(&ctx, pub, SM3_SM2_PUBKEY_SIZE);
+    sm3_final(&ctx, za);
+}
+
+static void sm2_test() {
+    printf("=== 十二、SM2身份杂凑值与ZA缓存测试 ===\n");
+    const unsigned char* did = (const unsigned char*)SM3_SM2_DEFAULT_ID;
+    unsigned char pub[SM3_SM2_PUBKEY_SIZE], za[SM3_DIGEST_SIZE], e[SM3_DIGEST_SIZE], ref[SM3_DIGEST_SIZE];
+    int pass = 1;
+
+    for (int i = 0; i < SM3_SM2_PUBKEY_SIZE; i++) pub[i] = (unsigned char)i;
+    {
+        int ok = sm3_sm2_za(did, SM3_SM2_DEFAULT_ID_LEN, pub, za) == 0;
+        ok &= strcmp(sm3_hash_to_string(za), "459643600e605c2de66ce84e5106971c10ddb41f082550f94504746c83c3d086") == 0;
+        sm3_sm2_digest(za, (const unsigned char*)"message digest", 14, e);
+        ok &= strcmp(sm3_hash_to_string(e), "9cd428096f9274728d5b3f1320283388bb4379bff6ef3a08d57efd9b51d7ff27") == 0;
+        printf("  用例1（默认ID）：%s\n", ok ? "通过" : "失败");
+        pass &= ok;
+    }
+
+    // 不同ID长度（含超出缓存ID上限的长ID）与逐段计算一致；超长ID被拒绝
+    srand(2030);
+    int mismatch = 0;
+    {
+        unsigned char uid[200];
+        for (size_t b = 0; b < sizeof(uid); b++) uid[b] = (unsigned char)rand();
+        for (size_t len = 0; len < sizeof(uid); len += 7) {
+            for (int b = 0; b < SM3_SM2_PUBKEY_SIZE; b++) pub[b] = (unsigned char)rand();
+            sm3_sm2_za(uid, len, pub, za);
+            sm2_za_naive(uid, len, pub, ref);
+            mismatch += !hash_equal(za, ref);
+        }
+        mismatch += sm3_sm2_za(uid, SM3_SM2_ID_MAX + 1, pub, za) != -1;
+    }
+
+    // 缓存：300个签名者（默认ID、短ID、长ID混合）随机访问容量64的缓存，触发替换
+    {
+        SM3_SM2_CACHE* cache = sm3_sm2_cache_create(64);
+        unsigned char (*pubs)[SM3_SM2_PUBKEY_SIZE] = (unsigned char (*)[SM3_SM2_PUBKEY_SIZE])malloc(300 * SM3_SM2_PUBKEY_SIZE);
+        unsigned char uid[100];
+        uint64_t hits = 0, misses = 0;
+        int calls = 0;
+        for (size_t b = 0; b < sizeof(uid); b++) uid[b] = (unsigned char)('A' + b % 26);
+        if (cache != NULL && pubs != NULL) {
+            for (int s = 0; s < 300; s++) {
+                for (int b = 0; b < SM3_SM2_PUBKEY_SIZE; b++) pubs[s][b] = (unsigned char)rand();
+            }
+            for (int r = 0; r < 5000; r++) {
+                int s = (r % 2 == 0) ? r % 16 : rand() % 300;     // 前16个签名者为热点
+                const unsigned char* id = s % 3 == 0 ? did : uid;
+                size_t id_len = s % 3 == 0 ? SM3_SM2_DEFAULT_ID_LEN : (s % 3 == 1 ? 5 : 100);
+                int ret = sm3_sm2_cache_digest(cache, id, id_len, pubs[s], uid, (size_t)r % 100, e);
+                sm2_za_naive(id, id_len, pubs[s], ref);
+                sm3_sm2_digest(ref, uid, (size_t)r % 100, ref);
+                mismatch += ret < 0 || !hash_equal(e, ref);
+                if (id_len <= SM3_SM2_CACHE_ID_MAX) calls++;
+            }
+            sm3_sm2_cache_stats(cache, &hits, &misses);
+            mismatch += hits + misses != (uint64_t)calls;
+            mismatch += hits == 0;
+            printf("  缓存命中%llu次，未命中%llu次\n", (unsigned long long)hits, (unsigned long long)misses);
+        }
+        else {
+            mismatch++;
+        }
+        sm3_sm2_cache_destroy(cache);
+
+        // 容量足够时第二遍全部命中
+        cache = sm3_sm2_cache_create(4096);
+        if (cache != NULL && pubs != NULL) {
+            int second = 0;
+            for (int pass2 = 0; pass2 < 2; pass2++) {
+                for (int s = 0; s < 300; s++) {
+                    int ret = sm3_sm2_cache_za(cache, did, SM3_SM2_DEFAULT_ID_LEN, pubs[s], za);
+                    if (pass2 == 1) second += ret == 1;
+                }
+            }
+            mismatch += second != 300;
+        }
+        sm3_sm2_cache_destroy(cache);
+        free(pubs);
+    }
+
+    // 批量消息摘要
+    {
+        unsigned char zas[20][SM3_DIGEST_SIZE], es[20][SM3_DIGEST_SIZE];
+        const unsigned char* msgs[20];
+        size_t lens[20];
+        for (int i = 0; i < 20; i++) {
+            for (int b = 0; b < SM3_DIGEST_SIZE; b++) zas[i][b] = (unsigned char)rand();
+            lens[i] = (size_t)rand() % 200;
+            msgs[i] = generate_random_input(lens[i] + 1);
+        }
+        sm3_sm2_digest_many((const unsigned char (*)[SM3_DIGEST_SIZE])zas, msgs, lens, 20, es);
+        for (int i = 0; i < 20; i++) {
+            sm3_sm2_digest(zas[i], msgs[i], lens[i], e);
+            mismatch += !hash_equal(e, es[i]);
+            free((void*)msgs[i]);
+        }
+    }
+    printf("  随机比对：不一致%d次\n", mismatch);
+    pass &= mismatch == 0;
+
+    printf("  结论：%s\n", pass ? "通过" : "失败");
+    printf("========================================================================\n\n");
+}
+
+// -------------------------- 扩展测试：SM3 Hash_DRBG --------------------------
+// 参考值由按SP 800-90A 10.1.1逐步实现的Python脚本（hashlib sm3）计算
+static void drbg_test() {
+    printf("=== 十三、SM3 Hash_DRBG测试 ===\n");
+    unsigned char entropy[32], nonce[16], out[1000], digest[SM3_DIGEST_SIZE];
+    SM3_DRBG drbg, drbg2;
+    int pass = 1, ok;
+
+    for (int i = 0; i < 32; i++) entropy[i] = (unsigned char)i;
+    for (int i = 0; i < 16; i++) nonce[i] = (unsigned char)(100 + i);
+    sm3_drbg_init(&drbg, entropy, 32, nonce, 16, (const unsigned char*)"sm3 drbg test", 13);
+    ok = sm3_drbg_generate(&drbg, out, 1000, NULL, 0) == 0;
+    sm3_hash(out, 1000, digest);
+    ok &= strcmp(sm3_hash_to_string(digest), "13a1f2fa7cdd33b24829abd0fa53c2deca17599325b5f2134742955978ec2762") == 0;
+    ok &= sm3_drbg_generate(&drbg, out, 77, (const unsigned char*)"additional", 10) == 0;
+    sm3_hash(out, 77, digest);
+    ok &= strcmp(sm3_hash_to_string(digest), "2418294829198d6f2ac753c2ccfa860fee609eacf75ebbd553a1b038a00b6784") == 0;
+    for (int i = 0; i < 32; i++) entropy[i] = (unsigned char)(200 + i);
+    sm3_drbg_reseed(&drbg, entropy, 32, (const unsigned char*)"reseed", 6);
+    ok &= sm3_drbg_generate(&drbg, out, 32, NULL, 0) == 0;
+    ok &= strcmp(sm3_hash_to_string(out), "b0ca714d3411a870de501e15cd233c6e28a533fe87f6b802cd4bda43deb1d254") == 0;
+    ok &= sm3_drbg_generate(&drbg, out, SM3_DRBG_MAX_REQUEST + 1, NULL, 0) == -1;
+    printf("  标准流程（实例化/附加输入/重播种）：%s\n", ok ? "通过" : "失败");
+    pass &= ok;
+
+    // 缓冲读取：任意分段方式拼起来等于按缓冲区大小整块generate的输出
+    {
+        unsigned char* a = (unsigned char*)malloc(3 * SM3_DRBG_BUF_SIZE);
+        unsigned char* b = (unsigned char*)malloc(3 * SM3_DRBG_BUF_SIZE);
+        ok = a != NULL && b != NULL;
+        if (ok) {
+            sm3_drbg_init(&drbg, entropy, 32, NULL, 0, NULL, 0);
+            sm3_drbg_init(&drbg2, entropy, 32, NULL, 0, NULL, 0);
+            for (int i = 0; i < 3; i++) sm3_drbg_generate(&drbg, a + i * SM3_DRBG_BUF_SIZE, SM3_DRBG_BUF_SIZE, NULL, 0);
+            srand(2031);
+            for (size_t done = 0; done < 3 * SM3_DRBG_BUF_SIZE;) {
+                size_t n = (size_t)rand() % 700;
+                if (n > 3 * SM3_DRBG_BUF_SIZE - done) n = 3 * SM3_DRBG_BUF_SIZE - done;
+                ok &= sm3_drbg_read(&drbg2, b + done, n) == 0;
+                done += n;
+            }
+            ok &= memcmp(a, b, 3 * SM3_DRBG_BUF_SIZE) == 0;
+        }
+        free(a);
+        free(b);
+        printf("  缓冲读取：%s\n", ok ? "通过" : "失败");
+        pass &= ok;
+    }
+
+    // 达到重播种间隔后拒绝输出
+    drbg.reseed_counter = SM3_DRBG_RESEED_INTERVAL + 1;
+    ok = sm3_drbg_generate(&drbg, out, 32, NULL, 0) == SM3_DRBG_NEED_RESEED;
+    sm3_drbg_reseed(&drbg, entropy, 32, NULL, 0);
+    ok &= sm3_drbg_generate(&drbg, out, 32, NULL, 0) == 0;
+    sm3_drbg_clear(&drbg);
+    sm3_drbg_clear(&drbg2);
+
+    // 线程本地生成器：两次输出不同
+    {
+        unsigned char r1[64], r2[64];
+        ok &= sm3_random_bytes(r1, sizeof(r1)) == 0 && sm3_random_bytes(r2, sizeof(r2)) == 0;
+        ok &= memcmp(r1, r2, sizeof(r1)) != 0;
+    }
+    printf("  重播种间隔与线程本地生成器：%s\n", ok ? "通过" : "失败");
+    pass &= ok;
+
+#ifndef _WIN32
+    // fork后父子进程的线程本地生成器输出不同（父进程已播种，子进程继承了同一状态）
+    {
+        unsigned char r1[64], r2[64];
+        int fds[2];
+        pid_t child;
+        ok = sm3_random_bytes(r1, sizeof(r1)) == 0 && pipe(fds) == 0;
+        if (ok && (child = fork()) == 0) {
+            close(fds[0]);
+            int wr = sm3_random_bytes(r2, sizeof(r2)) == 0 && write(fds[1], r2, sizeof(r2)) == (ssize_t)sizeof(r2);
+            _exit(wr ? 0 : 1);
+        }
+        if (ok) {
+            close(fds[1]);
+            ok = child > 0 && read(fds[0], r2, sizeof(r2)) == (ssize_t)sizeof(r2);
+            ok &= sm3_random_bytes(r1, sizeof(r1)) == 0;
+            ok &= memcmp(r1, r2, sizeof(r1)) != 0;
+            close(fds[0]);
+            if (child > 0) {
+                int status;
+                ok &= waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+            }
+        }
+        printf("  fork后重新播种：%s\n", ok ? "通过" : "失败");
+        pass &= ok;
+    }
+#endif
+
+    printf("  结论：%s\n", pass ? "通过" : "失败");
+    printf("========================================================================\n\n");
+}
+
+// -------------------------- 扩展测试：SM3哈希链 --------------------------
+// 参考值为Python hashlib sm3从SM3("abc")出发连续迭代1000次的结果
+static void chain_test() {
+    printf("=== 十四、SM3哈希链测试 ===\n");
+    unsigned char seed[SM3_DIGEST_SIZE], out[SM3_DIGEST_SIZE], ref[SM3_DIGEST_SIZE];
+    int pass = 1, ok;
+
+    sm3_str_hash("abc", seed);
+    sm3_chain_iterate(seed, 1000, out);
+    ok = strcmp(sm3_hash_to_string(out), "7a102236b59f505509b066c8e5c8e8bdcd495c7cc402f9dc06b47f6e3ee26cb0") == 0;
+    memcpy(ref, seed, SM3_DIGEST_SIZE);
+    for (int i = 0; i < 1000; i++) sm3_hash(ref, SM3_DIGEST_SIZE, ref);
+    ok &= hash_equal(out, ref);
+    sm3_chain_iterate(seed, 0, out);
+    ok &= hash_equal(out, seed);
+    printf("  SM3^1000(SM3(\"abc\"))：%s\n", ok ? "通过" : "失败");
+    pass &= ok;
+
+    // 多路迭代（条数不是通道数的整数倍）与校验
+    {
+        unsigned char seeds[19][SM3_DIGEST_SIZE], outs[19][SM3_DIGEST_SIZE], xs[19][SM3_DIGEST_SIZE];
+        uint64_t steps[19];
+        unsigned char* s = generate_random_input(sizeof(seeds));
+        int bad = s == NULL;
+        if (s != NULL) memcpy(seeds, s, sizeof(seeds));
+        free(s);
+        for (size_t count = 1; count <= 19 && !bad; count += 6) {
+            sm3_chain_iterate_many((const unsigned char (*)[SM3_DIGEST_SIZE])seeds, count, 37, outs);
+            for (size_t i = 0; i < count; i++) {
+                sm3_chain_iterate(seeds[i], 37, out);
+                bad += !hash_equal(out, outs[i]);
+            }
+        }
+        // 候选值为锚点往前第1~19步的元素，第5条被篡改
+        for (size_t i = 0; i < 19; i++) sm3_chain_iterate(seeds[i], 37 - (i + 1), xs[i]);
+        xs[5][0] ^= 1;
+        size_t valid = sm3_chain_verify_many((const unsigned char (*)[SM3_DIGEST_SIZE])outs,
+            (const unsigned char (*)[SM3_DIGEST_SIZE])xs, 19, 20, steps);
+        bad += valid != 18;
+        for (size_t i = 0; i < 19; i++) bad += steps[i] != (i == 5 ? 0 : i + 1);
+        bad += sm3_chain_verify(outs[3], xs[3], 4) != 4 || sm3_chain_verify(outs[3], xs[3], 3) != 0;
+        printf("  多路迭代与校验：%s\n", bad == 0 ? "通过" : "失败");
+        pass &= bad == 0;
+    }
+
+    // 逆序遍历：与整条链逐个比对，检查点栈深度不超过log2(n)+2
+    {
+        static const uint64_t ns[] = { 1, 2, 3, 64, 1000, 4097 };
+        unsigned char (*chain)[SM3_DIGEST_SIZE] = (unsigned char (*)[SM3_DIGEST_SIZE])malloc(4098 * SM3_DIGEST_SIZE);
+        SM3_CHAIN_WALK walk;
+        int bad = chain == NULL;
+        for (size_t c = 0; c < sizeof(ns) / sizeof(ns[0]) && !bad; c++) {
+            uint64_t n = ns[c], pos, expect = n, outputs = 0;
+            int max_top = 0, log2n = 0;
+            while ((1ULL << log2n) < n) log2n++;
+            sm3_chain_generate(seed, n, chain);
+            sm3_chain_walk_init(&walk, seed, n);
+            bad += !hash_equal(walk.anchor, chain[n]);
+            while (sm3_chain_walk_next(&walk, out, &pos)) {
+                bad += pos != --expect || !hash_equal(out, chain[pos]);
+                if (walk.top + 1 > max_top) max_top = walk.top + 1;
+                outputs++;
+            }
+            bad += outputs != n || max_top > log2n + 2;
+            sm3_chain_walk_clear(&walk);
+        }
+        bad += sm3_chain_walk_init(&walk, seed, 0) != -1;
+        free(chain);
+        printf("  检查点逆序遍历：%s\n", bad == 0 ? "通过" : "失败");
+        pass &= bad == 0;
+    }
+
+    printf("  结论：%s\n", pass ? "通过" : "失败");
+    printf("========================================================================\n\n");
+}
+
+// -------------------------- 扩展测试：WOTS+ / XMSS签名 --------------------------
+static void xmss_test() {
+    printf("=== 十五、WOTS+ / XMSS哈希签名测试 ===\n");
+    unsigned char seed[SM3_XMSS_SEED_SIZE], pk[SM3_XMSS_PK_SIZE], digest[SM3_DIGEST_SIZE];
+    unsigned char wpk[SM3_DIGEST_SIZE], rpk[SM3_DIGEST_SIZE], ref[SM3_DIGEST_SIZE];
+    unsigned char* wsig = (unsigned char*)malloc(SM3_WOTS_SIG_SIZE);
+    unsigned char* r = generate_random_input(sizeof(seed));
+    int pass = wsig != NULL && r != NULL, ok;
+    if (!pass) {
+        free(wsig);
+        free(r);
+        printf("  结论：失败（内存不足）\n");
+        return;
+    }
+    memcpy(seed, r, sizeof(seed));
+    free(r);
+
+    // WOTS+：第一条链的私钥元素 = SM3(PK.seed || 0^32 || ADRS(PRF, 叶子3, 链0) || SK.seed)，全零摘要时签名即私钥元素
+    {
+        unsigned char msg[SM3_BLOCK_SIZE + 32 + SM3_DIGEST_SIZE] = { 0 };
+        memcpy(msg, seed + 2 * SM3_DIGEST_SIZE, SM3_DIGEST_SIZE);
+        msg[SM3_BLOCK_SIZE + 19] = 5;
+        msg[SM3_BLOCK_SIZE + 23] = 3;
+        memcpy(msg + SM3_BLOCK_SIZE + 32, seed, SM3_DIGEST_SIZE);
+        sm3_hash(msg, sizeof(msg), ref);
+        memset(digest, 0, sizeof(digest));
+        sm3_wots_sign(seed, seed + 2 * SM3_DIGEST_SIZE, 3, digest, wsig);
+        ok = hash_equal(wsig, ref);
+        sm3_str_hash("wots", digest);
+        sm3_wots_public_key(seed, seed + 2 * SM3_DIGEST_SIZE, 3, wpk);
+        sm3_wots_sign(seed, seed + 2 * SM3_DIGEST_SIZE, 3, digest, wsig);
+        sm3_wots_pk_from_sig(seed + 2 * SM3_DIGEST_SIZE, 3, digest, wsig, rpk);
+        ok &= hash_equal(wpk, rpk);
+        digest[0] ^= 1;
+        sm3_wots_pk_from_sig(seed + 2 * SM3_DIGEST_SIZE, 3, digest, wsig, rpk);
+        ok &= !hash_equal(wpk, rpk);
+        printf("  WOTS+签名与公钥恢复：%s\n", ok ? "通过" : "失败");
+        pass &= ok;
+    }
+
+    // XMSS：线程池与单线程生成的树一致，叶子即WOTS+公钥
+    {
+        const unsigned int h = 8;
+        SM3_XMSS_KEY key, key2;
+        SM3_POOL* pool = sm3_pool_create(4, 64 * 1024);
+        unsigned char* sig = (unsigned char*)malloc(SM3_XMSS_SIG_SIZE(h));
+        const char* msg = "XMSS message";
+        int bad = pool == NULL || sig == NULL;
+        bad += sm3_xmss_keygen(&key, h, seed, pool) != 0;
+        bad += sm3_xmss_keygen(&key2, h, seed, NULL) != 0;
+        if (bad == 0) {
+            bad += !hash_equal(key.root, key2.root);
+            bad += !hash_equal(key.nodes[(1u << h) + 3], wpk);
+            sm3_xmss_public_key(&key, pk);
+
+            for (int i = 0; i < 3; i++) {
+                bad += sm3_xmss_sign(&key, (const unsigned char*)msg, strlen(msg), sig) != 0;
+                bad += sm3_xmss_verify(pk, h, (const unsigned char*)msg, strlen(msg), sig) != 1;
+            }
+            bad += key.next_index != 3;
+            bad += sm3_xmss_verify(pk, h, (const unsigned char*)msg, strlen(msg) - 1, sig) != 0;
+            sig[4 + SM3_DIGEST_SIZE + 100] ^= 1;
+            bad += sm3_xmss_verify(pk, h, (const unsigned char*)msg, strlen(msg), sig) != 0;
+            sig[4 + SM3_DIGEST_SIZE + 100] ^= 1;
+            sig[SM3_XMSS_SIG_SIZE(h) - 1] ^= 1;
+            bad += sm3_xmss_verify(pk, h, (const unsigned char*)msg, strlen(msg), sig) != 0;
+            sig[SM3_XMSS_SIG_SIZE(h) - 1] ^= 1;
+            sig[3] ^= 1;
+            bad += sm3_xmss_verify(pk, h, (const unsigned char*)msg, strlen(msg), sig) != 0;
+
+            // 用尽全部叶子
+            key2.next_index = (1u << h) - 1;
+            bad += sm3_xmss_sign(&key2, (const unsigned char*)msg, strlen(msg), sig) != 0;
+            bad += sm3_xmss_verify(pk, h, (const unsigned char*)msg, strlen(msg), sig) != 1;
+            bad += sm3_xmss_sign(&key2, (const unsigned char*)msg, strlen(msg), sig) != -1;
+        }
+        bad += sm3_xmss_keygen(&key2, 0, seed, NULL) != -1;
+        printf("  XMSS（h=%u）密钥生成、签名与验证：%s\n", h, bad == 0 ? "通过" : "失败");
+        pass &= bad == 0;
+        sm3_xmss_free(&key);
+        sm3_xmss_free(&key2);
+        if (pool != NULL) sm3_pool_destroy(pool);
+        free(sig);
+    }
+
+    free(wsig);
+    printf("  结论：%s\n", pass ? "通过" : "失败");
+    printf("========================================================================\n\n");
+}
+
+// -------------------------- 扩展测试：工作量证明搜索 --------------------------
+static void pow_test() {
+    printf("=== 十六、SM3工作量证明搜索测试 ===\n");
+    // 不同nonce位置：首分组起始、跨字边界、分组末尾、中间分组（其后还有固定分组）
+    static const struct { size_t len, pos; unsigned int nonce_len; } cases[] = {
+        { 40, 0, 8 }, { 100, 13, 8 }, { 64, 56, 8 }, { 200, 70, 4 }, { 119, 111, 8 }, { 30, 27, 3 }
+    };
+    unsigned char* msg = generate_random_input(256);
+    unsigned char target[SM3_DIGEST_SIZE], digest[SM3_DIGEST_SIZE], ref[SM3_DIGEST_SIZE];
+    SM3_POOL* pool = sm3_pool_create(4, 64 * 1024);
+    int pass = msg != NULL && pool != NULL;
+
+    sm3_pow_target_bits(12, target);
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]) && pass; c++) {
+        SM3_POW pow;
+        uint64_t nonce = 0, nonce2 = 0, expect = 0;
+        unsigned int nl = cases[c].nonce_len;
+        int bad = sm3_pow_init(&pow, msg, cases[c].len, cases[c].pos, nl, target) != 0;
+
+        // 逐个nonce用sm3_hash求最小解作为参考
+        for (uint64_t n = 1000;; n++) {
+            for (unsigned int i = 0; i < nl; i++) msg[cases[c].pos + i] = (unsigned char)(n >> (8 * (nl - 1 - i)));
+            sm3_hash(msg, cases[c].len, ref);
+            if (sm3_pow_meets(ref, target)) {
+                expect = n;
+                break;
+            }
+        }
+        bad += sm3_pow_search(&pow, 1000, 1 << 20, NULL, &nonce, digest) != 1;
+        bad += nonce != expect || !hash_equal(digest, ref);
+        bad += sm3_pow_search(&pow, 1000, 1 << 20, pool, &nonce2, NULL) != 1 || nonce2 != expect;
+        bad += sm3_pow_check(&pow, expect, digest) != 1 || !hash_equal(digest, ref);
+        bad += sm3_pow_check(&pow, expect - 1, NULL) != 0;
+        // 区间内无解
+        bad += sm3_pow_search(&pow, 1000, expect - 1000, pool, &nonce, NULL) != 0;
+        printf("  消息%3zu字节，nonce位于%3zu（%u字节）：最小解%llu %s\n", cases[c].len, cases[c].pos, nl,
+            (unsigned long long)expect, bad == 0 ? "通过" : "失败");
+        pass &= bad == 0;
+        sm3_pow_free(&pow);
+    }
+
+    // 参数检查：nonce跨越分组边界、越出消息
+    if (pass) {
+        SM3_POW pow;
+        int bad = sm3_pow_init(&pow, msg, 100, 60, 8, target) != -1;
+        bad += sm3_pow_init(&pow, msg, 100, 96, 8, target) != -1;
+        bad += sm3_pow_init(&pow, msg, 100, 0, 9, target) != -1;
+        printf("  参数检查：%s\n", bad == 0 ? "通过" : "失败");
+        pass &= bad == 0;
+    }
+
+    free(msg);
+    if (pool != NULL) sm3_pool_destroy(pool);
+    printf("  结论：%s\n", pass ? "通过" : "失败");
+    printf("========================================================================\n\n");
+}
+
+// 多线程共享同一缓存：各线程按偏斜分布访问相同的标识符集合
+typedef struct {
+    SM3_MEMO* memo;
+    int seed;
+    int mismatch;
+} MEMO_THREAD_ARG;
+
+static void memo_thread(SM3_POOL_WORKER* worker, void* arg) {
+    MEMO_THREAD_ARG* a = (MEMO_THREAD_ARG*)arg;
+    char key[32];
+    unsigned char got[SM3_DIGEST_SIZE], ref[SM3_DIGEST_SIZE];
+    unsigned int x = (unsigned int)a->seed;
+    (void)worker;
+    for (int r = 0; r < 20000; r++) {
+        x = x * 1103515245u + 12345u;
+        int id = (x >> 16) % 8 == 0 ? (int)((x >> 8) % 5000) : (int)((x >> 8) % 64);
+        snprintf(key, sizeof(key), "user:%d", id);
+        sm3_memo_str_hash(a->memo, key, got);
+        sm3_str_hash(key, ref);
+        a->mismatch += !hash_equal(got, ref);
+    }
+}
+
+static void memo_test() {
+    printf("=== 十七、短输入摘要记忆缓存测试 ===\n");
+    SM3_MEMO_STATS st;
+    unsigned char got[SM3_DIGEST_SIZE], ref[SM3_DIGEST_SIZE];
+    int pass = 1;
+
+    // 偏斜访问：64个热点标识符占7/8的访问，容量256的缓存，其余5000个冷标识符触发替换
+    {
+        SM3_MEMO* memo = sm3_memo_create(256, 64);
+        char key[32];
+        int mismatch = memo == NULL, calls = 0;
+        srand(2032);
+        for (int r = 0; r < 50000 && memo != NULL; r++) {
+            int id = rand() % 8 == 0 ? rand() % 5000 : rand() % 64;
+            snprintf(key, sizeof(key), "user:%d", id);
+            int ret = sm3_memo_str_hash(memo, key, got);
+            sm3_str_hash(key, ref);
+            mismatch += ret < 0 || !hash_equal(got, ref);
+            calls++;
+        }
+        if (memo != NULL) {
+            sm3_memo_stats(memo, &st);
+            mismatch += st.hits + st.misses != (uint64_t)calls || st.bypassed != 0;
+            mismatch += st.hits < (uint64_t)calls * 3 / 4 || st.evictions == 0;
+            printf("  偏斜访问：命中%llu次，未命中%llu次，替换%llu次，命中率%.1f%%\n", (unsigned long long)st.hits,
+                (unsigned long long)st.misses, (unsigned long long)st.evictions, 100.0 * (double)st.hits / (double)calls);
+        }
+        printf("  用例1（偏斜访问）：%s\n", mismatch == 0 ? "通过" : "失败");
+        pass &= mismatch == 0;
+        sm3_memo_destroy(memo);
+    }
+
+    // 长度边界：空输入、max_len字节（缓存）、max_len+1字节（旁路）；前缀相同、长度不同的输入互不混淆
+    {
+        SM3_MEMO* memo = sm3_memo_create(64, 100);
+        unsigned char* buf = generate_random_input(101);
+        int mismatch = memo == NULL || buf == NULL;
+        static const size_t lens[] = { 0, 1, 7, 8, 9, 99, 100, 101 };
+        for (int round = 0; round < 2 && !mismatch; round++) {
+            for (size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+                int ret = sm3_memo_hash(memo, buf, lens[i], got);
+                sm3_hash(buf, lens[i], ref);
+                mismatch += !hash_equal(got, ref);
+                mismatch += ret != (round == 1 && lens[i] <= 100);
+            }
+        }
+        if (memo != NULL && !mismatch) {
+            sm3_memo_stats(memo, &st);
+            mismatch += st.hits != 7 || st.misses != 7 || st.bypassed != 2;
+            sm3_memo_clear(memo);
+            sm3_memo_stats(memo, &st);
+            mismatch += st.hits != 0 || sm3_memo_hash(memo, buf, 8, got) != 0;
+        }
+        mismatch += sm3_memo_create(64, 0) != NULL;
+        printf("  用例2（长度边界与旁路）：%s\n", mismatch == 0 ? "通过" : "失败");
+        pass &= mismatch == 0;
+        free(buf);
+        sm3_memo_destroy(memo);
+    }
+
+    // 4个线程同时访问
+    {
+        SM3_MEMO* memo = sm3_memo_create(1024, 32);
+        SM3_POOL* pool = sm3_pool_create(4, 64 * 1024);
+        MEMO_THREAD_ARG args[4];
+        int mismatch = memo == NULL || pool == NULL;
+        for (int t = 0; t < 4 && !mismatch; t++) {
+            args[t].memo = memo;
+            args[t].seed = 100 + t;
+            args[t].mismatch = 0;
+            if (sm3_pool_submit(pool, -1, memo_thread, &args[t]) != 0) memo_thread(NULL, &args[t]);
+        }
+        if (!mismatch) {
+            sm3_pool_wait(pool);
+            for (int t = 0; t < 4; t++) mismatch += args[t].mismatch;
+            sm3_memo_stats(memo, &st);
+            mismatch += st.hits + st.misses != 4 * 20000;
+        }
+        printf("  用例3（多线程）：%s\n", mismatch == 0 ? "通过" : "失败");
+        pass &= mismatch == 0;
+        if (pool != NULL) sm3_pool_destroy(pool);
+        sm3_memo_destroy(memo);
+    }
+
+    printf("  结论：%s\n", pass ? "通过" : "失败");
+    printf("========================================================================\n\n");
+}
+
 // -------------------------- 保留原始调试测试 --------------------------
 // 简单的调试测试函数，用于快速验证SM3算法的基本功能
 static void debug_test() {
@@ -403,7 +1729,20 @@ static void print_usage(const char* program_name) {
     printf("    -test-boundary 运行边界用例测试（4组特殊场景）\n");
     printf("    -test-collision 运行抗碰撞性测试（10000组随机样本）\n");
     printf("    -test-avalanche 运行雪崩效应测试（5次比特翻转）\n");
-    printf("    -test-all     运行所有测试（标准+边界+抗碰撞+雪崩效应）\n");
+    printf("    -test-mb      运行多路并行接口一致性测试\n");
+    printf("    -test-filter  运行Bloom / Cuckoo过滤器测试\n");
+    printf("    -test-copy    运行融合复制哈希测试\n");
+    printf("    -test-tree    运行树哈希测试\n");
+    printf("    -test-pool    运行NUMA感知线程池测试\n");
+    printf("    -test-hmac    运行HMAC-SM3测试\n");
+    printf("    -test-kdf     运行密钥派生函数测试（SM2 KDF / PBKDF2 / HKDF）\n");
+    printf("    -test-sm2     运行SM2身份杂凑值与ZA缓存测试\n");
+    printf("    -test-drbg    运行SM3 Hash_DRBG测试\n");
+    printf("    -test-chain   运行SM3哈希链测试\n");
+    printf("    -test-xmss    运行WOTS+ / XMSS哈希签名测试\n");
+    printf("    -test-pow     运行SM3工作量证明搜索测试\n");
+    printf("    -test-memo    运行短输入摘要记忆缓存测试\n");
+    printf("    -test-all     运行所有测试（标准+边界+抗碰撞+雪崩效应+扩展接口）\n");
     printf("  帮助：\n");
     printf("    -h           显示此帮助信息\n");
     printf("\n示例:\n");
@@ -465,11 +1804,63 @@ int main(int argc, char* argv[]) {
     else if (strcmp(argv[1], "-test-avalanche") == 0) {
         avalanche_effect_test();
     }
+    else if (strcmp(argv[1], "-test-mb") == 0) {
+        multi_buffer_test();
+    }
+    else if (strcmp(argv[1], "-test-filter") == 0) {
+        filter_test();
+    }
+    else if (strcmp(argv[1], "-test-copy") == 0) {
+        copy_update_test();
+    }
+    else if (strcmp(argv[1], "-test-tree") == 0) {
+        tree_hash_test();
+    }
+    else if (strcmp(argv[1], "-test-pool") == 0) {
+        pool_test();
+    }
+    else if (strcmp(argv[1], "-test-hmac") == 0) {
+        hmac_test();
+    }
+    else if (strcmp(argv[1], "-test-kdf") == 0) {
+        kdf_test();
+    }
+    else if (strcmp(argv[1], "-test-sm2") == 0) {
+        sm2_test();
+    }
+    else if (strcmp(argv[1], "-test-drbg") == 0) {
+        drbg_test();
+    }
+    else if (strcmp(argv[1], "-test-chain") == 0) {
+        chain_test();
+    }
+    else if (strcmp(argv[1], "-test-xmss") == 0) {
+        xmss_test();
+    }
+    else if (strcmp(argv[1], "-test-pow") == 0) {
+        pow_test();
+    }
+    else if (strcmp(argv[1], "-test-memo") == 0) {
+        memo_test();
+    }
     else if (strcmp(argv[1], "-test-all") == 0) {
         standard_test_cases();
         boundary_test_cases();
         collision_resistance_test();
         avalanche_effect_test();
+        multi_buffer_test();
+        filter_test();
+        copy_update_test();
+        tree_hash_test();
+        pool_test();
+        hmac_test();
+        kdf_test();
+        sm2_test();
+        drbg_test();
+        chain_test();
+        xmss_test();
+        pow_test();
+        memo_test();
     }
     else if (strcmp(argv[1], "-debug") == 0) {
         debug_test();
@@ -0,0 +1,258 @@
+// sm3_hmac.c - HMAC-SM3实现
+// 外层输入固定为32字节：64字节K^opad分组之后只剩一个分组，
+// 内容为 内层摘要(32) || 0x80 || 0x00... || 消息总长768bit，直接构造后压缩，不经过sm3_update/sm3_final
+#include "sm3_hmac.h"
+#include "sm3_mb.h"
+#include <stdlib.h>
+
+#define HMAC_OUTER_BITS ((SM3_BLOCK_SIZE + SM3_DIGEST_SIZE) * 8)   // 外层消息总长（768bit）
+#define HMAC_MANY_CHUNK 256                                         // 批量接口每轮处理的消息数
+
+static void store_state(const uint32_t state[8], unsigned char out[SM3_DIGEST_SIZE]) {
+    for (int i = 0; i < 8; i++) {
+        out[i * 4] = (unsigned char)(state[i] >> 24);
+        out[i * 4 + 1] = (unsigned char)(state[i] >> 16);
+        out[i * 4 + 2] = (unsigned char)(state[i] >> 8);
+        out[i * 4 + 3] = (unsigned char)state[i];
+    }
+}
+
+// 由中间状态构造上下文：已处理一个完整分组
+static void ctx_from_state(SM3_CTX* ctx, const uint32_t state[8]) {
+    memcpy(ctx->state, state, sizeof(ctx->state));
+    ctx->bitlen = SM3_BLOCK_SIZE * 8;
+    memset(ctx->buffer, 0, sizeof(ctx->buffer));
+}
+
+// 压缩一个填充密钥分组，得到中间状态
+static void pad_state(uint32_t state[8], const unsigned char k[SM3_BLOCK_SIZE], unsigned char pad_byte) {
+    unsigned char block[SM3_BLOCK_SIZE];
+    SM3_CTX ctx;
+    for (int i = 0; i < SM3_BLOCK_SIZE; i++) block[i] = k[i] ^ pad_byte;
+    sm3_init(&ctx);
+    sm3_compress_blocks(ctx.state, block, 1);
+    memcpy(state, ctx.state, sizeof(ctx.state));
+    memset(block, 0, sizeof(block));
+}
+
+void hmac_sm3_key_init(SM3_HMAC_KEY* key, const unsigned char* k, size_t k_len) {
+    unsigned char kb[SM3_BLOCK_SIZE] = { 0 };
+    // 密钥超过分组长度时先哈希
+    if (k_len > SM3_BLOCK_SIZE) sm3_hash(k, k_len, kb);
+    else if (k_len > 0) memcpy(kb, k, k_len);
+    pad_state(key->istate, kb, 0x36);
+    pad_state(key->ostate, kb, 0x5c);
+    memset(kb, 0, sizeof(kb));
+}
+
+void hmac_sm3_key_clear(SM3_HMAC_KEY* key) {
+    volatile unsigned char* p = (volatile unsigned char*)key;
+    for (size_t i = 0; i < sizeof(*key); i++) p[i] = 0;
+}
+
+void hmac_sm3_key_inner_ctx(const SM3_HMAC_KEY* key, SM3_CTX* ctx) {
+    ctx_from_state(ctx, key->istate);
+}
+
+void hmac_sm3_key_outer_ctx(const SM3_HMAC_KEY* key, SM3_CTX* ctx) {
+    ctx_from_state(ctx, key->ostate);
+}
+
+// 构造外层的唯一分组
+static void outer_block(unsigned char block[SM3_BLOCK_SIZE], const unsigned char inner[SM3_DIGEST_SIZE]) {
+    memcpy(block, inner, SM3_DIGEST_SIZE);
+    memset(block + SM3_DIGEST_SIZE, 0, SM3_BLOCK_SIZE - SM3_DIGEST_SIZE);
+    block[SM3_DIGEST_SIZE] = 0x80;
+    block[SM3_BLOCK_SIZE - 2] = (unsigned char)(HMAC_OUTER_BITS >> 8);
+    block[SM3_BLOCK_SIZE - 1] = (unsigned char)HMAC_OUTER_BITS;
+}
+
+void hmac_sm3_outer(const SM3_HMAC_KEY* key, const unsigned char inner[SM3_DIGEST_SIZE], unsigned char mac[SM3_HMAC_SIZE]) {
+    unsigned char block[SM3_BLOCK_SIZE];
+    uint32_t state[8];
+    outer_block(block, inner);
+    memcpy(state, key->ostate, sizeof(state));
+    sm3_compress_blocks(state, block, 1);
+    store_state(state, mac);
+}
+
+void hmac_sm3_mac(const SM3_HMAC_KEY* key, const unsigned char* msg, size_t len, unsigned char mac[SM3_HMAC_SIZE]) {
+    SM3_CTX ctx;
+    unsigned char inner[SM3_DIGEST_SIZE];
+    ctx_from_state(&ctx, key->istate);
+    sm3_update(&ctx, msg, len);
+    sm3_final(&ctx, inner);
+    hmac_sm3_outer(key, inner, mac);
+}
+
+int hmac_sm3_verify(const SM3_HMAC_KEY* key, const unsigned char* msg, size_t len, const unsigned char tag[SM3_HMAC_SIZE]) {
+    unsigned char mac[SM3_HMAC_SIZE];
+    unsigned char diff = 0;
+    hmac_sm3_mac(key, msg, len, mac);
+    for (int i = 0; i < SM3_HMAC_SIZE; i++) diff |= mac[i] ^ tag[i];
+    return diff == 0;
+}
+
+void hmac_sm3_init(SM3_HMAC_CTX* ctx, const SM3_HMAC_KEY* key) {
+    ctx->key = key;
+    ctx_from_state(&ctx->inner, key->istate);
+}
+
+void hmac_sm3_update(SM3_HMAC_CTX* ctx, const unsigned char* data, size_t len) {
+    sm3_update(&ctx->inner, data, len);
+}
+
+void hmac_sm3_final(SM3_HMAC_CTX* ctx, unsigned char mac[SM3_HMAC_SIZE]) {
+    unsigned char inner[SM3_DIGEST_SIZE];
+    sm3_final(&ctx->inner, inner);
+    hmac_sm3_outer(ctx->key, inner, mac);
+    memset(&ctx->inner, 0, sizeof(ctx->inner));
+}
+
+// -------------------------- 批量接口 --------------------------
+// 外层批量计算：每个通道载入各自密钥的外层状态，压缩一个固定格式分组
+static void outer_many(const SM3_HMAC_KEY* const keys[], const unsigned char inner[][SM3_DIGEST_SIZE], size_t n,
+    unsigned char macs[][SM3_HMAC_SIZE]) {
+    unsigned char blocks[SM3_MB_LANES][SM3_BLOCK_SIZE];
+    const unsigned char* bp[SM3_MB_LANES];
+    uint32_t st[8][SM3_MB_LANES];
+
+    for (size_t i = 0; i < n; i += SM3_MB_LANES) {
+        size_t batch = n - i < SM3_MB_LANES ? n - i : SM3_MB_LANES;
+        if (batch == 1) {
+            hmac_sm3_outer(keys[i], inner[i], macs[i]);
+            break;
+        }
+        for (size_t l = 0; l < SM3_MB_LANES; l++) {
+            size_t j = i + (l < batch ? l : 0);      // 空闲通道重复计算第一条，结果丢弃
+            outer_block(blocks[l], inner[j]);
+            bp[l] = blocks[l];
+            for (int w = 0; w < 8; w++) st[w][l] = keys[j]->ostate[w];
+        }
+        sm3_mb_compress(st, bp);
+        for (size_t l = 0; l < batch; l++) {
+            uint32_t s[8];
+            for (int w = 0; w < 8; w++) s[w] = st[w][l];
+            store_state(s, macs[i + l]);
+        }
+    }
+}
+
+void hmac_sm3_many(const SM3_HMAC_KEY* const keys[], const unsigned char* const msgs[], const size_t lens[],
+    size_t n, unsigned char macs[][SM3_HMAC_SIZE]) {
+    SM3_CTX* ctxs = (SM3_CTX*)malloc(HMAC_MANY_CHUNK * sizeof(SM3_CTX));
+    const SM3_CTX* cptr[HMAC_MANY_CHUNK];
+    unsigned char (*inner)[SM3_DIGEST_SIZE] = (unsigned char (*)[SM3_DIGEST_SIZE])malloc(HMAC_MANY_CHUNK * SM3_DIGEST_SIZE);
+
+    if (ctxs == NULL || inner == NULL) {
+        for (size_t i = 0; i < n; i++) hmac_sm3_mac(keys[i], msgs[i], lens[i], macs[i]);
+        free(ctxs);
+        free(inner);
+        return;
+    }
+    for (size_t i = 0; i < n; i += HMAC_MANY_CHUNK) {
+        size_t batch = n - i < HMAC_MANY_CHUNK ? n - i : HMAC_MANY_CHUNK;
+        // 相邻消息使用同一密钥时共用一个上下文
+        for (size_t b = 0; b < batch; b++) {
+            if (b > 0 && keys[i + b] == keys[i + b - 1]) {
+                cptr[b] = cptr[b - 1];
+                continue;
+            }
+            ctx_from_state(&ctxs[b], keys[i + b]->istate);
+            cptr[b] = &ctxs[b];
+        }
+        sm3_mb_finish(cptr, msgs + i, lens + i, batch, inner);
+        outer_many(keys + i, (const unsigned char (*)[SM3_DIGEST_SIZE])inner, batch, macs + i);
+    }
+    memset(ctxs, 0, HMAC_MANY_CHUNK * sizeof(SM3_CTX));
+    free(ctxs);
+    free(inner);
+}
+
+size_t hmac_sm3_verify_many(const SM3_HMAC_KEY* const keys[], const unsigned char* const msgs[], const size_t lens[],
+    size_t n, const unsigned char tags[][SM3_HMAC_SIZE], int results[]) {
+    unsigned char (*macs)[SM3_HMAC_SIZE] = (unsigned char (*)[SM3_HMAC_SIZE])malloc(HMAC_MANY_CHUNK * SM3_HMAC_SIZE);
+    size_t valid = 0;
+
+    for (size_t i = 0; i < n; i += HMAC_MANY_CHUNK) {
+        size_t batch = n - i < HMAC_MANY_CHUNK ? n - i : HMAC_MANY_CHUNK;
+        if (macs != NULL) hmac_sm3_many(keys + i, msgs + i, lens + i, batch, macs);
+        for (size_t b = 0; b < batch; b++) {
+            int ok;
+            if (macs != NULL) {
+                unsigned char diff = 0;
+                for (int k = 0; k < SM3_HMAC_SIZE; k++) diff |= macs[b][k] ^ tags[i + b][k];
+                ok = diff == 0;
+            }
+            else {
+                ok = hmac_sm3_verify(keys[i + b], msgs[i + b], lens[i + b], tags[i + b]);
+            }
+            if (results) results[i + b] = ok;
+            valid += (size_t)ok;
+        }
+    }
+    free(macs);
+    return valid;
+}
+
+// -------------------------- 多密钥接口 --------------------------
+// 把一个分组压缩进全部密钥组的状态：分组只扩展一次，各组共用扩展结果
+static void multikey_absorb(uint32_t (*st)[8][SM3_MB_LANES], size_t groups, const unsigned char block[SM3_BLOCK_SIZE]) {
+    uint32_t W[68];
+    sm3_mb_expand(block, W);
+    for (size_t g = 0; g < groups; g++) sm3_mb_compress_shared(st[g], W);
+}
+
+void hmac_sm3_multikey(const SM3_HMAC_KEY* const keys[], size_t nkeys, const unsigned char* msg, size_t len,
+    unsigned char macs[][SM3_HMAC_SIZE]) {
+    size_t groups = (nkeys + SM3_MB_LANES - 1) / SM3_MB_LANES;
+    uint32_t (*st)[8][SM3_MB_LANES] = NULL;
+    unsigned char tail[2 * SM3_BLOCK_SIZE];
+    size_t i, full = len / SM3_BLOCK_SIZE, rem = len % SM3_BLOCK_SIZE;
+
+    // 单个密钥没有可共享的计算
+    if (nkeys > 1) st = (uint32_t (*)[8][SM3_MB_LANES])malloc(groups * sizeof(*st));
+    if (st == NULL) {
+        for (i = 0; i < nkeys; i++) hmac_sm3_mac(keys[i], msg, len, macs[i]);
+        return;
+    }
+
+    // 各通道载入各自密钥的内层状态，最后一组的空闲通道重复最后一个密钥
+    for (i = 0; i < groups * SM3_MB_LANES; i++) {
+        const SM3_HMAC_KEY* key = keys[i < nkeys ? i : nkeys - 1];
+        for (int w = 0; w < 8; w++) st[i / SM3_MB_LANES][w][i % SM3_MB_LANES] = key->istate[w];
+    }
+
+    // 消息分组：所有密钥的内层输入相同（K^ipad分组之后都是msg），长度相同则填充也相同
+    for (i = 0; i < full; i++) multikey_absorb(st, groups, msg + i * SM3_BLOCK_SIZE);
+    uint64_t bitlen = ((uint64_t)len + SM3_BLOCK_SIZE) * 8;
+    size_t tail_len = rem < SM3_BLOCK_SIZE - 8 ? SM3_BLOCK_SIZE : 2 * SM3_BLOCK_SIZE;
+    memset(tail, 0, sizeof(tail));
+    memcpy(tail, msg + full * SM3_BLOCK_SIZE, rem);
+    tail[rem] = 0x80;
+    for (i = 0; i < 8; i++) tail[tail_len - 1 - i] = (unsigned char)(bitlen >> (8 * i));
+    for (i = 0; i < tail_len; i += SM3_BLOCK_SIZE) multikey_absorb(st, groups, tail + i);
+
+    // 外层：每组8个内层摘要各配自己的外层状态
+    for (size_t g = 0; g < groups; g++) {
+        unsigned char inner[SM3_MB_LANES][SM3_DIGEST_SIZE];
+        size_t base = g * SM3_MB_LANES;
+        size_t batch = nkeys - base < SM3_MB_LANES ? nkeys - base : SM3_MB_LANES;
+        for (size_t l = 0; l < batch; l++) {
+            uint32_t s[8];
+            for (int w = 0; w < 8; w++) s[w] = st[g][w][l];
+            store_state(s, inner[l]);
+        }
+        outer_many(keys + base, (const unsigned char (*)[SM3_DIGEST_SIZE])inner, batch, macs + base);
+    }
+    memset(st, 0, groups * sizeof(*st));
+    memset(tail, 0, sizeof(tail));
+    free(st);
+}
+
+void hmac_sm3(const unsigned char* k, size_t k_len, const unsigned char* msg, size_t len, unsigned char mac[SM3_HMAC_SIZE]) {
+    SM3_HMAC_KEY key;
+    hmac_sm3_key_init(&key, k, k_len);
+    hmac_sm3_mac(&key, msg, len, mac);
+    hmac_sm3_key_clear(&key);
+}
@@ -0,0 +1,61 @@
+// sm3_hmac.h - HMAC-SM3（GB/T 15852.2 / RFC 2104构造）
+#ifndef SM3_HMAC_H
+#define SM3_HMAC_H
+
+#include "sm3.h"
+
+#define SM3_HMAC_SIZE SM3_DIGEST_SIZE
+
+// 密钥对象：K^ipad与K^opad各压缩一次后保存两组中间状态，之后每次计算MAC
+// 只需压缩消息分组，再加一次固定格式的外层分组（32字节内层摘要+填充恰好一个分组）
+// 长期使用的密钥应创建一次、反复使用；对象只读，可被多个线程同时使用
+typedef struct {
+    uint32_t istate[8];      // 已压缩K^ipad的状态
+    uint32_t ostate[8];      // 已压缩K^opad的状态
+} SM3_HMAC_KEY;
+
+// 流式计算上下文
+typedef struct {
+    SM3_CTX inner;
+    const SM3_HMAC_KEY* key;
+} SM3_HMAC_CTX;
+
+void hmac_sm3_key_init(SM3_HMAC_KEY* key, const unsigned char* k, size_t k_len);
+// 清除密钥对象中的中间状态（防止残留在内存中）
+void hmac_sm3_key_clear(SM3_HMAC_KEY* key);
+// 取得内/外层中间状态对应的SM3上下文（已处理一个分组、缓冲区为空），供多路并行等接口直接续算
+void hmac_sm3_key_inner_ctx(const SM3_HMAC_KEY* key, SM3_CTX* ctx);
+void hmac_sm3_key_outer_ctx(const SM3_HMAC_KEY* key, SM3_CTX* ctx);
+
+// 单次计算：message的MAC
+void hmac_sm3_mac(const SM3_HMAC_KEY* key, const unsigned char* msg, size_t len, unsigned char mac[SM3_HMAC_SIZE]);
+// 校验MAC（常量时间比较），一致返回1
+int hmac_sm3_verify(const SM3_HMAC_KEY* key, const unsigned char* msg, size_t len, const unsigned char tag[SM3_HMAC_SIZE]);
+// 外层计算：由32字节内层摘要得到MAC（固定长度快速路径，仅一次压缩）
+void hmac_sm3_outer(const SM3_HMAC_KEY* key, const unsigned char inner[SM3_DIGEST_SIZE], unsigned char mac[SM3_HMAC_SIZE]);
+
+// 流式计算
+void hmac_sm3_init(SM3_HMAC_CTX* ctx, const SM3_HMAC_KEY* key);
+void hmac_sm3_update(SM3_HMAC_CTX* ctx, const unsigned char* data, size_t len);
+void hmac_sm3_final(SM3_HMAC_CTX* ctx, unsigned char mac[SM3_HMAC_SIZE]);
+
+// -------------------------- 批量接口 --------------------------
+// n个(密钥, 消息)对的MAC：密钥可以全部相同，也可以各不相同（keys[i]指向各自的密钥对象）
+// 内层从缓存的中间状态出发经多路并行接口计算，外层固定格式分组直接送入多路压缩
+void hmac_sm3_many(const SM3_HMAC_KEY* const keys[], const unsigned char* const msgs[], const size_t lens[],
+    size_t n, unsigned char macs[][SM3_HMAC_SIZE]);
+// 批量校验：与期望标签逐字节比较（常量时间，不做十六进制转换），results[i]为1表示通过
+// 返回通过的数量；results可为NULL
+size_t hmac_sm3_verify_many(const SM3_HMAC_KEY* const keys[], const unsigned char* const msgs[], const size_t lens[],
+    size_t n, const unsigned char tags[][SM3_HMAC_SIZE], int results[]);
+
+// 同一消息在nkeys个密钥下的MAC（如按租户密钥分发同一负载）
+// 内层输入对所有密钥都是同一串分组：每个分组只做一次消息扩展，
+// 扩展结果广播到各通道，8个密钥的内层状态一组同时执行轮函数；外层按组多路压缩
+void hmac_sm3_multikey(const SM3_HMAC_KEY* const keys[], size_t nkeys, const unsigned char* msg, size_t len,
+    unsigned char macs[][SM3_HMAC_SIZE]);
+
+// 一次性计算（临时密钥，内部构造并清除密钥对象）
+void hmac_sm3(const unsigned char* k, size_t k_len, const unsigned char* msg, size_t len, unsigned char mac[SM3_HMAC_SIZE]);
+
+#endif
@@ -0,0 +1,415 @@
+// sm3_kdf.c - SM2密钥派生函数实现
+// 各计数器对应的消息为 Z || ct，长度相同，因此填充方式相同：尾部一到两个分组中只有4字节计数器不同
+#include "sm3_kdf.h"
+#include "sm3_mb.h"
+#include <stdlib.h>
+
+#define KDF_MAX_BLOCKS 0xFFFFFFFFull     // 计数器为32位，最多派生2^32-1个摘要
+#define PBKDF2_BLOCK_BITS ((SM3_BLOCK_SIZE + SM3_DIGEST_SIZE) * 8)   // 迭代分组对应的消息总长（768bit）
+#define HKDF_LABEL_PREFIX "tls13 "
+#define HKDF_LABEL_MAX (2 + 1 + 255 + 1 + 255)                        // HkdfLabel最大长度
+
+static void store_state(const uint32_t state[8], unsigned char out[SM3_DIGEST_SIZE]) {
+    for (int i = 0; i < 8; i++) {
+        out[i * 4] = (unsigned char)(state[i] >> 24);
+        out[i * 4 + 1] = (unsigned char)(state[i] >> 16);
+        out[i * 4 + 2] = (unsigned char)(state[i] >> 8);
+        out[i * 4 + 3] = (unsigned char)state[i];
+    }
+}
+
+static void put_counter(unsigned char* p, uint32_t ct) {
+    p[0] = (unsigned char)(ct >> 24);
+    p[1] = (unsigned char)(ct >> 16);
+    p[2] = (unsigned char)(ct >> 8);
+    p[3] = (unsigned char)ct;
+}
+
+// 输出一个摘要（最后一个可能截断）
+static void emit(unsigned char* key, size_t klen, uint64_t index, const unsigned char digest[SM3_DIGEST_SIZE]) {
+    size_t off = (size_t)index * SM3_DIGEST_SIZE;
+    size_t n = klen - off < SM3_DIGEST_SIZE ? klen - off : SM3_DIGEST_SIZE;
+    memcpy(key + off, digest, n);
+}
+
+int sm3_kdf_ctx(const SM3_CTX* zctx, unsigned char* key, size_t klen) {
+    unsigned char tail[SM3_MB_LANES][2 * SM3_BLOCK_SIZE];
+    const unsigned char* bp[SM3_MB_LANES];
+    uint32_t st[8][SM3_MB_LANES];
+    uint32_t W[68];
+    size_t r = zctx->bitlen / 8 % SM3_BLOCK_SIZE;
+    uint64_t bitlen = zctx->bitlen + 32;
+    uint64_t count = ((uint64_t)klen + SM3_DIGEST_SIZE - 1) / SM3_DIGEST_SIZE;
+    size_t tail_len = r + 4 < SM3_BLOCK_SIZE - 8 ? SM3_BLOCK_SIZE : 2 * SM3_BLOCK_SIZE;
+    // 计数器完全落在第一个分组时，第二个分组只有填充与长度，对所有计数器相同
+    int shared_last = tail_len == 2 * SM3_BLOCK_SIZE && r + 4 <= SM3_BLOCK_SIZE;
+    size_t lane_blocks = shared_last ? 1 : tail_len / SM3_BLOCK_SIZE;
+
+    if (count > KDF_MAX_BLOCKS) return -1;
+    if (count == 0) return 0;
+
+    // 尾部模板：Z的剩余字节 || 计数器（待填） || 0x80 || 0... || 总长度
+    memset(tail[0], 0, sizeof(tail[0]));
+    memcpy(tail[0], zctx->buffer, r);
+    tail[0][r + 4] = 0x80;
+    for (int i = 0; i < 8; i++) tail[0][tail_len - 1 - i] = (unsigned char)(bitlen >> (8 * i));
+    for (int l = 1; l < SM3_MB_LANES; l++) memcpy(tail[l], tail[0], tail_len);
+    if (shared_last) sm3_mb_expand(tail[0] + SM3_BLOCK_SIZE, W);
+
+    for (uint64_t i = 0; i < count; i += SM3_MB_LANES) {
+        size_t batch = count - i < SM3_MB_LANES ? (size_t)(count - i) : SM3_MB_LANES;
+        unsigned char digest[SM3_DIGEST_SIZE];
+
+        // 只剩一个计数器时走单路压缩
+        if (batch == 1) {
+            uint32_t s[8];
+            memcpy(s, zctx->state, sizeof(s));
+            put_counter(tail[0] + r, (uint32_t)(i + 1));
+            sm3_compress_blocks(s, tail[0], tail_len / SM3_BLOCK_SIZE);
+            store_state(s, digest);
+            emit(key, klen, i, digest);
+            break;
+        }
+
+        for (size_t l = 0; l < SM3_MB_LANES; l++) {
+            // 空闲通道重复最后一个计数器，结果丢弃
+            put_counter(tail[l] + r, (uint32_t)(i + 1 + (l < batch ? l : batch - 1)));
+            for (int w = 0; w < 8; w++) st[w][l] = zctx->state[w];
+        }
+        for (size_t b = 0; b < lane_blocks; b++) {
+            for (size_t l = 0; l < SM3_MB_LANES; l++) bp[l] = tail[l] + b * SM3_BLOCK_SIZE;
+            sm3_mb_compress(st, bp);
+        }
+        if (shared_last) sm3_mb_compress_shared(st, W);
+
+        for (size_t l = 0; l < batch; l++) {
+            uint32_t s[8];
+            for (int w = 0; w < 8; w++) s[w] = st[w][l];
+            store_state(s, digest);
+            emit(key, klen, i + l, digest);
+        }
+    }
+    memset(tail, 0, sizeof(tail));
+    memset(st, 0, sizeof(st));
+    return 0;
+}
+
+int sm3_kdf(const unsigned char* z, size_t zlen, unsigned char* key, size_t klen) {
+    SM3_CTX ctx;
+    int ret;
+    sm3_init(&ctx);
+    sm3_update(&ctx, z, zlen);
+    ret = sm3_kdf_ctx(&ctx, key, klen);
+    memset(&ctx, 0, sizeof(ctx));
+    return ret;
+}
+
+// -------------------------- PBKDF2-HMAC-SM3 --------------------------
+// 一个输出块的计算任务
+typedef struct {
+    const SM3_HMAC_KEY* key;             // 口令对应的HMAC密钥对象
+    const SM3_HMAC_CTX* salted;          // 已吸收盐值的内层上下文
+    uint32_t index;                      // 块序号i（从1开始）
+    unsigned char* out;
+    size_t out_len;                      // 最后一块可能不足32字节
+} PBKDF2_ITEM;
+
+// 固定格式分组：32字节数据 || 0x80 || 0x00... || 768bit
+static void pbkdf2_block_init(unsigned char block[SM3_BLOCK_SIZE]) {
+    memset(block + SM3_DIGEST_SIZE, 0, SM3_BLOCK_SIZE - SM3_DIGEST_SIZE);
+    block[SM3_DIGEST_SIZE] = 0x80;
+    block[SM3_BLOCK_SIZE - 2] = (unsigned char)(PBKDF2_BLOCK_BITS >> 8);
+    block[SM3_BLOCK_SIZE - 1] = (unsigned char)PBKDF2_BLOCK_BITS;
+}
+
+// U_1 = HMAC(P, S || INT(i))
+static void pbkdf2_first(const PBKDF2_ITEM* item, unsigned char u[SM3_DIGEST_SIZE]) {
+    SM3_HMAC_CTX hc = *item->salted;
+    unsigned char ct[4];
+    put_counter(ct, item->index);
+    hmac_sm3_update(&hc, ct, 4);
+    hmac_sm3_final(&hc, u);
+}
+
+// 单通道：一个输出块的全部迭代直接在状态数组上进行
+static void pbkdf2_one(const PBKDF2_ITEM* item, uint32_t iter) {
+    unsigned char block[SM3_BLOCK_SIZE], t[SM3_DIGEST_SIZE];
+    uint32_t s[8];
+
+    pbkdf2_block_init(block);
+    pbkdf2_first(item, block);
+    memcpy(t, block, SM3_DIGEST_SIZE);
+    for (uint32_t j = 1; j < iter; j++) {
+        memcpy(s, item->key->istate, sizeof(s));
+        sm3_compress_blocks(s, block, 1);
+        store_state(s, block);
+        memcpy(s, item->key->ostate, sizeof(s));
+        sm3_compress_blocks(s, block, 1);
+        store_state(s, block);
+        for (int b = 0; b < SM3_DIGEST_SIZE; b++) t[b] ^= block[b];
+    }
+    memcpy(item->out, t, item->out_len);
+    memset(block, 0, sizeof(block));
+    memset(t, 0, sizeof(t));
+}
+
+// 多通道：最多8个输出块（可属于不同口令）同步迭代
+static void pbkdf2_lanes(const PBKDF2_ITEM* items, size_t batch, uint32_t iter) {
+    unsigned char blocks[SM3_MB_LANES][SM3_BLOCK_SIZE], t[SM3_MB_LANES][SM3_DIGEST_SIZE];
+    const unsigned char* bp[SM3_MB_LANES];
+    const SM3_HMAC_KEY* keys[SM3_MB_LANES];
+    uint32_t st[8][SM3_MB_LANES];
+    size_t l;
+
+    for (l = 0; l < SM3_MB_LANES; l++) {
+        pbkdf2_block_init(blocks[l]);
+        bp[l] = blocks[l];
+        // 空闲通道重复第一个任务，结果丢弃
+        keys[l] = items[l < batch ? l : 0].key;
+        if (l < batch) pbkdf2_first(&items[l], blocks[l]);
+        else memcpy(blocks[l], blocks[0], SM3_DIGEST_SIZE);
+        memcpy(t[l], blocks[l], SM3_DIGEST_SIZE);
+    }
+    for (uint32_t j = 1; j < iter; j++) {
+        for (l = 0; l < SM3_MB_LANES; l++) {
+            for (int w = 0; w < 8; w++) st[w][l] = keys[l]->istate[w];
+        }
+        sm3_mb_compress(st, bp);
+        for (l = 0; l < SM3_MB_LANES; l++) {
+            uint32_t s[8];
+            for (int w = 0; w < 8; w++) {
+                s[w] = st[w][l];
+                st[w][l] = keys[l]->ostate[w];
+            }
+            store_state(s, blocks[l]);
+        }
+        sm3_mb_compress(st, bp);
+        for (l = 0; l < SM3_MB_LANES; l++) {
+            uint32_t s[8];
+            for (int w = 0; w < 8; w++) s[w] = st[w][l];
+            store_state(s, blocks[l]);
+            for (int b = 0; b < SM3_DIGEST_SIZE; b++) t[l][b] ^= blocks[l][b];
+        }
+    }
+    for (l = 0; l < batch; l++) memcpy(items[l].out, t[l], items[l].out_len);
+    memset(blocks, 0, sizeof(blocks));
+    memset(t, 0, sizeof(t));
+    memset(st, 0, sizeof(st));
+}
+
+int sm3_pbkdf2_many(const unsigned char* const passes[], const size_t pass_lens[],
+    const unsigned char* const salts[], const size_t salt_lens[], size_t n,
+    uint32_t iter, unsigned char* const keys[], size_t klen) {
+    uint64_t per = ((uint64_t)klen + SM3_DIGEST_SIZE - 1) / SM3_DIGEST_SIZE;
+    SM3_HMAC_KEY* hks;
+    SM3_HMAC_CTX* salted;
+    PBKDF2_ITEM items[SM3_MB_LANES];
+    size_t batch = 0;
+
+    if (iter == 0 || per > KDF_MAX_BLOCKS) return -1;
+    if (n == 0 || per == 0) return 0;
+    hks = (SM3_HMAC_KEY*)malloc(n * sizeof(SM3_HMAC_KEY));
+    salted = (SM3_HMAC_CTX*)malloc(n * sizeof(SM3_HMAC_CTX));
+    if (hks == NULL || salted == NULL) {
+        free(hks);
+        free(salted);
+        return -1;
+    }
+
+    // 全部(口令, 块序号)任务按顺序每8个一组送入通道，口令之间不必对齐
+    for (size_t p = 0; p < n; p++) {
+        hmac_sm3_key_init(&hks[p], passes[p], pass_lens[p]);
+        hmac_sm3_init(&salted[p], &hks[p]);
+        hmac_sm3_update(&salted[p], salts[p], salt_lens[p]);
+        for (uint64_t i = 0; i < per; i++) {
+            PBKDF2_ITEM* it = &items[batch++];
+            size_t off = (size_t)i * SM3_DIGEST_SIZE;
+            it->key = &hks[p];
+            it->salted = &salted[p];
+            it->index = (uint32_t)(i + 1);
+            it->out = keys[p] + off;
+            it->out_len = klen - off < SM3_DIGEST_SIZE ? klen - off : SM3_DIGEST_SIZE;
+            if (batch == SM3_MB_LANES) {
+                pbkdf2_lanes(items, batch, iter);
+                batch = 0;
+            }
+        }
+    }
+    if (batch == 1) pbkdf2_one(&items[0], iter);
+    else if (batch > 1) pbkdf2_lanes(items, batch, iter);
+
+    for (size_t p = 0; p < n; p++) hmac_sm3_key_clear(&hks[p]);
+    memset(salted, 0, n * sizeof(SM3_HMAC_CTX));
+    free(hks);
+    free(salted);
+    return 0;
+}
+
+int sm3_pbkdf2(const unsigned char* pass, size_t pass_len, const unsigned char* salt, size_t salt_len,
+    uint32_t iter, unsigned char* key, size_t klen) {
+    return sm3_pbkdf2_many(&pass, &pass_len, &salt, &salt_len, 1, iter, &key, klen);
+}
+
+// -------------------------- HKDF-SM3 --------------------------
+void sm3_hkdf_extract(const unsigned char* salt, size_t salt_len, const unsigned char* ikm, size_t ikm_len,
+    unsigned char prk[SM3_DIGEST_SIZE]) {
+    // 空盐值即空密钥：密钥分组都是64个0字节
+    hmac_sm3(salt, salt_len, ikm, ikm_len, prk);
+}
+
+void sm3_hkdf_extract_key(const unsigned char* salt, size_t salt_len, const unsigned char* ikm, size_t ikm_len,
+    SM3_HMAC_KEY* prk) {
+    unsigned char k[SM3_DIGEST_SIZE];
+    sm3_hkdf_extract(salt, salt_len, ikm, ikm_len, k);
+    hmac_sm3_key_init(prk, k, sizeof(k));
+    memset(k, 0, sizeof(k));
+}
+
+void sm3_hkdf_prk_init(SM3_HMAC_KEY* prk, const unsigned char* secret, size_t secret_len) {
+    hmac_sm3_key_init(prk, secret, secret_len);
+}
+
+int sm3_hkdf_expand(const SM3_HMAC_KEY* prk, const unsigned char* info, size_t info_len, unsigned char* okm, size_t len) {
+    unsigned char t[SM3_DIGEST_SIZE];
+    SM3_HMAC_CTX hc;
+
+    if (len > SM3_HKDF_MAX_OUT) return -1;
+    for (size_t off = 0, i = 1; off < len; off += SM3_DIGEST_SIZE, i++) {
+        unsigned char ct = (unsigned char)i;
+        size_t n = len - off < SM3_DIGEST_SIZE ? len - off : SM3_DIGEST_SIZE;
+        hmac_sm3_init(&hc, prk);
+        if (i > 1) hmac_sm3_update(&hc, t, SM3_DIGEST_SIZE);
+        hmac_sm3_update(&hc, info, info_len);
+        hmac_sm3_update(&hc, &ct, 1);
+        hmac_sm3_final(&hc, t);
+        memcpy(okm + off, t, n);
+    }
+    memset(t, 0, sizeof(t));
+    return 0;
+}
+
+int sm3_hkdf(const unsigned char* salt, size_t salt_len, const unsigned char* ikm, size_t ikm_len,
+    const unsigned char* info, size_t info_len, unsigned char* okm, size_t len) {
+    SM3_HMAC_KEY prk;
+    int ret;
+    if (len > SM3_HKDF_MAX_OUT) return -1;
+    sm3_hkdf_extract_key(salt, salt_len, ikm, ikm_len, &prk);
+    ret = sm3_hkdf_expand(&prk, info, info_len, okm, len);
+    hmac_sm3_key_clear(&prk);
+    return ret;
+}
+
+// 每个标签一段工作区：T(i-1)(32) || info || 计数器，第1块从info开始
+int sm3_hkdf_expand_many(const SM3_HMAC_KEY* prk, const unsigned char* const infos[], const size_t info_lens[],
+    size_t n, unsigned char* const okms[], const size_t lens[]) {
+    size_t total = 0, max_len = 0, m;
+    unsigned char* work;
+    size_t* offs;
+    const SM3_HMAC_KEY** keys;
+    const unsigned char** msgs;
+    size_t *mlens, *idx;
+    unsigned char (*t)[SM3_DIGEST_SIZE];
+
+    for (size_t j = 0; j < n; j++) {
+        if (lens[j] > SM3_HKDF_MAX_OUT) return -1;
+        if (lens[j] > max_len) max_len = lens[j];
+        total += SM3_DIGEST_SIZE + info_lens[j] + 1;
+    }
+    if (n == 0 || max_len == 0) return 0;
+
+    work = (unsigned char*)malloc(total);
+    offs = (size_t*)malloc(n * sizeof(size_t));
+    keys = (const SM3_HMAC_KEY**)malloc(n * sizeof(*keys));
+    msgs = (const unsigned char**)malloc(n * sizeof(*msgs));
+    mlens = (size_t*)malloc(n * sizeof(size_t));
+    idx = (size_t*)malloc(n * sizeof(size_t));
+    t = (unsigned char (*)[SM3_DIGEST_SIZE])malloc(n * SM3_DIGEST_SIZE);
+    if (work == NULL || offs == NULL || keys == NULL || msgs == NULL || mlens == NULL || idx == NULL || t == NULL) {
+        int ret = 0;
+        for (size_t j = 0; j < n && ret == 0; j++) ret = sm3_hkdf_expand(prk, infos[j], info_lens[j], okms[j], lens[j]);
+        free(work); free(offs); free(keys); free(msgs); free(mlens); free(idx); free(t);
+        return ret;
+    }
+
+    total = 0;
+    for (size_t j = 0; j < n; j++) {
+        offs[j] = total;
+        memcpy(work + total + SM3_DIGEST_SIZE, infos[j], info_lens[j]);
+        total += SM3_DIGEST_SIZE + info_lens[j] + 1;
+        keys[j] = prk;
+    }
+    for (size_t i = 1, off = 0; off < max_len; i++, off += SM3_DIGEST_SIZE) {
+        // 收集仍需第i块的标签
+        m = 0;
+        for (size_t j = 0; j < n; j++) {
+            unsigned char* w = work + offs[j];
+            if (lens[j] <= off) continue;
+            w[SM3_DIGEST_SIZE + info_lens[j]] = (unsigned char)i;
+            msgs[m] = i == 1 ? w + SM3_DIGEST_SIZE : w;
+            mlens[m] = (i == 1 ? 0 : SM3_DIGEST_SIZE) + info_lens[j] + 1;
+            idx[m++] = j;
+        }
+        hmac_sm3_many(keys, msgs, mlens, m, t);
+        for (size_t k = 0; k < m; k++) {
+            size_t j = idx[k];
+            size_t cnt = lens[j] - off < SM3_DIGEST_SIZE ? lens[j] - off : SM3_DIGEST_SIZE;
+            memcpy(work + offs[j], t[k], SM3_DIGEST_SIZE);
+            memcpy(okms[j] + off, t[k], cnt);
+        }
+    }
+    memset(work, 0, total);
+    memset(t, 0, n * SM3_DIGEST_SIZE);
+    free(work); free(offs); free(keys); free(msgs); free(mlens); free(idx); free(t);
+    return 0;
+}
+
+// 构造HkdfLabel，返回长度；参数超出范围返回0
+static size_t hkdf_label(unsigned char out[HKDF_LABEL_MAX], const char* label, const unsigned char* context,
+    size_t context_len, size_t len) {
+    size_t plen = sizeof(HKDF_LABEL_PREFIX) - 1, llen = strlen(label), p = 0;
+    if (plen + llen > 255 || context_len > 255 || len > 0xFFFF) return 0;
+    out[p++] = (unsigned char)(len >> 8);
+    out[p++] = (unsigned char)len;
+    out[p++] = (unsigned char)(plen + llen);
+    memcpy(out + p, HKDF_LABEL_PREFIX, plen);
+    p += plen;
+    memcpy(out + p, label, llen);
+    p += llen;
+    out[p++] = (unsigned char)context_len;
+    if (context_len > 0) memcpy(out + p, context, context_len);
+    return p + context_len;
+}
+
+int sm3_hkdf_expand_label(const SM3_HMAC_KEY* secret, const char* label, const unsigned char* context, size_t context_len,
+    unsigned char* out, size_t len) {
+    unsigned char info[HKDF_LABEL_MAX];
+    size_t info_len = hkdf_label(info, label, context, context_len, len);
+    if (info_len == 0) return -1;
+    return sm3_hkdf_expand(secret, info, info_len, out, len);
+}
+
+int sm3_hkdf_expand_label_many(const SM3_HMAC_KEY* secret, const char* const labels[], const unsigned char* context,
+    size_t context_len, size_t n, unsigned char* const outs[], const size_t lens[]) {
+    unsigned char (*infos)[HKDF_LABEL_MAX];
+    const unsigned char** ip;
+    size_t* info_lens;
+    int ret = 0;
+
+    if (n == 0) return 0;
+    infos = (unsigned char (*)[HKDF_LABEL_MAX])malloc(n * HKDF_LABEL_MAX);
+    ip = (const unsigned char**)malloc(n * sizeof(*ip));
+    info_lens = (size_t*)malloc(n * sizeof(size_t));
+    if (infos == NULL || ip == NULL || info_lens == NULL) {
+        for (size_t j = 0; j < n && ret == 0; j++) ret = sm3_hkdf_expand_label(secret, labels[j], context, context_len, outs[j], lens[j]);
+        free(infos); free(ip); free(info_lens);
+        return ret;
+    }
+    for (size_t j = 0; j < n && ret == 0; j++) {
+        info_lens[j] = hkdf_label(infos[j], labels[j], context, context_len, lens[j]);
+        ip[j] = infos[j];
+        if (info_lens[j] == 0) ret = -1;
+    }
+    if (ret == 0) ret = sm3_hkdf_expand_many(secret, ip, info_lens, n, outs, lens);
+    free(infos); free(ip); free(info_lens);
+    return ret;
+}
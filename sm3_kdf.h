@@ -0,0 +1,63 @@
+// sm3_kdf.h - 基于SM3的密钥派生函数（GM/T 0003 SM2密钥派生函数KDF、PBKDF2-HMAC-SM3、HKDF-SM3）
+#ifndef SM3_KDF_H
+#define SM3_KDF_H
+
+#include "sm3.h"
+#include "sm3_hmac.h"
+
+// KDF(Z, klen) = Ha1 || Ha2 || ... 截取前klen字节，其中 Ha_i = SM3(Z || ct)，ct为从1开始的32位大端计数器
+// Z只压缩一次得到中间状态；各计数器的尾部分组在多路并行通道上同时计算，
+// 计数器之后仅含填充的分组对所有计数器相同，只扩展一次后广播到各通道
+// klen超过(2^32-1)*32字节时返回-1，成功返回0
+// 注意：SM2加密要求派生结果不全为0，该检查由调用者完成
+int sm3_kdf(const unsigned char* z, size_t zlen, unsigned char* key, size_t klen);
+// 从已吸收Z的上下文出发派生（Z分多段提供时使用，如密钥交换中的 x || y || ZA || ZB），不修改上下文
+int sm3_kdf_ctx(const SM3_CTX* zctx, unsigned char* key, size_t klen);
+
+// -------------------------- PBKDF2-HMAC-SM3（RFC 8018） --------------------------
+// T_i = U_1 ^ ... ^ U_c，U_1 = HMAC(P, S || INT(i))，U_j = HMAC(P, U_{j-1})
+// U_j的内外两层输入都是32字节：从口令密钥对象的ipad/opad中间状态出发，各只压缩一个固定格式分组，
+// 分组的填充与长度部分只构造一次，每次迭代只改写前32字节
+// 多个输出块（klen > 32）或批量接口中的多个口令占用不同的多路并行通道，同时迭代
+// iter为0或klen超过(2^32-1)*32字节时返回-1，成功返回0
+int sm3_pbkdf2(const unsigned char* pass, size_t pass_len, const unsigned char* salt, size_t salt_len,
+    uint32_t iter, unsigned char* key, size_t klen);
+// n个口令（各自的盐）派生相同长度的密钥，keys[i]指向各自的输出缓冲区
+int sm3_pbkdf2_many(const unsigned char* const passes[], const size_t pass_lens[],
+    const unsigned char* const salts[], const size_t salt_lens[], size_t n,
+    uint32_t iter, unsigned char* const keys[], size_t klen);
+
+// -------------------------- HKDF-SM3（RFC 5869） --------------------------
+// PRK以HMAC密钥对象表示：ipad/opad中间状态在提取时计算一次，之后每个扩展步骤、每个标签都从中间状态出发，
+// T(i) = HMAC(PRK, T(i-1) || info || i) 只需压缩消息分组与一个外层分组
+// （info不超过22字节、或TLS 1.3标签较短时，内层只有一个分组，每个输出块共两次压缩）
+#define SM3_HKDF_MAX_OUT (255 * SM3_DIGEST_SIZE)
+
+// PRK = HMAC(salt, IKM)；salt为空时按RFC 5869使用32个0字节（与空密钥的HMAC结果相同）
+void sm3_hkdf_extract(const unsigned char* salt, size_t salt_len, const unsigned char* ikm, size_t ikm_len,
+    unsigned char prk[SM3_DIGEST_SIZE]);
+// 提取后直接得到PRK的密钥对象（PRK明文不离开函数），用完以hmac_sm3_key_clear清除
+void sm3_hkdf_extract_key(const unsigned char* salt, size_t salt_len, const unsigned char* ikm, size_t ikm_len,
+    SM3_HMAC_KEY* prk);
+// 由已知PRK（如TLS密钥调度中的上一级secret）建立密钥对象
+void sm3_hkdf_prk_init(SM3_HMAC_KEY* prk, const unsigned char* secret, size_t secret_len);
+// OKM = T(1) || T(2) || ... 截取前len字节；len超过SM3_HKDF_MAX_OUT时返回-1
+int sm3_hkdf_expand(const SM3_HMAC_KEY* prk, const unsigned char* info, size_t info_len, unsigned char* okm, size_t len);
+// 一次性extract + expand
+int sm3_hkdf(const unsigned char* salt, size_t salt_len, const unsigned char* ikm, size_t ikm_len,
+    const unsigned char* info, size_t info_len, unsigned char* okm, size_t len);
+
+// 批量扩展：同一PRK下n个info，各自的第i个输出块在多路并行通道上一起计算（同一标签的各块前后依赖）
+int sm3_hkdf_expand_many(const SM3_HMAC_KEY* prk, const unsigned char* const infos[], const size_t info_lens[],
+    size_t n, unsigned char* const okms[], const size_t lens[]);
+
+// TLS 1.3 HKDF-Expand-Label（RFC 8446 7.1，RFC 8998 SM3套件）：
+// info = uint16 len || uint8 |"tls13 " label| || "tls13 " label || uint8 |context| || context
+// label超过249字节、context超过255字节或len超过65535时返回-1
+int sm3_hkdf_expand_label(const SM3_HMAC_KEY* secret, const char* label, const unsigned char* context, size_t context_len,
+    unsigned char* out, size_t len);
+// 同一secret与context下的多个标签（如"c hs traffic"与"s hs traffic"、"key"与"iv"）一次派生
+int sm3_hkdf_expand_label_many(const SM3_HMAC_KEY* secret, const char* const labels[], const unsigned char* context,
+    size_t context_len, size_t n, unsigned char* const outs[], const size_t lens[]);
+
+#endif
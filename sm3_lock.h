@@ -0,0 +1,21 @@
+// sm3_lock.h - 库内部使用的可移植互斥锁（不属于公开接口）
+#ifndef SM3_LOCK_H
+#define SM3_LOCK_H
+
+#ifdef _WIN32
+#include <windows.h>
+typedef CRITICAL_SECTION SM3_LOCK;
+#define SM3_LOCK_INIT(l) InitializeCriticalSection(l)
+#define SM3_LOCK_FREE(l) DeleteCriticalSection(l)
+#define SM3_LOCK_ACQUIRE(l) EnterCriticalSection(l)
+#define SM3_LOCK_RELEASE(l) LeaveCriticalSection(l)
+#else
+#include <pthread.h>
+typedef pthread_mutex_t SM3_LOCK;
+#define SM3_LOCK_INIT(l) pthread_mutex_init((l), NULL)
+#define SM3_LOCK_FREE(l) pthread_mutex_destroy(l)
+#define SM3_LOCK_ACQUIRE(l) pthread_mutex_lock(l)
+#define SM3_LOCK_RELEASE(l) pthread_mutex_unlock(l)
+#endif
+
+#endif
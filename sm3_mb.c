@@ -0,0 +1,659 @@
+// sm3_mb.c - SM3多路并行计算实现
+// 将多条相互独立的消息放入SIMD通道同时压缩，提高批量小数据的哈希吞吐量
+#include "sm3_mb.h"
+#include <stdlib.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// SM3常量T按轮次预先循环左移（T_j <<< (j mod 32)），避免每轮重复计算
+static const uint32_t SM3_TJ[64] = {
+    0x79cc4519, 0xf3988a32, 0xe7311465, 0xce6228cb, 0x9cc45197, 0x3988a32f, 0x7311465e, 0xe6228cbc,
+    0xcc451979, 0x988a32f3, 0x311465e7, 0x6228cbce, 0xc451979c, 0x88a32f39, 0x11465e73, 0x228cbce6,
+    0x9d8a7a87, 0x3b14f50f, 0x7629ea1e, 0xec53d43c, 0xd8a7a879, 0xb14f50f3, 0x629ea1e7, 0xc53d43ce,
+    0x8a7a879d, 0x14f50f3b, 0x29ea1e76, 0x53d43cec, 0xa7a879d8, 0x4f50f3b1, 0x9ea1e762, 0x3d43cec5,
+    0x7a879d8a, 0xf50f3b14, 0xea1e7629, 0xd43cec53, 0xa879d8a7, 0x50f3b14f, 0xa1e7629e, 0x43cec53d,
+    0x879d8a7a, 0x0f3b14f5, 0x1e7629ea, 0x3cec53d4, 0x79d8a7a8, 0xf3b14f50, 0xe7629ea1, 0xcec53d43,
+    0x9d8a7a87, 0x3b14f50f, 0x7629ea1e, 0xec53d43c, 0xd8a7a879, 0xb14f50f3, 0x629ea1e7, 0xc53d43ce,
+    0x8a7a879d, 0x14f50f3b, 0x29ea1e76, 0x53d43cec, 0xa7a879d8, 0x4f50f3b1, 0x9ea1e762, 0x3d43cec5
+};
+
+// 初始向量（32字节输入迭代时每次从IV出发）
+static const uint32_t SM3_MB_IV[8] = {
+    0x7380166f, 0x4914b2b9, 0x172442d7, 0xda8a0600,
+    0xa96f30bc, 0x163138aa, 0xe38dee4d, 0xb0fb0e4e
+};
+
+// 空闲通道使用的占位分组
+static const unsigned char SM3_MB_ZERO_BLOCK[SM3_BLOCK_SIZE] = { 0 };
+
+// 读取大端序32位字
+static uint32_t load_be32(const unsigned char* p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | (uint32_t)p[3];
+}
+
+#if defined(__AVX2__)
+// -------------------------- AVX2实现：一个ymm寄存器承载8个通道 --------------------------
+#define MB_ROTL(x, n) _mm256_or_si256(_mm256_slli_epi32((x), (n)), _mm256_srli_epi32((x), 32 - (n)))
+#define MB_XOR3(x, y, z) _mm256_xor_si256(_mm256_xor_si256((x), (y)), (z))
+#define MB_P0(x) MB_XOR3((x), MB_ROTL((x), 9), MB_ROTL((x), 17))
+#define MB_P1(x) MB_XOR3((x), MB_ROTL((x), 15), MB_ROTL((x), 23))
+
+// 从第from轮迭代到第63轮：W为已扩展的逐通道消息字，regs为第from轮开始时的寄存器，
+// state为分组输入状态，结束时与寄存器异或后写回state
+static void mb_rounds_from(uint32_t state[8][SM3_MB_LANES], const uint32_t regs[8][SM3_MB_LANES], int from, const __m256i W[68]) {
+    int j;
+    __m256i A = _mm256_loadu_si256((const __m256i*)regs[0]);
+    __m256i B = _mm256_loadu_si256((const __m256i*)regs[1]);
+    __m256i C = _mm256_loadu_si256((const __m256i*)regs[2]);
+    __m256i D = _mm256_loadu_si256((const __m256i*)regs[3]);
+    __m256i E = _mm256_loadu_si256((const __m256i*)regs[4]);
+    __m256i F = _mm256_loadu_si256((const __m256i*)regs[5]);
+    __m256i G = _mm256_loadu_si256((const __m256i*)regs[6]);
+    __m256i H = _mm256_loadu_si256((const __m256i*)regs[7]);
+    __m256i A0 = _mm256_loadu_si256((const __m256i*)state[0]);
+    __m256i B0 = _mm256_loadu_si256((const __m256i*)state[1]);
+    __m256i C0 = _mm256_loadu_si256((const __m256i*)state[2]);
+    __m256i D0 = _mm256_loadu_si256((const __m256i*)state[3]);
+    __m256i E0 = _mm256_loadu_si256((const __m256i*)state[4]);
+    __m256i F0 = _mm256_loadu_si256((const __m256i*)state[5]);
+    __m256i G0 = _mm256_loadu_si256((const __m256i*)state[6]);
+    __m256i H0 = _mm256_loadu_si256((const __m256i*)state[7]);
+
+    for (j = from; j < 64; j++) {
+        __m256i A12 = MB_ROTL(A, 12);
+        __m256i SS1 = _mm256_add_epi32(_mm256_add_epi32(A12, E), _mm256_set1_epi32((int)SM3_TJ[j]));
+        SS1 = MB_ROTL(SS1, 7);
+        __m256i SS2 = _mm256_xor_si256(SS1, A12);
+        __m256i FF, GG;
+        if (j < 16) {
+            FF = MB_XOR3(A, B, C);
+            GG = MB_XOR3(E, F, G);
+        }
+        else {
+            FF = _mm256_or_si256(_mm256_and_si256(A, B), _mm256_and_si256(_mm256_or_si256(A, B), C));
+            GG = _mm256_or_si256(_mm256_and_si256(E, F), _mm256_andnot_si256(E, G));
+        }
+        __m256i TT1 = _mm256_add_epi32(_mm256_add_epi32(FF, D),
+            _mm256_add_epi32(SS2, _mm256_xor_si256(W[j], W[j + 4])));
+        __m256i TT2 = _mm256_add_epi32(_mm256_add_epi32(GG, H), _mm256_add_epi32(SS1, W[j]));
+        D = C; C = MB_ROTL(B, 9); B = A; A = TT1;
+        H = G; G = MB_ROTL(F, 19); F = E; E = MB_P0(TT2);
+    }
+
+    _mm256_storeu_si256((__m256i*)state[0], _mm256_xor_si256(A, A0));
+    _mm256_storeu_si256((__m256i*)state[1], _mm256_xor_si256(B, B0));
+    _mm256_storeu_si256((__m256i*)state[2], _mm256_xor_si256(C, C0));
+    _mm256_storeu_si256((__m256i*)state[3], _mm256_xor_si256(D, D0));
+    _mm256_storeu_si256((__m256i*)state[4], _mm256_xor_si256(E, E0));
+    _mm256_storeu_si256((__m256i*)state[5], _mm256_xor_si256(F, F0));
+    _mm256_storeu_si256((__m256i*)state[6], _mm256_xor_si256(G, G0));
+    _mm256_storeu_si256((__m256i*)state[7], _mm256_xor_si256(H, H0));
+}
+
+// 64轮迭代
+static void mb_rounds(uint32_t state[8][SM3_MB_LANES], const __m256i W[68]) {
+    mb_rounds_from(state, (const uint32_t (*)[SM3_MB_LANES])state, 0, W);
+}
+
+// 向量化生成W[16~67]
+static void mb_expand(__m256i W[68]) {
+    for (int j = 16; j < 68; j++) {
+        __m256i t = MB_XOR3(W[j - 16], W[j - 9], MB_ROTL(W[j - 3], 15));
+        W[j] = MB_XOR3(MB_P1(t), MB_ROTL(W[j - 13], 7), W[j - 6]);
+    }
+}
+
+void sm3_mb_compress(uint32_t state[8][SM3_MB_LANES], const unsigned char* const blocks[SM3_MB_LANES]) {
+    __m256i W[68];
+    uint32_t tmp[SM3_MB_LANES];
+    int j, l;
+
+    // 消息扩展：先按通道转置读入16个字，再向量化扩展
+    for (j = 0; j < 16; j++) {
+        for (l = 0; l < SM3_MB_LANES; l++) tmp[l] = load_be32(blocks[l] + j * 4);
+        W[j] = _mm256_loadu_si256((const __m256i*)tmp);
+    }
+    mb_expand(W);
+    mb_rounds(state, W);
+}
+
+void sm3_mb_hash32_iterate(uint32_t x[8][SM3_MB_LANES], uint64_t n) {
+    __m256i W[68];
+    uint32_t st[8][SM3_MB_LANES];
+    for (uint64_t i = 0; i < n; i++) {
+        for (int j = 0; j < 8; j++) {
+            W[j] = _mm256_loadu_si256((const __m256i*)x[j]);
+            _mm256_storeu_si256((__m256i*)st[j], _mm256_set1_epi32((int)SM3_MB_IV[j]));
+        }
+        W[8] = _mm256_set1_epi32((int)0x80000000);
+        for (int j = 9; j < 15; j++) W[j] = _mm256_setzero_si256();
+        W[15] = _mm256_set1_epi32(SM3_DIGEST_SIZE * 8);
+        mb_expand(W);
+        mb_rounds(st, W);
+        memcpy(x, st, sizeof(st));
+    }
+}
+
+void sm3_mb_compress_shared(uint32_t state[8][SM3_MB_LANES], const uint32_t W[68]) {
+    __m256i Wv[68];
+    // 已扩展的字广播到全部通道
+    for (int j = 0; j < 68; j++) Wv[j] = _mm256_set1_epi32((int)W[j]);
+    mb_rounds(state, Wv);
+}
+
+void sm3_mb_compress_partial(const SM3_MB_PARTIAL* part, const uint32_t var[][SM3_MB_LANES], uint32_t state[8][SM3_MB_LANES]) {
+    __m256i W[68];
+    uint32_t regs[8][SM3_MB_LANES];
+    int j;
+
+    // 固定字广播，可变字逐通道读入，只重算依赖可变字的扩展项
+    for (j = 0; j < 16; j++) {
+        if (part->dep[j]) W[j] = _mm256_loadu_si256((const __m256i*)var[j - part->var_word]);
+        else W[j] = _mm256_set1_epi32((int)part->W[j]);
+    }
+    for (; j < 68; j++) {
+        if (part->dep[j]) {
+            __m256i t = MB_XOR3(W[j - 16], W[j - 9], MB_ROTL(W[j - 3], 15));
+            W[j] = MB_XOR3(MB_P1(t), MB_ROTL(W[j - 13], 7), W[j - 6]);
+        }
+        else W[j] = _mm256_set1_epi32((int)part->W[j]);
+    }
+    for (j = 0; j < 8; j++) {
+        _mm256_storeu_si256((__m256i*)state[j], _mm256_set1_epi32((int)part->V[j]));
+        _mm256_storeu_si256((__m256i*)regs[j], _mm256_set1_epi32((int)part->R[j]));
+    }
+    mb_rounds_from(state, (const uint32_t (*)[SM3_MB_LANES])regs, (int)part->rounds, W);
+}
+#else
+// -------------------------- 通用实现：按通道展开的标量循环（便于编译器自动向量化） --------------------------
+static void mb_rounds_from(uint32_t state[8][SM3_MB_LANES], const uint32_t regs[8][SM3_MB_LANES], int from,
+    const uint32_t W[68][SM3_MB_LANES]) {
+    uint32_t A[SM3_MB_LANES], B[SM3_MB_LANES], C[SM3_MB_LANES], D[SM3_MB_LANES];
+    uint32_t E[SM3_MB_LANES], F[SM3_MB_LANES], G[SM3_MB_LANES], H[SM3_MB_LANES];
+    int j, l;
+
+    for (l = 0; l < SM3_MB_LANES; l++) {
+        A[l] = regs[0][l]; B[l] = regs[1][l]; C[l] = regs[2][l]; D[l] = regs[3][l];
+        E[l] = regs[4][l]; F[l] = regs[5][l]; G[l] = regs[6][l]; H[l] = regs[7][l];
+    }
+
+    for (j = from; j < 64; j++) {
+        for (l = 0; l < SM3_MB_LANES; l++) {
+            uint32_t A12 = ROTLEFT(A[l], 12);
+            uint32_t SS1 = ROTLEFT(A12 + E[l] + SM3_TJ[j], 7);
+            uint32_t SS2 = SS1 ^ A12;
+            uint32_t FF = (j < 16) ? (A[l] ^ B[l] ^ C[l]) : ((A[l] & B[l]) | ((A[l] | B[l]) & C[l]));
+            uint32_t GG = (j < 16) ? (E[l] ^ F[l] ^ G[l]) : ((E[l] & F[l]) | (~E[l] & G[l]));
+            uint32_t TT1 = FF + D[l] + SS2 + (W[j][l] ^ W[j + 4][l]);
+            uint32_t TT2 = GG + H[l] + SS1 + W[j][l];
+            D[l] = C[l]; C[l] = ROTLEFT(B[l], 9); B[l] = A[l]; A[l] = TT1;
+            H[l] = G[l]; G[l] = ROTLEFT(F[l], 19); F[l] = E[l]; E[l] = TT2 ^ ROTLEFT(TT2, 9) ^ ROTLEFT(TT2, 17);
+        }
+    }
+
+    for (l = 0; l < SM3_MB_LANES; l++) {
+        state[0][l] ^= A[l]; state[1][l] ^= B[l]; state[2][l] ^= C[l]; state[3][l] ^= D[l];
+        state[4][l] ^= E[l]; state[5][l] ^= F[l]; state[6][l] ^= G[l]; state[7][l] ^= H[l];
+    }
+}
+
+static void mb_rounds(uint32_t state[8][SM3_MB_LANES], const uint32_t W[68][SM3_MB_LANES]) {
+    mb_rounds_from(state, (const uint32_t (*)[SM3_MB_LANES])state, 0, W);
+}
+
+static void mb_expand(uint32_t W[68][SM3_MB_LANES]) {
+    for (int j = 16; j < 68; j++) {
+        for (int l = 0; l < SM3_MB_LANES; l++) {
+            uint32_t t = W[j - 16][l] ^ W[j - 9][l] ^ ROTLEFT(W[j - 3][l], 15);
+            W[j][l] = (t ^ ROTLEFT(t, 15) ^ ROTLEFT(t, 23)) ^ ROTLEFT(W[j - 13][l], 7) ^ W[j - 6][l];
+        }
+    }
+}
+
+void sm3_mb_compress(uint32_t state[8][SM3_MB_LANES], const unsigned char* const blocks[SM3_MB_LANES]) {
+    uint32_t W[68][SM3_MB_LANES];
+    int j, l;
+
+    for (j = 0; j < 16; j++) {
+        for (l = 0; l < SM3_MB_LANES; l++) W[j][l] = load_be32(blocks[l] + j * 4);
+    }
+    mb_expand(W);
+    mb_rounds(state, (const uint32_t (*)[SM3_MB_LANES])W);
+}
+
+void sm3_mb_hash32_iterate(uint32_t x[8][SM3_MB_LANES], uint64_t n) {
+    uint32_t W[68][SM3_MB_LANES];
+    uint32_t st[8][SM3_MB_LANES];
+    for (uint64_t i = 0; i < n; i++) {
+        for (int l = 0; l < SM3_MB_LANES; l++) {
+            for (int j = 0; j < 8; j++) {
+                W[j][l] = x[j][l];
+                st[j][l] = SM3_MB_IV[j];
+            }
+            W[8][l] = 0x80000000;
+            for (int j = 9; j < 15; j++) W[j][l] = 0;
+            W[15][l] = SM3_DIGEST_SIZE * 8;
+        }
+        mb_expand(W);
+        mb_rounds(st, (const uint32_t (*)[SM3_MB_LANES])W);
+        memcpy(x, st, sizeof(st));
+    }
+}
+
+void sm3_mb_compress_shared(uint32_t state[8][SM3_MB_LANES], const uint32_t W[68]) {
+    uint32_t Wv[68][SM3_MB_LANES];
+    for (int j = 0; j < 68; j++) {
+        for (int l = 0; l < SM3_MB_LANES; l++) Wv[j][l] = W[j];
+    }
+    mb_rounds(state, (const uint32_t (*)[SM3_MB_LANES])Wv);
+}
+
+void sm3_mb_compress_partial(const SM3_MB_PARTIAL* part, const uint32_t var[][SM3_MB_LANES], uint32_t state[8][SM3_MB_LANES]) {
+    uint32_t W[68][SM3_MB_LANES];
+    uint32_t regs[8][SM3_MB_LANES];
+    int j, l;
+
+    for (j = 0; j < 68; j++) {
+        for (l = 0; l < SM3_MB_LANES; l++) {
+            if (!part->dep[j]) W[j][l] = part->W[j];
+            else if (j < 16) W[j][l] = var[j - part->var_word][l];
+            else {
+                uint32_t t = W[j - 16][l] ^ W[j - 9][l] ^ ROTLEFT(W[j - 3][l], 15);
+                W[j][l] = (t ^ ROTLEFT(t, 15) ^ ROTLEFT(t, 23)) ^ ROTLEFT(W[j - 13][l], 7) ^ W[j - 6][l];
+            }
+        }
+    }
+    for (j = 0; j < 8; j++) {
+        for (l = 0; l < SM3_MB_LANES; l++) {
+            state[j][l] = part->V[j];
+            regs[j][l] = part->R[j];
+        }
+    }
+    mb_rounds_from(state, (const uint32_t (*)[SM3_MB_LANES])regs, (int)part->rounds, (const uint32_t (*)[SM3_MB_LANES])W);
+}
+#endif
+
+void sm3_mb_expand(const unsigned char block[SM3_BLOCK_SIZE], uint32_t W[68]) {
+    int j;
+    for (j = 0; j < 16; j++) W[j] = load_be32(block + j * 4);
+    for (j = 16; j < 68; j++) {
+        uint32_t t = W[j - 16] ^ W[j - 9] ^ ROTLEFT(W[j - 3], 15);
+        W[j] = (t ^ ROTLEFT(t, 15) ^ ROTLEFT(t, 23)) ^ ROTLEFT(W[j - 13], 7) ^ W[j - 6];
+    }
+}
+
+void sm3_mb_partial_init(SM3_MB_PARTIAL* part, const uint32_t V[8], const unsigned char block[SM3_BLOCK_SIZE],
+    unsigned int var_word, unsigned int var_count) {
+    uint32_t A, B, C, D, E, F, G, H;
+    unsigned int j;
+
+    memcpy(part->V, V, sizeof(part->V));
+    part->var_word = var_word;
+    part->var_count = var_count;
+    sm3_mb_expand(block, part->W);
+    for (j = 0; j < 16; j++) part->dep[j] = j >= var_word && j < var_word + var_count;
+    for (; j < 68; j++) {
+        part->dep[j] = part->dep[j - 16] | part->dep[j - 9] | part->dep[j - 3] | part->dep[j - 13] | part->dep[j - 6];
+    }
+
+    // 第j轮用到W[j]与W[j+4]，在此之前的轮对全部通道相同
+    part->rounds = var_word > 4 ? var_word - 4 : 0;
+    A = V[0]; B = V[1]; C = V[2]; D = V[3]; E = V[4]; F = V[5]; G = V[6]; H = V[7];
+    for (j = 0; j < part->rounds; j++) {
+        uint32_t A12 = ROTLEFT(A, 12);
+        uint32_t SS1 = ROTLEFT(A12 + E + SM3_TJ[j], 7);
+        uint32_t SS2 = SS1 ^ A12;
+        uint32_t TT1 = (A ^ B ^ C) + D + SS2 + (part->W[j] ^ part->W[j + 4]);
+        uint32_t TT2 = (E ^ F ^ G) + H + SS1 + part->W[j];
+        D = C; C = ROTLEFT(B, 9); B = A; A = TT1;
+        H = G; G = ROTLEFT(F, 19); F = E; E = TT2 ^ ROTLEFT(TT2, 9) ^ ROTLEFT(TT2, 17);
+    }
+    part->R[0] = A; part->R[1] = B; part->R[2] = C; part->R[3] = D;
+    part->R[4] = E; part->R[5] = F; part->R[6] = G; part->R[7] = H;
+}
+
+// 对n个上下文各压缩一个完整分组
+// 状态先收集到交错数组中统一压缩，再写回各自的上下文
+void sm3_mb_update_blocks(SM3_CTX* const ctxs[], const unsigned char* const blocks[], size_t n) {
+    uint32_t st[8][SM3_MB_LANES];
+    const unsigned char* bp[SM3_MB_LANES];
+
+    for (size_t base = 0; base < n; base += SM3_MB_LANES) {
+        size_t cnt = (n - base < SM3_MB_LANES) ? n - base : SM3_MB_LANES;
+        if (cnt == 1) {
+            sm3_compress_blocks(ctxs[base]->state, blocks[base], 1);
+            ctxs[base]->bitlen += SM3_BLOCK_SIZE * 8;
+            continue;
+        }
+        for (size_t l = 0; l < SM3_MB_LANES; l++) {
+            const SM3_CTX* c = ctxs[base + (l < cnt ? l : 0)];
+            for (int w = 0; w < 8; w++) st[w][l] = c->state[w];
+            bp[l] = (l < cnt) ? blocks[base + l] : SM3_MB_ZERO_BLOCK;
+        }
+        sm3_mb_compress(st, bp);
+        for (size_t l = 0; l < cnt; l++) {
+            for (int w = 0; w < 8; w++) ctxs[base + l]->state[w] = st[w][l];
+            ctxs[base + l]->bitlen += SM3_BLOCK_SIZE * 8;
+        }
+    }
+}
+
+// 单个通道的任务进度
+// 一条消息被拆为：可选的首分组（上下文缓冲区残留+数据开头）、中间整分组（直接指向输入）、1~2个填充尾分组
+typedef struct {
+    int active;
+    size_t job;                               // 任务序号
+    unsigned char head[SM3_BLOCK_SIZE];       // 首分组
+    int has_head;
+    const unsigned char* mid;                 // 中间整分组
+    size_t mid_blocks;
+    unsigned char tail[2 * SM3_BLOCK_SIZE];   // 填充后的尾分组
+    int tail_blocks;
+    size_t pos;                               // 已送出的分组数
+} MB_LANE;
+
+// 按照上下文与剩余数据构造通道任务
+static void mb_lane_setup(MB_LANE* lane, size_t job, const SM3_CTX* ctx, const unsigned char* data, size_t len) {
+    size_t idx = (size_t)(ctx->bitlen / 8 % SM3_BLOCK_SIZE);
+    uint64_t total_bits = ctx->bitlen + (uint64_t)len * 8;
+    size_t rem;
+
+    lane->active = 1;
+    lane->job = job;
+    lane->has_head = 0;
+    lane->pos = 0;
+    lane->mid = NULL;
+    lane->mid_blocks = 0;
+
+    if (idx > 0 && idx + len >= SM3_BLOCK_SIZE) {
+        // 缓冲区残留与数据开头拼成一个完整首分组
+        memcpy(lane->head, ctx->buffer, idx);
+        memcpy(lane->head + idx, data, SM3_BLOCK_SIZE - idx);
+        lane->has_head = 1;
+        data += SM3_BLOCK_SIZE - idx;
+        len -= SM3_BLOCK_SIZE - idx;
+        idx = 0;
+    }
+
+    lane->mid = data;
+    lane->mid_blocks = len / SM3_BLOCK_SIZE;
+    rem = len % SM3_BLOCK_SIZE;
+
+    // 尾分组：残留前缀 + 剩余数据 + 0x80 + 0填充 + 64bit长度
+    memcpy(lane->tail, ctx->buffer, idx);
+    memcpy(lane->tail + idx, data + lane->mid_blocks * SM3_BLOCK_SIZE, rem);
+    rem += idx;
+    lane->tail[rem++] = 0x80;
+    lane->tail_blocks = (rem > 56) ? 2 : 1;
+    memset(lane->tail + rem, 0, lane->tail_blocks * SM3_BLOCK_SIZE - rem);
+    for (int i = 0; i < 8; i++) {
+        lane->tail[lane->tail_blocks * SM3_BLOCK_SIZE - 8 + i] = (unsigned char)(total_bits >> (56 - 8 * i));
+    }
+}
+
+// 取得通道的下一个分组
+static const unsigned char* mb_lane_next(MB_LANE* lane) {
+    size_t p = lane->pos++;
+    if (lane->has_head) {
+        if (p == 0) return lane->head;
+        p--;
+    }
+    if (p < lane->mid_blocks) return lane->mid + p * SM3_BLOCK_SIZE;
+    return lane->tail + (p - lane->mid_blocks) * SM3_BLOCK_SIZE;
+}
+
+// 通道剩余分组数
+static size_t mb_lane_left(const MB_LANE* lane) {
+    return (size_t)lane->has_head + lane->mid_blocks + (size_t)lane->tail_blocks - lane->pos;
+}
+
+// 状态转为大端序摘要
+static void mb_store_digest(unsigned char digest[SM3_DIGEST_SIZE], const uint32_t st[8][SM3_MB_LANES], size_t l) {
+    for (int i = 0; i < 8; i++) {
+        digest[i * 4] = (unsigned char)(st[i][l] >> 24);
+        digest[i * 4 + 1] = (unsigned char)(st[i][l] >> 16);
+        digest[i * 4 + 2] = (unsigned char)(st[i][l] >> 8);
+        digest[i * 4 + 3] = (unsigned char)st[i][l];
+    }
+}
+
+// 通道调度核心：某条消息处理完毕后立即从队列补入下一条消息，保持通道满载
+// ctxs为NULL时所有任务共用shared上下文
+static void mb_run(const SM3_CTX* const ctxs[], const SM3_CTX* shared, const unsigned char* const data[],
+    const size_t lens[], size_t n, unsigned char digests[][SM3_DIGEST_SIZE]) {
+    MB_LANE* lanes = (MB_LANE*)malloc(sizeof(MB_LANE) * SM3_MB_LANES);
+    uint32_t st[8][SM3_MB_LANES];
+    const unsigned char* bp[SM3_MB_LANES];
+    size_t next = 0;
+
+    if (lanes == NULL) {
+        // 内存不足时退化为逐条计算
+        for (size_t i = 0; i < n; i++) {
+            SM3_CTX c = ctxs ? *ctxs[i] : *shared;
+            sm3_update(&c, data[i], lens[i]);
+            sm3_final(&c, digests[i]);
+        }
+        return;
+    }
+    memset(lanes, 0, sizeof(MB_LANE) * SM3_MB_LANES);
+
+    for (;;) {
+        size_t active = 0, last = 0;
+        for (size_t l = 0; l < SM3_MB_LANES; l++) {
+            if (!lanes[l].active && next < n) {
+                const SM3_CTX* c = ctxs ? ctxs[next] : shared;
+                mb_lane_setup(&lanes[l], next, c, data[next], lens[next]);
+                for (int w = 0; w < 8; w++) st[w][l] = c->state[w];
+                next++;
+            }
+            if (lanes[l].active) {
+                active++;
+                last = l;
+            }
+        }
+        if (active == 0) break;
+
+        if (active == 1 && next >= n) {
+            // 只剩一条长消息时用标量压缩收尾，避免空转其余通道
+            MB_LANE* lane = &lanes[last];
+            uint32_t s[8];
+            for (int w = 0; w < 8; w++) s[w] = st[w][last];
+            while (mb_lane_left(lane) > 0) sm3_compress_blocks(s, mb_lane_next(lane), 1);
+            for (int w = 0; w < 8; w++) st[w][last] = s[w];
+            mb_store_digest(digests[lane->job], st, last);
+            lane->active = 0;
+            break;
+        }
+
+        for (size_t l = 0; l < SM3_MB_LANES; l++) {
+            bp[l] = lanes[l].active ? mb_lane_next(&lanes[l]) : SM3_MB_ZERO_BLOCK;
+        }
+        sm3_mb_compress(st, bp);
+        for (size_t l = 0; l < SM3_MB_LANES; l++) {
+            if (lanes[l].active && mb_lane_left(&lanes[l]) == 0) {
+                mb_store_digest(digests[lanes[l].job], st, l);
+                lanes[l].active = 0;
+            }
+        }
+    }
+    free(lanes);
+}
+
+// 从给定上下文出发批量完成哈希
+void sm3_mb_finish(const SM3_CTX* const ctxs[], const unsigned char* const data[], const size_t lens[],
+    size_t n, unsigned char digests[][SM3_DIGEST_SIZE]) {
+    mb_run(ctxs, NULL, data, lens, n, digests);
+}
+
+// 批量计算独立消息的摘要（全部从初始向量开始）
+void sm3_mb_hash(const unsigned char* const data[], const size_t lens[], size_t n,
+    unsigned char digests[][SM3_DIGEST_SIZE]) {
+    SM3_CTX init;
+    sm3_init(&init);
+    mb_run(NULL, &init, data, lens, n, digests);
+}
+
+// -------------------------- 多流调度器 --------------------------
+#define SM3_MB_STREAM_SHRINK (64u << 10)   // 压缩后缓冲容量超过该值则收缩
+
+void sm3_mb_sched_init(SM3_MB_SCHED* sched, size_t max_pending_bytes) {
+    memset(sched, 0, sizeof(*sched));
+    sched->max_pending = max_pending_bytes;
+}
+
+void sm3_mb_stream_init(SM3_MB_STREAM* stream) {
+    memset(stream, 0, sizeof(*stream));
+    sm3_init(&stream->ctx);
+}
+
+static void sched_push(SM3_MB_SCHED* sched, SM3_MB_STREAM* s) {
+    s->queued = 1;
+    s->next_ready = NULL;
+    if (sched->ready_tail) sched->ready_tail->next_ready = s;
+    else sched->ready_head = s;
+    sched->ready_tail = s;
+    sched->nready++;
+}
+
+static SM3_MB_STREAM* sched_pop(SM3_MB_SCHED* sched) {
+    SM3_MB_STREAM* s = sched->ready_head;
+    if (s == NULL) return NULL;
+    sched->ready_head = s->next_ready;
+    if (sched->ready_head == NULL) sched->ready_tail = NULL;
+    sched->nready--;
+    s->queued = 0;
+    s->next_ready = NULL;
+    return s;
+}
+
+// 从就绪队列中移除指定流
+static void sched_unlink(SM3_MB_SCHED* sched, SM3_MB_STREAM* s) {
+    SM3_MB_STREAM** pp = &sched->ready_head;
+    SM3_MB_STREAM* prev = NULL;
+    while (*pp && *pp != s) {
+        prev = *pp;
+        pp = &(*pp)->next_ready;
+    }
+    if (*pp == NULL) return;
+    *pp = s->next_ready;
+    if (sched->ready_tail == s) sched->ready_tail = prev;
+    sched->nready--;
+    s->queued = 0;
+    s->next_ready = NULL;
+}
+
+// 流退出通道：丢弃已压缩的数据，保留不足一个分组的尾部
+static void stream_compact(SM3_MB_SCHED* sched, SM3_MB_STREAM* s, size_t consumed) {
+    memmove(s->pending, s->pending + consumed, s->pending_len - consumed);
+    s->pending_len -= consumed;
+    sched->pending_bytes -= consumed;
+    if (s->pending_cap > SM3_MB_STREAM_SHRINK && s->pending_len < SM3_BLOCK_SIZE) {
+        unsigned char* p = (unsigned char*)realloc(s->pending, SM3_BLOCK_SIZE * 4);
+        if (p != NULL) {
+            s->pending = p;
+            s->pending_cap = SM3_BLOCK_SIZE * 4;
+        }
+    }
+}
+
+// 一轮调度：通道中的流逐分组并行压缩，某流数据耗尽即换入下一个就绪流
+// force为0时只在通道满载时压缩，剩余流放回队列；force为1时压缩全部就绪流
+static void sched_run(SM3_MB_SCHED* sched, int force) {
+    SM3_MB_STREAM* lane[SM3_MB_LANES] = { 0 };
+    size_t pos[SM3_MB_LANES] = { 0 };
+    uint32_t st[8][SM3_MB_LANES];
+    const unsigned char* bp[SM3_MB_LANES];
+    size_t active = 0, l;
+
+    for (;;) {
+        for (l = 0; l < SM3_MB_LANES; l++) {
+            if (lane[l] == NULL && sched->ready_head != NULL) {
+                lane[l] = sched_pop(sched);
+                pos[l] = 0;
+                for (int w = 0; w < 8; w++) st[w][l] = lane[l]->ctx.state[w];
+                active++;
+            }
+        }
+        if (active == 0 || (!force && active < SM3_MB_LANES)) break;
+
+        if (active == 1) {
+            // 只剩一个流时直接标量压缩
+            for (l = 0; lane[l] == NULL; l++) {}
+            SM3_MB_STREAM* s = lane[l];
+            size_t nblk = (s->pending_len - pos[l]) / SM3_BLOCK_SIZE;
+            for (int w = 0; w < 8; w++) s->ctx.state[w] = st[w][l];
+            sm3_compress_blocks(s->ctx.state, s->pending + pos[l], nblk);
+            s->ctx.bitlen += (uint64_t)nblk * SM3_BLOCK_SIZE * 8;
+            stream_compact(sched, s, pos[l] + nblk * SM3_BLOCK_SIZE);
+            lane[l] = NULL;
+            active = 0;
+            continue;
+        }
+
+        for (l = 0; l < SM3_MB_LANES; l++) {
+            bp[l] = lane[l] ? lane[l]->pending + pos[l] : SM3_MB_ZERO_BLOCK;
+        }
+        sm3_mb_compress(st, bp);
+        for (l = 0; l < SM3_MB_LANES; l++) {
+            SM3_MB_STREAM* s = lane[l];
+            if (s == NULL) continue;
+            pos[l] += SM3_BLOCK_SIZE;
+            s->ctx.bitlen += SM3_BLOCK_SIZE * 8;
+            if (s->pending_len - pos[l] < SM3_BLOCK_SIZE) {
+                for (int w = 0; w < 8; w++) s->ctx.state[w] = st[w][l];
+                stream_compact(sched, s, pos[l]);
+                lane[l] = NULL;
+                active--;
+            }
+        }
+    }
+
+    // 通道未满时退出：仍有数据的流写回状态后放回队列
+    for (l = 0; l < SM3_MB_LANES; l++) {
+        SM3_MB_STREAM* s = lane[l];
+        if (s == NULL) continue;
+        for (int w = 0; w < 8; w++) s->ctx.state[w] = st[w][l];
+        stream_compact(sched, s, pos[l]);
+        sched_push(sched, s);
+    }
+}
+
+int sm3_mb_stream_update(SM3_MB_SCHED* sched, SM3_MB_STREAM* stream, const unsigned char* data, size_t len) {
+    if (stream->pending_len + len > stream->pending_cap) {
+        size_t cap = stream->pending_cap ? stream->pending_cap : SM3_BLOCK_SIZE * 4;
+        while (cap < stream->pending_len + len) cap *= 2;
+        unsigned char* p = (unsigned char*)realloc(stream->pending, cap);
+        if (p == NULL) return -1;
+        stream->pending = p;
+        stream->pending_cap = cap;
+    }
+    memcpy(stream->pending + stream->pending_len, data, len);
+    stream->pending_len += len;
+    sched->pending_bytes += len;
+
+    if (!stream->queued && stream->pending_len >= SM3_BLOCK_SIZE) sched_push(sched, stream);
+    if (sched->nready >= SM3_MB_LANES) sched_run(sched, 0);
+    if (sched->max_pending > 0 && sched->pending_bytes > sched->max_pending) sched_run(sched, 1);
+    return 0;
+}
+
+void sm3_mb_sched_flush(SM3_MB_SCHED* sched) {
+    sched_run(sched, 1);
+}
+
+void sm3_mb_stream_final(SM3_MB_SCHED* sched, SM3_MB_STREAM* stream, unsigned char digest[SM3_DIGEST_SIZE]) {
+    if (stream->queued) sched_unlink(sched, stream);
+    sm3_update(&stream->ctx, stream->pending, stream->pending_len);
+    sm3_final(&stream->ctx, digest);
+    sched->pending_bytes -= stream->pending_len;
+    stream->pending_len = 0;
+}
+
+void sm3_mb_stream_free(SM3_MB_SCHED* sched, SM3_MB_STREAM* stream) {
+    if (stream->queued) sched_unlink(sched, stream);
+    sched->pending_bytes -= stream->pending_len;
+    free(stream->pending);
+    memset(stream, 0, sizeof(*stream));
+}
@@ -0,0 +1,86 @@
+// sm3_mb.h - SM3多路并行（multi-buffer）计算接口
+#ifndef SM3_MB_H
+#define SM3_MB_H
+
+#include "sm3.h"
+
+#define SM3_MB_LANES 8       // 并行通道数（AVX2一个寄存器容纳8个32bit字）
+
+// 单次多路压缩：state按"字序号×通道"交错存放，每个通道压缩各自的一个分组
+// 空闲通道可传入任意有效分组，其结果由调用者丢弃
+void sm3_mb_compress(uint32_t state[8][SM3_MB_LANES], const unsigned char* const blocks[SM3_MB_LANES]);
+
+// 同一分组、多个状态：消息扩展只与分组内容有关，与链接状态无关，
+// 因此分组先用sm3_mb_expand扩展一次（W[0~67]，W'在轮函数中由W[j]^W[j+4]得到），
+// 再由sm3_mb_compress_shared广播到全部通道，对8个不同的状态执行64轮
+void sm3_mb_expand(const unsigned char block[SM3_BLOCK_SIZE], uint32_t W[68]);
+void sm3_mb_compress_shared(uint32_t state[8][SM3_MB_LANES], const uint32_t W[68]);
+
+// 32字节消息的多路迭代哈希（哈希链）：x按"字序号×通道"交错存放，每个通道原地替换为SM3^n(x)
+// 分组后半部分为常量字，直接以状态字作为消息字，不经过字节转换
+void sm3_mb_hash32_iterate(uint32_t x[8][SM3_MB_LANES], uint64_t n);
+
+// 部分可变分组：各通道从同一状态V出发压缩同一分组，只有从var_word起的var_count（1~3）个字逐通道不同（如nonce）
+// 初始化时预先计算：不依赖可变字的扩展项（计算时直接广播），以及消息字尚未用到可变字的前几轮
+// （第j轮使用W[j]与W[j+4]，前max(var_word-4, 0)轮与可变字无关）
+typedef struct {
+    uint32_t V[8];                       // 分组输入状态
+    uint32_t R[8];                       // 预先计算的轮结束后的寄存器A~H
+    uint32_t W[68];                      // 固定字的扩展，dep[j]为0的项即为最终值
+    unsigned char dep[68];               // W[j]是否依赖可变字
+    unsigned int var_word, var_count;
+    unsigned int rounds;                 // 已预先计算的轮数
+} SM3_MB_PARTIAL;
+
+// block中可变字的内容被忽略
+void sm3_mb_partial_init(SM3_MB_PARTIAL* part, const uint32_t V[8], const unsigned char block[SM3_BLOCK_SIZE],
+    unsigned int var_word, unsigned int var_count);
+// var[i][l]为通道l的第var_word+i个消息字，结果（压缩后的状态）写入state
+void sm3_mb_compress_partial(const SM3_MB_PARTIAL* part, const uint32_t var[][SM3_MB_LANES], uint32_t state[8][SM3_MB_LANES]);
+
+// 对n个上下文各压缩一个完整分组（n不限，内部按通道数分批）
+// 要求每个上下文缓冲区为空（已处理长度是64字节的整数倍）
+void sm3_mb_update_blocks(SM3_CTX* const ctxs[], const unsigned char* const blocks[], size_t n);
+
+// 从n个上下文出发吸收剩余数据并输出摘要，结果等价于逐个调用sm3_update+sm3_final
+// 上下文可以是已吸收固定前缀的中间状态（如HMAC密钥块、盐值），函数不修改上下文
+void sm3_mb_finish(const SM3_CTX* const ctxs[], const unsigned char* const data[], const size_t lens[],
+    size_t n, unsigned char digests[][SM3_DIGEST_SIZE]);
+
+// 批量计算n条独立消息的SM3摘要，长消息与短消息混合时通道会被动态补位
+void sm3_mb_hash(const unsigned char* const data[], const size_t lens[], size_t n,
+    unsigned char digests[][SM3_DIGEST_SIZE]);
+
+// -------------------------- 多流调度器 --------------------------
+// 大量并发数据流（如网络流、文件流）各自持有一个上下文，数据先进入流的待处理缓冲，
+// 调度器凑满通道后在多路并行内核上统一压缩完整分组，流之间互不等待
+
+// 单个数据流
+typedef struct SM3_MB_STREAM {
+    SM3_CTX ctx;                         // 已压缩部分的状态（缓冲区始终为空）
+    unsigned char* pending;              // 尚未压缩的数据
+    size_t pending_len, pending_cap;
+    int queued;                          // 是否在就绪队列中
+    struct SM3_MB_STREAM* next_ready;
+} SM3_MB_STREAM;
+
+// 调度器
+typedef struct {
+    SM3_MB_STREAM* ready_head;           // 待处理数据不少于一个分组的流
+    SM3_MB_STREAM* ready_tail;
+    size_t nready;
+    size_t pending_bytes;                // 所有流的待处理字节总数
+    size_t max_pending;                  // 超过该值时强制压缩全部就绪流
+} SM3_MB_SCHED;
+
+void sm3_mb_sched_init(SM3_MB_SCHED* sched, size_t max_pending_bytes);
+void sm3_mb_stream_init(SM3_MB_STREAM* stream);
+// 向流追加数据；就绪流数达到通道数时自动触发一轮并行压缩。内存不足返回-1
+int sm3_mb_stream_update(SM3_MB_SCHED* sched, SM3_MB_STREAM* stream, const unsigned char* data, size_t len);
+// 压缩所有就绪流的全部完整分组（通道不满时同样执行）
+void sm3_mb_sched_flush(SM3_MB_SCHED* sched);
+// 输出流的摘要（先压缩该流剩余数据），流之后需重新初始化才能复用
+void sm3_mb_stream_final(SM3_MB_SCHED* sched, SM3_MB_STREAM* stream, unsigned char digest[SM3_DIGEST_SIZE]);
+void sm3_mb_stream_free(SM3_MB_SCHED* sched, SM3_MB_STREAM* stream);
+
+#endif
@@ -0,0 +1,60 @@
+// sm3_memo.c - 短输入的SM3摘要记忆缓存实现
+#include "sm3_memo.h"
+#include "sm3_cache.h"
+#include <stdlib.h>
+
+#define MEMO_MAX_LEN 4096
+
+// 键为输入本身，值为摘要
+struct SM3_MEMO {
+    SM3_CACHE cache;
+};
+
+SM3_MEMO* sm3_memo_create(size_t capacity, size_t max_len) {
+    SM3_MEMO* memo;
+
+    if (max_len == 0 || max_len > MEMO_MAX_LEN) return NULL;
+    memo = (SM3_MEMO*)malloc(sizeof(SM3_MEMO));
+    if (memo == NULL) return NULL;
+    if (sm3_cache_init(&memo->cache, capacity, max_len, SM3_DIGEST_SIZE) != 0) {
+        free(memo);
+        return NULL;
+    }
+    return memo;
+}
+
+void sm3_memo_destroy(SM3_MEMO* memo) {
+    if (memo == NULL) return;
+    sm3_cache_free(&memo->cache);
+    free(memo);
+}
+
+int sm3_memo_hash(SM3_MEMO* memo, const unsigned char* input, size_t len, unsigned char output[SM3_DIGEST_SIZE]) {
+    if (len > memo->cache.key_max) {
+        sm3_cache_bypass(&memo->cache, len);
+        sm3_hash(input, len, output);
+        return 0;
+    }
+    if (sm3_cache_get(&memo->cache, input, len, output)) return 1;
+    // 锁外计算摘要，其他线程可同时访问该分片
+    sm3_hash(input, len, output);
+    sm3_cache_put(&memo->cache, input, len, output);
+    return 0;
+}
+
+int sm3_memo_str_hash(SM3_MEMO* memo, const char* str, unsigned char output[SM3_DIGEST_SIZE]) {
+    return sm3_memo_hash(memo, (const unsigned char*)str, strlen(str), output);
+}
+
+void sm3_memo_stats(SM3_MEMO* memo, SM3_MEMO_STATS* stats) {
+    SM3_CACHE_STATS cs;
+    sm3_cache_stats(&memo->cache, &cs);
+    stats->hits = cs.hits;
+    stats->misses = cs.misses;
+    stats->bypassed = cs.bypassed;
+    stats->evictions = cs.evictions;
+}
+
+void sm3_memo_clear(SM3_MEMO* memo) {
+    sm3_cache_clear(&memo->cache);
+}
@@ -0,0 +1,33 @@
+// sm3_memo.h - 短输入的SM3摘要记忆缓存
+#ifndef SM3_MEMO_H
+#define SM3_MEMO_H
+
+#include "sm3.h"
+
+// 同一批短标识符被反复计算摘要时，按输入内容缓存摘要，命中时省去压缩
+// 容量与内存在创建时固定，分片加锁，可被多个线程同时使用；每个分片为4路组相联表，组满时替换最久未命中的项
+// 以廉价指纹选分片和组，命中前逐字节比较完整输入，指纹碰撞不会返回错误的摘要
+// 长度超过max_len的输入不进入缓存，直接计算（计为旁路）
+
+typedef struct SM3_MEMO SM3_MEMO;
+
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;                     // 未命中（已计算并写入缓存）
+    uint64_t bypassed;                   // 超过max_len未进入缓存
+    uint64_t evictions;                  // 写入时替换了有效项
+} SM3_MEMO_STATS;
+
+// capacity为缓存的摘要个数上限（向上取整到分片与组的整数倍），max_len为可缓存输入的最大字节数（1~4096）。失败返回NULL
+SM3_MEMO* sm3_memo_create(size_t capacity, size_t max_len);
+void sm3_memo_destroy(SM3_MEMO* memo);
+// 计算摘要：命中返回1，未命中或旁路返回0
+int sm3_memo_hash(SM3_MEMO* memo, const unsigned char* input, size_t len, unsigned char output[SM3_DIGEST_SIZE]);
+// 与sm3_str_hash对应的带缓存版本，返回值同上
+int sm3_memo_str_hash(SM3_MEMO* memo, const char* str, unsigned char output[SM3_DIGEST_SIZE]);
+// 统计（各分片累加）；命中率 = hits / (hits + misses + bypassed)
+void sm3_memo_stats(SM3_MEMO* memo, SM3_MEMO_STATS* stats);
+// 清空缓存项与统计
+void sm3_memo_clear(SM3_MEMO* memo);
+
+#endif
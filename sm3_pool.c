@@ -0,0 +1,547 @@
+// sm3_pool.c - NUMA感知的哈希线程池实现
+// 每个节点一个FIFO任务队列，全部队列共用一把锁（任务粒度为MB级，锁开销可忽略）
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+#include "sm3_pool.h"
+#include "sm3_mb.h"
+#include "sm3_tree.h"
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+#endif
+
+#define POOL_MAX_NODES 64
+#define POOL_MAX_THREADS 1024
+#define POOL_BATCH_MIN 64                // 批量哈希时每个任务的最少消息数
+#define POOL_TASKS_PER_THREAD 4          // 切分任务时的目标任务数 = 线程数 × 该值
+
+typedef struct POOL_TASK {
+    SM3_POOL_FN fn;
+    void* arg;
+    SM3_POOL_GROUP* group;               // 所属任务组（可为NULL）
+    struct POOL_TASK* next;
+} POOL_TASK;
+
+typedef struct {
+    POOL_TASK* head;
+    POOL_TASK* tail;
+    int* cpus;                           // 节点内的CPU编号，NULL表示不绑定
+    int ncpus;
+} POOL_NODE;
+
+typedef struct {
+    SM3_POOL_WORKER w;
+    struct SM3_POOL* pool;
+} POOL_THREAD;
+
+struct SM3_POOL {
+    int nthreads, nnodes;
+    POOL_NODE nodes[POOL_MAX_NODES];
+    POOL_THREAD* workers;
+    size_t buf_size;
+    size_t pending;                      // 已提交但未完成的任务数
+    int next_node;                       // 未指定节点的任务轮流分配
+    int quit, started, failed;
+#ifndef _WIN32
+    pthread_t* tids;
+    pthread_mutex_t lock;
+    pthread_cond_t work_cv, done_cv;
+#endif
+};
+
+#ifndef _WIN32
+static __thread POOL_THREAD* pool_self;  // 当前线程对应的工作线程，非工作线程为NULL
+#endif
+
+// -------------------------- 拓扑发现 --------------------------
+// 解析"0-3,8-11"格式的CPU列表
+static int parse_cpulist(const char* s, int* cpus, int max) {
+    int n = 0;
+    while (*s && *s != '\n') {
+        char* end;
+        long a = strtol(s, &end, 10), b;
+        if (end == s) break;
+        b = a;
+        if (*end == '-') b = strtol(end + 1, &end, 10);
+        for (long c = a; c <= b && n < max; c++) cpus[n++] = (int)c;
+        s = (*end == ',') ? end + 1 : end;
+    }
+    return n;
+}
+
+static void discover_nodes(SM3_POOL* pool) {
+    pool->nnodes = 0;
+#ifdef __linux__
+    for (int id = 0; id < POOL_MAX_NODES; id++) {
+        char path[64], line[4096];
+        int cpus[1024];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", id);
+        FILE* f = fopen(path, "r");
+        if (f == NULL) continue;
+        int n = fgets(line, sizeof(line), f) ? parse_cpulist(line, cpus, 1024) : 0;
+        fclose(f);
+        if (n == 0) continue;                       // 只有内存没有CPU的节点
+        POOL_NODE* node = &pool->nodes[pool->nnodes];
+        node->cpus = (int*)malloc((size_t)n * sizeof(int));
+        if (node->cpus == NULL) continue;
+        memcpy(node->cpus, cpus, (size_t)n * sizeof(int));
+        node->ncpus = n;
+        pool->nnodes++;
+    }
+    // 单节点时无需绑定，交给调度器
+    if (pool->nnodes == 1) {
+        free(pool->nodes[0].cpus);
+        pool->nodes[0].cpus = NULL;
+    }
+#endif
+    if (pool->nnodes == 0) {
+        long n = 1;
+#ifndef _WIN32
+        n = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+        pool->nodes[0].cpus = NULL;
+        pool->nodes[0].ncpus = n > 0 ? (int)n : 1;
+        pool->nnodes = 1;
+    }
+}
+
+// -------------------------- 工作线程 --------------------------
+static void pool_lock(SM3_POOL* pool) {
+#ifndef _WIN32
+    pthread_mutex_lock(&pool->lock);
+#else
+    (void)pool;
+#endif
+}
+
+static void pool_unlock(SM3_POOL* pool) {
+#ifndef _WIN32
+    pthread_mutex_unlock(&pool->lock);
+#else
+    (void)pool;
+#endif
+}
+
+// 取任务：先本节点，再按节点顺序窃取
+static POOL_TASK* take_task(SM3_POOL* pool, int node) {
+    for (int i = 0; i < pool->nnodes; i++) {
+        POOL_NODE* q = &pool->nodes[(node + i) % pool->nnodes];
+        if (q->head != NULL) {
+            POOL_TASK* t = q->head;
+            q->head = t->next;
+            if (q->head == NULL) q->tail = NULL;
+            return t;
+        }
+    }
+    return NULL;
+}
+
+// 取属于group的任务（group为NULL时取任意任务），供在任务内等待的工作线程代为执行
+static POOL_TASK* take_group_task(SM3_POOL* pool, int node, SM3_POOL_GROUP* group) {
+    if (group == NULL) return take_task(pool, node);
+    for (int i = 0; i < pool->nnodes; i++) {
+        POOL_NODE* q = &pool->nodes[i];
+        for (POOL_TASK *t = q->head, *prev = NULL; t != NULL; prev = t, t = t->next) {
+            if (t->group != group) continue;
+            if (prev) prev->next = t->next;
+            else q->head = t->next;
+            if (q->tail == t) q->tail = prev;
+            return t;
+        }
+    }
+    return NULL;
+}
+
+static void finish_task(SM3_POOL* pool, POOL_TASK* t) {
+    pool_lock(pool);
+    pool->pending--;
+    if (t->group != NULL) t->group->pending--;
+#ifndef _WIN32
+    pthread_cond_broadcast(&pool->done_cv);
+#endif
+    pool_unlock(pool);
+    free(t);
+}
+
+// 分配本地读缓冲：绑定之后分配并写满一遍，使页面落在本节点
+static int worker_setup(SM3_POOL* pool, SM3_POOL_WORKER* w) {
+#ifdef __linux__
+    POOL_NODE* node = &pool->nodes[w->node];
+    if (node->cpus != NULL) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int i = 0; i < node->ncpus; i++) {
+            if (node->cpus[i] < CPU_SETSIZE) CPU_SET(node->cpus[i], &set);
+        }
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#endif
+    w->buf = (unsigned char*)malloc(pool->buf_size);
+    if (w->buf == NULL) return -1;
+    memset(w->buf, 0, pool->buf_size);
+    w->buf_size = pool->buf_size;
+    return 0;
+}
+
+#ifndef _WIN32
+static void* pool_thread(void* p) {
+    POOL_THREAD* th = (POOL_THREAD*)p;
+    SM3_POOL* pool = th->pool;
+    int ok = worker_setup(pool, &th->w) == 0;
+
+    pool_self = th;
+    pthread_mutex_lock(&pool->lock);
+    pool->started++;
+    if (!ok) pool->failed = 1;
+    pthread_cond_broadcast(&pool->done_cv);
+    for (;;) {
+        POOL_TASK* t = NULL;
+        while (!pool->quit && (t = take_task(pool, th->w.node)) == NULL) pthread_cond_wait(&pool->work_cv, &pool->lock);
+        if (t == NULL) break;
+        pthread_mutex_unlock(&pool->lock);
+        t->fn(&th->w, t->arg);
+        finish_task(pool, t);
+        pthread_mutex_lock(&pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+#endif
+
+// -------------------------- 线程池接口 --------------------------
+SM3_POOL* sm3_pool_create(int threads, size_t buf_size) {
+    SM3_POOL* pool = (SM3_POOL*)calloc(1, sizeof(SM3_POOL));
+    if (pool == NULL) return NULL;
+    discover_nodes(pool);
+    pool->buf_size = buf_size ? buf_size : SM3_POOL_BUF_DEFAULT;
+
+    if (threads <= 0) {
+        threads = 0;
+        for (int i = 0; i < pool->nnodes; i++) threads += pool->nodes[i].ncpus;
+    }
+    if (threads > POOL_MAX_THREADS) threads = POOL_MAX_THREADS;
+#ifdef _WIN32
+    threads = 1;
+#endif
+    pool->nthreads = threads;
+    pool->workers = (POOL_THREAD*)calloc((size_t)threads, sizeof(POOL_THREAD));
+    if (pool->workers == NULL) {
+        sm3_pool_destroy(pool);
+        return NULL;
+    }
+    // 线程按节点轮流分配，各节点线程数均衡
+    for (int t = 0; t < threads; t++) {
+        pool->workers[t].w.id = t;
+        pool->workers[t].w.node = t % pool->nnodes;
+        pool->workers[t].pool = pool;
+    }
+
+#ifndef _WIN32
+    pool->tids = (pthread_t*)calloc((size_t)threads, sizeof(pthread_t));
+    if (pool->tids == NULL) {
+        sm3_pool_destroy(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_cv, NULL);
+    pthread_cond_init(&pool->done_cv, NULL);
+    for (int t = 0; t < threads; t++) {
+        if (pthread_create(&pool->tids[t], NULL, pool_thread, &pool->workers[t]) != 0) {
+            pool->nthreads = t;
+            pool->failed = 1;
+            break;
+        }
+    }
+    // 等待全部线程完成绑定与缓冲分配
+    pthread_mutex_lock(&pool->lock);
+    while (pool->started < pool->nthreads) pthread_cond_wait(&pool->done_cv, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+#else
+    if (worker_setup(pool, &pool->workers[0].w) != 0) pool->failed = 1;
+#endif
+    if (pool->failed) {
+        sm3_pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void sm3_pool_destroy(SM3_POOL* pool) {
+    if (pool == NULL) return;
+#ifndef _WIN32
+    if (pool->tids != NULL) {
+        pthread_mutex_lock(&pool->lock);
+        pool->quit = 1;
+        pthread_cond_broadcast(&pool->work_cv);
+        pthread_mutex_unlock(&pool->lock);
+        for (int t = 0; t < pool->nthreads; t++) pthread_join(pool->tids[t], NULL);
+        pthread_mutex_destroy(&pool->lock);
+        pthread_cond_destroy(&pool->work_cv);
+        pthread_cond_destroy(&pool->done_cv);
+        free(pool->tids);
+    }
+#endif
+    for (int t = 0; pool->workers != NULL && t < pool->nthreads; t++) free(pool->workers[t].w.buf);
+    for (int i = 0; i < pool->nnodes; i++) free(pool->nodes[i].cpus);
+    free(pool->workers);
+    free(pool);
+}
+
+int sm3_pool_threads(const SM3_POOL* pool) {
+    return pool->nthreads;
+}
+
+int sm3_pool_nodes(const SM3_POOL* pool) {
+    return pool->nnodes;
+}
+
+int sm3_pool_submit_group(SM3_POOL* pool, int node, SM3_POOL_FN fn, void* arg, SM3_POOL_GROUP* group) {
+    POOL_TASK* t = (POOL_TASK*)malloc(sizeof(POOL_TASK));
+    if (t == NULL) return -1;
+    t->fn = fn;
+    t->arg = arg;
+    t->group = group;
+    t->next = NULL;
+
+    pool_lock(pool);
+    if (node < 0 || node >= pool->nnodes) node = pool->next_node++ % pool->nnodes;
+    POOL_NODE* q = &pool->nodes[node];
+    if (q->tail) q->tail->next = t;
+    else q->head = t;
+    q->tail = t;
+    pool->pending++;
+    if (group != NULL) group->pending++;
+#ifndef _WIN32
+    pthread_cond_broadcast(&pool->work_cv);
+    pool_unlock(pool);
+#else
+    // 无线程时立即执行
+    pool_unlock(pool);
+    t = take_task(pool, node);
+    t->fn(&pool->workers[0].w, t->arg);
+    finish_task(pool, t);
+#endif
+    return 0;
+}
+
+int sm3_pool_submit(SM3_POOL* pool, int node, SM3_POOL_FN fn, void* arg) {
+    return sm3_pool_submit_group(pool, node, fn, arg, NULL);
+}
+
+// 工作线程在任务内等待时不睡眠，而是代为执行组内仍在排队的任务：
+// 否则全部工作线程都在等待时，组内任务无人执行
+void sm3_pool_wait_group(SM3_POOL* pool, SM3_POOL_GROUP* group) {
+#ifndef _WIN32
+    POOL_THREAD* self = (pool_self != NULL && pool_self->pool == pool) ? pool_self : NULL;
+    POOL_TASK* t;
+
+    pthread_mutex_lock(&pool->lock);
+    while (group ? group->pending > 0 : pool->pending > 0) {
+        if (self != NULL && (t = take_group_task(pool, self->w.node, group)) != NULL) {
+            pthread_mutex_unlock(&pool->lock);
+            t->fn(&self->w, t->arg);
+            finish_task(pool, t);
+            pthread_mutex_lock(&pool->lock);
+            continue;
+        }
+        pthread_cond_wait(&pool->done_cv, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+#else
+    (void)pool;
+    (void)group;
+#endif
+}
+
+void sm3_pool_wait(SM3_POOL* pool) {
+    sm3_pool_wait_group(pool, NULL);
+}
+
+// -------------------------- 批量消息 --------------------------
+typedef struct {
+    const unsigned char* const* data;
+    const size_t* lens;
+    size_t n;
+    unsigned char (*digests)[SM3_DIGEST_SIZE];
+} BATCH_TASK;
+
+static void batch_task(SM3_POOL_WORKER* w, void* arg) {
+    BATCH_TASK* t = (BATCH_TASK*)arg;
+    (void)w;
+    sm3_mb_hash(t->data, t->lens, t->n, t->digests);
+}
+
+void sm3_pool_hash_batch(SM3_POOL* pool, const unsigned char* const data[], const size_t lens[], size_t n,
+    unsigned char digests[][SM3_DIGEST_SIZE]) {
+    size_t per = n / ((size_t)pool->nthreads * POOL_TASKS_PER_THREAD) + 1;
+    if (per < POOL_BATCH_MIN) per = POOL_BATCH_MIN;
+    size_t ntasks = (n + per - 1) / per;
+    BATCH_TASK* tasks = (BATCH_TASK*)malloc((ntasks ? ntasks : 1) * sizeof(BATCH_TASK));
+    SM3_POOL_GROUP group = { 0 };
+
+    if (tasks == NULL) {
+        sm3_mb_hash(data, lens, n, digests);
+        return;
+    }
+    for (size_t i = 0; i < ntasks; i++) {
+        size_t off = i * per;
+        tasks[i].data = data + off;
+        tasks[i].lens = lens + off;
+        tasks[i].n = n - off < per ? n - off : per;
+        tasks[i].digests = digests + off;
+        if (sm3_pool_submit_group(pool, -1, batch_task, &tasks[i], &group) != 0) batch_task(NULL, &tasks[i]);
+    }
+    sm3_pool_wait_group(pool, &group);
+    free(tasks);
+}
+
+// -------------------------- 多文件 --------------------------
+typedef struct {
+    const char* filename;
+    unsigned char* digest;
+    int* status;
+} FILE_TASK;
+
+static void file_task(SM3_POOL_WORKER* w, void* arg) {
+    FILE_TASK* t = (FILE_TASK*)arg;
+    FILE* f = fopen(t->filename, "rb");
+    SM3_CTX ctx;
+    size_t n;
+
+    *t->status = -1;
+    if (f == NULL) return;
+    sm3_init(&ctx);
+    while ((n = fread(w->buf, 1, w->buf_size, f)) > 0) sm3_update(&ctx, w->buf, n);
+    if (!ferror(f)) {
+        sm3_final(&ctx, t->digest);
+        *t->status = 0;
+    }
+    fclose(f);
+}
+
+void sm3_pool_file_hashes(SM3_POOL* pool, const char* const filenames[], size_t n,
+    unsigned char digests[][SM3_DIGEST_SIZE], int status[]) {
+    FILE_TASK* tasks = (FILE_TASK*)malloc((n ? n : 1) * sizeof(FILE_TASK));
+    SM3_POOL_GROUP group = { 0 };
+
+    for (size_t i = 0; i < n; i++) {
+        status[i] = -1;
+        if (tasks == NULL) {
+            status[i] = sm3_file_hash(filenames[i], digests[i]);
+            continue;
+        }
+        tasks[i].filename = filenames[i];
+        tasks[i].digest = digests[i];
+        tasks[i].status = &status[i];
+        // 提交失败时在当前线程计算（没有工作线程缓冲，使用文件接口）
+        if (sm3_pool_submit_group(pool, (int)(i % (size_t)pool->nnodes), file_task, &tasks[i], &group) != 0)
+            status[i] = sm3_file_hash(filenames[i], digests[i]);
+    }
+    sm3_pool_wait_group(pool, &group);
+    free(tasks);
+}
+
+// -------------------------- 树哈希 --------------------------
+typedef struct {
+    const char* filename;
+    uint64_t offset, length;
+    size_t leaf_size;
+    unsigned char* root;
+    int status;
+} TREE_TASK;
+
+// 读取区间并计算叶子摘要：每次读入工作线程缓冲能容纳的整数个叶子
+static void tree_task(SM3_POOL_WORKER* w, void* arg) {
+    TREE_TASK* t = (TREE_TASK*)arg;
+    size_t nleaves = (size_t)sm3_tree_leaf_count(t->length, t->leaf_size);
+    unsigned char (*leaves)[SM3_DIGEST_SIZE] = (unsigned char (*)[SM3_DIGEST_SIZE])malloc(nleaves * SM3_DIGEST_SIZE);
+    size_t chunk = w->buf_size / t->leaf_size * t->leaf_size;
+    FILE* f = fopen(t->filename, "rb");
+    uint64_t done = 0;
+    size_t filled = 0;
+
+    t->status = -1;
+    if (f == NULL || leaves == NULL || chunk == 0) {
+        // 叶子大于本地缓冲时退化为单独分配缓冲的文件接口
+        if (f != NULL && leaves != NULL) t->status = sm3_tree_file_hash(t->filename, t->offset, t->length, t->leaf_size, t->root);
+        if (f) fclose(f);
+        free(leaves);
+        return;
+    }
+#ifdef _WIN32
+    if (_fseeki64(f, (__int64)t->offset, SEEK_SET) != 0) done = UINT64_MAX;
+#else
+    if (fseeko(f, (off_t)t->offset, SEEK_SET) != 0) done = UINT64_MAX;
+#endif
+    while (done < t->length) {
+        size_t want = t->length - done < chunk ? (size_t)(t->length - done) : chunk;
+        if (fread(w->buf, 1, want, f) != want) break;
+        sm3_tree_leaves(w->buf, want, t->leaf_size, leaves + filled);
+        filled += (size_t)sm3_tree_leaf_count(want, t->leaf_size);
+        done += want;
+    }
+    if (t->length == 0) sm3_tree_leaves(w->buf, 0, t->leaf_size, leaves);
+    if (done == t->length) {
+        sm3_tree_root((const unsigned char (*)[SM3_DIGEST_SIZE])leaves, nleaves, t->root);
+        t->status = 0;
+    }
+    fclose(f);
+    free(leaves);
+}
+
+int sm3_pool_tree_file_hash(SM3_POOL* pool, const char* filename, size_t leaf_size,
+    unsigned char out[SM3_DIGEST_SIZE]) {
+    uint64_t size, per = 1;
+    SM3_POOL_GROUP group = { 0 };
+    int ret = 0;
+#ifdef _WIN32
+    struct __stat64 sb;
+    if (_stat64(filename, &sb) != 0 || leaf_size == 0) return -1;
+#else
+    struct stat sb;
+    if (stat(filename, &sb) != 0 || leaf_size == 0) return -1;
+#endif
+    size = (uint64_t)sb.st_size;
+
+    // 每个任务2^k个叶子，任务数接近 线程数×POOL_TASKS_PER_THREAD
+    uint64_t leaves = sm3_tree_leaf_count(size, leaf_size);
+    uint64_t target = (uint64_t)pool->nthreads * POOL_TASKS_PER_THREAD;
+    while ((leaves + per - 1) / per > target) per *= 2;
+    uint64_t task_bytes = per * leaf_size;
+    size_t ntasks = size == 0 ? 1 : (size_t)((size + task_bytes - 1) / task_bytes);
+
+    TREE_TASK* tasks = (TREE_TASK*)malloc(ntasks * sizeof(TREE_TASK));
+    unsigned char (*roots)[SM3_DIGEST_SIZE] = (unsigned char (*)[SM3_DIGEST_SIZE])malloc(ntasks * SM3_DIGEST_SIZE);
+    if (tasks == NULL || roots == NULL) {
+        free(tasks);
+        free(roots);
+        return -1;
+    }
+    for (size_t i = 0; i < ntasks; i++) {
+        tasks[i].filename = filename;
+        tasks[i].offset = i * task_bytes;
+        tasks[i].length = size - tasks[i].offset < task_bytes ? size - tasks[i].offset : task_bytes;
+        tasks[i].leaf_size = leaf_size;
+        tasks[i].root = roots[i];
+        tasks[i].status = -1;
+        // 相邻区间交给同一节点，读取在节点内保持顺序
+        int node = (int)(i * (size_t)pool->nnodes / ntasks);
+        if (sm3_pool_submit_group(pool, node, tree_task, &tasks[i], &group) != 0) ret = -1;
+    }
+    sm3_pool_wait_group(pool, &group);
+    for (size_t i = 0; i < ntasks; i++) {
+        if (tasks[i].status != 0) ret = -1;
+    }
+    if (ret == 0) sm3_tree_root((const unsigned char (*)[SM3_DIGEST_SIZE])roots, ntasks, out);
+    free(tasks);
+    free(roots);
+    return ret;
+}
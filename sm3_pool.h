@@ -0,0 +1,57 @@
+// sm3_pool.h - NUMA感知的哈希线程池
+#ifndef SM3_POOL_H
+#define SM3_POOL_H
+
+#include "sm3.h"
+
+// 工作线程按NUMA节点绑定到该节点的CPU上，读缓冲由工作线程在绑定后自行分配并首次写入
+// （first-touch），因此位于本节点内存；每个节点一个任务队列，工作线程优先处理本节点队列，
+// 本节点空闲时才从其他节点窃取任务。拓扑取自/sys/devices/system/node，不依赖libnuma；
+// 无法获取拓扑时视为单节点且不绑定。Windows下不创建线程，任务在提交时直接执行
+
+#define SM3_POOL_BUF_DEFAULT (4u << 20)     // 每个工作线程的默认读缓冲大小
+
+typedef struct SM3_POOL SM3_POOL;
+
+// 任务执行时可用的工作线程信息
+typedef struct {
+    int id;                      // 工作线程序号
+    int node;                    // 所在NUMA节点
+    unsigned char* buf;          // 本节点内存上的读缓冲
+    size_t buf_size;
+} SM3_POOL_WORKER;
+
+typedef void (*SM3_POOL_FN)(SM3_POOL_WORKER* worker, void* arg);
+
+// 任务组：调用方持有，初始化为{ 0 }，用于只等待自己提交的任务
+typedef struct {
+    size_t pending;              // 组内已提交但未完成的任务数（由线程池维护）
+} SM3_POOL_GROUP;
+
+// 创建线程池：threads为0时每个在线CPU一个线程；buf_size为0时使用默认值。失败返回NULL
+SM3_POOL* sm3_pool_create(int threads, size_t buf_size);
+void sm3_pool_destroy(SM3_POOL* pool);
+int sm3_pool_threads(const SM3_POOL* pool);
+int sm3_pool_nodes(const SM3_POOL* pool);
+// 提交任务，node为期望执行的节点（-1表示任意节点）。内存不足返回-1
+int sm3_pool_submit(SM3_POOL* pool, int node, SM3_POOL_FN fn, void* arg);
+// 等待已提交的全部任务完成（包括其他调用方的任务）
+void sm3_pool_wait(SM3_POOL* pool);
+// 提交属于group的任务，返回值同sm3_pool_submit
+int sm3_pool_submit_group(SM3_POOL* pool, int node, SM3_POOL_FN fn, void* arg, SM3_POOL_GROUP* group);
+// 只等待group内的任务完成。可在任务内调用：此时当前工作线程会代为执行组内排队的任务，
+// 这些任务与当前任务共用worker->buf，等待前后缓冲内容不保留
+void sm3_pool_wait_group(SM3_POOL* pool, SM3_POOL_GROUP* group);
+
+// -------------------------- 并行哈希路径 --------------------------
+// 批量消息：按段分给工作线程，每段经多路并行接口计算
+void sm3_pool_hash_batch(SM3_POOL* pool, const unsigned char* const data[], const size_t lens[], size_t n,
+    unsigned char digests[][SM3_DIGEST_SIZE]);
+// 多文件：每个文件一个任务，使用工作线程的本地读缓冲；status[i]为0表示成功
+void sm3_pool_file_hashes(SM3_POOL* pool, const char* const filenames[], size_t n,
+    unsigned char digests[][SM3_DIGEST_SIZE], int status[]);
+// 单个大文件的树哈希（见sm3_tree.h）：按2^k个叶子对齐分段，各段子树根并行计算后合并，失败返回-1
+int sm3_pool_tree_file_hash(SM3_POOL* pool, const char* filename, size_t leaf_size,
+    unsigned char out[SM3_DIGEST_SIZE]);
+
+#endif
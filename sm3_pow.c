@@ -0,0 +1,219 @@
+// sm3_pow.c - SM3工作量证明求解与校验实现
+#include "sm3_pow.h"
+#include "sm3_lock.h"
+#include <stdlib.h>
+
+#define POW_CHUNK (1u << 16)                 // 工作线程每次领取的nonce数
+#define POW_POLL_BATCHES 256                 // 每计算这么多组检查一次其他线程是否已找到更小的解
+
+static uint32_t load_be32(const unsigned char* p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | (uint32_t)p[3];
+}
+
+void sm3_pow_target_bits(unsigned int bits, unsigned char target[SM3_DIGEST_SIZE]) {
+    memset(target, 0xff, SM3_DIGEST_SIZE);
+    if (bits > SM3_DIGEST_SIZE * 8) bits = SM3_DIGEST_SIZE * 8;
+    memset(target, 0, bits / 8);
+    if (bits % 8) target[bits / 8] = (unsigned char)(0xff >> (bits % 8));
+}
+
+int sm3_pow_meets(const unsigned char digest[SM3_DIGEST_SIZE], const unsigned char target[SM3_DIGEST_SIZE]) {
+    return memcmp(digest, target, SM3_DIGEST_SIZE) <= 0;
+}
+
+int sm3_pow_init(SM3_POW* pow, const unsigned char* msg, size_t len, size_t nonce_pos, unsigned int nonce_len,
+    const unsigned char target[SM3_DIGEST_SIZE]) {
+    size_t b = nonce_pos / SM3_BLOCK_SIZE, padded, nsuffix;
+    unsigned int var_word, var_count;
+    SM3_CTX ctx;
+
+    memset(pow, 0, sizeof(*pow));
+    if (nonce_len < 1 || nonce_len > 8 || nonce_pos > len || len - nonce_pos < nonce_len) return -1;
+    pow->offset = (unsigned int)(nonce_pos % SM3_BLOCK_SIZE);
+    if (pow->offset + nonce_len > SM3_BLOCK_SIZE) return -1;
+    pow->nonce_len = nonce_len;
+    memcpy(pow->target, target, SM3_DIGEST_SIZE);
+
+    // 填充后的消息：nonce所在分组之前的部分直接压缩，之后的部分保存
+    padded = (len + 9 + SM3_BLOCK_SIZE - 1) / SM3_BLOCK_SIZE * SM3_BLOCK_SIZE;
+    nsuffix = padded - b * SM3_BLOCK_SIZE;
+    pow->ntail = nsuffix / SM3_BLOCK_SIZE - 1;
+    pow->suffix = (unsigned char*)calloc(nsuffix, 1);
+    pow->tail_W = (uint32_t (*)[68])malloc((pow->ntail ? pow->ntail : 1) * sizeof(pow->tail_W[0]));
+    if (pow->suffix == NULL || pow->tail_W == NULL) {
+        sm3_pow_free(pow);
+        return -1;
+    }
+    memcpy(pow->suffix, msg + b * SM3_BLOCK_SIZE, len - b * SM3_BLOCK_SIZE);
+    memset(pow->suffix + pow->offset, 0, nonce_len);
+    pow->suffix[len - b * SM3_BLOCK_SIZE] = 0x80;
+    for (int i = 0; i < 8; i++) pow->suffix[nsuffix - 1 - i] = (unsigned char)((uint64_t)len * 8 >> (8 * i));
+
+    sm3_init(&ctx);
+    memcpy(pow->mid, ctx.state, sizeof(pow->mid));
+    sm3_compress_blocks(pow->mid, msg, b);
+
+    var_word = pow->offset / 4;
+    var_count = (pow->offset + nonce_len - 1) / 4 - var_word + 1;
+    for (unsigned int i = 0; i < var_count; i++) pow->base[i] = load_be32(pow->suffix + (var_word + i) * 4);
+    sm3_mb_partial_init(&pow->part, pow->mid, pow->suffix, var_word, var_count);
+    for (size_t t = 0; t < pow->ntail; t++) sm3_mb_expand(pow->suffix + (t + 1) * SM3_BLOCK_SIZE, pow->tail_W[t]);
+    return 0;
+}
+
+// nonce可表示的最大值
+static uint64_t pow_max_nonce(const SM3_POW* pow) {
+    return pow->nonce_len == 8 ? UINT64_MAX : ((uint64_t)1 << (8 * pow->nonce_len)) - 1;
+}
+
+// nonce写入所在的各消息字
+static void pow_nonce_words(const SM3_POW* pow, uint64_t nonce, uint32_t w[3]) {
+    unsigned int first = pow->offset / 4;
+    w[0] = pow->base[0];
+    w[1] = pow->base[1];
+    w[2] = pow->base[2];
+    for (unsigned int i = 0; i < pow->nonce_len; i++) {
+        unsigned int q = pow->offset + i;
+        uint32_t byte = (uint32_t)(nonce >> (8 * (pow->nonce_len - 1 - i))) & 0xff;
+        w[q / 4 - first] |= byte << (24 - 8 * (q % 4));
+    }
+}
+
+int sm3_pow_check(const SM3_POW* pow, uint64_t nonce, unsigned char digest[SM3_DIGEST_SIZE]) {
+    unsigned char block[SM3_BLOCK_SIZE], out[SM3_DIGEST_SIZE];
+    uint32_t st[8];
+
+    if (nonce > pow_max_nonce(pow)) return 0;
+    memcpy(block, pow->suffix, SM3_BLOCK_SIZE);
+    for (unsigned int i = 0; i < pow->nonce_len; i++) {
+        block[pow->offset + i] = (unsigned char)(nonce >> (8 * (pow->nonce_len - 1 - i)));
+    }
+    memcpy(st, pow->mid, sizeof(st));
+    sm3_compress_blocks(st, block, 1);
+    sm3_compress_blocks(st, pow->suffix + SM3_BLOCK_SIZE, pow->ntail);
+    for (int i = 0; i < 8; i++) {
+        out[i * 4] = (unsigned char)(st[i] >> 24);
+        out[i * 4 + 1] = (unsigned char)(st[i] >> 16);
+        out[i * 4 + 2] = (unsigned char)(st[i] >> 8);
+        out[i * 4 + 3] = (unsigned char)st[i];
+    }
+    if (digest) memcpy(digest, out, SM3_DIGEST_SIZE);
+    return sm3_pow_meets(out, pow->target);
+}
+
+// 通道l的状态是否不大于阈值（绝大多数情况下第一个字即可判定）
+static int lane_meets(const uint32_t st[8][SM3_MB_LANES], size_t l, const unsigned char target[SM3_DIGEST_SIZE]) {
+    for (int i = 0; i < 8; i++) {
+        uint32_t t = load_be32(target + i * 4);
+        if (st[i][l] != t) return st[i][l] < t;
+    }
+    return 1;
+}
+
+// -------------------------- 搜索 --------------------------
+typedef struct {
+    const SM3_POW* pow;
+    uint64_t next, last;                     // 尚未领取的区间[next, last]
+    int exhausted;
+    int found;
+    uint64_t best;                           // 已找到的最小解
+    SM3_LOCK lock;
+} POW_SEARCH;
+
+// 在[lo, hi]中顺序搜索，返回1并写入最小解；其他线程已找到更小的解时提前结束
+static int pow_scan(POW_SEARCH* s, uint64_t lo, uint64_t hi, uint64_t* hit) {
+    const SM3_POW* pow = s->pow;
+    uint32_t st[8][SM3_MB_LANES], var[3][SM3_MB_LANES], w[3];
+    unsigned int polls = 0;
+
+    for (uint64_t n = lo;; n += SM3_MB_LANES) {
+        size_t batch = hi - n < SM3_MB_LANES ? (size_t)(hi - n) + 1 : SM3_MB_LANES;
+        for (size_t l = 0; l < SM3_MB_LANES; l++) {
+            pow_nonce_words(pow, n + (l < batch ? l : 0), w);
+            for (int i = 0; i < 3; i++) var[i][l] = w[i];
+        }
+        sm3_mb_compress_partial(&pow->part, (const uint32_t (*)[SM3_MB_LANES])var, st);
+        for (size_t t = 0; t < pow->ntail; t++) sm3_mb_compress_shared(st, pow->tail_W[t]);
+        for (size_t l = 0; l < batch; l++) {
+            if (lane_meets(st, l, pow->target)) {
+                *hit = n + l;
+                return 1;
+            }
+        }
+        if (hi - n < SM3_MB_LANES) return 0;
+        if (++polls == POW_POLL_BATCHES) {
+            int stop;
+            polls = 0;
+            SM3_LOCK_ACQUIRE(&s->lock);
+            stop = s->found && s->best < n;
+            SM3_LOCK_RELEASE(&s->lock);
+            if (stop) return 0;
+        }
+    }
+}
+
+static void pow_worker(SM3_POOL_WORKER* worker, void* arg) {
+    POW_SEARCH* s = (POW_SEARCH*)arg;
+    (void)worker;
+    for (;;) {
+        uint64_t lo, hi, hit;
+        // 按顺序领取区段，已有解时不再领取更大的区段，保证结果是最小解
+        SM3_LOCK_ACQUIRE(&s->lock);
+        if (s->exhausted || (s->found && s->best < s->next)) {
+            SM3_LOCK_RELEASE(&s->lock);
+            return;
+        }
+        lo = s->next;
+        hi = s->last - lo < POW_CHUNK - 1 ? s->last : lo + POW_CHUNK - 1;
+        if (hi == s->last) s->exhausted = 1;
+        else s->next = hi + 1;
+        SM3_LOCK_RELEASE(&s->lock);
+
+        if (pow_scan(s, lo, hi, &hit)) {
+            SM3_LOCK_ACQUIRE(&s->lock);
+            if (!s->found || hit < s->best) {
+                s->found = 1;
+                s->best = hit;
+            }
+            SM3_LOCK_RELEASE(&s->lock);
+        }
+    }
+}
+
+int sm3_pow_search(const SM3_POW* pow, uint64_t start, uint64_t count, SM3_POOL* pool,
+    uint64_t* nonce, unsigned char digest[SM3_DIGEST_SIZE]) {
+    POW_SEARCH s;
+    SM3_POOL_GROUP group = { 0 };
+    uint64_t max = pow_max_nonce(pow);
+
+    if (count == 0 || start > max) return 0;
+    s.pow = pow;
+    s.next = start;
+    s.last = max - start < count - 1 ? max : start + (count - 1);
+    s.exhausted = 0;
+    s.found = 0;
+    s.best = 0;
+    SM3_LOCK_INIT(&s.lock);
+
+    if (pool != NULL) {
+        int threads = sm3_pool_threads(pool);
+        for (int i = 0; i < threads; i++) {
+            if (sm3_pool_submit_group(pool, -1, pow_worker, &s, &group) != 0) break;
+        }
+    }
+    pow_worker(NULL, &s);                    // 调用线程同样领取区段；无线程池或提交失败时由它完成剩余区段
+    if (pool != NULL) sm3_pool_wait_group(pool, &group);
+    SM3_LOCK_FREE(&s.lock);
+
+    if (!s.found) return 0;
+    if (nonce) *nonce = s.best;
+    sm3_pow_check(pow, s.best, digest);
+    return 1;
+}
+
+void sm3_pow_free(SM3_POW* pow) {
+    free(pow->suffix);
+    free(pow->tail_W);
+    pow->suffix = NULL;
+    pow->tail_W = NULL;
+}
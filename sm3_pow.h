@@ -0,0 +1,43 @@
+// sm3_pow.h - SM3工作量证明（客户端谜题）求解与校验
+#ifndef SM3_POW_H
+#define SM3_POW_H
+
+#include "sm3.h"
+#include "sm3_mb.h"
+#include "sm3_pool.h"
+
+// 谜题：消息msg中从nonce_pos起的nonce_len（1~8）字节写入大端序nonce，求SM3(msg) <= target（256位大端整数）
+// 搜索时nonce之前的完整分组只压缩一次；nonce所在分组按SM3_MB_PARTIAL预先计算与nonce无关的扩展项和轮；
+// nonce之后的分组（含填充）内容固定，各自只扩展一次后广播到8个通道
+// nonce不能跨越64字节分组边界
+typedef struct {
+    uint32_t mid[8];                     // nonce之前的分组压缩后的状态
+    SM3_MB_PARTIAL part;                 // nonce所在分组
+    unsigned char* suffix;               // 自nonce所在分组起的填充后消息（nonce字节为0）
+    uint32_t (*tail_W)[68];              // 之后各分组的消息扩展
+    size_t ntail;
+    uint32_t base[3];                    // nonce所在字中的其余字节
+    unsigned int offset;                 // nonce在分组内的偏移
+    unsigned int nonce_len;
+    unsigned char target[SM3_DIGEST_SIZE];
+} SM3_POW;
+
+// 前导零位数（0~256）转换为阈值
+void sm3_pow_target_bits(unsigned int bits, unsigned char target[SM3_DIGEST_SIZE]);
+// 摘要是否不大于阈值
+int sm3_pow_meets(const unsigned char digest[SM3_DIGEST_SIZE], const unsigned char target[SM3_DIGEST_SIZE]);
+
+// 参数无效（nonce越界、跨分组或长度不在1~8）或内存不足返回-1
+int sm3_pow_init(SM3_POW* pow, const unsigned char* msg, size_t len, size_t nonce_pos, unsigned int nonce_len,
+    const unsigned char target[SM3_DIGEST_SIZE]);
+// 计算给定nonce的摘要（digest可为NULL），满足阈值返回1（服务端校验）
+int sm3_pow_check(const SM3_POW* pow, uint64_t nonce, unsigned char digest[SM3_DIGEST_SIZE]);
+// 在[start, start + count)中搜索满足阈值的最小nonce（超出nonce_len可表示范围的部分忽略）
+// 8个nonce一组在多路并行通道上计算；pool不为NULL时按区段分给各工作线程与调用线程，
+// 只等待本次提交的任务（可在线程池任务内调用），找到解后大于该解的区段不再计算。
+// 找到返回1并输出nonce与摘要（digest可为NULL），否则返回0
+int sm3_pow_search(const SM3_POW* pow, uint64_t start, uint64_t count, SM3_POOL* pool,
+    uint64_t* nonce, unsigned char digest[SM3_DIGEST_SIZE]);
+void sm3_pow_free(SM3_POW* pow);
+
+#endif
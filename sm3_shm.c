@@ -0,0 +1,259 @@
+// sm3_shm.c - 共享内存零拷贝提交环实现
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+#include "sm3_shm.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define SHM_MAX_ENTRIES (1u << 20)
+#define SHM_ALIGN(x, a) (((x) + (a) - 1) / (a) * (a))
+
+// 由entries与数据区大小计算布局，返回映射总大小
+static size_t shm_layout(uint32_t entries, uint64_t data_size, uint64_t* sq_off, uint64_t* cq_off, uint64_t* data_off) {
+    *sq_off = SHM_ALIGN(sizeof(SM3_SHM_HDR), 64);
+    *cq_off = SHM_ALIGN(*sq_off + (uint64_t)entries * sizeof(SM3_SHM_SQE), 64);
+    *data_off = SHM_ALIGN(*cq_off + (uint64_t)entries * sizeof(SM3_SHM_CQE), 4096);
+    return (size_t)(*data_off + data_size);
+}
+
+// -------------------------- 客户端 --------------------------
+int sm3_shm_connect(SM3_SHM_CLIENT* c, const char* sock_path, unsigned int entries, size_t data_size) {
+    struct sockaddr_un sa;
+    uint64_t sq_off, cq_off, data_off;
+    uint32_t n = 1;
+    unsigned char ack[2];
+
+    memset(c, 0, sizeof(*c));
+    c->sock = c->memfd = c->sq_efd = c->cq_efd = -1;
+    if (entries == 0 || entries > SHM_MAX_ENTRIES || data_size == 0) return -1;
+    while (n < entries) n <<= 1;
+    data_size = SHM_ALIGN(data_size, 4096);
+    c->map_size = shm_layout(n, data_size, &sq_off, &cq_off, &data_off);
+    c->slot_end = (uint64_t*)calloc(n, sizeof(uint64_t));
+
+    // 共享内存：封印后大小不可再改变
+    c->memfd = memfd_create("sm3-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (c->slot_end == NULL || c->memfd < 0 || ftruncate(c->memfd, (off_t)c->map_size) != 0 ||
+        fcntl(c->memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) goto fail;
+    c->hdr = (SM3_SHM_HDR*)mmap(NULL, c->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, c->memfd, 0);
+    if (c->hdr == (SM3_SHM_HDR*)MAP_FAILED) {
+        c->hdr = NULL;
+        goto fail;
+    }
+    c->hdr->magic = SM3_SHM_MAGIC;
+    c->hdr->entries = n;
+    c->hdr->sq_off = sq_off;
+    c->hdr->cq_off = cq_off;
+    c->hdr->data_off = data_off;
+    c->hdr->data_size = data_size;
+    c->sq = (SM3_SHM_SQE*)((unsigned char*)c->hdr + sq_off);
+    c->cq = (SM3_SHM_CQE*)((unsigned char*)c->hdr + cq_off);
+    c->data = (unsigned char*)c->hdr + data_off;
+    c->data_size = data_size;
+    c->mask = n - 1;
+
+    c->sq_efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    c->cq_efd = eventfd(0, EFD_CLOEXEC);
+    c->sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    memset(&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    snprintf(sa.sun_path, sizeof(sa.sun_path), "%s", sock_path);
+    if (c->sq_efd < 0 || c->cq_efd < 0 || c->sock < 0 || connect(c->sock, (struct sockaddr*)&sa, sizeof(sa)) != 0) goto fail;
+
+    // 'S'消息附带三个描述符：共享内存、提交eventfd、完成eventfd
+    {
+        struct msghdr msg;
+        struct iovec iov;
+        char type = 'S';
+        union {
+            struct cmsghdr align;
+            char buf[CMSG_SPACE(3 * sizeof(int))];
+        } ctl;
+        int fds[3] = { c->memfd, c->sq_efd, c->cq_efd };
+        memset(&msg, 0, sizeof(msg));
+        memset(&ctl, 0, sizeof(ctl));
+        iov.iov_base = &type;
+        iov.iov_len = 1;
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = ctl.buf;
+        msg.msg_controllen = sizeof(ctl.buf);
+        struct cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+        cm->cmsg_level = SOL_SOCKET;
+        cm->cmsg_type = SCM_RIGHTS;
+        cm->cmsg_len = CMSG_LEN(3 * sizeof(int));
+        memcpy(CMSG_DATA(cm), fds, sizeof(fds));
+        if (sendmsg(c->sock, &msg, MSG_NOSIGNAL) != 1) goto fail;
+    }
+    for (size_t got = 0; got < sizeof(ack);) {
+        ssize_t r = read(c->sock, ack + got, sizeof(ack) - got);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) goto fail;
+        got += (size_t)r;
+    }
+    if (ack[0] != 'A' || ack[1] != 0) goto fail;
+    return 0;
+
+fail:
+    sm3_shm_close(c);
+    return -1;
+}
+
+uint32_t sm3_shm_inflight(const SM3_SHM_CLIENT* c) {
+    return c->sq_tail - c->cq_head;
+}
+
+unsigned char* sm3_shm_alloc(SM3_SHM_CLIENT* c, size_t len) {
+    uint64_t start, pos;
+    if (len > c->data_size || sm3_shm_inflight(c) > c->mask) return NULL;
+    // 无在途请求时从数据区开头分配，使不超过data_size的请求总能成功
+    if (sm3_shm_inflight(c) == 0) c->free_tail = c->alloc_head = (c->alloc_head + c->data_size - 1) / c->data_size * c->data_size;
+    start = c->alloc_head;
+    pos = start % c->data_size;
+    if (pos + len > c->data_size) start += c->data_size - pos;          // 不跨越数据区末尾
+    if (start + len - c->free_tail > c->data_size) return NULL;
+    c->alloc_head = start + len;
+    return c->data + start % c->data_size;
+}
+
+int sm3_shm_submit(SM3_SHM_CLIENT* c, const unsigned char* p, size_t len, uint64_t user_data) {
+    SM3_SHM_SQE* e;
+    if (sm3_shm_inflight(c) > c->mask) return -1;
+    e = &c->sq[c->sq_tail & c->mask];
+    e->offset = (uint64_t)(p - c->data);
+    e->len = len;
+    e->user_data = user_data;
+    c->slot_end[c->sq_tail & c->mask] = c->alloc_head;
+    c->sq_tail++;
+    SM3_SHM_STORE(&c->hdr->sq_tail, c->sq_tail);
+    SM3_SHM_FENCE();
+    if (__atomic_exchange_n(&c->hdr->sq_need_wakeup, 0, __ATOMIC_ACQ_REL)) {
+        uint64_t one = 1;
+        if (write(c->sq_efd, &one, sizeof(one)) < 0) return -1;
+    }
+    return 0;
+}
+
+size_t sm3_shm_complete(SM3_SHM_CLIENT* c, SM3_SHM_CQE* out, size_t max, int wait) {
+    for (;;) {
+        uint32_t tail = SM3_SHM_LOAD(&c->hdr->cq_tail);
+        size_t n = 0;
+        while (c->cq_head != tail && n < max) {
+            uint32_t slot = c->cq_head & c->mask;
+            out[n++] = c->cq[slot];
+            c->free_tail = c->slot_end[slot];
+            c->cq_head++;
+        }
+        if (n > 0) {
+            SM3_SHM_STORE(&c->hdr->cq_head, c->cq_head);
+            return n;
+        }
+        if (!wait || max == 0 || c->cq_head == c->sq_tail) return 0;
+
+        // 休眠前置位标志并再次检查，避免错过服务端的发布
+        SM3_SHM_STORE(&c->hdr->cq_need_wakeup, 1);
+        SM3_SHM_FENCE();
+        if (SM3_SHM_LOAD(&c->hdr->cq_tail) != c->cq_head) continue;
+        uint64_t v;
+        if (read(c->cq_efd, &v, sizeof(v)) < 0 && errno != EINTR) return 0;
+    }
+}
+
+void sm3_shm_close(SM3_SHM_CLIENT* c) {
+    if (c->sock >= 0) close(c->sock);
+    if (c->hdr != NULL) munmap(c->hdr, c->map_size);
+    if (c->memfd >= 0) close(c->memfd);
+    if (c->sq_efd >= 0) close(c->sq_efd);
+    if (c->cq_efd >= 0) close(c->cq_efd);
+    free(c->slot_end);
+    memset(c, 0, sizeof(*c));
+    c->sock = c->memfd = c->sq_efd = c->cq_efd = -1;
+}
+
+// -------------------------- 服务端 --------------------------
+int sm3_shm_ring_attach(SM3_SHM_RING* r, int memfd) {
+    struct stat st;
+    SM3_SHM_HDR h;
+    uint64_t sq_off, cq_off, data_off;
+    int seals = fcntl(memfd, F_GET_SEALS);
+
+    memset(r, 0, sizeof(*r));
+    if (seals < 0 || !(seals & F_SEAL_SHRINK) || fstat(memfd, &st) != 0 || (size_t)st.st_size < sizeof(SM3_SHM_HDR)) return -1;
+    r->map_size = (size_t)st.st_size;
+    r->hdr = (SM3_SHM_HDR*)mmap(NULL, r->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (r->hdr == (SM3_SHM_HDR*)MAP_FAILED) {
+        r->hdr = NULL;
+        return -1;
+    }
+
+    // 布局只读取一次并按本端规则重新计算，之后只使用本地副本
+    memcpy(&h, r->hdr, sizeof(h));
+    if (h.magic != SM3_SHM_MAGIC || h.entries == 0 || h.entries > SHM_MAX_ENTRIES || (h.entries & (h.entries - 1)) != 0 ||
+        h.data_size == 0 || h.data_size > r->map_size ||
+        shm_layout(h.entries, h.data_size, &sq_off, &cq_off, &data_off) > r->map_size ||
+        h.sq_off != sq_off || h.cq_off != cq_off || h.data_off != data_off || h.sq_head != 0 || h.cq_tail != 0) {
+        sm3_shm_ring_detach(r);
+        return -1;
+    }
+    r->sq = (SM3_SHM_SQE*)((unsigned char*)r->hdr + sq_off);
+    r->cq = (SM3_SHM_CQE*)((unsigned char*)r->hdr + cq_off);
+    r->data = (const unsigned char*)r->hdr + data_off;
+    r->data_size = h.data_size;
+    r->mask = h.entries - 1;
+    return 0;
+}
+
+void sm3_shm_ring_detach(SM3_SHM_RING* r) {
+    if (r->hdr != NULL) munmap(r->hdr, r->map_size);
+    memset(r, 0, sizeof(*r));
+}
+
+int sm3_shm_ring_pop(SM3_SHM_RING* r, const unsigned char** data, size_t* len, uint64_t* user_data) {
+    uint32_t tail = SM3_SHM_LOAD(&r->hdr->sq_tail);
+    SM3_SHM_SQE e;
+    if (tail == r->sq_head) return 0;
+    if (tail - r->sq_head > r->mask + 1) return -1;
+    e = r->sq[r->sq_head & r->mask];
+    r->sq_head++;
+    SM3_SHM_STORE(&r->hdr->sq_head, r->sq_head);
+    *user_data = e.user_data;
+    *len = (size_t)e.len;
+    *data = (e.offset <= r->data_size && e.len <= r->data_size - e.offset) ? r->data + e.offset : NULL;
+    return 1;
+}
+
+int sm3_shm_ring_arm(SM3_SHM_RING* r) {
+    SM3_SHM_STORE(&r->hdr->sq_need_wakeup, 1);
+    SM3_SHM_FENCE();
+    if (SM3_SHM_LOAD(&r->hdr->sq_tail) == r->sq_head) return 1;
+    SM3_SHM_STORE(&r->hdr->sq_need_wakeup, 0);
+    return 0;
+}
+
+void sm3_shm_ring_post(SM3_SHM_RING* r, uint64_t user_data, uint32_t status, const unsigned char digest[SM3_DIGEST_SIZE]) {
+    SM3_SHM_CQE* e = &r->cq[r->cq_tail & r->mask];
+    e->user_data = user_data;
+    e->status = status;
+    e->reserved = 0;
+    if (digest != NULL) memcpy(e->digest, digest, SM3_DIGEST_SIZE);
+    else memset(e->digest, 0, SM3_DIGEST_SIZE);
+    r->cq_tail++;
+}
+
+int sm3_shm_ring_publish(SM3_SHM_RING* r) {
+    SM3_SHM_STORE(&r->hdr->cq_tail, r->cq_tail);
+    SM3_SHM_FENCE();
+    return __atomic_exchange_n(&r->hdr->cq_need_wakeup, 0, __ATOMIC_ACQ_REL) != 0;
+}
+#endif
@@ -0,0 +1,105 @@
+// sm3_shm.h - 共享内存零拷贝提交环（Linux，配合sm3d使用）
+#ifndef SM3_SHM_H
+#define SM3_SHM_H
+
+#include "sm3.h"
+
+// 客户端创建一块memfd共享内存（封印F_SEAL_SHRINK，服务端不会因对方截断而SIGBUS），布局为：
+//   头部 | 提交环（SQE × entries）| 完成环（CQE × entries）| 数据区
+// 客户端把数据直接写入数据区，在提交环中登记（偏移, 长度, user_data）；服务端原地计算摘要，
+// 把摘要写入完成环。两个环都是单生产者单消费者（SPSC），同一客户端的多个线程需各自建立连接或自行加锁
+// 唤醒使用两个eventfd：消费者准备休眠前置位need_wakeup标志，生产者发布后取走（清除）标志，只在标志曾置位时写eventfd，
+// 对方忙碌时不产生系统调用
+// 服务端按提交顺序完成，因此客户端的数据区按环形缓冲顺序回收；
+// 客户端在途请求数不超过entries，完成环不会溢出
+
+#define SM3_SHM_MAGIC 0x53334d52u            // "S3MR"
+#define SM3_SHM_DEFAULT_ENTRIES 1024
+#define SM3_SHM_DEFAULT_DATA (16u << 20)
+
+typedef struct {
+    uint64_t offset;                         // 数据在数据区中的偏移
+    uint64_t len;
+    uint64_t user_data;
+} SM3_SHM_SQE;
+
+typedef struct {
+    uint64_t user_data;
+    uint32_t status;                         // 0成功，非0表示描述符越界
+    uint32_t reserved;
+    unsigned char digest[SM3_DIGEST_SIZE];
+} SM3_SHM_CQE;
+
+// 共享头部：各方写入的字段分处不同缓存行
+typedef struct {
+    uint32_t magic, entries;                 // entries为2的幂
+    uint64_t sq_off, cq_off, data_off, data_size;
+    unsigned char pad0[64 - 40];
+    volatile uint32_t sq_head;               // 服务端写
+    volatile uint32_t sq_need_wakeup;        // 服务端置位，客户端提交时清除
+    unsigned char pad1[64 - 8];
+    volatile uint32_t sq_tail;               // 客户端写
+    unsigned char pad2[64 - 4];
+    volatile uint32_t cq_head;               // 客户端写
+    volatile uint32_t cq_need_wakeup;        // 客户端置位，服务端发布时清除
+    unsigned char pad3[64 - 8];
+    volatile uint32_t cq_tail;               // 服务端写
+    unsigned char pad4[64 - 4];
+} SM3_SHM_HDR;
+
+#define SM3_SHM_LOAD(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define SM3_SHM_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define SM3_SHM_FENCE() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+// -------------------------- 客户端 --------------------------
+typedef struct {
+    int sock, memfd, sq_efd, cq_efd;
+    SM3_SHM_HDR* hdr;
+    size_t map_size;
+    SM3_SHM_SQE* sq;
+    SM3_SHM_CQE* cq;
+    unsigned char* data;
+    uint64_t data_size;
+    uint32_t mask;
+    uint64_t alloc_head, free_tail;          // 数据区的虚拟偏移（单调递增）
+    uint64_t* slot_end;                      // 每个提交项占用的数据区末端，完成时据此回收
+    uint32_t sq_tail, cq_head;               // 本地副本
+} SM3_SHM_CLIENT;
+
+// 连接sm3d并建立共享内存环（entries向上取为2的幂），失败返回-1
+int sm3_shm_connect(SM3_SHM_CLIENT* c, const char* sock_path, unsigned int entries, size_t data_size);
+// 在数据区中分配len字节供调用者直接写入，空间不足（需先回收完成项）返回NULL；每次分配后必须紧接着提交
+unsigned char* sm3_shm_alloc(SM3_SHM_CLIENT* c, size_t len);
+// 提交sm3_shm_alloc返回的缓冲，在途请求已达entries时返回-1
+int sm3_shm_submit(SM3_SHM_CLIENT* c, const unsigned char* p, size_t len, uint64_t user_data);
+// 取出最多max个完成项并回收其数据区，wait非0时至少等到一个完成项（无在途请求时立即返回0）
+size_t sm3_shm_complete(SM3_SHM_CLIENT* c, SM3_SHM_CQE* out, size_t max, int wait);
+// 在途请求数
+uint32_t sm3_shm_inflight(const SM3_SHM_CLIENT* c);
+void sm3_shm_close(SM3_SHM_CLIENT* c);
+
+// -------------------------- 服务端 --------------------------
+typedef struct {
+    SM3_SHM_HDR* hdr;
+    size_t map_size;
+    SM3_SHM_SQE* sq;
+    SM3_SHM_CQE* cq;
+    const unsigned char* data;
+    uint64_t data_size;
+    uint32_t mask;
+    uint32_t sq_head, cq_tail;               // 本地副本
+} SM3_SHM_RING;
+
+// 映射客户端传来的memfd并校验布局与封印，失败返回-1
+int sm3_shm_ring_attach(SM3_SHM_RING* r, int memfd);
+void sm3_shm_ring_detach(SM3_SHM_RING* r);
+// 取出下一个提交项，无可取项返回0，提交环尾指针异常（超出entries）返回-1；描述符越界时*data为NULL
+int sm3_shm_ring_pop(SM3_SHM_RING* r, const unsigned char** data, size_t* len, uint64_t* user_data);
+// 准备休眠：置位need_wakeup后再次检查，提交环仍为空返回1，否则清除标志返回0（调用者继续取）
+int sm3_shm_ring_arm(SM3_SHM_RING* r);
+// 写入一个完成项（发布前客户端不可见）
+void sm3_shm_ring_post(SM3_SHM_RING* r, uint64_t user_data, uint32_t status, const unsigned char digest[SM3_DIGEST_SIZE]);
+// 发布已写入的完成项，客户端正在等待时返回1（调用者写完成eventfd）
+int sm3_shm_ring_publish(SM3_SHM_RING* r);
+
+#endif
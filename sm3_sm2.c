@@ -0,0 +1,148 @@
+// sm3_sm2.c - SM2身份杂凑值ZA与消息摘要实现
+// 验签时同一签名者反复出现：ZA按(ID, 公钥)缓存，默认ID的前缀中间状态只计算一次
+#include "sm3_sm2.h"
+#include "sm3_mb.h"
+#include "sm3_cache.h"
+#include <stdlib.h>
+
+#define SM2_DIGEST_CHUNK 256             // 批量摘要每轮处理的消息数
+
+// GM/T 0003.5 推荐曲线参数 a || b || xG || yG
+static const unsigned char SM2_CURVE[128] = {
+    0xFF, 0xFF, 0xFF, 0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFC,
+    0x28, 0xE9, 0xFA, 0x9E, 0x9D, 0x9F, 0x5E, 0x34, 0x4D, 0x5A, 0x9E, 0x4B, 0xCF, 0x65, 0x09, 0xA7,
+    0xF3, 0x97, 0x89, 0xF5, 0x15, 0xAB, 0x8F, 0x92, 0xDD, 0xBC, 0xBD, 0x41, 0x4D, 0x94, 0x0E, 0x93,
+    0x32, 0xC4, 0xAE, 0x2C, 0x1F, 0x19, 0x81, 0x19, 0x5F, 0x99, 0x04, 0x46, 0x6A, 0x39, 0xC9, 0x94,
+    0x8F, 0xE3, 0x0B, 0xBF, 0xF2, 0x66, 0x0B, 0xE1, 0x71, 0x5A, 0x45, 0x89, 0x33, 0x4C, 0x74, 0xC7,
+    0xBC, 0x37, 0x36, 0xA2, 0xF4, 0xF6, 0x77, 0x9C, 0x59, 0xBD, 0xCE, 0xE3, 0x6B, 0x69, 0x21, 0x53,
+    0xD0, 0xA9, 0x87, 0x7C, 0xC6, 0x2A, 0x47, 0x40, 0x02, 0xDF, 0x32, 0xE5, 0x21, 0x39, 0xF0, 0xA0
+};
+
+int sm3_sm2_id_init(SM3_SM2_ID* id, const unsigned char* uid, size_t uid_len) {
+    unsigned char entl[2];
+    if (uid_len > SM3_SM2_ID_MAX) return -1;
+    entl[0] = (unsigned char)((uid_len * 8) >> 8);
+    entl[1] = (unsigned char)(uid_len * 8);
+    sm3_init(&id->ctx);
+    sm3_update(&id->ctx, entl, 2);
+    sm3_update(&id->ctx, uid, uid_len);
+    sm3_update(&id->ctx, SM2_CURVE, sizeof(SM2_CURVE));
+    return 0;
+}
+
+void sm3_sm2_za_from_id(const SM3_SM2_ID* id, const unsigned char pub[SM3_SM2_PUBKEY_SIZE], unsigned char za[SM3_DIGEST_SIZE]) {
+    SM3_CTX ctx = id->ctx;
+    sm3_update(&ctx, pub, SM3_SM2_PUBKEY_SIZE);
+    sm3_final(&ctx, za);
+}
+
+int sm3_sm2_za(const unsigned char* uid, size_t uid_len, const unsigned char pub[SM3_SM2_PUBKEY_SIZE],
+    unsigned char za[SM3_DIGEST_SIZE]) {
+    SM3_SM2_ID id;
+    if (sm3_sm2_id_init(&id, uid, uid_len) != 0) return -1;
+    sm3_sm2_za_from_id(&id, pub, za);
+    return 0;
+}
+
+void sm3_sm2_msg_init(SM3_CTX* ctx, const unsigned char za[SM3_DIGEST_SIZE]) {
+    sm3_init(ctx);
+    memcpy(ctx->buffer, za, SM3_DIGEST_SIZE);
+    ctx->bitlen = SM3_DIGEST_SIZE * 8;
+}
+
+void sm3_sm2_digest(const unsigned char za[SM3_DIGEST_SIZE], const unsigned char* msg, size_t len,
+    unsigned char e[SM3_DIGEST_SIZE]) {
+    SM3_CTX ctx;
+    sm3_sm2_msg_init(&ctx, za);
+    sm3_update(&ctx, msg, len);
+    sm3_final(&ctx, e);
+}
+
+void sm3_sm2_digest_many(const unsigned char za[][SM3_DIGEST_SIZE], const unsigned char* const msgs[],
+    const size_t lens[], size_t n, unsigned char e[][SM3_DIGEST_SIZE]) {
+    SM3_CTX* ctxs = (SM3_CTX*)malloc(SM2_DIGEST_CHUNK * sizeof(SM3_CTX));
+    const SM3_CTX* cptr[SM2_DIGEST_CHUNK];
+
+    if (ctxs == NULL) {
+        for (size_t i = 0; i < n; i++) sm3_sm2_digest(za[i], msgs[i], lens[i], e[i]);
+        return;
+    }
+    for (size_t i = 0; i < n; i += SM2_DIGEST_CHUNK) {
+        size_t batch = n - i < SM2_DIGEST_CHUNK ? n - i : SM2_DIGEST_CHUNK;
+        for (size_t b = 0; b < batch; b++) {
+            sm3_sm2_msg_init(&ctxs[b], za[i + b]);
+            cptr[b] = &ctxs[b];
+        }
+        sm3_mb_finish(cptr, msgs + i, lens + i, batch, e + i);
+    }
+    free(ctxs);
+}
+
+// -------------------------- ZA缓存 --------------------------
+// 键为 公钥 || ID，值为ZA
+struct SM3_SM2_CACHE {
+    SM3_CACHE cache;
+    SM3_SM2_ID default_id;
+};
+
+SM3_SM2_CACHE* sm3_sm2_cache_create(size_t capacity) {
+    SM3_SM2_CACHE* cache = (SM3_SM2_CACHE*)malloc(sizeof(SM3_SM2_CACHE));
+
+    if (cache == NULL) return NULL;
+    if (sm3_cache_init(&cache->cache, capacity, SM3_SM2_PUBKEY_SIZE + SM3_SM2_CACHE_ID_MAX, SM3_DIGEST_SIZE) != 0) {
+        free(cache);
+        return NULL;
+    }
+    sm3_sm2_id_init(&cache->default_id, (const unsigned char*)SM3_SM2_DEFAULT_ID, SM3_SM2_DEFAULT_ID_LEN);
+    return cache;
+}
+
+void sm3_sm2_cache_destroy(SM3_SM2_CACHE* cache) {
+    if (cache == NULL) return;
+    sm3_cache_free(&cache->cache);
+    free(cache);
+}
+
+int sm3_sm2_cache_za(SM3_SM2_CACHE* cache, const unsigned char* uid, size_t uid_len,
+    const unsigned char pub[SM3_SM2_PUBKEY_SIZE], unsigned char za[SM3_DIGEST_SIZE]) {
+    unsigned char key[SM3_SM2_PUBKEY_SIZE + SM3_SM2_CACHE_ID_MAX];
+    int is_default = uid_len == SM3_SM2_DEFAULT_ID_LEN && memcmp(uid, SM3_SM2_DEFAULT_ID, SM3_SM2_DEFAULT_ID_LEN) == 0;
+
+    if (uid_len > SM3_SM2_CACHE_ID_MAX) {
+        sm3_cache_bypass(&cache->cache, uid_len);
+        return sm3_sm2_za(uid, uid_len, pub, za) == 0 ? 0 : -1;
+    }
+    memcpy(key, pub, SM3_SM2_PUBKEY_SIZE);
+    memcpy(key + SM3_SM2_PUBKEY_SIZE, uid, uid_len);
+    if (sm3_cache_get(&cache->cache, key, SM3_SM2_PUBKEY_SIZE + uid_len, za)) return 1;
+
+    // 锁外计算ZA，其他线程可同时访问该分片
+    if (is_default) sm3_sm2_za_from_id(&cache->default_id, pub, za);
+    else sm3_sm2_za(uid, uid_len, pub, za);
+    sm3_cache_put(&cache->cache, key, SM3_SM2_PUBKEY_SIZE + uid_len, za);
+    return 0;
+}
+
+int sm3_sm2_cache_msg_init(SM3_SM2_CACHE* cache, const unsigned char* uid, size_t uid_len,
+    const unsigned char pub[SM3_SM2_PUBKEY_SIZE], SM3_CTX* ctx) {
+    unsigned char za[SM3_DIGEST_SIZE];
+    int ret = sm3_sm2_cache_za(cache, uid, uid_len, pub, za);
+    if (ret >= 0) sm3_sm2_msg_init(ctx, za);
+    return ret;
+}
+
+int sm3_sm2_cache_digest(SM3_SM2_CACHE* cache, const unsigned char* uid, size_t uid_len,
+    const unsigned char pub[SM3_SM2_PUBKEY_SIZE], const unsigned char* msg, size_t len, unsigned char e[SM3_DIGEST_SIZE]) {
+    unsigned char za[SM3_DIGEST_SIZE];
+    int ret = sm3_sm2_cache_za(cache, uid, uid_len, pub, za);
+    if (ret >= 0) sm3_sm2_digest(za, msg, len, e);
+    return ret;
+}
+
+void sm3_sm2_cache_stats(SM3_SM2_CACHE* cache, uint64_t* hits, uint64_t* misses) {
+    SM3_CACHE_STATS cs;
+    sm3_cache_stats(&cache->cache, &cs);
+    if (hits) *hits = cs.hits;
+    if (misses) *misses = cs.misses;
+}
@@ -0,0 +1,61 @@
+// sm3_sm2.h - SM2签名中的SM3杂凑部分（GM/T 0003.2 用户身份杂凑值ZA与消息摘要e）
+#ifndef SM3_SM2_H
+#define SM3_SM2_H
+
+#include "sm3.h"
+
+// ZA = SM3(ENTL || ID || a || b || xG || yG || xA || yA)，e = SM3(ZA || M)
+// 曲线参数固定为GM/T 0003.5推荐的256位曲线，公钥为未压缩坐标 xA || yA（各32字节，不含0x04前缀）
+// ENTL为ID的比特长度（16位），因此ID最长8191字节
+
+#define SM3_SM2_PUBKEY_SIZE 64
+#define SM3_SM2_ID_MAX 8191
+#define SM3_SM2_DEFAULT_ID "1234567812345678"    // 未约定ID时使用的默认值
+#define SM3_SM2_DEFAULT_ID_LEN 16
+
+// ID前缀中间状态：ENTL || ID || a || b || xG || yG 与公钥无关，同一ID的各个签名者共用
+// 默认ID时前缀146字节，其中两个完整分组只压缩一次，之后每个公钥只需再压缩两个分组
+typedef struct {
+    SM3_CTX ctx;
+} SM3_SM2_ID;
+
+// ID超过SM3_SM2_ID_MAX时返回-1
+int sm3_sm2_id_init(SM3_SM2_ID* id, const unsigned char* uid, size_t uid_len);
+void sm3_sm2_za_from_id(const SM3_SM2_ID* id, const unsigned char pub[SM3_SM2_PUBKEY_SIZE], unsigned char za[SM3_DIGEST_SIZE]);
+int sm3_sm2_za(const unsigned char* uid, size_t uid_len, const unsigned char pub[SM3_SM2_PUBKEY_SIZE],
+    unsigned char za[SM3_DIGEST_SIZE]);
+
+// 消息摘要：ZA只有32字节、不足一个分组，其中间状态就是初始向量加缓冲区中的ZA，
+// 这里直接构造该上下文（不经过sm3_init/sm3_update），之后对M调用sm3_update/sm3_final
+void sm3_sm2_msg_init(SM3_CTX* ctx, const unsigned char za[SM3_DIGEST_SIZE]);
+void sm3_sm2_digest(const unsigned char za[SM3_DIGEST_SIZE], const unsigned char* msg, size_t len,
+    unsigned char e[SM3_DIGEST_SIZE]);
+// 批量消息摘要：n条(ZA, M)经多路并行接口计算
+void sm3_sm2_digest_many(const unsigned char za[][SM3_DIGEST_SIZE], const unsigned char* const msgs[],
+    const size_t lens[], size_t n, unsigned char e[][SM3_DIGEST_SIZE]);
+
+// -------------------------- ZA缓存 --------------------------
+// 按(ID, 公钥)缓存ZA，容量固定、分片加锁，可被多个线程同时使用
+// 每个分片为4路组相联表，组满时替换最久未命中的项；ID超过SM3_SM2_CACHE_ID_MAX字节时不缓存（直接计算）
+// 默认ID的前缀中间状态在创建时预先计算
+
+#define SM3_SM2_CACHE_ID_MAX 64
+
+typedef struct SM3_SM2_CACHE SM3_SM2_CACHE;
+
+// capacity为缓存的ZA个数上限（向上取整到分片与组的整数倍）。失败返回NULL
+SM3_SM2_CACHE* sm3_sm2_cache_create(size_t capacity);
+void sm3_sm2_cache_destroy(SM3_SM2_CACHE* cache);
+// 取得ZA：命中返回1，未命中（已计算并写入缓存）返回0，ID超过SM3_SM2_ID_MAX返回-1
+int sm3_sm2_cache_za(SM3_SM2_CACHE* cache, const unsigned char* uid, size_t uid_len,
+    const unsigned char pub[SM3_SM2_PUBKEY_SIZE], unsigned char za[SM3_DIGEST_SIZE]);
+// 取得已吸收ZA的消息摘要上下文，返回值同上
+int sm3_sm2_cache_msg_init(SM3_SM2_CACHE* cache, const unsigned char* uid, size_t uid_len,
+    const unsigned char pub[SM3_SM2_PUBKEY_SIZE], SM3_CTX* ctx);
+// e = SM3(ZA || M)，ZA取自缓存，返回值同上
+int sm3_sm2_cache_digest(SM3_SM2_CACHE* cache, const unsigned char* uid, size_t uid_len,
+    const unsigned char pub[SM3_SM2_PUBKEY_SIZE], const unsigned char* msg, size_t len, unsigned char e[SM3_DIGEST_SIZE]);
+// 命中/未命中计数（各分片累加）
+void sm3_sm2_cache_stats(SM3_SM2_CACHE* cache, uint64_t* hits, uint64_t* misses);
+
+#endif
@@ -0,0 +1,117 @@
+// sm3_tree.c - SM3树哈希实现
+// 叶子摘要共享"已吸收0x00前缀"的中间状态，经多路并行接口一次计算多个叶子
+#include "sm3_tree.h"
+#include "sm3_mb.h"
+#include <stdlib.h>
+
+#define TREE_FILE_LEAVES 16              // 文件模式每次读入的叶子数
+
+uint64_t sm3_tree_leaf_count(uint64_t len, size_t leaf_size) {
+    return len == 0 ? 1 : (len + leaf_size - 1) / leaf_size;
+}
+
+// 批量计算叶子摘要
+void sm3_tree_leaves(const unsigned char* data, size_t len, size_t leaf_size, unsigned char digests[][SM3_DIGEST_SIZE]) {
+    static const unsigned char leaf_prefix = 0x00;
+    const unsigned char* ptrs[SM3_MB_LANES];
+    const SM3_CTX* cptr[SM3_MB_LANES];
+    size_t lens[SM3_MB_LANES];
+    SM3_CTX prefix;
+    size_t n = (size_t)sm3_tree_leaf_count(len, leaf_size);
+
+    sm3_init(&prefix);
+    sm3_update(&prefix, &leaf_prefix, 1);
+    for (size_t l = 0; l < SM3_MB_LANES; l++) cptr[l] = &prefix;
+
+    for (size_t i = 0; i < n; i += SM3_MB_LANES) {
+        size_t batch = n - i < SM3_MB_LANES ? n - i : SM3_MB_LANES;
+        for (size_t b = 0; b < batch; b++) {
+            size_t off = (i + b) * leaf_size;
+            ptrs[b] = data + off;
+            lens[b] = len - off < leaf_size ? len - off : leaf_size;
+        }
+        sm3_mb_finish(cptr, ptrs, lens, batch, digests + i);
+    }
+}
+
+void sm3_tree_node(const unsigned char left[SM3_DIGEST_SIZE], const unsigned char right[SM3_DIGEST_SIZE],
+    unsigned char out[SM3_DIGEST_SIZE]) {
+    unsigned char buf[1 + 2 * SM3_DIGEST_SIZE];
+    buf[0] = 0x01;
+    memcpy(buf + 1, left, SM3_DIGEST_SIZE);
+    memcpy(buf + 1 + SM3_DIGEST_SIZE, right, SM3_DIGEST_SIZE);
+    sm3_hash(buf, sizeof(buf), out);
+}
+
+// 递归合并：左子树取小于n的最大2的幂个节点
+void sm3_tree_root(const unsigned char nodes[][SM3_DIGEST_SIZE], size_t n, unsigned char out[SM3_DIGEST_SIZE]) {
+    unsigned char left[SM3_DIGEST_SIZE], right[SM3_DIGEST_SIZE];
+    size_t k = 1;
+    if (n == 1) {
+        memcpy(out, nodes[0], SM3_DIGEST_SIZE);
+        return;
+    }
+    while (k * 2 < n) k *= 2;
+    sm3_tree_root(nodes, k, left);
+    sm3_tree_root(nodes + k, n - k, right);
+    sm3_tree_node(left, right, out);
+}
+
+int sm3_tree_hash(const unsigned char* data, size_t len, size_t leaf_size, unsigned char out[SM3_DIGEST_SIZE]) {
+    size_t n = (size_t)sm3_tree_leaf_count(len, leaf_size);
+    unsigned char (*leaves)[SM3_DIGEST_SIZE] = (unsigned char (*)[SM3_DIGEST_SIZE])malloc(n * SM3_DIGEST_SIZE);
+    if (leaves == NULL) return -1;
+    sm3_tree_leaves(data, len, leaf_size, leaves);
+    sm3_tree_root((const unsigned char (*)[SM3_DIGEST_SIZE])leaves, n, out);
+    free(leaves);
+    return 0;
+}
+
+// 文件区间：顺序读入若干叶子后批量计算，最后合并全部叶子摘要
+int sm3_tree_file_hash(const char* filename, uint64_t offset, uint64_t length, size_t leaf_size,
+    unsigned char out[SM3_DIGEST_SIZE]) {
+    FILE* f = fopen(filename, "rb");
+    unsigned char* buf = NULL;
+    unsigned char (*leaves)[SM3_DIGEST_SIZE] = NULL;
+    size_t nleaves = 0, cap = 0;
+    uint64_t done = 0;
+    int ret = -1;
+
+    if (f == NULL || leaf_size == 0) goto out;
+#ifdef _WIN32
+    if (_fseeki64(f, (__int64)offset, SEEK_SET) != 0) goto out;
+#else
+    if (fseeko(f, (off_t)offset, SEEK_SET) != 0) goto out;
+#endif
+    buf = (unsigned char*)malloc(leaf_size * TREE_FILE_LEAVES);
+    if (buf == NULL) goto out;
+
+    for (;;) {
+        size_t want = leaf_size * TREE_FILE_LEAVES;
+        if (length - done < want) want = (size_t)(length - done);
+        size_t got = want ? fread(buf, 1, want, f) : 0;
+        if (got == 0 && nleaves > 0) break;           // 空区间仍需计算一个空叶子
+        size_t n = (size_t)sm3_tree_leaf_count(got, leaf_size);
+        if (nleaves + n > cap) {
+            size_t ncap = cap ? cap * 2 : 64;
+            while (ncap < nleaves + n) ncap *= 2;
+            void* p = realloc(leaves, ncap * SM3_DIGEST_SIZE);
+            if (p == NULL) goto out;
+            leaves = (unsigned char (*)[SM3_DIGEST_SIZE])p;
+            cap = ncap;
+        }
+        sm3_tree_leaves(buf, got, leaf_size, leaves + nleaves);
+        nleaves += n;
+        done += got;
+        if (got < want || done == length) break;
+    }
+    if (ferror(f)) goto out;
+    sm3_tree_root((const unsigned char (*)[SM3_DIGEST_SIZE])leaves, nleaves, out);
+    ret = 0;
+
+out:
+    if (f) fclose(f);
+    free(buf);
+    free(leaves);
+    return ret;
+}
@@ -0,0 +1,32 @@
+// sm3_tree.h - SM3树哈希（Merkle树）模式
+#ifndef SM3_TREE_H
+#define SM3_TREE_H
+
+#include "sm3.h"
+
+// 数据按leaf_size切分为叶子（最后一个叶子可以较短；空数据视为一个空叶子）：
+//   叶子摘要 = SM3(0x00 || 叶子数据)
+//   内部节点 = SM3(0x01 || 左子树根 || 右子树根)
+// n个节点的树按"左侧取小于n的最大2的幂"递归划分（与RFC 6962相同），
+// 因此任意按2^k个叶子对齐的连续区间恰好是一棵完整子树：
+// 各区间独立计算子树根后，再用sm3_tree_root合并即得到整体根，适合多线程/多进程分段计算
+
+#define SM3_TREE_LEAF_DEFAULT (1u << 20)    // 默认叶子大小（1MB）
+
+// 数据长度对应的叶子数（至少为1）
+uint64_t sm3_tree_leaf_count(uint64_t len, size_t leaf_size);
+// 计算一段数据的全部叶子摘要（经多路并行接口批量计算），digests需容纳sm3_tree_leaf_count个摘要
+void sm3_tree_leaves(const unsigned char* data, size_t len, size_t leaf_size, unsigned char digests[][SM3_DIGEST_SIZE]);
+// 计算内部节点
+void sm3_tree_node(const unsigned char left[SM3_DIGEST_SIZE], const unsigned char right[SM3_DIGEST_SIZE],
+    unsigned char out[SM3_DIGEST_SIZE]);
+// 由n个（按序排列的叶子或对齐子树的）根合并出树根
+void sm3_tree_root(const unsigned char nodes[][SM3_DIGEST_SIZE], size_t n, unsigned char out[SM3_DIGEST_SIZE]);
+// 计算内存数据的树哈希，内存不足返回-1
+int sm3_tree_hash(const unsigned char* data, size_t len, size_t leaf_size, unsigned char out[SM3_DIGEST_SIZE]);
+// 计算文件[offset, offset+length)区间的子树根（length为UINT64_MAX时到文件末尾），失败返回-1
+// 区间起点应按leaf_size*2^k对齐，区间结果才能与其他区间合并
+int sm3_tree_file_hash(const char* filename, uint64_t offset, uint64_t length, size_t leaf_size,
+    unsigned char out[SM3_DIGEST_SIZE]);
+
+#endif
@@ -0,0 +1,480 @@
+// sm3_xmss.c - WOTS+ / XMSS式哈希签名实现
+// 链函数每步两次压缩：ADRS || M 分组（逐通道）+ 仅含填充的常量分组（预先扩展，广播到各通道）
+#include "sm3_xmss.h"
+#include "sm3_mb.h"
+#include "sm3_hmac.h"
+#include <stdlib.h>
+
+#define WOTS_LEN1 64                         // 32字节摘要的16进制位数
+#define WOTS_LEN2 3                          // 校验和位数（最大64*15=960 < 16^3）
+#define XMSS_LEAVES_PER_BATCH 4              // 密钥生成时一次送入通道的叶子数（4*67条链）
+#define XMSS_TASK_LEAVES 64                  // 线程池中每个任务负责的叶子数
+
+// ADRS类型
+#define ADRS_WOTS_HASH 0
+#define ADRS_WOTS_PK 1
+#define ADRS_TREE 2
+#define ADRS_WOTS_PRF 5
+
+#define ADRS_TYPE 16
+#define ADRS_LEAF 20
+#define ADRS_CHAIN 24                        // 树节点：高度
+#define ADRS_HASH 28                         // 树节点：序号
+
+// 与PK.seed相关的预计算
+typedef struct {
+    uint32_t seed_state[8];                  // 已压缩 PK.seed || 0^32 的状态
+    unsigned char pad_block[SM3_BLOCK_SIZE]; // 128字节消息（F）的填充分组
+    uint32_t pad_W[68];                      // 上述分组的消息扩展
+} XMSS_HCTX;
+
+// 一条链的计算任务：从start步开始再走steps步
+typedef struct {
+    unsigned char adrs[32];
+    unsigned char val[SM3_DIGEST_SIZE];
+    unsigned int start, steps;
+    unsigned char* out;
+} CHAIN_JOB;
+
+static void put_u32(unsigned char* p, uint32_t v) {
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+static uint32_t get_u32(const unsigned char* p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | (uint32_t)p[3];
+}
+
+static void store_state(const uint32_t state[8], unsigned char out[SM3_DIGEST_SIZE]) {
+    for (int i = 0; i < 8; i++) put_u32(out + i * 4, state[i]);
+}
+
+static void adrs_init(unsigned char adrs[32], uint32_t type, uint32_t leaf) {
+    memset(adrs, 0, 32);
+    put_u32(adrs + ADRS_TYPE, type);
+    put_u32(adrs + ADRS_LEAF, leaf);
+}
+
+static void hctx_init(XMSS_HCTX* hc, const unsigned char pub_seed[SM3_DIGEST_SIZE]) {
+    unsigned char block[SM3_BLOCK_SIZE] = { 0 };
+    SM3_CTX iv;
+    sm3_init(&iv);
+    memcpy(block, pub_seed, SM3_DIGEST_SIZE);
+    memcpy(hc->seed_state, iv.state, sizeof(hc->seed_state));
+    sm3_compress_blocks(hc->seed_state, block, 1);
+    memset(hc->pad_block, 0, SM3_BLOCK_SIZE);
+    hc->pad_block[0] = 0x80;
+    hc->pad_block[SM3_BLOCK_SIZE - 2] = (unsigned char)((2 * SM3_BLOCK_SIZE * 8) >> 8);
+    hc->pad_block[SM3_BLOCK_SIZE - 1] = (unsigned char)(2 * SM3_BLOCK_SIZE * 8);
+    sm3_mb_expand(hc->pad_block, hc->pad_W);
+}
+
+// 任意长度M的Th（WOTS+公钥压缩、消息摘要等）
+static void th_long(const XMSS_HCTX* hc, const unsigned char adrs[32], const unsigned char* m, size_t len,
+    unsigned char out[SM3_DIGEST_SIZE]) {
+    SM3_CTX ctx;
+    memcpy(ctx.state, hc->seed_state, sizeof(ctx.state));
+    ctx.bitlen = SM3_BLOCK_SIZE * 8;
+    memset(ctx.buffer, 0, sizeof(ctx.buffer));
+    sm3_update(&ctx, adrs, 32);
+    sm3_update(&ctx, m, len);
+    sm3_final(&ctx, out);
+}
+
+// 单通道F：block为 ADRS || M，结果写入out
+static void f_one(const XMSS_HCTX* hc, const unsigned char block[SM3_BLOCK_SIZE], unsigned char out[SM3_DIGEST_SIZE]) {
+    uint32_t s[8];
+    memcpy(s, hc->seed_state, sizeof(s));
+    sm3_compress_blocks(s, block, 1);
+    sm3_compress_blocks(s, hc->pad_block, 1);
+    store_state(s, out);
+}
+
+// 链任务调度：通道中的链走完即换入下一条，保持通道满载；最后只剩一条链时用标量压缩收尾
+static void chains_run(const XMSS_HCTX* hc, CHAIN_JOB* jobs, size_t n) {
+    unsigned char blk[SM3_MB_LANES][SM3_BLOCK_SIZE];
+    const unsigned char* bp[SM3_MB_LANES];
+    uint32_t st[8][SM3_MB_LANES];
+    CHAIN_JOB* lane[SM3_MB_LANES] = { 0 };
+    unsigned int pos[SM3_MB_LANES] = { 0 };
+    size_t next = 0, active = 0, l;
+
+    memset(blk, 0, sizeof(blk));
+    for (l = 0; l < SM3_MB_LANES; l++) bp[l] = blk[l];
+    for (;;) {
+        for (l = 0; l < SM3_MB_LANES; l++) {
+            if (lane[l] != NULL) continue;
+            while (next < n && jobs[next].steps == 0) {
+                memcpy(jobs[next].out, jobs[next].val, SM3_DIGEST_SIZE);
+                next++;
+            }
+            if (next >= n) continue;
+            lane[l] = &jobs[next++];
+            pos[l] = 0;
+            memcpy(blk[l], lane[l]->adrs, 32);
+            active++;
+        }
+        if (active == 0) break;
+
+        if (active == 1 && next >= n) {
+            for (l = 0; lane[l] == NULL; l++) {}
+            CHAIN_JOB* j = lane[l];
+            for (; pos[l] < j->steps; pos[l]++) {
+                put_u32(blk[l] + ADRS_HASH, j->start + pos[l]);
+                memcpy(blk[l] + 32, j->val, SM3_DIGEST_SIZE);
+                f_one(hc, blk[l], j->val);
+            }
+            memcpy(j->out, j->val, SM3_DIGEST_SIZE);
+            break;
+        }
+
+        for (l = 0; l < SM3_MB_LANES; l++) {
+            if (lane[l] != NULL) {
+                put_u32(blk[l] + ADRS_HASH, lane[l]->start + pos[l]);
+                memcpy(blk[l] + 32, lane[l]->val, SM3_DIGEST_SIZE);
+            }
+            for (int w = 0; w < 8; w++) st[w][l] = hc->seed_state[w];
+        }
+        sm3_mb_compress(st, bp);
+        sm3_mb_compress_shared(st, hc->pad_W);
+        for (l = 0; l < SM3_MB_LANES; l++) {
+            uint32_t s[8];
+            CHAIN_JOB* j = lane[l];
+            if (j == NULL) continue;
+            for (int w = 0; w < 8; w++) s[w] = st[w][l];
+            store_state(s, j->val);
+            if (++pos[l] == j->steps) {
+                memcpy(j->out, j->val, SM3_DIGEST_SIZE);
+                lane[l] = NULL;
+                active--;
+            }
+        }
+    }
+    memset(blk, 0, sizeof(blk));
+}
+
+// 摘要转为67个16进制位（64个消息位 + 3个校验和位）
+static void wots_digits(const unsigned char digest[SM3_DIGEST_SIZE], unsigned int d[SM3_WOTS_LEN]) {
+    unsigned int csum = 0;
+    for (int i = 0; i < WOTS_LEN1; i++) {
+        d[i] = (i & 1) ? (digest[i / 2] & 0x0f) : (digest[i / 2] >> 4);
+        csum += SM3_WOTS_W - 1 - d[i];
+    }
+    for (int i = 0; i < WOTS_LEN2; i++) d[WOTS_LEN1 + i] = (csum >> (4 * (WOTS_LEN2 - 1 - i))) & 0x0f;
+}
+
+// 为nleaves个叶子的全部链设置私钥元素任务（PRF）
+static void wots_prf_jobs(CHAIN_JOB* jobs, const unsigned char sk_seed[SM3_DIGEST_SIZE], uint32_t first_leaf, size_t nleaves) {
+    for (size_t k = 0; k < nleaves; k++) {
+        for (int i = 0; i < SM3_WOTS_LEN; i++) {
+            CHAIN_JOB* j = &jobs[k * SM3_WOTS_LEN + i];
+            adrs_init(j->adrs, ADRS_WOTS_PRF, first_leaf + (uint32_t)k);
+            put_u32(j->adrs + ADRS_CHAIN, (uint32_t)i);
+            memcpy(j->val, sk_seed, SM3_DIGEST_SIZE);
+            j->start = 0;
+            j->steps = 1;
+            j->out = j->val;
+        }
+    }
+}
+
+// 由PRF结果转为链任务：从第start步走steps步
+static void wots_chain_job(CHAIN_JOB* j, uint32_t leaf, int chain, unsigned int start, unsigned int steps, unsigned char* out) {
+    adrs_init(j->adrs, ADRS_WOTS_HASH, leaf);
+    put_u32(j->adrs + ADRS_CHAIN, (uint32_t)chain);
+    j->start = start;
+    j->steps = steps;
+    j->out = out;
+}
+
+static void wots_compress_pk(const XMSS_HCTX* hc, uint32_t leaf, const unsigned char* pk, unsigned char out[SM3_DIGEST_SIZE]) {
+    unsigned char adrs[32];
+    adrs_init(adrs, ADRS_WOTS_PK, leaf);
+    th_long(hc, adrs, pk, SM3_WOTS_SIG_SIZE, out);
+}
+
+// nleaves个连续叶子的压缩公钥
+static int wots_leaves(const XMSS_HCTX* hc, const unsigned char sk_seed[SM3_DIGEST_SIZE], uint32_t first_leaf, size_t nleaves,
+    unsigned char (*leaves)[SM3_DIGEST_SIZE]) {
+    CHAIN_JOB* jobs = (CHAIN_JOB*)malloc(XMSS_LEAVES_PER_BATCH * SM3_WOTS_LEN * sizeof(CHAIN_JOB));
+    unsigned char* pk = (unsigned char*)malloc(XMSS_LEAVES_PER_BATCH * SM3_WOTS_SIG_SIZE);
+    if (jobs == NULL || pk == NULL) {
+        free(jobs);
+        free(pk);
+        return -1;
+    }
+    for (size_t b = 0; b < nleaves; b += XMSS_LEAVES_PER_BATCH) {
+        size_t cnt = nleaves - b < XMSS_LEAVES_PER_BATCH ? nleaves - b : XMSS_LEAVES_PER_BATCH;
+        uint32_t leaf = first_leaf + (uint32_t)b;
+        wots_prf_jobs(jobs, sk_seed, leaf, cnt);
+        chains_run(hc, jobs, cnt * SM3_WOTS_LEN);
+        for (size_t k = 0; k < cnt; k++) {
+            for (int i = 0; i < SM3_WOTS_LEN; i++) {
+                wots_chain_job(&jobs[k * SM3_WOTS_LEN + i], leaf + (uint32_t)k, i, 0, SM3_WOTS_W - 1,
+                    pk + (k * SM3_WOTS_LEN + i) * SM3_DIGEST_SIZE);
+            }
+        }
+        chains_run(hc, jobs, cnt * SM3_WOTS_LEN);
+        for (size_t k = 0; k < cnt; k++) wots_compress_pk(hc, leaf + (uint32_t)k, pk + k * SM3_WOTS_SIG_SIZE, leaves[b + k]);
+    }
+    memset(jobs, 0, XMSS_LEAVES_PER_BATCH * SM3_WOTS_LEN * sizeof(CHAIN_JOB));
+    free(jobs);
+    free(pk);
+    return 0;
+}
+
+void sm3_wots_public_key(const unsigned char sk_seed[SM3_DIGEST_SIZE], const unsigned char pub_seed[SM3_DIGEST_SIZE],
+    uint32_t leaf, unsigned char pk[SM3_DIGEST_SIZE]) {
+    XMSS_HCTX hc;
+    hctx_init(&hc, pub_seed);
+    if (wots_leaves(&hc, sk_seed, leaf, 1, (unsigned char (*)[SM3_DIGEST_SIZE])pk) != 0) memset(pk, 0, SM3_DIGEST_SIZE);
+}
+
+static void wots_sign_hc(const XMSS_HCTX* hc, const unsigned char sk_seed[SM3_DIGEST_SIZE], uint32_t leaf,
+    const unsigned char digest[SM3_DIGEST_SIZE], unsigned char sig[SM3_WOTS_SIG_SIZE]) {
+    CHAIN_JOB jobs[SM3_WOTS_LEN];
+    unsigned int d[SM3_WOTS_LEN];
+    wots_digits(digest, d);
+    wots_prf_jobs(jobs, sk_seed, leaf, 1);
+    chains_run(hc, jobs, SM3_WOTS_LEN);
+    for (int i = 0; i < SM3_WOTS_LEN; i++) wots_chain_job(&jobs[i], leaf, i, 0, d[i], sig + i * SM3_DIGEST_SIZE);
+    chains_run(hc, jobs, SM3_WOTS_LEN);
+    memset(jobs, 0, sizeof(jobs));
+}
+
+static void wots_pk_from_sig_hc(const XMSS_HCTX* hc, uint32_t leaf, const unsigned char digest[SM3_DIGEST_SIZE],
+    const unsigned char sig[SM3_WOTS_SIG_SIZE], unsigned char pk[SM3_DIGEST_SIZE]) {
+    CHAIN_JOB jobs[SM3_WOTS_LEN];
+    unsigned char ends[SM3_WOTS_SIG_SIZE];
+    unsigned int d[SM3_WOTS_LEN];
+    wots_digits(digest, d);
+    for (int i = 0; i < SM3_WOTS_LEN; i++) {
+        wots_chain_job(&jobs[i], leaf, i, d[i], SM3_WOTS_W - 1 - d[i], ends + i * SM3_DIGEST_SIZE);
+        memcpy(jobs[i].val, sig + i * SM3_DIGEST_SIZE, SM3_DIGEST_SIZE);
+    }
+    chains_run(hc, jobs, SM3_WOTS_LEN);
+    wots_compress_pk(hc, leaf, ends, pk);
+}
+
+void sm3_wots_sign(const unsigned char sk_seed[SM3_DIGEST_SIZE], const unsigned char pub_seed[SM3_DIGEST_SIZE],
+    uint32_t leaf, const unsigned char digest[SM3_DIGEST_SIZE], unsigned char sig[SM3_WOTS_SIG_SIZE]) {
+    XMSS_HCTX hc;
+    hctx_init(&hc, pub_seed);
+    wots_sign_hc(&hc, sk_seed, leaf, digest, sig);
+}
+
+void sm3_wots_pk_from_sig(const unsigned char pub_seed[SM3_DIGEST_SIZE], uint32_t leaf,
+    const unsigned char digest[SM3_DIGEST_SIZE], const unsigned char sig[SM3_WOTS_SIG_SIZE], unsigned char pk[SM3_DIGEST_SIZE]) {
+    XMSS_HCTX hc;
+    hctx_init(&hc, pub_seed);
+    wots_pk_from_sig_hc(&hc, leaf, digest, sig, pk);
+}
+
+// -------------------------- Merkle树 --------------------------
+// 父节点 = Th(PK.seed, ADRS(TREE, 高度, 序号), 左 || 右)：消息共160字节，
+// 第二个分组为 ADRS || 左，第三个分组为 右 || 填充，两者都逐通道压缩
+static void tree_block(unsigned char blk[2][SM3_BLOCK_SIZE], unsigned int height, uint32_t index,
+    const unsigned char left[SM3_DIGEST_SIZE], const unsigned char right[SM3_DIGEST_SIZE]) {
+    const uint32_t bits = (SM3_BLOCK_SIZE + 32 + 2 * SM3_DIGEST_SIZE) * 8;
+    adrs_init(blk[0], ADRS_TREE, 0);
+    put_u32(blk[0] + ADRS_CHAIN, height);
+    put_u32(blk[0] + ADRS_HASH, index);
+    memcpy(blk[0] + 32, left, SM3_DIGEST_SIZE);
+    memcpy(blk[1], right, SM3_DIGEST_SIZE);
+    memset(blk[1] + SM3_DIGEST_SIZE, 0, SM3_BLOCK_SIZE - SM3_DIGEST_SIZE);
+    blk[1][SM3_DIGEST_SIZE] = 0x80;
+    blk[1][SM3_BLOCK_SIZE - 2] = (unsigned char)(bits >> 8);
+    blk[1][SM3_BLOCK_SIZE - 1] = (unsigned char)bits;
+}
+
+static void tree_node(const XMSS_HCTX* hc, unsigned int height, uint32_t index,
+    const unsigned char left[SM3_DIGEST_SIZE], const unsigned char right[SM3_DIGEST_SIZE], unsigned char out[SM3_DIGEST_SIZE]) {
+    unsigned char blk[2][SM3_BLOCK_SIZE];
+    uint32_t s[8];
+    tree_block(blk, height, index, left, right);
+    memcpy(s, hc->seed_state, sizeof(s));
+    sm3_compress_blocks(s, blk[0], 2);
+    store_state(s, out);
+}
+
+// 由一层的n个子节点对（children[2i], children[2i+1]）计算n个父节点，8个一组多路压缩
+static void tree_level(const XMSS_HCTX* hc, unsigned int height, const unsigned char (*children)[SM3_DIGEST_SIZE],
+    size_t n, unsigned char (*parents)[SM3_DIGEST_SIZE]) {
+    unsigned char blk[SM3_MB_LANES][2][SM3_BLOCK_SIZE];
+    const unsigned char* bp[SM3_MB_LANES];
+    uint32_t st[8][SM3_MB_LANES];
+
+    for (size_t i = 0; i < n; i += SM3_MB_LANES) {
+        size_t batch = n - i < SM3_MB_LANES ? n - i : SM3_MB_LANES;
+        if (batch == 1) {
+            tree_node(hc, height, (uint32_t)i, children[2 * i], children[2 * i + 1], parents[i]);
+            break;
+        }
+        for (size_t l = 0; l < SM3_MB_LANES; l++) {
+            size_t k = i + (l < batch ? l : 0);
+            tree_block(blk[l], height, (uint32_t)k, children[2 * k], children[2 * k + 1]);
+            for (int w = 0; w < 8; w++) st[w][l] = hc->seed_state[w];
+        }
+        for (int b = 0; b < 2; b++) {
+            for (size_t l = 0; l < SM3_MB_LANES; l++) bp[l] = blk[l][b];
+            sm3_mb_compress(st, bp);
+        }
+        for (size_t l = 0; l < batch; l++) {
+            uint32_t s[8];
+            for (int w = 0; w < 8; w++) s[w] = st[w][l];
+            store_state(s, parents[i + l]);
+        }
+    }
+}
+
+// -------------------------- XMSS --------------------------
+typedef struct {
+    const XMSS_HCTX* hc;
+    const SM3_XMSS_KEY* key;
+    uint32_t first;
+    size_t count;
+    int failed;
+} XMSS_LEAF_TASK;
+
+static void leaf_task(SM3_POOL_WORKER* worker, void* arg) {
+    XMSS_LEAF_TASK* t = (XMSS_LEAF_TASK*)arg;
+    (void)worker;
+    t->failed = wots_leaves(t->hc, t->key->sk_seed, t->first, t->count,
+        t->key->nodes + ((size_t)1 << t->key->height) + t->first);
+}
+
+int sm3_xmss_keygen(SM3_XMSS_KEY* key, unsigned int height, const unsigned char seed[SM3_XMSS_SEED_SIZE], SM3_POOL* pool) {
+    XMSS_HCTX hc;
+    size_t nleaves, ntasks;
+    XMSS_LEAF_TASK* tasks;
+    SM3_POOL_GROUP group = { 0 };
+    int failed = 0;
+
+    memset(key, 0, sizeof(*key));
+    if (height < 1 || height > SM3_XMSS_MAX_HEIGHT) return -1;
+    nleaves = (size_t)1 << height;
+    key->nodes = (unsigned char (*)[SM3_DIGEST_SIZE])malloc(2 * nleaves * SM3_DIGEST_SIZE);
+    ntasks = (nleaves + XMSS_TASK_LEAVES - 1) / XMSS_TASK_LEAVES;
+    tasks = (XMSS_LEAF_TASK*)malloc(ntasks * sizeof(XMSS_LEAF_TASK));
+    if (key->nodes == NULL || tasks == NULL) {
+        free(key->nodes);
+        free(tasks);
+        key->nodes = NULL;
+        return -1;
+    }
+    key->height = height;
+    memcpy(key->sk_seed, seed, SM3_DIGEST_SIZE);
+    memcpy(key->sk_prf, seed + SM3_DIGEST_SIZE, SM3_DIGEST_SIZE);
+    memcpy(key->pub_seed, seed + 2 * SM3_DIGEST_SIZE, SM3_DIGEST_SIZE);
+    hctx_init(&hc, key->pub_seed);
+
+    // 叶子：按段并行，每段内的链在多路并行通道上计算
+    for (size_t t = 0; t < ntasks; t++) {
+        tasks[t].hc = &hc;
+        tasks[t].key = key;
+        tasks[t].first = (uint32_t)(t * XMSS_TASK_LEAVES);
+        tasks[t].count = nleaves - t * XMSS_TASK_LEAVES < XMSS_TASK_LEAVES ? nleaves - t * XMSS_TASK_LEAVES : XMSS_TASK_LEAVES;
+        tasks[t].failed = 0;
+        if (pool == NULL || sm3_pool_submit_group(pool, -1, leaf_task, &tasks[t], &group) != 0) leaf_task(NULL, &tasks[t]);
+    }
+    if (pool != NULL) sm3_pool_wait_group(pool, &group);
+    for (size_t t = 0; t < ntasks; t++) failed |= tasks[t].failed;
+    free(tasks);
+    if (failed) {
+        sm3_xmss_free(key);
+        return -1;
+    }
+
+    // 内部节点：高度z的层在堆中占[2^(h-z), 2^(h-z+1))，子节点紧随其后成对排列
+    for (unsigned int z = 1; z <= height; z++) {
+        size_t first = (size_t)1 << (height - z);
+        tree_level(&hc, z, (const unsigned char (*)[SM3_DIGEST_SIZE])(key->nodes + 2 * first), first, key->nodes + first);
+    }
+    memcpy(key->root, key->nodes[1], SM3_DIGEST_SIZE);
+    return 0;
+}
+
+void sm3_xmss_public_key(const SM3_XMSS_KEY* key, unsigned char pk[SM3_XMSS_PK_SIZE]) {
+    memcpy(pk, key->root, SM3_DIGEST_SIZE);
+    memcpy(pk + SM3_DIGEST_SIZE, key->pub_seed, SM3_DIGEST_SIZE);
+}
+
+// 消息摘要 SM3(R || PK.seed || root || idx || M)
+static void xmss_msg_digest(const unsigned char r[SM3_DIGEST_SIZE], const unsigned char pk[SM3_XMSS_PK_SIZE], uint32_t idx,
+    const unsigned char* msg, size_t len, unsigned char out[SM3_DIGEST_SIZE]) {
+    unsigned char ib[4];
+    SM3_CTX ctx;
+    put_u32(ib, idx);
+    sm3_init(&ctx);
+    sm3_update(&ctx, r, SM3_DIGEST_SIZE);
+    sm3_update(&ctx, pk + SM3_DIGEST_SIZE, SM3_DIGEST_SIZE);
+    sm3_update(&ctx, pk, SM3_DIGEST_SIZE);
+    sm3_update(&ctx, ib, 4);
+    sm3_update(&ctx, msg, len);
+    sm3_final(&ctx, out);
+}
+
+int sm3_xmss_sign(SM3_XMSS_KEY* key, const unsigned char* msg, size_t len, unsigned char* sig) {
+    XMSS_HCTX hc;
+    SM3_HMAC_KEY prf;
+    SM3_HMAC_CTX hctx;
+    unsigned char pk[SM3_XMSS_PK_SIZE], digest[SM3_DIGEST_SIZE], ib[4];
+    uint32_t idx = key->next_index;
+    size_t k;
+
+    if (key->nodes == NULL || idx >= ((uint32_t)1 << key->height)) return -1;
+    key->next_index++;
+
+    // R = HMAC(SK.prf, idx || M)
+    put_u32(ib, idx);
+    hmac_sm3_key_init(&prf, key->sk_prf, SM3_DIGEST_SIZE);
+    hmac_sm3_init(&hctx, &prf);
+    hmac_sm3_update(&hctx, ib, 4);
+    hmac_sm3_update(&hctx, msg, len);
+    hmac_sm3_final(&hctx, sig + 4);
+    hmac_sm3_key_clear(&prf);
+
+    memcpy(sig, ib, 4);
+    sm3_xmss_public_key(key, pk);
+    xmss_msg_digest(sig + 4, pk, idx, msg, len, digest);
+    hctx_init(&hc, key->pub_seed);
+    wots_sign_hc(&hc, key->sk_seed, idx, digest, sig + 4 + SM3_DIGEST_SIZE);
+
+    // 认证路径：自叶子向上各层的兄弟节点
+    k = ((size_t)1 << key->height) + idx;
+    for (unsigned int z = 0; z < key->height; z++, k >>= 1) {
+        memcpy(sig + 4 + SM3_DIGEST_SIZE + SM3_WOTS_SIG_SIZE + (size_t)z * SM3_DIGEST_SIZE, key->nodes[k ^ 1], SM3_DIGEST_SIZE);
+    }
+    return 0;
+}
+
+int sm3_xmss_verify(const unsigned char pk[SM3_XMSS_PK_SIZE], unsigned int height, const unsigned char* msg, size_t len,
+    const unsigned char* sig) {
+    XMSS_HCTX hc;
+    unsigned char digest[SM3_DIGEST_SIZE], node[SM3_DIGEST_SIZE];
+    const unsigned char* auth = sig + 4 + SM3_DIGEST_SIZE + SM3_WOTS_SIG_SIZE;
+    uint32_t idx = get_u32(sig);
+    unsigned char diff = 0;
+
+    if (height < 1 || height > SM3_XMSS_MAX_HEIGHT || idx >= ((uint32_t)1 << height)) return 0;
+    hctx_init(&hc, pk + SM3_DIGEST_SIZE);
+    xmss_msg_digest(sig + 4, pk, idx, msg, len, digest);
+    wots_pk_from_sig_hc(&hc, idx, digest, sig + 4 + SM3_DIGEST_SIZE, node);
+    for (unsigned int z = 0; z < height; z++) {
+        uint32_t parent = idx >> (z + 1);
+        if ((idx >> z) & 1) tree_node(&hc, z + 1, parent, auth + (size_t)z * SM3_DIGEST_SIZE, node, node);
+        else tree_node(&hc, z + 1, parent, node, auth + (size_t)z * SM3_DIGEST_SIZE, node);
+    }
+    for (int i = 0; i < SM3_DIGEST_SIZE; i++) diff |= node[i] ^ pk[i];
+    return diff == 0;
+}
+
+void sm3_xmss_free(SM3_XMSS_KEY* key) {
+    volatile unsigned char* p = (volatile unsigned char*)key->sk_seed;
+    for (size_t i = 0; i < 2 * SM3_DIGEST_SIZE; i++) p[i] = 0;      // SK.seed与SK.prf相邻
+    if (key->nodes != NULL) free(key->nodes);
+    key->nodes = NULL;
+    key->next_index = 0;
+}
@@ -0,0 +1,62 @@
+// sm3_xmss.h - 基于SM3的哈希签名：WOTS+一次性签名与XMSS式Merkle树多次签名
+#ifndef SM3_XMSS_H
+#define SM3_XMSS_H
+
+#include "sm3.h"
+#include "sm3_pool.h"
+
+// 可调哈希（SPHINCS+ "simple"构造）：Th(PK.seed, ADRS, M) = SM3(PK.seed || 0^32 || ADRS || M)
+//   PK.seed补齐为一个完整分组，压缩一次后作为中间状态被全部调用共用；
+//   链函数F（M为32字节）只剩 ADRS || M 一个分组加一个仅含填充的常量分组，后者只扩展一次
+//   私钥元素 PRF(SK.seed, ADRS) = Th(PK.seed, ADRS, SK.seed)，与F形状相同
+// ADRS为32字节：层(4) || 树(12) || 类型(4) || 叶子序号(4) || 链序号/树高(4) || 链内步数/节点序号(4)
+// 参数：n = 32，w = 16（len = 64 + 3 = 67条链），树高h取1~SM3_XMSS_MAX_HEIGHT
+// 密钥生成、签名与验证中的全部链步骤按任务送入多路并行通道（某条链结束即换入下一条），
+// 密钥生成按叶子分段交给线程池
+
+#define SM3_WOTS_W 16
+#define SM3_WOTS_LEN 67
+#define SM3_WOTS_SIG_SIZE (SM3_WOTS_LEN * SM3_DIGEST_SIZE)
+#define SM3_XMSS_MAX_HEIGHT 20
+#define SM3_XMSS_SEED_SIZE (3 * SM3_DIGEST_SIZE)         // SK.seed || SK.prf || PK.seed
+#define SM3_XMSS_PK_SIZE (2 * SM3_DIGEST_SIZE)           // root || PK.seed
+// 签名：叶子序号(4，大端) || R(32) || WOTS+签名 || 认证路径(h*32)
+#define SM3_XMSS_SIG_SIZE(h) (4 + SM3_DIGEST_SIZE + SM3_WOTS_SIG_SIZE + (size_t)(h) * SM3_DIGEST_SIZE)
+
+// -------------------------- WOTS+ --------------------------
+// 同一(SK.seed, PK.seed, leaf)只能签名一次；签名对象为32字节摘要
+// pk为压缩后的公钥（67个链终点经Th压缩为32字节）
+void sm3_wots_public_key(const unsigned char sk_seed[SM3_DIGEST_SIZE], const unsigned char pub_seed[SM3_DIGEST_SIZE],
+    uint32_t leaf, unsigned char pk[SM3_DIGEST_SIZE]);
+void sm3_wots_sign(const unsigned char sk_seed[SM3_DIGEST_SIZE], const unsigned char pub_seed[SM3_DIGEST_SIZE],
+    uint32_t leaf, const unsigned char digest[SM3_DIGEST_SIZE], unsigned char sig[SM3_WOTS_SIG_SIZE]);
+// 由签名恢复压缩公钥，与已知公钥比较即完成验证
+void sm3_wots_pk_from_sig(const unsigned char pub_seed[SM3_DIGEST_SIZE], uint32_t leaf,
+    const unsigned char digest[SM3_DIGEST_SIZE], const unsigned char sig[SM3_WOTS_SIG_SIZE], unsigned char pk[SM3_DIGEST_SIZE]);
+
+// -------------------------- XMSS --------------------------
+// 私钥对象保存整棵树（2^(h+1)个节点，h=20时64MB），签名时直接取认证路径
+// 有状态：每次签名消耗一个叶子，next_index必须在签名输出前持久化，否则叶子重用将泄露私钥
+typedef struct {
+    unsigned int height;
+    uint32_t next_index;                                 // 下一个未使用的叶子
+    unsigned char sk_seed[SM3_DIGEST_SIZE];
+    unsigned char sk_prf[SM3_DIGEST_SIZE];
+    unsigned char pub_seed[SM3_DIGEST_SIZE];
+    unsigned char root[SM3_DIGEST_SIZE];
+    unsigned char (*nodes)[SM3_DIGEST_SIZE];             // 堆序：nodes[1]为根，nodes[2^h + i]为第i个叶子
+} SM3_XMSS_KEY;
+
+// 由96字节种子生成密钥（种子应取自可靠随机源，如sm3_random_bytes），pool为NULL时在调用线程上计算；只等待本次提交的任务，可在线程池任务内调用
+// 高度超出范围或内存不足返回-1
+int sm3_xmss_keygen(SM3_XMSS_KEY* key, unsigned int height, const unsigned char seed[SM3_XMSS_SEED_SIZE], SM3_POOL* pool);
+void sm3_xmss_public_key(const SM3_XMSS_KEY* key, unsigned char pk[SM3_XMSS_PK_SIZE]);
+// 签名并推进next_index；叶子已用完返回-1
+int sm3_xmss_sign(SM3_XMSS_KEY* key, const unsigned char* msg, size_t len, unsigned char* sig);
+// 验证签名，通过返回1
+int sm3_xmss_verify(const unsigned char pk[SM3_XMSS_PK_SIZE], unsigned int height, const unsigned char* msg, size_t len,
+    const unsigned char* sig);
+// 清除并释放私钥
+void sm3_xmss_free(SM3_XMSS_KEY* key);
+
+#endif
@@ -0,0 +1,262 @@
+// sm3cp.c - 复制文件并同时计算SM3摘要
+// 源文件与目标文件均映射到内存，sm3_copy_and_update对每个分组只读取一次源数据：
+// 载入的字直接写入目标映射，同时参与压缩，省去"先复制、再sm3_file_hash校验"的第二遍读取
+// 输入不可映射（管道、设备）或在Windows上时退化为读缓冲+就地计算
+// 目标为普通文件（或不存在）时先写入同目录下的临时文件，摘要校验通过后rename替换，
+// 复制失败或摘要不一致时原目标文件保持不变；源与目标为同一文件时拒绝复制
+// 目标为设备、管道等无法替换的文件时直接写入，摘要不一致只报告、不删除目标
+#include "sm3.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <windows.h>
+#endif
+
+#define CP_TMP_SUFFIX ".sm3cp.XXXXXX"
+
+#define CP_CHUNK (8u << 20)          // 映射复制时每次处理的长度
+#define CP_STREAM_BUF (1u << 20)     // 流式复制的缓冲大小
+
+// 流式复制：读入缓冲后就地计算摘要再写出
+static int copy_stream(FILE* in, FILE* out, SM3_CTX* ctx, unsigned long long* copied) {
+    unsigned char* buf = (unsigned char*)malloc(CP_STREAM_BUF);
+    size_t n;
+    int ret = 0;
+    if (buf == NULL) return -1;
+    while ((n = fread(buf, 1, CP_STREAM_BUF, in)) > 0) {
+        sm3_update(ctx, buf, n);
+        if (fwrite(buf, 1, n, out) != n) {
+            ret = -1;
+            break;
+        }
+        *copied += n;
+    }
+    if (ferror(in)) ret = -1;
+    free(buf);
+    return ret;
+}
+
+#ifndef _WIN32
+// 映射复制：源、目标都是普通文件时使用，返回1表示条件不满足需退化为流式复制
+static int copy_mapped(int in_fd, int out_fd, off_t size, SM3_CTX* ctx, unsigned long long* copied) {
+    struct stat sb;
+    if (size <= 0 || (uint64_t)size > (uint64_t)(size_t)-1) return 1;
+    if (fstat(out_fd, &sb) != 0 || !S_ISREG(sb.st_mode)) return 1;
+
+    unsigned char* src = (unsigned char*)mmap(NULL, (size_t)size, PROT_READ, MAP_SHARED, in_fd, 0);
+    if (src == MAP_FAILED) return 1;
+    if (ftruncate(out_fd, size) != 0) {
+        munmap(src, (size_t)size);
+        return -1;
+    }
+    unsigned char* dst = (unsigned char*)mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, out_fd, 0);
+    if (dst == MAP_FAILED) {
+        munmap(src, (size_t)size);
+        return ftruncate(out_fd, 0) == 0 ? 1 : -1;
+    }
+    madvise(src, (size_t)size, MADV_SEQUENTIAL);
+    madvise(dst, (size_t)size, MADV_SEQUENTIAL);
+
+    for (size_t off = 0; off < (size_t)size; off += CP_CHUNK) {
+        size_t n = (size_t)size - off < CP_CHUNK ? (size_t)size - off : CP_CHUNK;
+        sm3_copy_and_update(ctx, dst + off, src + off, n);
+        *copied += n;
+    }
+
+    int ret = munmap(dst, (size_t)size) == 0 ? 0 : -1;
+    munmap(src, (size_t)size);
+    return ret;
+}
+#endif
+
+// 复制src到dst并输出摘要；expect非NULL时摘要不一致返回1（目标经临时文件写入时保持不变，无法替换的目标已被写入）
+static int copy_file(const char* src_path, const char* dst_path, const unsigned char* expect, unsigned char digest[SM3_DIGEST_SIZE]) {
+    SM3_CTX ctx;
+    unsigned long long copied = 0;
+    int ret;
+
+    sm3_init(&ctx);
+#ifndef _WIN32
+    int in_fd = open(src_path, O_RDONLY);
+    struct stat sb, db;
+    char* tmp_path = NULL;
+    if (in_fd < 0 || fstat(in_fd, &sb) != 0) {
+        fprintf(stderr, "错误: 无法打开源文件 %s: %s\n", src_path, strerror(errno));
+        if (in_fd >= 0) close(in_fd);
+        return -1;
+    }
+    int dst_exists = stat(dst_path, &db) == 0;
+    if (dst_exists && db.st_dev == sb.st_dev && db.st_ino == sb.st_ino) {
+        fprintf(stderr, "错误: %s 与 %s 是同一文件\n", src_path, dst_path);
+        close(in_fd);
+        return -1;
+    }
+    int out_fd;
+    if (!dst_exists || S_ISREG(db.st_mode)) {
+        // 在目标所在目录创建临时文件，保证rename在同一文件系统内原子完成
+        size_t len = strlen(dst_path);
+        tmp_path = (char*)malloc(len + sizeof(CP_TMP_SUFFIX));
+        if (tmp_path == NULL) {
+            close(in_fd);
+            return -1;
+        }
+        memcpy(tmp_path, dst_path, len);
+        memcpy(tmp_path + len, CP_TMP_SUFFIX, sizeof(CP_TMP_SUFFIX));
+        out_fd = mkstemp(tmp_path);
+        if (out_fd >= 0 && fchmod(out_fd, (dst_exists ? db.st_mode : sb.st_mode) & 0777) != 0) {
+            close(out_fd);
+            unlink(tmp_path);
+            out_fd = -1;
+        }
+    }
+    else out_fd = open(dst_path, O_WRONLY | O_TRUNC);     // 设备、管道等不能替换，直接写入
+    if (out_fd < 0) {
+        fprintf(stderr, "错误: 无法创建目标文件 %s: %s\n", dst_path, strerror(errno));
+        free(tmp_path);
+        close(in_fd);
+        return -1;
+    }
+
+    ret = S_ISREG(sb.st_mode) ? copy_mapped(in_fd, out_fd, sb.st_size, &ctx, &copied) : 1;
+    if (ret == 1) {
+        // 退化为流式复制（空文件、管道、目标不可映射等）
+        FILE* in = fdopen(in_fd, "rb");
+        FILE* out = fdopen(out_fd, "wb");
+        if (in == NULL || out == NULL) {
+            fprintf(stderr, "错误: 无法打开文件流\n");
+            if (tmp_path != NULL) unlink(tmp_path);
+            free(tmp_path);
+            return -1;
+        }
+        sm3_init(&ctx);
+        copied = 0;
+        ret = copy_stream(in, out, &ctx, &copied);
+        fclose(in);
+        if (fclose(out) != 0) ret = -1;
+    }
+    else {
+        close(in_fd);
+        if (close(out_fd) != 0) ret = -1;
+    }
+    if (ret == 0) {
+        sm3_final(&ctx, digest);
+        if (expect != NULL && memcmp(expect, digest, SM3_DIGEST_SIZE) != 0) ret = 1;
+    }
+    if (tmp_path != NULL) {
+        if (ret == 0 && rename(tmp_path, dst_path) != 0) {
+            fprintf(stderr, "错误: 无法替换目标文件 %s: %s\n", dst_path, strerror(errno));
+            ret = -1;
+        }
+        if (ret != 0) unlink(tmp_path);
+        free(tmp_path);
+    }
+    else if (ret == 1) fprintf(stderr, "警告: %s 不是普通文件，数据已写入\n", dst_path);
+    if (ret < 0) fprintf(stderr, "错误: 复制 %s 到 %s 失败\n", src_path, dst_path);
+    return ret;
+#else
+    // 同样先写入临时文件，校验通过后替换目标（源与目标相同时也不会先截断源文件）
+    size_t len = strlen(dst_path);
+    char* tmp_path = (char*)malloc(len + sizeof(CP_TMP_SUFFIX));
+    if (tmp_path == NULL) return -1;
+    memcpy(tmp_path, dst_path, len);
+    memcpy(tmp_path + len, CP_TMP_SUFFIX, sizeof(CP_TMP_SUFFIX));
+    FILE* in = fopen(src_path, "rb");
+    FILE* out = (in != NULL && _mktemp_s(tmp_path, len + sizeof(CP_TMP_SUFFIX)) == 0) ? fopen(tmp_path, "wbx") : NULL;
+    if (in == NULL || out == NULL) {
+        fprintf(stderr, "错误: 无法打开 %s 或创建 %s 的临时文件\n", src_path, dst_path);
+        if (in) fclose(in);
+        free(tmp_path);
+        return -1;
+    }
+    ret = copy_stream(in, out, &ctx, &copied);
+    fclose(in);
+    if (fclose(out) != 0) ret = -1;
+    if (ret == 0) {
+        sm3_final(&ctx, digest);
+        if (expect != NULL && memcmp(expect, digest, SM3_DIGEST_SIZE) != 0) ret = 1;
+    }
+    if (ret == 0 && !MoveFileExA(tmp_path, dst_path, MOVEFILE_REPLACE_EXISTING)) {
+        fprintf(stderr, "错误: 无法替换目标文件 %s\n", dst_path);
+        ret = -1;
+    }
+    if (ret != 0) remove(tmp_path);
+    free(tmp_path);
+    if (ret < 0) fprintf(stderr, "错误: 复制 %s 到 %s 失败\n", src_path, dst_path);
+    return ret;
+#endif
+}
+
+// 解析64位十六进制期望摘要
+static int parse_digest(const char* hex, unsigned char digest[SM3_DIGEST_SIZE]) {
+    if (strlen(hex) != 2 * SM3_DIGEST_SIZE) return -1;
+    for (int i = 0; i < SM3_DIGEST_SIZE; i++) {
+        unsigned v;
+        if (sscanf(hex + 2 * i, "%2x", &v) != 1) return -1;
+        digest[i] = (unsigned char)v;
+    }
+    return 0;
+}
+
+static void print_usage(const char* program_name) {
+    printf("SM3复制校验工具（复制与摘要计算一次完成）\n");
+    printf("用法: %s [选项] <源文件> <目标文件>\n", program_name);
+    printf("选项:\n");
+    printf("  -c <摘要>     期望的SM3摘要（十六进制），不一致时不写入目标文件并返回失败\n");
+    printf("  -h            显示此帮助信息\n");
+    printf("输出格式与sha256sum一致：\"<摘要>  <目标文件>\"\n");
+    printf("\n示例:\n");
+    printf("  %s build/app.bin release/app.bin\n", program_name);
+    printf("  %s -c \"$(cat app.bin.sm3)\" build/app.bin release/app.bin\n", program_name);
+}
+
+int main(int argc, char* argv[]) {
+    const char* paths[2] = { NULL, NULL };
+    const char* expect_hex = NULL;
+    unsigned char expect[SM3_DIGEST_SIZE], digest[SM3_DIGEST_SIZE];
+    int npaths = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-c") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "错误: -c选项需要参数\n");
+                return 1;
+            }
+            expect_hex = argv[++i];
+        }
+        else if (strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else if (npaths < 2) paths[npaths++] = argv[i];
+        else {
+            fprintf(stderr, "错误: 多余的参数 %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (npaths != 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (expect_hex != NULL && parse_digest(expect_hex, expect) != 0) {
+        fprintf(stderr, "错误: 期望摘要格式错误（需64位十六进制）\n");
+        return 1;
+    }
+
+    int ret = copy_file(paths[0], paths[1], expect_hex != NULL ? expect : NULL, digest);
+    if (ret < 0) return 1;
+    printf("%s  %s\n", sm3_hash_to_string(digest), paths[1]);
+
+    if (ret == 1) {
+        fprintf(stderr, "错误: 摘要不一致，未替换 %s\n", paths[1]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,993 @@
+// sm3d.c - 本地SM3哈希服务
+// 多个进程经Unix域套接字提交哈希请求（内联数据或文件路径），服务端把所有客户端的请求汇成批次，
+// 在多路并行通道上统一计算（sm3_mb_hash，长短消息混合时通道动态补位），摘要按请求号返回
+// 批次在以下任一条件满足时计算：请求数或字节数达到上限；已无立即可读的输入且
+// 通道已满或"等待"近期没有带来新请求（自适应）；最早的请求等待达到时限（-d）
+// 客户端可以流水线方式连续发送请求，响应按完成顺序返回
+// 大批量客户端可改用共享内存提交环（sm3_shm.h）：数据写入共享区后只登记描述符，
+// 服务端在共享区中原地计算并把摘要写入完成环，数据与摘要都不经过套接字复制
+// 服务端以自身权限打开客户端给出的路径，因此只接受与服务端同一用户（或root）的连接（SO_PEERCRED）
+// 文件请求只接受普通文件，经pread读取（不映射，文件被截断不会使服务端崩溃）；
+// 不超过D_FILE_INLINE的小文件读入批次缓冲一同计算，更大的文件交给后台线程，不阻塞事件循环
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+#include "sm3.h"
+#include "sm3_mb.h"
+#include "sm3_shm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define D_DEFAULT_DEADLINE_US 200
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+// 协议（整数均为大端序）：
+//   客户端 -> 服务端  'D' 请求号(4) 长度(4) 数据                  计算数据的摘要
+//   客户端 -> 服务端  'F' 请求号(4) 路径长度(2) 路径              计算文件的摘要
+//   服务端 -> 客户端  'R' 请求号(4) 状态(1) 摘要(32)              状态0为成功，1为文件无法读取
+//   客户端 -> 服务端  'S'，SCM_RIGHTS附带memfd、提交eventfd、完成eventfd   建立共享内存环
+//   服务端 -> 客户端  'A' 状态(1)                                 状态0为成功
+// 内联数据超过D_MAX_INLINE或类型无法识别时服务端关闭连接；共享内存完成项的状态2表示描述符越界，
+// 提交环尾指针异常时服务端关闭连接
+#define D_RESP_SIZE (1 + 4 + 1 + SM3_DIGEST_SIZE)
+#define D_MAX_INLINE (16u << 20)
+#define D_BATCH_MAX 256                        // 一批最多请求数
+#define D_BATCH_BYTES (8u << 20)               // 一批内联数据达到该字节数即计算
+#define D_READ_CHUNK (64u << 10)
+#define D_OUT_HIGH (1u << 20)                  // 待发送响应超过该值时暂停读取该客户端
+#define D_CLIENT_WINDOW 4096                   // 客户端模式未收到响应的请求数上限（响应合计远小于D_OUT_HIGH）
+#define D_PROBE_INTERVAL 32                    // 自适应关闭等待后，每隔这么多批仍等待一次以重新评估
+#define D_FILE_INLINE (64u << 10)              // 不超过该大小的文件在批次中计算
+#define D_FILE_WORKERS 2                       // 计算大文件的后台线程数
+#define D_FILE_CHUNK (1u << 20)                // 后台线程每次pread的字节数
+#define D_STATUS_OFFLOAD 0xff                  // 批次内部标记：已交给后台线程，不在本批响应
+
+enum { D_REQ_DATA, D_REQ_FILE, D_REQ_SHM };
+enum { D_EV_LISTEN, D_EV_TIMER, D_EV_SOCK, D_EV_RING, D_EV_JOBS };
+
+struct D_CLIENT_;
+
+// epoll事件来源
+typedef struct {
+    int kind;
+    struct D_CLIENT_* client;
+} D_EVSRC;
+
+typedef struct D_CLIENT_ {
+    int fd;
+    D_EVSRC sock_src, ring_src;
+    unsigned char* in;
+    size_t in_len, in_pos, in_cap;             // in_pos之前的请求已解析
+    unsigned char* out;
+    size_t out_len, out_pos, out_cap;
+    int npending;                              // 在当前批次或后台线程中的请求数（未完成前不移动输入缓冲、不释放连接）
+    int closing;
+    uint32_t events;
+    int fds[3], nfds;                          // 随'S'消息收到、尚未使用的描述符
+    int has_ring, ring_armed, ring_dirty;      // ring_armed：已置位唤醒标志，新提交会写eventfd
+    SM3_SHM_RING ring;
+    int sq_efd, cq_efd;
+    struct D_CLIENT_* next_ring;
+    struct D_CLIENT_* next_dead;
+} D_CLIENT;
+
+typedef struct {
+    D_CLIENT* client;
+    int kind;
+    uint64_t id;                               // 请求号，共享内存请求为user_data
+    size_t off;                                // 数据或路径在客户端输入缓冲中的偏移
+    const unsigned char* ptr;                  // 共享内存请求的数据，描述符越界时为NULL
+    size_t len;
+} D_REQ;
+
+// 交给后台线程的大文件
+typedef struct D_JOB_ {
+    D_CLIENT* client;
+    uint64_t id;
+    int fd;
+    unsigned char status;
+    unsigned char digest[SM3_DIGEST_SIZE];
+    struct D_JOB_* next;
+} D_JOB;
+
+typedef struct {
+    int ep, lfd, tfd;
+    D_EVSRC listen_src, timer_src, jobs_src;
+    unsigned char* file_buf;                   // 小文件的读取缓冲，D_BATCH_MAX × D_FILE_INLINE
+    pthread_t workers[D_FILE_WORKERS];
+    int nworkers;
+    pthread_mutex_t job_lock;
+    pthread_cond_t job_cond;
+    D_JOB *jobs_head, *jobs_tail;              // 待计算
+    D_JOB* jobs_done;                          // 已完成、待响应
+    int jobs_stop;
+    int jobs_efd;                              // 后台线程完成时通知事件循环
+    unsigned int deadline_us;
+    D_REQ reqs[D_BATCH_MAX];
+    size_t n, bytes;
+    size_t waited_from;                        // 开始等待时的请求数，未等待为(size_t)-1
+    unsigned int gain;                         // 每次等待新到达请求数的滑动平均（×16）
+    unsigned int since_probe;
+    D_CLIENT* rings;                           // 建立了共享内存环的连接
+    D_CLIENT* dead;                            // 已关闭、待释放的连接
+    unsigned long long total_reqs, total_batches, total_bytes, total_shm, total_offload;
+} D_SERVER;
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void on_signal(int sig) {
+    (void)sig;
+    g_stop = 1;
+}
+
+static void put_be(unsigned char* p, uint64_t v, int bytes) {
+    for (int i = bytes - 1; i >= 0; i--) {
+        p[i] = (unsigned char)v;
+        v >>= 8;
+    }
+}
+
+static uint64_t get_be(const unsigned char* p, int bytes) {
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; i++) v = (v << 8) | p[i];
+    return v;
+}
+
+static int reserve(unsigned char** buf, size_t* cap, size_t need) {
+    if (need <= *cap) return 0;
+    size_t c = *cap ? *cap : 4096;
+    while (c < need) c *= 2;
+    unsigned char* p = (unsigned char*)realloc(*buf, c);
+    if (p == NULL) return -1;
+    *buf = p;
+    *cap = c;
+    return 0;
+}
+
+// -------------------------- 客户端连接 --------------------------
+static void client_update_events(D_SERVER* s, D_CLIENT* c) {
+    struct epoll_event ev;
+    uint32_t want = 0;
+    if (c->closing) return;
+    if (c->out_len - c->out_pos < D_OUT_HIGH) want |= EPOLLIN;
+    if (c->out_len > c->out_pos) want |= EPOLLOUT;
+    if (want == c->events) return;
+    ev.events = want;
+    ev.data.ptr = &c->sock_src;
+    epoll_ctl(s->ep, EPOLL_CTL_MOD, c->fd, &ev);
+    c->events = want;
+}
+
+static void client_free(D_CLIENT* c) {
+    close(c->fd);
+    for (int i = 0; i < c->nfds; i++) close(c->fds[i]);
+    if (c->has_ring) {
+        sm3_shm_ring_detach(&c->ring);
+        close(c->sq_efd);
+        close(c->cq_efd);
+    }
+    free(c->in);
+    free(c->out);
+    free(c);
+}
+
+// 关闭连接：只从epoll移除并挂入待释放链表，由事件循环在本轮结束、且其请求已不在批次中时释放
+static void client_close(D_SERVER* s, D_CLIENT* c) {
+    if (c->closing) return;
+    epoll_ctl(s->ep, EPOLL_CTL_DEL, c->fd, NULL);
+    if (c->has_ring) epoll_ctl(s->ep, EPOLL_CTL_DEL, c->sq_efd, NULL);
+    c->closing = 1;
+    c->next_dead = s->dead;
+    s->dead = c;
+}
+
+static void reap_clients(D_SERVER* s) {
+    D_CLIENT** pp = &s->dead;
+    while (*pp != NULL) {
+        D_CLIENT* c = *pp;
+        if (c->npending == 0) {
+            *pp = c->next_dead;
+            if (c->has_ring) {
+                D_CLIENT** rp = &s->rings;
+                while (*rp != c) rp = &(*rp)->next_ring;
+                *rp = c->next_ring;
+            }
+            client_free(c);
+        }
+        else pp = &c->next_dead;
+    }
+}
+
+static void client_flush_out(D_SERVER* s, D_CLIENT* c) {
+    while (c->out_pos < c->out_len) {
+        ssize_t w = write(c->fd, c->out + c->out_pos, c->out_len - c->out_pos);
+        if (w < 0 && errno == EINTR) continue;
+        if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (w <= 0) {
+            client_close(s, c);
+            return;
+        }
+        c->out_pos += (size_t)w;
+    }
+    if (c->out_pos == c->out_len) c->out_pos = c->out_len = 0;
+    client_update_events(s, c);
+}
+
+// 追加一个'R'响应，失败时关闭连接
+static void client_respond(D_SERVER* s, D_CLIENT* c, uint64_t id, unsigned char status, const unsigned char* digest) {
+    if (reserve(&c->out, &c->out_cap, c->out_len + D_RESP_SIZE) != 0) {
+        client_close(s, c);
+        return;
+    }
+    unsigned char* p = c->out + c->out_len;
+    p[0] = 'R';
+    put_be(p + 1, id, 4);
+    p[5] = status;
+    if (digest != NULL) memcpy(p + 6, digest, SM3_DIGEST_SIZE);
+    else memset(p + 6, 0, SM3_DIGEST_SIZE);
+    c->out_len += D_RESP_SIZE;
+}
+
+// -------------------------- 大文件后台线程 --------------------------
+// 从偏移0起pread到文件末尾（文件在计算期间被截断时只计算剩余内容），读取出错返回-1
+static int hash_fd(int fd, unsigned char* buf, size_t cap, unsigned char digest[SM3_DIGEST_SIZE]) {
+    SM3_CTX ctx;
+    off_t pos = 0;
+    sm3_init(&ctx);
+    for (;;) {
+        ssize_t r = pread(fd, buf, cap, pos);
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0) return -1;
+        if (r == 0) break;
+        sm3_update(&ctx, buf, (size_t)r);
+        pos += r;
+    }
+    sm3_final(&ctx, digest);
+    return 0;
+}
+
+static void* file_worker(void* arg) {
+    D_SERVER* s = (D_SERVER*)arg;
+    unsigned char* buf = (unsigned char*)malloc(D_FILE_CHUNK);
+    for (;;) {
+        D_JOB* job;
+        uint64_t one = 1;
+        pthread_mutex_lock(&s->job_lock);
+        while (s->jobs_head == NULL && !s->jobs_stop) pthread_cond_wait(&s->job_cond, &s->job_lock);
+        job = s->jobs_head;
+        if (job != NULL) {
+            s->jobs_head = job->next;
+            if (s->jobs_head == NULL) s->jobs_tail = NULL;
+        }
+        pthread_mutex_unlock(&s->job_lock);
+        if (job == NULL) break;
+
+        job->status = (buf != NULL && hash_fd(job->fd, buf, D_FILE_CHUNK, job->digest) == 0) ? 0 : 1;
+        close(job->fd);
+        pthread_mutex_lock(&s->job_lock);
+        job->next = s->jobs_done;
+        s->jobs_done = job;
+        pthread_mutex_unlock(&s->job_lock);
+        if (write(s->jobs_efd, &one, sizeof(one)) < 0) {
+            // eventfd计数不会溢出，忽略
+        }
+    }
+    free(buf);
+    return NULL;
+}
+
+// 把已打开的大文件交给后台线程，失败返回-1（调用者关闭fd）
+static int jobs_submit(D_SERVER* s, D_CLIENT* c, uint64_t id, int fd) {
+    D_JOB* job;
+    if (s->nworkers == 0 || (job = (D_JOB*)calloc(1, sizeof(D_JOB))) == NULL) return -1;
+    job->client = c;
+    job->id = id;
+    job->fd = fd;
+    c->npending++;
+    s->total_offload++;
+    pthread_mutex_lock(&s->job_lock);
+    if (s->jobs_tail != NULL) s->jobs_tail->next = job;
+    else s->jobs_head = job;
+    s->jobs_tail = job;
+    pthread_cond_signal(&s->job_cond);
+    pthread_mutex_unlock(&s->job_lock);
+    return 0;
+}
+
+// 发送已完成的大文件响应
+static void jobs_complete(D_SERVER* s) {
+    D_JOB* job;
+    uint64_t v;
+    if (read(s->jobs_efd, &v, sizeof(v)) < 0 && errno != EAGAIN) return;
+    pthread_mutex_lock(&s->job_lock);
+    job = s->jobs_done;
+    s->jobs_done = NULL;
+    pthread_mutex_unlock(&s->job_lock);
+    while (job != NULL) {
+        D_JOB* next = job->next;
+        D_CLIENT* c = job->client;
+        c->npending--;
+        if (!c->closing) {
+            client_respond(s, c, job->id, job->status, job->status == 0 ? job->digest : NULL);
+            if (!c->closing) client_flush_out(s, c);
+        }
+        free(job);
+        job = next;
+    }
+}
+
+static void jobs_start(D_SERVER* s) {
+    struct epoll_event ev;
+    pthread_mutex_init(&s->job_lock, NULL);
+    pthread_cond_init(&s->job_cond, NULL);
+    s->jobs_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    s->jobs_src.kind = D_EV_JOBS;
+    ev.events = EPOLLIN;
+    ev.data.ptr = &s->jobs_src;
+    if (s->jobs_efd < 0 || epoll_ctl(s->ep, EPOLL_CTL_ADD, s->jobs_efd, &ev) != 0) return;
+    while (s->nworkers < D_FILE_WORKERS && pthread_create(&s->workers[s->nworkers], NULL, file_worker, s) == 0) s->nworkers++;
+}
+
+// 计算完队列中的大文件后结束后台线程
+static void jobs_stop(D_SERVER* s) {
+    pthread_mutex_lock(&s->job_lock);
+    s->jobs_stop = 1;
+    pthread_cond_broadcast(&s->job_cond);
+    pthread_mutex_unlock(&s->job_lock);
+    for (int i = 0; i < s->nworkers; i++) pthread_join(s->workers[i], NULL);
+    if (s->jobs_efd >= 0) {
+        jobs_complete(s);
+        close(s->jobs_efd);
+    }
+    pthread_mutex_destroy(&s->job_lock);
+    pthread_cond_destroy(&s->job_cond);
+}
+
+// -------------------------- 批次 --------------------------
+// 打开客户端给出的路径：O_NONBLOCK使FIFO等特殊文件不会阻塞open，随后只接受普通文件
+static int open_regular(const char* path, struct stat* st) {
+    int fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC | O_NOCTTY);
+    if (fd < 0) return -1;
+    if (fstat(fd, st) != 0 || !S_ISREG(st->st_mode)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void batch_flush(D_SERVER* s) {
+    const unsigned char* data[D_BATCH_MAX];
+    size_t lens[D_BATCH_MAX], idx[D_BATCH_MAX];
+    unsigned char digests[D_BATCH_MAX][SM3_DIGEST_SIZE];
+    unsigned char status[D_BATCH_MAX];
+    size_t n = 0;
+    struct itimerspec off;
+
+    if (s->n == 0) return;
+    memset(&off, 0, sizeof(off));
+    timerfd_settime(s->tfd, 0, &off, NULL);
+
+    // 自适应：记录这一批在等待期间新到达的请求数
+    if (s->waited_from != (size_t)-1) {
+        s->gain = (s->gain * 7 + (unsigned int)(s->n - s->waited_from) * 16) / 8;
+        s->since_probe = 0;
+    }
+
+    for (size_t i = 0; i < s->n; i++) {
+        D_REQ* r = &s->reqs[i];
+        status[i] = 0;
+        if (r->client->closing) continue;
+        if (r->kind == D_REQ_FILE) {
+            char path[65536];
+            struct stat st;
+            int fd;
+            memcpy(path, r->client->in + r->off, r->len);
+            path[r->len] = '\0';
+            fd = open_regular(path, &st);
+            if (fd < 0) {
+                status[i] = 1;
+                continue;
+            }
+            if ((uint64_t)st.st_size > D_FILE_INLINE) {
+                if (jobs_submit(s, r->client, r->id, fd) == 0) status[i] = D_STATUS_OFFLOAD;
+                else {
+                    close(fd);
+                    status[i] = 1;
+                }
+                continue;
+            }
+            // 小文件读入该请求的缓冲槽；读到的字节数以实际为准（文件可能同时被截断）
+            unsigned char* buf = s->file_buf + i * D_FILE_INLINE;
+            size_t got = 0;
+            while (got < (size_t)st.st_size) {
+                ssize_t rd = pread(fd, buf + got, (size_t)st.st_size - got, (off_t)got);
+                if (rd < 0 && errno == EINTR) continue;
+                if (rd <= 0) break;
+                got += (size_t)rd;
+            }
+            close(fd);
+            data[n] = buf;
+            lens[n] = got;
+        }
+        else if (r->kind == D_REQ_SHM) {
+            if (r->ptr == NULL) {
+                status[i] = 2;
+                continue;
+            }
+            data[n] = r->ptr;                  // 在共享区中原地计算
+            lens[n] = r->len;
+        }
+        else {
+            data[n] = r->client->in + r->off;
+            lens[n] = r->len;
+        }
+        idx[n++] = i;
+    }
+    sm3_mb_hash(data, lens, n, digests);
+
+    // 写回响应；j遍历已计算的请求
+    for (size_t i = 0, j = 0; i < s->n; i++) {
+        D_REQ* r = &s->reqs[i];
+        D_CLIENT* c = r->client;
+        const unsigned char* digest = (j < n && idx[j] == i) ? digests[j++] : NULL;
+        if (status[i] == D_STATUS_OFFLOAD) continue;           // 由后台线程完成时响应
+        c->npending--;
+        if (c->closing) continue;
+        if (r->kind == D_REQ_SHM) {
+            sm3_shm_ring_post(&c->ring, r->id, status[i], digest);
+            c->ring_dirty = 1;
+            continue;
+        }
+        client_respond(s, c, r->id, status[i], digest);
+    }
+    s->total_reqs += s->n;
+    s->total_batches++;
+    s->total_bytes += s->bytes;
+
+    // 批次中的客户端：发布完成项、移动输入缓冲并发送响应
+    for (size_t i = 0; i < s->n; i++) {
+        D_CLIENT* c = s->reqs[i].client;
+        if (c == NULL) continue;
+        for (size_t k = i + 1; k < s->n; k++) {
+            if (s->reqs[k].client == c) s->reqs[k].client = NULL;
+        }
+        if (c->closing) continue;
+        if (c->ring_dirty) {
+            uint64_t one = 1;
+            c->ring_dirty = 0;
+            if (sm3_shm_ring_publish(&c->ring) && write(c->cq_efd, &one, sizeof(one)) < 0) {
+                client_close(s, c);
+                continue;
+            }
+        }
+        if (c->in_pos > 0) {
+            memmove(c->in, c->in + c->in_pos, c->in_len - c->in_pos);
+            c->in_len -= c->in_pos;
+            c->in_pos = 0;
+        }
+        if (c->out_len > c->out_pos) client_flush_out(s, c);
+    }
+    s->n = 0;
+    s->bytes = 0;
+    s->waited_from = (size_t)-1;
+}
+
+static void batch_add(D_SERVER* s, D_CLIENT* c, int kind, uint64_t id, size_t off, const unsigned char* ptr, size_t len) {
+    D_REQ* r = &s->reqs[s->n++];
+    r->client = c;
+    r->kind = kind;
+    r->id = id;
+    r->off = off;
+    r->ptr = ptr;
+    r->len = len;
+    c->npending++;
+    if (kind != D_REQ_FILE) s->bytes += len;
+    if (s->n == 1) {
+        struct itimerspec t;
+        memset(&t, 0, sizeof(t));
+        t.it_value.tv_sec = s->deadline_us / 1000000;
+        t.it_value.tv_nsec = (long)(s->deadline_us % 1000000) * 1000;
+        timerfd_settime(s->tfd, 0, &t, NULL);
+    }
+    if (s->n == D_BATCH_MAX || s->bytes >= D_BATCH_BYTES) batch_flush(s);
+}
+
+// -------------------------- 共享内存环 --------------------------
+// 用随'S'消息收到的描述符建立共享内存环，返回应答状态
+static int ring_setup(D_SERVER* s, D_CLIENT* c) {
+    struct epoll_event ev;
+    if (c->has_ring || c->nfds != 3 || sm3_shm_ring_attach(&c->ring, c->fds[0]) != 0) return 1;
+    close(c->fds[0]);
+    c->sq_efd = c->fds[1];
+    c->cq_efd = c->fds[2];
+    c->nfds = 0;
+    c->ring_src.kind = D_EV_RING;
+    c->ring_src.client = c;
+    ev.events = EPOLLIN;
+    ev.data.ptr = &c->ring_src;
+    if (fcntl(c->sq_efd, F_SETFL, O_NONBLOCK) != 0 || epoll_ctl(s->ep, EPOLL_CTL_ADD, c->sq_efd, &ev) != 0) {
+        sm3_shm_ring_detach(&c->ring);
+        close(c->sq_efd);
+        close(c->cq_efd);
+        return 1;
+    }
+    c->has_ring = 1;
+    c->next_ring = s->rings;
+    s->rings = c;
+    return 0;
+}
+
+// 取出提交环中的请求，一次最多D_BATCH_MAX个；取空后置位唤醒标志，返回1表示仍有剩余
+static int ring_drain(D_SERVER* s, D_CLIENT* c) {
+    int taken = 0;
+    c->ring_armed = 0;
+    while (!c->closing) {
+        const unsigned char* data;
+        size_t len;
+        uint64_t user_data;
+        int r = sm3_shm_ring_pop(&c->ring, &data, &len, &user_data);
+        if (r < 0) {
+            client_close(s, c);
+            break;
+        }
+        if (r == 0) {
+            if (!sm3_shm_ring_arm(&c->ring)) continue;
+            c->ring_armed = 1;
+            break;
+        }
+        s->total_shm++;
+        batch_add(s, c, D_REQ_SHM, user_data, 0, data, len);
+        if (++taken == D_BATCH_MAX) return 1;
+    }
+    return 0;
+}
+
+// 轮询未置位唤醒标志的共享内存环：服务端忙碌时客户端提交不写eventfd，新请求由这里取走
+static int rings_poll(D_SERVER* s) {
+    int more = 0;
+    for (D_CLIENT* c = s->rings; c != NULL; c = c->next_ring) {
+        if (!c->closing && !c->ring_armed) more |= ring_drain(s, c);
+    }
+    return more;
+}
+
+// -------------------------- 套接字请求 --------------------------
+// 解析输入缓冲中的完整请求，返回-1表示协议错误
+static int client_parse(D_SERVER* s, D_CLIENT* c) {
+    while (!c->closing && c->in_len > c->in_pos && c->out_len - c->out_pos < D_OUT_HIGH) {
+        const unsigned char* p = c->in + c->in_pos;
+        size_t avail = c->in_len - c->in_pos;
+        if (p[0] == 'D') {
+            if (avail < 9) break;
+            uint32_t len = (uint32_t)get_be(p + 5, 4);
+            if (len > D_MAX_INLINE) return -1;
+            if (avail < 9 + (size_t)len) break;
+            c->in_pos += 9 + (size_t)len;
+            batch_add(s, c, D_REQ_DATA, get_be(p + 1, 4), c->in_pos - len, NULL, len);
+        }
+        else if (p[0] == 'F') {
+            if (avail < 7) break;
+            uint32_t len = (uint32_t)get_be(p + 5, 2);
+            if (avail < 7 + (size_t)len) break;
+            c->in_pos += 7 + (size_t)len;
+            batch_add(s, c, D_REQ_FILE, get_be(p + 1, 4), c->in_pos - len, NULL, len);
+        }
+        else if (p[0] == 'S') {
+            c->in_pos++;
+            if (reserve(&c->out, &c->out_cap, c->out_len + 2) != 0) return -1;
+            c->out[c->out_len] = 'A';
+            c->out[c->out_len + 1] = (unsigned char)ring_setup(s, c);
+            c->out_len += 2;
+            client_flush_out(s, c);
+        }
+        else return -1;
+    }
+    return 0;
+}
+
+static void client_read(D_SERVER* s, D_CLIENT* c) {
+    struct msghdr msg;
+    struct iovec iov;
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(3 * sizeof(int))];
+    } ctl;
+
+    if (reserve(&c->in, &c->in_cap, c->in_len + D_READ_CHUNK) != 0) {
+        client_close(s, c);
+        return;
+    }
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = c->in + c->in_len;
+    iov.iov_len = c->in_cap - c->in_len;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctl.buf;
+    msg.msg_controllen = sizeof(ctl.buf);
+    ssize_t r = recvmsg(c->fd, &msg, MSG_CMSG_CLOEXEC);
+    if (r < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) return;
+    if (r <= 0) {
+        client_close(s, c);
+        return;
+    }
+    // 附带的描述符留给随后解析到的'S'消息
+    for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != NULL; cm = CMSG_NXTHDR(&msg, cm)) {
+        int fds[3];
+        size_t nfd = (cm->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        if (cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_RIGHTS || nfd > 3) continue;
+        memcpy(fds, CMSG_DATA(cm), nfd * sizeof(int));
+        for (size_t i = 0; i < nfd; i++) {
+            if (c->nfds < 3) c->fds[c->nfds++] = fds[i];
+            else close(fds[i]);
+        }
+    }
+    c->in_len += (size_t)r;
+    if (client_parse(s, c) != 0) client_close(s, c);
+}
+
+static void server_accept(D_SERVER* s) {
+    for (;;) {
+        struct epoll_event ev;
+        struct ucred cred;
+        socklen_t cred_len = sizeof(cred);
+        int fd = accept4(s->lfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        // 其他用户可借服务端的权限读取文件，拒绝
+        if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) != 0 ||
+            (cred.uid != geteuid() && cred.uid != 0)) {
+            close(fd);
+            continue;
+        }
+        D_CLIENT* c = (D_CLIENT*)calloc(1, sizeof(D_CLIENT));
+        if (c == NULL) {
+            close(fd);
+            continue;
+        }
+        c->fd = fd;
+        c->sock_src.kind = D_EV_SOCK;
+        c->sock_src.client = c;
+        c->events = EPOLLIN;
+        ev.events = EPOLLIN;
+        ev.data.ptr = &c->sock_src;
+        if (epoll_ctl(s->ep, EPOLL_CTL_ADD, fd, &ev) != 0) client_free(c);
+    }
+}
+
+static int server_main(const char* sock_path, unsigned int deadline_us) {
+    D_SERVER* s = (D_SERVER*)calloc(1, sizeof(D_SERVER));
+    struct sockaddr_un sa;
+    struct epoll_event ev, evs[64];
+    int ret = 0;
+
+    if (s == NULL) return 1;
+    s->deadline_us = deadline_us;
+    s->waited_from = (size_t)-1;
+    s->gain = 16;
+    s->file_buf = (unsigned char*)malloc((size_t)D_BATCH_MAX * D_FILE_INLINE);
+    s->lfd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    memset(&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    snprintf(sa.sun_path, sizeof(sa.sun_path), "%s", sock_path);
+    unlink(sock_path);
+    if (s->file_buf == NULL || s->lfd < 0 || bind(s->lfd, (struct sockaddr*)&sa, sizeof(sa)) != 0 || listen(s->lfd, 128) != 0) {
+        fprintf(stderr, "错误: 无法监听 %s\n", sock_path);
+        free(s->file_buf);
+        free(s);
+        return 1;
+    }
+    s->ep = epoll_create1(EPOLL_CLOEXEC);
+    s->tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    s->listen_src.kind = D_EV_LISTEN;
+    s->timer_src.kind = D_EV_TIMER;
+    ev.events = EPOLLIN;
+    ev.data.ptr = &s->listen_src;
+    epoll_ctl(s->ep, EPOLL_CTL_ADD, s->lfd, &ev);
+    ev.data.ptr = &s->timer_src;
+    epoll_ctl(s->ep, EPOLL_CTL_ADD, s->tfd, &ev);
+    jobs_start(s);
+    fprintf(stderr, "sm3d: 监听 %s，批次时限 %u 微秒\n", sock_path, deadline_us);
+
+    while (!g_stop) {
+        // 批次非空且尚未决定等待、或共享内存环还有剩余时，只检查是否还有立即可读的输入
+        int more = rings_poll(s);
+        int timeout = (more || (s->n > 0 && s->waited_from == (size_t)-1)) ? 0 : -1;
+        int n = epoll_wait(s->ep, evs, 64, timeout);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ret = 1;
+            break;
+        }
+        if (n == 0) {
+            if (more || s->n == 0) continue;
+            // 输入已取尽：通道已满，或近期等待几乎带不来新请求时立即计算，否则等到时限
+            if (s->n >= SM3_MB_LANES || (s->gain < 16 && ++s->since_probe < D_PROBE_INTERVAL)) batch_flush(s);
+            else if (s->waited_from == (size_t)-1) s->waited_from = s->n;
+            continue;
+        }
+        for (int i = 0; i < n; i++) {
+            D_EVSRC* src = (D_EVSRC*)evs[i].data.ptr;
+            D_CLIENT* c = src->client;
+            if (src->kind == D_EV_LISTEN) server_accept(s);
+            else if (src->kind == D_EV_TIMER) {
+                uint64_t expirations;
+                if (read(s->tfd, &expirations, sizeof(expirations)) > 0) batch_flush(s);
+            }
+            else if (src->kind == D_EV_JOBS) jobs_complete(s);
+            else if (src->kind == D_EV_RING) {
+                uint64_t v;
+                if (c->closing) continue;
+                if (read(c->sq_efd, &v, sizeof(v)) < 0 && errno != EAGAIN) client_close(s, c);
+                else ring_drain(s, c);
+            }
+            else {
+                if (c->closing) continue;
+                if (evs[i].events & EPOLLOUT) client_flush_out(s, c);
+                if (c->closing) continue;
+                if (evs[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) client_read(s, c);
+            }
+        }
+        // 等待期间新到达的请求已填满通道时不必等到时限
+        if (s->n > 0 && s->waited_from != (size_t)-1 && s->n >= SM3_MB_LANES) batch_flush(s);
+        reap_clients(s);
+    }
+    batch_flush(s);
+    jobs_stop(s);
+    reap_clients(s);
+    fprintf(stderr, "sm3d: 共%llu个请求（共享内存%llu个，后台线程计算的大文件%llu个），%llu批（平均每批%.1f个），内联与共享内存数据%llu字节\n",
+        s->total_reqs, s->total_shm, s->total_offload, s->total_batches,
+        s->total_batches ? (double)s->total_reqs / (double)s->total_batches : 0.0, s->total_bytes);
+    close(s->lfd);
+    close(s->tfd);
+    close(s->ep);
+    unlink(sock_path);
+    free(s->file_buf);
+    free(s);
+    return ret;
+}
+
+// -------------------------- 客户端模式 --------------------------
+static int write_full(int fd, const void* p, size_t n) {
+    const unsigned char* b = (const unsigned char*)p;
+    while (n > 0) {
+        ssize_t w = write(fd, b, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return -1;
+        b += w;
+        n -= (size_t)w;
+    }
+    return 0;
+}
+
+static int read_full(int fd, void* p, size_t n) {
+    unsigned char* b = (unsigned char*)p;
+    while (n > 0) {
+        ssize_t r = read(fd, b, n);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return -1;
+        b += r;
+        n -= (size_t)r;
+    }
+    return 0;
+}
+
+// 读取一个响应并按请求号记录
+static int client_recv(int fd, unsigned char (*digests)[SM3_DIGEST_SIZE], unsigned char* ok, int nargs) {
+    unsigned char resp[D_RESP_SIZE];
+    if (read_full(fd, resp, sizeof(resp)) != 0 || resp[0] != 'R') return -1;
+    uint32_t id = (uint32_t)get_be(resp + 1, 4);
+    if (id < (uint32_t)nargs) {
+        ok[id] = resp[5] == 0;
+        memcpy(digests[id], resp + 6, SM3_DIGEST_SIZE);
+    }
+    return 0;
+}
+
+// 流水线发送请求（未收到响应的请求不超过D_CLIENT_WINDOW个，否则服务端待发送响应积压到上限后
+// 停止读取，而客户端仍在写入，双方互相等待），按请求号输出摘要
+static int client_main(const char* sock_path, int files, char** args, int nargs) {
+    struct sockaddr_un sa;
+    unsigned char (*digests)[SM3_DIGEST_SIZE] = (unsigned char (*)[SM3_DIGEST_SIZE])malloc((size_t)nargs * SM3_DIGEST_SIZE);
+    unsigned char* ok = (unsigned char*)calloc((size_t)nargs, 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0), ret = 0, received = 0;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    snprintf(sa.sun_path, sizeof(sa.sun_path), "%s", sock_path);
+    if (digests == NULL || ok == NULL || fd < 0 || connect(fd, (struct sockaddr*)&sa, sizeof(sa)) != 0) {
+        fprintf(stderr, "错误: 无法连接 %s\n", sock_path);
+        return 1;
+    }
+    for (int i = 0; i < nargs; i++) {
+        unsigned char hdr[9];
+        size_t len = strlen(args[i]);
+        while (i - received >= D_CLIENT_WINDOW) {
+            if (client_recv(fd, digests, ok, nargs) != 0) {
+                fprintf(stderr, "错误: 连接中断\n");
+                return 1;
+            }
+            received++;
+        }
+        hdr[0] = files ? 'F' : 'D';
+        put_be(hdr + 1, (uint64_t)i, 4);
+        if (files) {
+            if (len > 65535) len = 65535;
+            put_be(hdr + 5, len, 2);
+        }
+        else put_be(hdr + 5, len, 4);
+        if (write_full(fd, hdr, files ? 7 : 9) != 0 || write_full(fd, args[i], len) != 0) {
+            fprintf(stderr, "错误: 发送请求失败\n");
+            return 1;
+        }
+    }
+    for (; received < nargs; received++) {
+        if (client_recv(fd, digests, ok, nargs) != 0) {
+            fprintf(stderr, "错误: 连接中断\n");
+            return 1;
+        }
+    }
+    for (int i = 0; i < nargs; i++) {
+        if (ok[i]) printf("%s  %s\n", sm3_hash_to_string(digests[i]), args[i]);
+        else {
+            fprintf(stderr, "错误: 服务端无法读取 %s\n", args[i]);
+            ret = 1;
+        }
+    }
+    close(fd);
+    free(digests);
+    free(ok);
+    return ret;
+}
+
+// 记录完成项：state为0未完成，1成功，2失败（客户端读取文件失败时提交前即置为2）
+static void shm_reap(SM3_SHM_CLIENT* sc, unsigned char (*digests)[SM3_DIGEST_SIZE], unsigned char* state, int nargs, int wait) {
+    SM3_SHM_CQE cqes[64];
+    size_t got = sm3_shm_complete(sc, cqes, 64, wait);
+    for (size_t k = 0; k < got; k++) {
+        uint64_t i = cqes[k].user_data;
+        if (i >= (uint64_t)nargs || state[i] != 0) continue;
+        state[i] = cqes[k].status == 0 ? 1 : 2;
+        memcpy(digests[i], cqes[k].digest, SM3_DIGEST_SIZE);
+    }
+}
+
+// 共享内存模式：字符串或文件内容由客户端直接写入共享区后提交，摘要从完成环读取
+static int client_shm_main(const char* sock_path, int files, char** args, int nargs) {
+    SM3_SHM_CLIENT sc;
+    size_t data_size = SM3_SHM_DEFAULT_DATA;
+    unsigned char (*digests)[SM3_DIGEST_SIZE] = (unsigned char (*)[SM3_DIGEST_SIZE])malloc((size_t)nargs * SM3_DIGEST_SIZE);
+    unsigned char* state = (unsigned char*)calloc((size_t)nargs, 1);
+    int ret = 0;
+
+    // 数据区至少容纳最大的单个输入
+    for (int i = 0; i < nargs; i++) {
+        struct stat st;
+        size_t len = strlen(args[i]);
+        if (files) len = stat(args[i], &st) == 0 ? (size_t)st.st_size : 0;
+        if (len > data_size) data_size = len;
+    }
+    if (digests == NULL || state == NULL || sm3_shm_connect(&sc, sock_path, SM3_SHM_DEFAULT_ENTRIES, data_size) != 0) {
+        fprintf(stderr, "错误: 无法与 %s 建立共享内存环\n", sock_path);
+        return 1;
+    }
+    for (int i = 0; i < nargs; i++) {
+        struct stat st;
+        unsigned char* p;
+        size_t len = strlen(args[i]);
+        int fd = -1;
+        if (files) {
+            fd = open(args[i], O_RDONLY);
+            if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || (size_t)st.st_size > sc.data_size) {
+                if (fd >= 0) close(fd);
+                state[i] = 2;
+                continue;
+            }
+            len = (size_t)st.st_size;
+        }
+        // 数据区或提交环已满时先回收完成项
+        while ((p = sm3_shm_alloc(&sc, len)) == NULL) shm_reap(&sc, digests, state, nargs, 1);
+        if (files) {
+            if (read_full(fd, p, len) != 0) state[i] = 2;
+            close(fd);
+        }
+        else memcpy(p, args[i], len);
+        if (sm3_shm_submit(&sc, p, len, (uint64_t)i) != 0) {
+            fprintf(stderr, "错误: 提交请求失败\n");
+            return 1;
+        }
+    }
+    while (sm3_shm_inflight(&sc) > 0) shm_reap(&sc, digests, state, nargs, 1);
+    for (int i = 0; i < nargs; i++) {
+        if (state[i] == 1) printf("%s  %s\n", sm3_hash_to_string(digests[i]), args[i]);
+        else {
+            fprintf(stderr, "错误: 无法计算 %s\n", args[i]);
+            ret = 1;
+        }
+    }
+    sm3_shm_close(&sc);
+    free(digests);
+    free(state);
+    return ret;
+}
+#endif
+
+static void print_usage(const char* program_name) {
+    printf("SM3本地哈希服务\n");
+    printf("用法: %s [-d <微秒>] [-s <路径>]                  （服务端）\n", program_name);
+    printf("      %s -c [-s <路径>] [-M] [-F] <字符串或文件>... （客户端）\n", program_name);
+    printf("选项:\n");
+    printf("  -s <路径>     Unix域套接字路径（默认/tmp/sm3d.sock）\n");
+    printf("  -d <微秒>     批次时限：最早的请求最多等待该时间即计算（默认%u）\n", D_DEFAULT_DEADLINE_US);
+    printf("  -c            客户端模式：把参数作为请求发送并输出\"<摘要>  <参数>\"\n");
+    printf("  -F            客户端模式下参数为文件路径（由服务端读取；与-M同用时由客户端读入共享区）\n");
+    printf("  -M            客户端模式下经共享内存提交环提交\n");
+    printf("  -h            显示此帮助信息\n");
+    printf("服务端以自身权限读取客户端给出的文件，只接受同一用户（或root）的连接\n");
+    printf("服务端收到SIGINT/SIGTERM后计算完当前批次、输出统计并退出\n");
+}
+
+int main(int argc, char* argv[]) {
+#ifndef __linux__
+    (void)argc;
+    print_usage(argv[0]);
+    fprintf(stderr, "错误: 该工具依赖epoll与timerfd，仅支持Linux\n");
+    return 1;
+#else
+    const char* sock_path = "/tmp/sm3d.sock";
+    long deadline = D_DEFAULT_DEADLINE_US;
+    int client = 0, files = 0, shm = 0, first_arg = argc;
+    struct sigaction sa;
+
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "-d") == 0) && i + 1 >= argc) {
+            fprintf(stderr, "错误: %s选项需要参数\n", argv[i]);
+            return 1;
+        }
+        if (strcmp(argv[i], "-s") == 0) sock_path = argv[++i];
+        else if (strcmp(argv[i], "-d") == 0) deadline = atol(argv[++i]);
+        else if (strcmp(argv[i], "-c") == 0) client = 1;
+        else if (strcmp(argv[i], "-F") == 0) files = 1;
+        else if (strcmp(argv[i], "-M") == 0) shm = 1;
+        else if (strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else {
+            first_arg = i;
+            break;
+        }
+    }
+    signal(SIGPIPE, SIG_IGN);
+    if (client) {
+        if (first_arg >= argc) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (shm) return client_shm_main(sock_path, files, argv + first_arg, argc - first_arg);
+        return client_main(sock_path, files, argv + first_arg, argc - first_arg);
+    }
+    if (first_arg < argc || deadline <= 0 || deadline > 10000000) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    return server_main(sock_path, (unsigned int)deadline);
+#endif
+}
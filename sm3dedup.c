@@ -0,0 +1,665 @@
+// sm3dedup.c - 基于SM3摘要的外存重复记录检测工具
+// 对超大数据集逐条记录计算SM3摘要，按内存上限生成有序的摘要段文件（run），
+// 再多路归并所有段文件，流式输出摘要相同的记录组；内存占用与数据量无关
+#include "sm3.h"
+#include "sm3_mb.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#define getpid _getpid
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#define DEDUP_CHUNK_SIZE (8u << 20)        // 输入块大小上限（8MB），内存上限较小时按线程数缩小
+#define DEDUP_MIN_CHUNK (64u << 10)        // 输入块大小下限
+#define DEDUP_HASH_BATCH 4096              // 每批送入多路并行接口的记录数
+#define DEDUP_MAX_THREADS 64
+#define DEDUP_READER_BUF (1u << 20)        // 归并时每个段文件的读缓冲（1MB）
+#define DEDUP_MAX_FANIN 512                // 单次归并最多打开的段文件数
+
+// 段文件中的一条记录：摘要 + 记录序号（从1开始）
+typedef struct {
+    unsigned char digest[SM3_DIGEST_SIZE];
+    uint64_t record;
+} DEDUP_ENTRY;
+
+// 输入块（生产者-消费者队列中的槽位）
+typedef struct {
+    char* data;
+    size_t len, cap;
+    uint64_t first_record;         // 块内第一条记录的序号
+    int state;                     // 0=空闲 1=待处理 2=处理中
+} DEDUP_CHUNK;
+
+// 段文件列表
+typedef struct {
+    char** paths;
+    size_t count, cap;
+    unsigned seq;
+} DEDUP_RUNS;
+
+// 全局运行状态
+typedef struct {
+    char sep;                      // 记录分隔符
+    const char* tmpdir;
+    size_t chunk_size;             // 输入块大小
+    size_t run_entries;            // 每个线程的段缓冲容量（条）
+    size_t merge_mem;              // 归并阶段可用内存
+    DEDUP_CHUNK* slots;
+    size_t nslots;
+    int quit;
+    int error;
+    DEDUP_RUNS runs;
+    uint64_t total_records;
+#ifndef _WIN32
+    pthread_mutex_t lock;
+    pthread_cond_t work_cv;
+    pthread_cond_t free_cv;
+#endif
+} DEDUP_STATE;
+
+// 工作线程私有的段缓冲
+typedef struct {
+    DEDUP_STATE* st;
+    DEDUP_ENTRY* entries;
+    size_t count;
+} DEDUP_WORKER;
+
+static void dedup_lock(DEDUP_STATE* st) {
+#ifndef _WIN32
+    pthread_mutex_lock(&st->lock);
+#else
+    (void)st;
+#endif
+}
+
+static void dedup_unlock(DEDUP_STATE* st) {
+#ifndef _WIN32
+    pthread_mutex_unlock(&st->lock);
+#else
+    (void)st;
+#endif
+}
+
+// -------------------------- 段文件生成 --------------------------
+// 比较函数：先按摘要，再按记录序号（保证同组记录按出现顺序输出）
+static int entry_cmp(const void* a, const void* b) {
+    const DEDUP_ENTRY* x = (const DEDUP_ENTRY*)a;
+    const DEDUP_ENTRY* y = (const DEDUP_ENTRY*)b;
+    int c = memcmp(x->digest, y->digest, SM3_DIGEST_SIZE);
+    if (c != 0) return c;
+    return (x->record > y->record) - (x->record < y->record);
+}
+
+// 生成新的段文件路径并登记到列表
+static char* runs_new_path(DEDUP_STATE* st) {
+    char* path = (char*)malloc(strlen(st->tmpdir) + 64);
+    if (path == NULL) return NULL;
+    dedup_lock(st);
+    sprintf(path, "%s/sm3dedup.%d.%u.run", st->tmpdir, (int)getpid(), st->runs.seq++);
+    if (st->runs.count == st->runs.cap) {
+        size_t cap = st->runs.cap ? st->runs.cap * 2 : 64;
+        char** p = (char**)realloc(st->runs.paths, cap * sizeof(char*));
+        if (p == NULL) {
+            dedup_unlock(st);
+            free(path);
+            return NULL;
+        }
+        st->runs.paths = p;
+        st->runs.cap = cap;
+    }
+    st->runs.paths[st->runs.count++] = path;
+    dedup_unlock(st);
+    return path;
+}
+
+// 排序段缓冲并写出为一个段文件
+static int worker_flush(DEDUP_WORKER* w) {
+    if (w->count == 0) return 0;
+    qsort(w->entries, w->count, sizeof(DEDUP_ENTRY), entry_cmp);
+
+    char* path = runs_new_path(w->st);
+    if (path == NULL) return -1;
+    FILE* f = fopen(path, "wb");
+    if (f == NULL) {
+        fprintf(stderr, "错误: 无法创建段文件 %s\n", path);
+        return -1;
+    }
+    size_t wrote = fwrite(w->entries, sizeof(DEDUP_ENTRY), w->count, f);
+    if (fclose(f) != 0 || wrote != w->count) {
+        fprintf(stderr, "错误: 写入段文件 %s 失败\n", path);
+        return -1;
+    }
+    w->count = 0;
+    return 0;
+}
+
+// 处理一个输入块：切分记录，批量计算摘要并放入段缓冲
+static int worker_process(DEDUP_WORKER* w, const DEDUP_CHUNK* ch) {
+    const unsigned char* data[DEDUP_HASH_BATCH];
+    size_t lens[DEDUP_HASH_BATCH];
+    unsigned char digests[DEDUP_HASH_BATCH][SM3_DIGEST_SIZE];
+    uint64_t record = ch->first_record;
+    const char* p = ch->data;
+    const char* end = ch->data + ch->len;
+    char sep = w->st->sep;
+
+    while (p < end) {
+        size_t n = 0;
+        // 段缓冲剩余空间不足一批时先写出
+        if (w->st->run_entries - w->count < DEDUP_HASH_BATCH && worker_flush(w) != 0) return -1;
+        while (n < DEDUP_HASH_BATCH && p < end) {
+            const char* q = (const char*)memchr(p, sep, (size_t)(end - p));
+            if (q == NULL) q = end;
+            data[n] = (const unsigned char*)p;
+            lens[n] = (size_t)(q - p);
+            n++;
+            p = (q < end) ? q + 1 : end;
+        }
+        sm3_mb_hash(data, lens, n, digests);
+        for (size_t i = 0; i < n; i++) {
+            DEDUP_ENTRY* e = &w->entries[w->count++];
+            memcpy(e->digest, digests[i], SM3_DIGEST_SIZE);
+            e->record = record++;
+        }
+    }
+    return 0;
+}
+
+// 工作线程主循环
+static void worker_loop(DEDUP_WORKER* w) {
+    DEDUP_STATE* st = w->st;
+    dedup_lock(st);
+    for (;;) {
+        DEDUP_CHUNK* pick = NULL;
+        for (size_t i = 0; i < st->nslots && pick == NULL; i++) {
+            if (st->slots[i].state == 1) pick = &st->slots[i];
+        }
+        if (pick == NULL) {
+            if (st->quit) break;
+#ifndef _WIN32
+            pthread_cond_wait(&st->work_cv, &st->lock);
+            continue;
+#else
+            break;
+#endif
+        }
+        pick->state = 2;
+        dedup_unlock(st);
+        int r = worker_process(w, pick);
+        dedup_lock(st);
+        if (r != 0) st->error = 1;
+        pick->state = 0;
+#ifndef _WIN32
+        pthread_cond_broadcast(&st->free_cv);
+#endif
+    }
+    dedup_unlock(st);
+}
+
+#ifndef _WIN32
+static void* worker_thread(void* arg) {
+    DEDUP_WORKER* w = (DEDUP_WORKER*)arg;
+    worker_loop(w);
+    if (worker_flush(w) != 0) {
+        dedup_lock(w->st);
+        w->st->error = 1;
+        dedup_unlock(w->st);
+    }
+    return NULL;
+}
+#endif
+
+// 统计块内记录数（末尾不带分隔符的残余记录也计入）
+static uint64_t count_records(const char* p, size_t len, char sep) {
+    uint64_t n = 0;
+    const char* end = p + len;
+    while (p < end) {
+        const char* q = (const char*)memchr(p, sep, (size_t)(end - p));
+        n++;
+        if (q == NULL) break;
+        p = q + 1;
+    }
+    return n;
+}
+
+// 跨块遗留的不完整记录
+typedef struct {
+    char* data;
+    size_t len, cap;
+} DEDUP_CARRY;
+
+// 调整缓冲区容量，遗留缓冲始终不小于输入块，保证能容纳块尾的残余记录
+static int chunk_resize(DEDUP_CHUNK* ch, DEDUP_CARRY* carry, size_t cap) {
+    char* p = (char*)realloc(ch->data, cap);
+    if (p == NULL) return -1;
+    ch->data = p;
+    ch->cap = cap;
+    if (carry->cap < cap) {
+        char* c = (char*)realloc(carry->data, cap);
+        if (c == NULL) return -1;
+        carry->data = c;
+        carry->cap = cap;
+    }
+    return 0;
+}
+
+// 读取下一个输入块，块尾对齐到记录分隔符；返回1表示读到数据，0表示结束，-1表示失败
+static int read_chunk(DEDUP_CHUNK* ch, FILE* in, DEDUP_CARRY* carry, int* eof, char sep, size_t chunk_size) {
+    size_t len = carry->len;
+    if (ch->cap < chunk_size || ch->cap < len * 2) {
+        size_t cap = chunk_size;
+        while (cap < len * 2) cap *= 2;
+        if (chunk_resize(ch, carry, cap) != 0) return -1;
+    }
+    memcpy(ch->data, carry->data, len);
+    carry->len = 0;
+
+    for (;;) {
+        if (!*eof) {
+            len += fread(ch->data + len, 1, ch->cap - len, in);
+            if (len < ch->cap) *eof = 1;
+        }
+        if (*eof) break;
+        // 从块尾向前找到最后一个分隔符
+        size_t cut = len;
+        while (cut > 0 && ch->data[cut - 1] != sep) cut--;
+        if (cut > 0) {
+            memcpy(carry->data, ch->data + cut, len - cut);
+            carry->len = len - cut;
+            len = cut;
+            break;
+        }
+        // 单条记录超过块大小时扩大缓冲区
+        if (chunk_resize(ch, carry, ch->cap * 2) != 0) return -1;
+    }
+    ch->len = len;
+    return len > 0 ? 1 : 0;
+}
+
+// 阶段一：并行读取、哈希并生成有序段文件
+static int generate_runs(DEDUP_STATE* st, FILE* in, int threads) {
+    DEDUP_WORKER workers[DEDUP_MAX_THREADS];
+    DEDUP_CARRY carry = { NULL, 0, 0 };
+    uint64_t next_record = 1;
+    int eof = 0, ret = 0;
+#ifndef _WIN32
+    pthread_t tids[DEDUP_MAX_THREADS];
+#else
+    threads = 1;
+#endif
+
+    st->nslots = (size_t)threads * 2;
+    st->slots = (DEDUP_CHUNK*)calloc(st->nslots, sizeof(DEDUP_CHUNK));
+    if (st->slots == NULL) return -1;
+    for (int t = 0; t < threads; t++) {
+        workers[t].st = st;
+        workers[t].count = 0;
+        workers[t].entries = (DEDUP_ENTRY*)malloc(st->run_entries * sizeof(DEDUP_ENTRY));
+        if (workers[t].entries == NULL) {
+            fprintf(stderr, "错误: 无法分配段缓冲（请减小 -m 或 -t）\n");
+            while (t-- > 0) free(workers[t].entries);
+            free(st->slots);
+            return -1;
+        }
+    }
+
+#ifndef _WIN32
+    pthread_mutex_init(&st->lock, NULL);
+    pthread_cond_init(&st->work_cv, NULL);
+    pthread_cond_init(&st->free_cv, NULL);
+    for (int t = 0; t < threads; t++) pthread_create(&tids[t], NULL, worker_thread, &workers[t]);
+#endif
+
+    for (;;) {
+        DEDUP_CHUNK* slot = NULL;
+        dedup_lock(st);
+        for (;;) {
+            for (size_t i = 0; i < st->nslots && slot == NULL; i++) {
+                if (st->slots[i].state == 0) slot = &st->slots[i];
+            }
+            if (slot != NULL || st->error) break;
+#ifndef _WIN32
+            pthread_cond_wait(&st->free_cv, &st->lock);
+#endif
+        }
+        dedup_unlock(st);
+        if (st->error) {
+            ret = -1;
+            break;
+        }
+
+        int r = read_chunk(slot, in, &carry, &eof, st->sep, st->chunk_size);
+        if (r < 0) {
+            fprintf(stderr, "错误: 内存不足\n");
+            ret = -1;
+        }
+        if (r <= 0) break;
+
+        slot->first_record = next_record;
+        next_record += count_records(slot->data, slot->len, st->sep);
+
+        dedup_lock(st);
+        slot->state = 1;
+#ifndef _WIN32
+        pthread_cond_signal(&st->work_cv);
+#endif
+        dedup_unlock(st);
+#ifdef _WIN32
+        worker_loop(&workers[0]);
+#endif
+        if (eof && carry.len == 0) break;
+    }
+
+    dedup_lock(st);
+    st->quit = 1;
+#ifndef _WIN32
+    pthread_cond_broadcast(&st->work_cv);
+#endif
+    dedup_unlock(st);
+#ifndef _WIN32
+    for (int t = 0; t < threads; t++) pthread_join(tids[t], NULL);
+    pthread_mutex_destroy(&st->lock);
+    pthread_cond_destroy(&st->work_cv);
+    pthread_cond_destroy(&st->free_cv);
+#else
+    if (worker_flush(&workers[0]) != 0) st->error = 1;
+#endif
+    if (st->error) ret = -1;
+
+    st->total_records = next_record - 1;
+    for (int t = 0; t < threads; t++) free(workers[t].entries);
+    for (size_t i = 0; i < st->nslots; i++) free(st->slots[i].data);
+    free(st->slots);
+    free(carry.data);
+    return ret;
+}
+
+// -------------------------- 多路归并 --------------------------
+// 段文件顺序读取器
+typedef struct {
+    FILE* f;
+    DEDUP_ENTRY* buf;
+    size_t n, pos, cap;
+} RUN_READER;
+
+// 取当前记录，缓冲耗尽时批量读取；返回0表示该段已读完
+static int reader_fill(RUN_READER* r) {
+    if (r->pos < r->n) return 1;
+    r->n = fread(r->buf, sizeof(DEDUP_ENTRY), r->cap, r->f);
+    r->pos = 0;
+    return r->n > 0;
+}
+
+// 归并输出接收者：写入新段文件，或直接进行重复分组
+typedef int (*ENTRY_SINK)(void* arg, const DEDUP_ENTRY* e);
+
+// 最小堆下沉（按各读取器的当前记录排序）
+static void heap_down(RUN_READER** heap, size_t n, size_t i) {
+    for (;;) {
+        size_t l = 2 * i + 1, r = l + 1, m = i;
+        if (l < n && entry_cmp(&heap[l]->buf[heap[l]->pos], &heap[m]->buf[heap[m]->pos]) < 0) m = l;
+        if (r < n && entry_cmp(&heap[r]->buf[heap[r]->pos], &heap[m]->buf[heap[m]->pos]) < 0) m = r;
+        if (m == i) return;
+        RUN_READER* t = heap[i];
+        heap[i] = heap[m];
+        heap[m] = t;
+        i = m;
+    }
+}
+
+// k路归并一组段文件，结果依次交给sink
+static int merge_runs(char** paths, size_t k, size_t mem, ENTRY_SINK sink, void* arg) {
+    RUN_READER* readers = (RUN_READER*)calloc(k, sizeof(RUN_READER));
+    RUN_READER** heap = (RUN_READER**)malloc(k * sizeof(RUN_READER*));
+    size_t cap = mem / (k * sizeof(DEDUP_ENTRY));
+    size_t hn = 0;
+    int ret = 0;
+
+    if (cap < 256) cap = 256;
+    if (readers == NULL || heap == NULL) ret = -1;
+    for (size_t i = 0; i < k && ret == 0; i++) {
+        readers[i].f = fopen(paths[i], "rb");
+        readers[i].buf = (DEDUP_ENTRY*)malloc(cap * sizeof(DEDUP_ENTRY));
+        readers[i].cap = cap;
+        if (readers[i].f == NULL || readers[i].buf == NULL) {
+            fprintf(stderr, "错误: 无法读取段文件 %s\n", paths[i]);
+            ret = -1;
+        }
+        else if (reader_fill(&readers[i])) {
+            heap[hn++] = &readers[i];
+        }
+    }
+
+    if (ret == 0) {
+        for (size_t i = hn; i-- > 0;) heap_down(heap, hn, i);
+        while (hn > 0) {
+            RUN_READER* top = heap[0];
+            if (sink(arg, &top->buf[top->pos]) != 0) {
+                ret = -1;
+                break;
+            }
+            top->pos++;
+            if (!reader_fill(top)) heap[0] = heap[--hn];
+            heap_down(heap, hn, 0);
+        }
+    }
+
+    for (size_t i = 0; readers != NULL && i < k; i++) {
+        if (readers[i].f) fclose(readers[i].f);
+        free(readers[i].buf);
+    }
+    free(readers);
+    free(heap);
+    return ret;
+}
+
+// 中间归并的接收者：带缓冲写入新段文件
+typedef struct {
+    FILE* f;
+    DEDUP_ENTRY* buf;
+    size_t n, cap;
+} RUN_WRITER;
+
+static int writer_sink(void* arg, const DEDUP_ENTRY* e) {
+    RUN_WRITER* w = (RUN_WRITER*)arg;
+    w->buf[w->n++] = *e;
+    if (w->n == w->cap) {
+        if (fwrite(w->buf, sizeof(DEDUP_ENTRY), w->n, w->f) != w->n) return -1;
+        w->n = 0;
+    }
+    return 0;
+}
+
+// 段文件数超过单次归并上限时，分组归并为更少的段文件，直到可一次完成
+static int reduce_runs(DEDUP_STATE* st, size_t fanin) {
+    while (st->runs.count > fanin) {
+        size_t old_count = st->runs.count;
+        char** old = st->runs.paths;
+        st->runs.paths = NULL;
+        st->runs.count = st->runs.cap = 0;
+
+        for (size_t base = 0; base < old_count; base += fanin) {
+            size_t k = (old_count - base < fanin) ? old_count - base : fanin;
+            char* path = runs_new_path(st);
+            RUN_WRITER w;
+            w.cap = DEDUP_READER_BUF / sizeof(DEDUP_ENTRY);
+            w.n = 0;
+            w.buf = (DEDUP_ENTRY*)malloc(w.cap * sizeof(DEDUP_ENTRY));
+            w.f = path ? fopen(path, "wb") : NULL;
+            int r = (w.f == NULL || w.buf == NULL) ? -1 : merge_runs(old + base, k, st->merge_mem, writer_sink, &w);
+            if (r == 0 && w.n > 0 && fwrite(w.buf, sizeof(DEDUP_ENTRY), w.n, w.f) != w.n) r = -1;
+            if (w.f != NULL && fclose(w.f) != 0) r = -1;
+            free(w.buf);
+            for (size_t i = base; i < base + k; i++) {
+                remove(old[i]);
+                free(old[i]);
+                old[i] = NULL;
+            }
+            if (r != 0) {
+                fprintf(stderr, "错误: 中间归并失败\n");
+                for (size_t i = base + k; i < old_count; i++) {
+                    remove(old[i]);
+                    free(old[i]);
+                }
+                free(old);
+                return -1;
+            }
+        }
+        free(old);
+    }
+    return 0;
+}
+
+// 最终归并的接收者：相邻摘要相同即为一组重复记录，流式输出
+typedef struct {
+    FILE* out;
+    DEDUP_ENTRY prev;
+    int have_prev;
+    int in_group;
+    uint64_t groups;
+    uint64_t dup_records;
+} GROUP_SINK;
+
+static int group_sink(void* arg, const DEDUP_ENTRY* e) {
+    GROUP_SINK* g = (GROUP_SINK*)arg;
+    if (g->have_prev && memcmp(g->prev.digest, e->digest, SM3_DIGEST_SIZE) == 0) {
+        if (!g->in_group) {
+            fprintf(g->out, "%s\t%llu", sm3_hash_to_string(e->digest), (unsigned long long)g->prev.record);
+            g->in_group = 1;
+            g->groups++;
+            g->dup_records++;
+        }
+        fprintf(g->out, ",%llu", (unsigned long long)e->record);
+        g->dup_records++;
+        return 0;
+    }
+    if (g->in_group) fputc('\n', g->out);
+    g->in_group = 0;
+    g->prev = *e;
+    g->have_prev = 1;
+    return ferror(g->out) ? -1 : 0;
+}
+
+// -------------------------- 主程序 --------------------------
+static void print_usage(const char* program_name) {
+    printf("SM3外存重复记录检测工具\n");
+    printf("用法: %s [选项] [输入文件]\n", program_name);
+    printf("选项:\n");
+    printf("  -m <MB>       内存上限（含输入块、段缓冲与归并读缓冲），默认1024MB\n");
+    printf("  -t <线程数>   段文件生成线程数，默认为在线CPU数\n");
+    printf("  -T <目录>     临时段文件目录，默认为TMPDIR或/tmp\n");
+    printf("  -0            记录以NUL分隔（默认以换行分隔）\n");
+    printf("  -h            显示此帮助信息\n");
+    printf("输出: 每组重复记录一行，格式为\"<SM3摘要>\\t<记录序号列表>\"，序号从1开始\n");
+    printf("\n示例:\n");
+    printf("  %s -m 4096 -T /data/tmp records.txt > dups.txt\n", program_name);
+}
+
+int main(int argc, char* argv[]) {
+    DEDUP_STATE st;
+    const char* in_path = NULL;
+    size_t mem_mb = 1024;
+    int threads;
+    int ret = 0;
+
+    memset(&st, 0, sizeof(st));
+    st.sep = '\n';
+    st.tmpdir = getenv("TMPDIR");
+    if (st.tmpdir == NULL || st.tmpdir[0] == '\0') st.tmpdir = "/tmp";
+#ifdef _WIN32
+    threads = 1;
+#else
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = (ncpu < 1) ? 1 : (ncpu > DEDUP_MAX_THREADS ? DEDUP_MAX_THREADS : (int)ncpu);
+#endif
+
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        if ((strcmp(a, "-m") == 0 || strcmp(a, "-t") == 0 || strcmp(a, "-T") == 0) && i + 1 >= argc) {
+            fprintf(stderr, "错误: %s选项需要参数\n", a);
+            return 1;
+        }
+        if (strcmp(a, "-m") == 0) mem_mb = (size_t)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(a, "-t") == 0) {
+            threads = atoi(argv[++i]);
+            if (threads < 1) threads = 1;
+            if (threads > DEDUP_MAX_THREADS) threads = DEDUP_MAX_THREADS;
+        }
+        else if (strcmp(a, "-T") == 0) st.tmpdir = argv[++i];
+        else if (strcmp(a, "-0") == 0) st.sep = '\0';
+        else if (strcmp(a, "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else if (in_path == NULL) in_path = a;
+        else {
+            fprintf(stderr, "错误: 多余的参数 %s\n", a);
+            return 1;
+        }
+    }
+
+    // 内存分配：每线程两个输入块与各自的段缓冲，另有一个与输入块等大的遗留缓冲（保存块尾的残余记录）
+    // 输入块合计不超过内存上限的一半，线程多或上限小时缩小输入块；上限连最小输入块与段缓冲都容纳不下时减少线程数
+    // 单条记录超过输入块一半时缓冲区随之扩大，此时实际占用可能超出上限
+    size_t mem = mem_mb << 20;
+    size_t min_run = (size_t)DEDUP_HASH_BATCH * 4 * sizeof(DEDUP_ENTRY);
+    size_t run_mem;
+    int want_threads = threads;
+    for (;;) {
+        size_t nchunks = (size_t)threads * 2 + 1;
+        st.chunk_size = mem / 2 / nchunks;
+        if (st.chunk_size > DEDUP_CHUNK_SIZE) st.chunk_size = DEDUP_CHUNK_SIZE;
+        if (st.chunk_size < DEDUP_MIN_CHUNK) st.chunk_size = DEDUP_MIN_CHUNK;
+        run_mem = mem > nchunks * st.chunk_size ? mem - nchunks * st.chunk_size : 0;
+        if (threads == 1 || run_mem / (size_t)threads >= min_run) break;
+        threads--;
+    }
+    if (threads < want_threads) fprintf(stderr, "提示: 内存上限%zuMB不足以支撑%d个线程，改用%d个\n", mem_mb, want_threads, threads);
+    st.run_entries = run_mem / threads / sizeof(DEDUP_ENTRY);
+    if (st.run_entries < DEDUP_HASH_BATCH * 4) st.run_entries = DEDUP_HASH_BATCH * 4;
+    st.merge_mem = mem;
+
+    FILE* in = in_path ? fopen(in_path, "rb") : stdin;
+    if (in == NULL) {
+        fprintf(stderr, "错误: 无法打开输入文件 %s\n", in_path);
+        return 1;
+    }
+
+    if (generate_runs(&st, in, threads) != 0) ret = -1;
+    if (in != stdin) fclose(in);
+
+    // 按内存上限确定单次归并的段文件数
+    size_t fanin = st.merge_mem / DEDUP_READER_BUF;
+    if (fanin < 2) fanin = 2;
+    if (fanin > DEDUP_MAX_FANIN) fanin = DEDUP_MAX_FANIN;
+    size_t initial_runs = st.runs.count;
+    if (ret == 0) ret = reduce_runs(&st, fanin);
+
+    GROUP_SINK g;
+    memset(&g, 0, sizeof(g));
+    g.out = stdout;
+    if (ret == 0 && st.runs.count > 0) {
+        ret = merge_runs(st.runs.paths, st.runs.count, st.merge_mem, group_sink, &g);
+        if (g.in_group) fputc('\n', g.out);
+    }
+    if (fflush(stdout) != 0) ret = -1;
+
+    for (size_t i = 0; i < st.runs.count; i++) {
+        remove(st.runs.paths[i]);
+        free(st.runs.paths[i]);
+    }
+    free(st.runs.paths);
+
+    fprintf(stderr, "记录总数: %llu，段文件数: %zu，重复组数: %llu，重复记录数: %llu\n",
+        (unsigned long long)st.total_records, initial_runs,
+        (unsigned long long)g.groups, (unsigned long long)g.dup_records);
+    return ret == 0 ? 0 : 1;
+}
@@ -0,0 +1,422 @@
+// sm3dist.c - 多进程分布式树哈希
+// 协调进程把文件按"2^k个叶子"对齐切分为区间任务，经Unix域套接字分发给工作进程；
+// 工作进程计算区间子树根并返回，协调进程按sm3_tree规则合并出每个文件的树根
+// 工作进程可以由协调进程本地派生（-w），也可以在其他位置以 -W 模式启动后连接同一套接字；
+// 协议只传输路径、区间与摘要，换成TCP等流式连接后可直接用于多节点部署
+#include "sm3.h"
+#include "sm3_tree.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// 协议（整数均为大端序）：
+//   工作进程 -> 协调进程  'H' 版本(1)                             连接后的问候
+//   协调进程 -> 工作进程  'T' 任务号(8) 偏移(8) 长度(8) 叶子大小(4) 路径长度(2) 路径
+//   工作进程 -> 协调进程  'R' 任务号(8) 状态(1，0为成功) 子树根(32)
+//   协调进程 -> 工作进程  'Q'                                       结束
+#define DIST_VERSION 1
+#define DIST_RESULT_SIZE (1 + 8 + 1 + SM3_DIGEST_SIZE)
+#define DIST_MAX_INFLIGHT 2                    // 每个工作进程的在途任务数（计算与传输重叠）
+#define DIST_MAX_WORKERS 256
+#define DIST_TASKS_PER_WORKER 4                // 目标任务数 = 工作进程数 × 该值
+#define DIST_MAX_TASK_BYTES (256ull << 20)     // 单个任务的最大字节数
+
+typedef struct {
+    const char* path;             // 输出用的原始路径
+    char* abs_path;               // 发给工作进程的绝对路径（外部工作进程的工作目录可能不同）
+    uint64_t size;
+    uint64_t task_bytes;          // 每个任务覆盖的字节数（叶子大小×2^k）
+    size_t first_task, ntasks;
+    size_t remaining;
+    int failed;
+    unsigned char (*roots)[SM3_DIGEST_SIZE];
+} DIST_FILE;
+
+typedef struct {
+    size_t file;
+    uint64_t offset, length;
+} DIST_TASK;
+
+typedef struct {
+    int fd;
+    int ready;                    // 已收到问候
+    size_t inflight[DIST_MAX_INFLIGHT];
+    int ninflight;
+} DIST_WORKER;
+
+// -------------------------- 通用I/O --------------------------
+static int write_full(int fd, const void* p, size_t n) {
+    const unsigned char* b = (const unsigned char*)p;
+    while (n > 0) {
+        ssize_t w = write(fd, b, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return -1;
+        b += w;
+        n -= (size_t)w;
+    }
+    return 0;
+}
+
+static int read_full(int fd, void* p, size_t n) {
+    unsigned char* b = (unsigned char*)p;
+    while (n > 0) {
+        ssize_t r = read(fd, b, n);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return -1;
+        b += r;
+        n -= (size_t)r;
+    }
+    return 0;
+}
+
+static void put_be(unsigned char* p, uint64_t v, int bytes) {
+    for (int i = bytes - 1; i >= 0; i--) {
+        p[i] = (unsigned char)v;
+        v >>= 8;
+    }
+}
+
+static uint64_t get_be(const unsigned char* p, int bytes) {
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; i++) v = (v << 8) | p[i];
+    return v;
+}
+
+// -------------------------- 工作进程 --------------------------
+static int worker_main(const char* sock_path) {
+    struct sockaddr_un sa;
+    unsigned char hdr[1 + 8 + 8 + 8 + 4 + 2];
+    unsigned char res[DIST_RESULT_SIZE];
+    char path[65536];
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    snprintf(sa.sun_path, sizeof(sa.sun_path), "%s", sock_path);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&sa, sizeof(sa)) != 0) {
+        fprintf(stderr, "错误: 工作进程无法连接 %s\n", sock_path);
+        return 1;
+    }
+    unsigned char hello[2] = { 'H', DIST_VERSION };
+    if (write_full(fd, hello, sizeof(hello)) != 0) return 1;
+
+    for (;;) {
+        if (read_full(fd, hdr, 1) != 0 || hdr[0] == 'Q') break;
+        if (hdr[0] != 'T' || read_full(fd, hdr + 1, sizeof(hdr) - 1) != 0) break;
+        uint64_t id = get_be(hdr + 1, 8);
+        uint64_t offset = get_be(hdr + 9, 8);
+        uint64_t length = get_be(hdr + 17, 8);
+        size_t leaf = (size_t)get_be(hdr + 25, 4);
+        size_t plen = (size_t)get_be(hdr + 29, 2);
+        if (read_full(fd, path, plen) != 0) break;
+        path[plen] = '\0';
+
+        res[0] = 'R';
+        put_be(res + 1, id, 8);
+        res[9] = sm3_tree_file_hash(path, offset, length, leaf, res + 10) == 0 ? 0 : 1;
+        if (write_full(fd, res, sizeof(res)) != 0) break;
+    }
+    close(fd);
+    return 0;
+}
+
+// -------------------------- 协调进程 --------------------------
+// 为文件确定任务粒度：任务数接近 工作进程数×DIST_TASKS_PER_WORKER，且每个任务为2^k个叶子
+static uint64_t choose_task_bytes(uint64_t size, size_t leaf, int nworkers) {
+    uint64_t leaves = sm3_tree_leaf_count(size, leaf);
+    uint64_t per = 1;
+    uint64_t target = (uint64_t)(nworkers > 0 ? nworkers : 1) * DIST_TASKS_PER_WORKER;
+    while ((leaves + per - 1) / per > target && per * 2 * leaf <= DIST_MAX_TASK_BYTES) per *= 2;
+    return per * leaf;
+}
+
+static int send_task(DIST_WORKER* w, const DIST_TASK* t, size_t id, const DIST_FILE* files, size_t leaf) {
+    unsigned char hdr[1 + 8 + 8 + 8 + 4 + 2];
+    const char* path = files[t->file].abs_path;
+    size_t plen = strlen(path);
+    hdr[0] = 'T';
+    put_be(hdr + 1, id, 8);
+    put_be(hdr + 9, t->offset, 8);
+    put_be(hdr + 17, t->length, 8);
+    put_be(hdr + 25, leaf, 4);
+    put_be(hdr + 29, plen, 2);
+    if (write_full(w->fd, hdr, sizeof(hdr)) != 0 || write_full(w->fd, path, plen) != 0) return -1;
+    w->inflight[w->ninflight++] = id;
+    return 0;
+}
+
+// 任务队列（环形，失效工作进程的在途任务重新入队）
+typedef struct {
+    size_t* items;
+    size_t cap, head, count;
+} TASK_QUEUE;
+
+static void queue_push(TASK_QUEUE* q, size_t id) {
+    q->items[(q->head + q->count) % q->cap] = id;
+    q->count++;
+}
+
+static size_t queue_pop(TASK_QUEUE* q) {
+    size_t id = q->items[q->head];
+    q->head = (q->head + 1) % q->cap;
+    q->count--;
+    return id;
+}
+
+static void drop_worker(DIST_WORKER* w, TASK_QUEUE* q) {
+    for (int i = 0; i < w->ninflight; i++) queue_push(q, w->inflight[i]);
+    w->ninflight = 0;
+    close(w->fd);
+    w->fd = -1;
+}
+
+static int coordinator_main(const char* sock_path, int nlocal, size_t leaf, char** paths, size_t nfiles) {
+    DIST_FILE* files = (DIST_FILE*)calloc(nfiles, sizeof(DIST_FILE));
+    DIST_WORKER workers[DIST_MAX_WORKERS];
+    DIST_TASK* tasks = NULL;
+    TASK_QUEUE q;
+    pid_t pids[DIST_MAX_WORKERS];
+    size_t ntasks = 0, next_print = 0;
+    int nworkers = 0, ret = 0;
+    struct sockaddr_un sa;
+
+    if (files == NULL) return 1;
+    memset(&q, 0, sizeof(q));
+
+    // 切分任务
+    for (size_t i = 0; i < nfiles; i++) {
+        struct stat sb;
+        files[i].path = paths[i];
+        files[i].abs_path = realpath(paths[i], NULL);
+        if (files[i].abs_path == NULL || stat(paths[i], &sb) != 0 || !S_ISREG(sb.st_mode) ||
+            strlen(files[i].abs_path) > 65535) {
+            fprintf(stderr, "错误: 无法读取普通文件 %s\n", paths[i]);
+            return 1;
+        }
+        files[i].size = (uint64_t)sb.st_size;
+        files[i].task_bytes = choose_task_bytes(files[i].size, leaf, nlocal);
+        files[i].first_task = ntasks;
+        files[i].ntasks = files[i].size == 0 ? 1 : (size_t)((files[i].size + files[i].task_bytes - 1) / files[i].task_bytes);
+        files[i].remaining = files[i].ntasks;
+        files[i].roots = (unsigned char (*)[SM3_DIGEST_SIZE])malloc(files[i].ntasks * SM3_DIGEST_SIZE);
+        if (files[i].roots == NULL) return 1;
+        ntasks += files[i].ntasks;
+    }
+    tasks = (DIST_TASK*)malloc(ntasks * sizeof(DIST_TASK));
+    q.items = (size_t*)malloc(ntasks * sizeof(size_t));
+    q.cap = ntasks;
+    if (tasks == NULL || q.items == NULL) return 1;
+    for (size_t i = 0; i < nfiles; i++) {
+        for (size_t t = 0; t < files[i].ntasks; t++) {
+            DIST_TASK* task = &tasks[files[i].first_task + t];
+            task->file = i;
+            task->offset = t * files[i].task_bytes;
+            task->length = files[i].size - task->offset < files[i].task_bytes ? files[i].size - task->offset : files[i].task_bytes;
+            queue_push(&q, files[i].first_task + t);
+        }
+    }
+
+    // 监听并派生本地工作进程
+    int lfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    memset(&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    snprintf(sa.sun_path, sizeof(sa.sun_path), "%s", sock_path);
+    unlink(sock_path);
+    if (lfd < 0 || bind(lfd, (struct sockaddr*)&sa, sizeof(sa)) != 0 || listen(lfd, DIST_MAX_WORKERS) != 0) {
+        fprintf(stderr, "错误: 无法监听 %s\n", sock_path);
+        return 1;
+    }
+    fflush(NULL);
+    for (int i = 0; i < nlocal; i++) {
+        pids[i] = fork();
+        if (pids[i] == 0) {
+            close(lfd);
+            _exit(worker_main(sock_path));
+        }
+    }
+    if (nlocal == 0) fprintf(stderr, "等待工作进程连接 %s ...\n", sock_path);
+
+    size_t done_files = 0;
+    int had_worker = 0, nexited = 0;
+    while (done_files < nfiles) {
+        struct pollfd pfd[DIST_MAX_WORKERS + 1];
+        int idx[DIST_MAX_WORKERS + 1];
+        int np = 0, alive = 0;
+
+        pfd[np].fd = lfd;
+        pfd[np].events = POLLIN;
+        idx[np++] = -1;
+        for (int i = 0; i < nworkers; i++) {
+            if (workers[i].fd < 0) continue;
+            alive++;
+            // 补足在途任务
+            while (workers[i].ready && workers[i].ninflight < DIST_MAX_INFLIGHT && q.count > 0) {
+                size_t id = queue_pop(&q);
+                if (send_task(&workers[i], &tasks[id], id, files, leaf) != 0) {
+                    queue_push(&q, id);
+                    drop_worker(&workers[i], &q);
+                    break;
+                }
+            }
+            if (workers[i].fd < 0) continue;
+            pfd[np].fd = workers[i].fd;
+            pfd[np].events = POLLIN;
+            idx[np++] = i;
+        }
+        while (nlocal > 0 && waitpid(-1, NULL, WNOHANG) > 0) nexited++;
+        if (alive == 0 && nlocal > 0 && (had_worker || nexited == nlocal)) {
+            fprintf(stderr, "错误: 全部工作进程已退出，任务未完成\n");
+            ret = 1;
+            break;
+        }
+
+        if (poll(pfd, (nfds_t)np, nlocal > 0 ? 1000 : -1) < 0) {
+            if (errno == EINTR) continue;
+            ret = 1;
+            break;
+        }
+        if (pfd[0].revents & POLLIN) {
+            int cfd = accept(lfd, NULL, NULL);
+            if (cfd >= 0 && nworkers < DIST_MAX_WORKERS) {
+                memset(&workers[nworkers], 0, sizeof(DIST_WORKER));
+                workers[nworkers++].fd = cfd;
+                had_worker = 1;
+            }
+            else if (cfd >= 0) close(cfd);
+        }
+        for (int p = 1; p < np; p++) {
+            DIST_WORKER* w = &workers[idx[p]];
+            unsigned char res[DIST_RESULT_SIZE];
+            if (!(pfd[p].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            if (!w->ready) {
+                unsigned char hello[2];
+                if (read_full(w->fd, hello, 2) != 0 || hello[0] != 'H' || hello[1] != DIST_VERSION) drop_worker(w, &q);
+                else w->ready = 1;
+                continue;
+            }
+            if (read_full(w->fd, res, sizeof(res)) != 0 || res[0] != 'R') {
+                drop_worker(w, &q);
+                continue;
+            }
+            size_t id = (size_t)get_be(res + 1, 8);
+            int found = -1;
+            for (int i = 0; i < w->ninflight; i++) {
+                if (w->inflight[i] == id) found = i;
+            }
+            if (found < 0) {
+                drop_worker(w, &q);
+                continue;
+            }
+            w->inflight[found] = w->inflight[--w->ninflight];
+
+            DIST_FILE* f = &files[tasks[id].file];
+            if (res[9] != 0) f->failed = 1;
+            memcpy(f->roots[id - f->first_task], res + 10, SM3_DIGEST_SIZE);
+            if (--f->remaining == 0) done_files++;
+        }
+
+        // 按命令行顺序输出已完成的文件
+        while (next_print < nfiles && files[next_print].remaining == 0) {
+            DIST_FILE* f = &files[next_print++];
+            unsigned char root[SM3_DIGEST_SIZE];
+            if (f->failed) {
+                fprintf(stderr, "错误: 工作进程无法读取 %s\n", f->path);
+                ret = 1;
+                continue;
+            }
+            sm3_tree_root((const unsigned char (*)[SM3_DIGEST_SIZE])f->roots, f->ntasks, root);
+            printf("%s  %s\n", sm3_hash_to_string(root), f->path);
+        }
+    }
+    fflush(stdout);
+
+    for (int i = 0; i < nworkers; i++) {
+        if (workers[i].fd >= 0) {
+            write_full(workers[i].fd, "Q", 1);
+            close(workers[i].fd);
+        }
+    }
+    for (int i = 0; i < nlocal; i++) waitpid(pids[i], NULL, 0);     // 已回收的进程返回ECHILD
+    close(lfd);
+    unlink(sock_path);
+    for (size_t i = 0; i < nfiles; i++) {
+        free(files[i].roots);
+        free(files[i].abs_path);
+    }
+    free(files);
+    free(tasks);
+    free(q.items);
+    return ret;
+}
+#endif
+
+static void print_usage(const char* program_name) {
+    printf("SM3多进程树哈希工具\n");
+    printf("用法: %s [选项] <文件>...\n", program_name);
+    printf("      %s -W <套接字路径>          （以工作进程模式连接协调进程）\n", program_name);
+    printf("选项:\n");
+    printf("  -w <数量>     本地派生的工作进程数（默认CPU核数，0表示只等待外部工作进程）\n");
+    printf("  -l <KB>       叶子大小（默认%u）\n", SM3_TREE_LEAF_DEFAULT >> 10);
+    printf("  -s <路径>     监听的Unix域套接字路径（默认/tmp/sm3dist.<pid>.sock）\n");
+    printf("  -h            显示此帮助信息\n");
+    printf("输出为每个文件的树根（见sm3_tree.h），格式\"<摘要>  <文件>\"\n");
+}
+
+int main(int argc, char* argv[]) {
+#ifdef _WIN32
+    (void)argc;
+    print_usage(argv[0]);
+    fprintf(stderr, "错误: 该工具依赖Unix域套接字与fork，Windows下不可用\n");
+    return 1;
+#else
+    char default_sock[108];
+    const char* sock_path = NULL;
+    const char* worker_sock = NULL;
+    long nlocal = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t leaf = SM3_TREE_LEAF_DEFAULT;
+    int first_file = argc;
+
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-w") == 0 || strcmp(argv[i], "-l") == 0 || strcmp(argv[i], "-s") == 0 ||
+            strcmp(argv[i], "-W") == 0) && i + 1 >= argc) {
+            fprintf(stderr, "错误: %s选项需要参数\n", argv[i]);
+            return 1;
+        }
+        if (strcmp(argv[i], "-w") == 0) nlocal = atol(argv[++i]);
+        else if (strcmp(argv[i], "-l") == 0) leaf = (size_t)atol(argv[++i]) << 10;
+        else if (strcmp(argv[i], "-s") == 0) sock_path = argv[++i];
+        else if (strcmp(argv[i], "-W") == 0) worker_sock = argv[++i];
+        else if (strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else {
+            first_file = i;
+            break;
+        }
+    }
+    signal(SIGPIPE, SIG_IGN);
+    if (worker_sock != NULL) return worker_main(worker_sock);
+
+    if (first_file >= argc || leaf == 0 || leaf > 0xffffffffu || nlocal < 0 || nlocal > DIST_MAX_WORKERS) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (sock_path == NULL) {
+        snprintf(default_sock, sizeof(default_sock), "/tmp/sm3dist.%ld.sock", (long)getpid());
+        sock_path = default_sock;
+    }
+    return coordinator_main(sock_path, (int)nlocal, leaf, argv + first_file, (size_t)(argc - first_file));
+#endif
+}
@@ -0,0 +1,467 @@
+// sm3tar.c - tar流逐成员计算SM3摘要
+// 单遍顺序读取tar文件或标准输入，解析头部（ustar/GNU长文件名/pax扩展头），
+// 边读边计算每个普通文件成员的摘要并输出清单，不向磁盘解包任何内容
+// 整块落在读缓冲内的小成员先登记，缓冲回收前经多路并行接口批量计算；跨缓冲的大成员流式计算
+#include "sm3.h"
+#include "sm3_mb.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define TAR_BLOCK 512
+#define TAR_READ_BUF (4u << 20)            // 读缓冲（4MB，512字节的整数倍）
+#define TAR_MAX_META (16u << 20)           // 长文件名/pax扩展头的最大长度
+
+// 待批量计算的小成员
+typedef struct {
+    const unsigned char* data;
+    size_t len;
+    size_t name_off;                       // 名称在名称缓冲中的偏移
+} TAR_PENDING;
+
+// 清单中的一项（校验模式使用）
+typedef struct {
+    char* path;
+    unsigned char digest[SM3_DIGEST_SIZE];
+    int seen;
+} MANIFEST_ITEM;
+
+// 运行状态
+typedef struct {
+    FILE* in;
+    FILE* out;
+    unsigned char* buf;
+    size_t len, pos;
+    int eof;
+    // 小成员批量队列
+    TAR_PENDING* pending;
+    size_t npending, pending_cap;
+    char* names;
+    size_t names_len, names_cap;
+    // 校验模式
+    MANIFEST_ITEM* manifest;
+    size_t nmanifest;
+    uint64_t members, bytes, mismatches;
+} TAR_STATE;
+
+// -------------------------- 输出与校验 --------------------------
+static int manifest_cmp(const void* a, const void* b) {
+    return strcmp(((const MANIFEST_ITEM*)a)->path, ((const MANIFEST_ITEM*)b)->path);
+}
+
+// 输出一个成员的结果：清单模式打印摘要，校验模式与清单比对
+static void emit(TAR_STATE* st, const char* path, const unsigned char digest[SM3_DIGEST_SIZE]) {
+    st->members++;
+    if (st->manifest == NULL) {
+        fprintf(st->out, "%s  %s\n", sm3_hash_to_string(digest), path);
+        return;
+    }
+    MANIFEST_ITEM key;
+    key.path = (char*)path;
+    MANIFEST_ITEM* it = (MANIFEST_ITEM*)bsearch(&key, st->manifest, st->nmanifest, sizeof(MANIFEST_ITEM), manifest_cmp);
+    if (it == NULL) {
+        fprintf(st->out, "%s: 不在清单中\n", path);
+        st->mismatches++;
+    }
+    else if (memcmp(it->digest, digest, SM3_DIGEST_SIZE) != 0) {
+        fprintf(st->out, "%s: 失败\n", path);
+        st->mismatches++;
+        it->seen = 1;
+    }
+    else {
+        fprintf(st->out, "%s: 通过\n", path);
+        it->seen = 1;
+    }
+}
+
+// 批量计算已登记的小成员，并按登记顺序输出
+static void flush_pending(TAR_STATE* st) {
+    size_t n = st->npending;
+    if (n == 0) return;
+    const unsigned char** data = (const unsigned char**)malloc(n * sizeof(*data));
+    size_t* lens = (size_t*)malloc(n * sizeof(size_t));
+    unsigned char (*digests)[SM3_DIGEST_SIZE] = (unsigned char (*)[SM3_DIGEST_SIZE])malloc(n * SM3_DIGEST_SIZE);
+
+    if (data != NULL && lens != NULL && digests != NULL) {
+        for (size_t i = 0; i < n; i++) {
+            data[i] = st->pending[i].data;
+            lens[i] = st->pending[i].len;
+        }
+        sm3_mb_hash(data, lens, n, digests);
+    }
+    else if (digests != NULL) {
+        for (size_t i = 0; i < n; i++) sm3_hash(st->pending[i].data, st->pending[i].len, digests[i]);
+    }
+    for (size_t i = 0; digests != NULL && i < n; i++) emit(st, st->names + st->pending[i].name_off, digests[i]);
+    if (digests == NULL) fprintf(stderr, "错误: 内存不足，%zu个成员未计算\n", n);
+
+    free(data);
+    free(lens);
+    free(digests);
+    st->npending = 0;
+    st->names_len = 0;
+}
+
+// 登记一个完全位于读缓冲内的小成员
+static int add_pending(TAR_STATE* st, const unsigned char* data, size_t len, const char* name) {
+    size_t nlen = strlen(name) + 1;
+    if (st->npending == st->pending_cap) {
+        size_t cap = st->pending_cap ? st->pending_cap * 2 : 256;
+        TAR_PENDING* p = (TAR_PENDING*)realloc(st->pending, cap * sizeof(TAR_PENDING));
+        if (p == NULL) return -1;
+        st->pending = p;
+        st->pending_cap = cap;
+    }
+    if (st->names_len + nlen > st->names_cap) {
+        size_t cap = st->names_cap ? st->names_cap : 4096;
+        while (cap < st->names_len + nlen) cap *= 2;
+        char* p = (char*)realloc(st->names, cap);
+        if (p == NULL) return -1;
+        st->names = p;
+        st->names_cap = cap;
+    }
+    memcpy(st->names + st->names_len, name, nlen);
+    st->pending[st->npending].data = data;
+    st->pending[st->npending].len = len;
+    st->pending[st->npending].name_off = st->names_len;
+    st->npending++;
+    st->names_len += nlen;
+    return 0;
+}
+
+// -------------------------- 顺序读取 --------------------------
+// 保证缓冲中至少有一个512字节块可用；缓冲回收前先完成批量计算。返回0表示输入结束
+static int ensure_block(TAR_STATE* st) {
+    if (st->len - st->pos >= TAR_BLOCK) return 1;
+    if (st->eof) return 0;
+    flush_pending(st);
+    size_t rest = st->len - st->pos;
+    memmove(st->buf, st->buf + st->pos, rest);
+    st->len = rest + fread(st->buf + rest, 1, TAR_READ_BUF - rest, st->in);
+    st->pos = 0;
+    if (st->len < TAR_READ_BUF) st->eof = 1;
+    return st->len >= TAR_BLOCK;
+}
+
+// 顺序读取size字节成员内容（含512字节对齐填充）；ctx非空时计算摘要，out非空时复制内容
+static int consume(TAR_STATE* st, uint64_t size, SM3_CTX* ctx, unsigned char* out) {
+    uint64_t padded = (size + TAR_BLOCK - 1) / TAR_BLOCK * TAR_BLOCK;
+    uint64_t done = 0;
+    while (done < padded) {
+        if (!ensure_block(st)) return -1;
+        size_t avail = (st->len - st->pos) / TAR_BLOCK * TAR_BLOCK;
+        if (avail > padded - done) avail = (size_t)(padded - done);
+        if (done < size) {
+            size_t useful = (size - done < avail) ? (size_t)(size - done) : avail;
+            if (ctx) sm3_update(ctx, st->buf + st->pos, useful);
+            if (out) memcpy(out + done, st->buf + st->pos, useful);
+        }
+        st->pos += avail;
+        done += avail;
+    }
+    return 0;
+}
+
+// -------------------------- 头部解析 --------------------------
+// 解析数值字段：八进制文本，或GNU扩展的base-256二进制（首字节最高位为1）
+static uint64_t parse_number(const unsigned char* p, size_t n) {
+    uint64_t v = 0;
+    if (p[0] & 0x80) {
+        v = p[0] & 0x7f;
+        for (size_t i = 1; i < n; i++) v = (v << 8) | p[i];
+        return v;
+    }
+    size_t i = 0;
+    while (i < n && (p[i] == ' ' || p[i] == '\0')) i++;
+    for (; i < n && p[i] >= '0' && p[i] <= '7'; i++) v = v * 8 + (uint64_t)(p[i] - '0');
+    return v;
+}
+
+// 校验头部校验和（校验和字段按8个空格计算）
+static int header_ok(const unsigned char* h) {
+    uint64_t want = parse_number(h + 148, 8);
+    uint64_t sum = 0;
+    for (int i = 0; i < TAR_BLOCK; i++) sum += (i >= 148 && i < 156) ? ' ' : h[i];
+    return sum == want;
+}
+
+static int is_zero_block(const unsigned char* h) {
+    for (int i = 0; i < TAR_BLOCK; i++) {
+        if (h[i]) return 0;
+    }
+    return 1;
+}
+
+// 解析pax扩展头中的path与size记录（格式："<长度> <键>=<值>\n"）
+static void parse_pax(const char* p, size_t n, char** path, uint64_t* size, int* has_size) {
+    size_t i = 0;
+    while (i < n) {
+        char* end;
+        unsigned long rec = strtoul(p + i, &end, 10);
+        if (end == p + i || *end != ' ' || rec == 0 || i + rec > n) return;
+        const char* kv = end + 1;
+        const char* rec_end = p + i + rec - 1;           // 指向记录末尾的换行
+        const char* eq = (const char*)memchr(kv, '=', (size_t)(rec_end - kv));
+        if (eq != NULL) {
+            size_t klen = (size_t)(eq - kv), vlen = (size_t)(rec_end - eq - 1);
+            if (klen == 4 && memcmp(kv, "path", 4) == 0) {
+                char* s = (char*)malloc(vlen + 1);
+                if (s != NULL) {
+                    memcpy(s, eq + 1, vlen);
+                    s[vlen] = '\0';
+                    free(*path);
+                    *path = s;
+                }
+            }
+            else if (klen == 4 && memcmp(kv, "size", 4) == 0) {
+                *size = strtoull(eq + 1, NULL, 10);
+                *has_size = 1;
+            }
+        }
+        i += rec;
+    }
+}
+
+// 读取长文件名或pax扩展头的内容
+static char* read_meta(TAR_STATE* st, uint64_t size) {
+    if (size > TAR_MAX_META) return NULL;
+    char* p = (char*)malloc((size_t)size + 1);
+    if (p == NULL) return NULL;
+    if (consume(st, size, NULL, (unsigned char*)p) != 0) {
+        free(p);
+        return NULL;
+    }
+    p[size] = '\0';
+    return p;
+}
+
+// 主循环：逐个解析成员
+static int process_tar(TAR_STATE* st) {
+    char* long_name = NULL;     // GNU 'L' 或 pax path 覆盖的名称
+    uint64_t pax_size = 0;
+    int has_pax_size = 0;
+    int ret = 0;
+
+    while (ensure_block(st)) {
+        const unsigned char* h = st->buf + st->pos;
+        if (is_zero_block(h)) break;                     // 归档结束标志
+        if (!header_ok(h)) {
+            fprintf(stderr, "错误: 头部校验和错误（第%llu个成员附近），不是tar流或数据损坏\n",
+                (unsigned long long)st->members + 1);
+            ret = -1;
+            break;
+        }
+        char type = (char)h[156];
+        uint64_t size = has_pax_size ? pax_size : parse_number(h + 124, 12);
+        char name[256 + 155 + 2];
+
+        if (long_name != NULL) {
+            name[0] = '\0';
+        }
+        else if (memcmp(h + 257, "ustar", 5) == 0 && h[345] != '\0') {
+            snprintf(name, sizeof(name), "%.155s/%.100s", (const char*)h + 345, (const char*)h);
+        }
+        else {
+            snprintf(name, sizeof(name), "%.100s", (const char*)h);
+        }
+        st->pos += TAR_BLOCK;
+
+        if (type == 'L' || type == 'x') {
+            // GNU长文件名或pax扩展头：作用于下一个成员
+            char* meta = read_meta(st, parse_number(h + 124, 12));
+            if (meta == NULL) {
+                fprintf(stderr, "错误: 扩展头过长或数据截断\n");
+                ret = -1;
+                break;
+            }
+            if (type == 'L') {
+                free(long_name);
+                long_name = meta;
+            }
+            else {
+                parse_pax(meta, strlen(meta), &long_name, &pax_size, &has_pax_size);
+                free(meta);
+            }
+            continue;
+        }
+        if (type == 'g' || type == 'K') {
+            if (consume(st, parse_number(h + 124, 12), NULL, NULL) != 0) {
+                ret = -1;
+                break;
+            }
+            continue;
+        }
+
+        const char* path = long_name ? long_name : name;
+        if (type == '0' || type == '\0' || type == '7') {
+            // 普通文件：完全位于缓冲内时登记批量计算，否则流式计算
+            uint64_t padded = (size + TAR_BLOCK - 1) / TAR_BLOCK * TAR_BLOCK;
+            if (padded <= st->len - st->pos) {
+                if (add_pending(st, st->buf + st->pos, (size_t)size, path) != 0) {
+                    ret = -1;
+                    break;
+                }
+                st->pos += (size_t)padded;
+            }
+            else {
+                SM3_CTX ctx;
+                unsigned char digest[SM3_DIGEST_SIZE];
+                flush_pending(st);                      // 保持清单顺序与归档一致
+                sm3_init(&ctx);
+                if (consume(st, size, &ctx, NULL) != 0) {
+                    fprintf(stderr, "错误: 成员 %s 数据截断\n", path);
+                    ret = -1;
+                    break;
+                }
+                sm3_final(&ctx, digest);
+                emit(st, path, digest);
+            }
+            st->bytes += size;
+        }
+        else if (type == 'S') {
+            fprintf(stderr, "警告: 稀疏文件 %s 未计算摘要\n", path);
+            if (consume(st, size, NULL, NULL) != 0) {
+                ret = -1;
+                break;
+            }
+        }
+        else if (type != '1' && type != '2' && type != '3' && type != '4' && type != '5' && type != '6') {
+            // 未知类型按普通数据跳过
+            if (consume(st, size, NULL, NULL) != 0) {
+                ret = -1;
+                break;
+            }
+        }
+
+        free(long_name);
+        long_name = NULL;
+        has_pax_size = 0;
+    }
+
+    flush_pending(st);
+    free(long_name);
+    return ret;
+}
+
+// -------------------------- 清单加载 --------------------------
+// 读取"<64位十六进制摘要>  <路径>"格式的清单
+static int load_manifest(TAR_STATE* st, const char* path) {
+    FILE* f = fopen(path, "r");
+    char line[4096 + 80];
+    size_t cap = 0;
+    if (f == NULL) return -1;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        size_t n = strlen(line);
+        while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r')) line[--n] = '\0';
+        if (n < 67 || line[64] != ' ' || line[65] != ' ') continue;
+        if (st->nmanifest == cap) {
+            cap = cap ? cap * 2 : 256;
+            MANIFEST_ITEM* m = (MANIFEST_ITEM*)realloc(st->manifest, cap * sizeof(MANIFEST_ITEM));
+            if (m == NULL) {
+                fclose(f);
+                return -1;
+            }
+            st->manifest = m;
+        }
+        MANIFEST_ITEM* it = &st->manifest[st->nmanifest];
+        int ok = 1;
+        for (int i = 0; i < SM3_DIGEST_SIZE && ok; i++) {
+            unsigned v;
+            ok = sscanf(line + 2 * i, "%2x", &v) == 1;
+            it->digest[i] = (unsigned char)v;
+        }
+        if (!ok) continue;
+        it->path = (char*)malloc(n - 66 + 1);
+        if (it->path == NULL) {
+            fclose(f);
+            return -1;
+        }
+        memcpy(it->path, line + 66, n - 66 + 1);
+        it->seen = 0;
+        st->nmanifest++;
+    }
+    fclose(f);
+    qsort(st->manifest, st->nmanifest, sizeof(MANIFEST_ITEM), manifest_cmp);
+    return 0;
+}
+
+static void print_usage(const char* program_name) {
+    printf("SM3 tar流逐成员摘要工具\n");
+    printf("用法: %s [选项] [tar文件|-]\n", program_name);
+    printf("选项:\n");
+    printf("  -o <文件>     清单输出文件（默认标准输出）\n");
+    printf("  -c <清单>     按清单校验归档中的每个成员\n");
+    printf("  -h            显示此帮助信息\n");
+    printf("清单格式与sha256sum一致：\"<摘要>  <路径>\"，仅包含普通文件\n");
+    printf("\n示例:\n");
+    printf("  %s release.tar > release.sm3\n", program_name);
+    printf("  zcat release.tar.gz | %s -c release.sm3 -\n", program_name);
+}
+
+int main(int argc, char* argv[]) {
+    TAR_STATE st;
+    const char* in_path = NULL;
+    const char* out_path = NULL;
+    const char* check_path = NULL;
+    int ret;
+
+    memset(&st, 0, sizeof(st));
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "-c") == 0) && i + 1 >= argc) {
+            fprintf(stderr, "错误: %s选项需要参数\n", argv[i]);
+            return 1;
+        }
+        if (strcmp(argv[i], "-o") == 0) out_path = argv[++i];
+        else if (strcmp(argv[i], "-c") == 0) check_path = argv[++i];
+        else if (strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else if (in_path == NULL) in_path = argv[i];
+        else {
+            fprintf(stderr, "错误: 多余的参数 %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (check_path != NULL && load_manifest(&st, check_path) != 0) {
+        fprintf(stderr, "错误: 无法读取清单 %s\n", check_path);
+        return 1;
+    }
+    st.in = (in_path == NULL || strcmp(in_path, "-") == 0) ? stdin : fopen(in_path, "rb");
+    st.out = out_path ? fopen(out_path, "w") : stdout;
+    st.buf = (unsigned char*)malloc(TAR_READ_BUF);
+    if (st.in == NULL || st.out == NULL || st.buf == NULL) {
+        fprintf(stderr, "错误: 无法打开输入/输出文件\n");
+        return 1;
+    }
+    // 直接以大块读入自有缓冲，不经stdio的二次缓冲
+    setvbuf(st.in, NULL, _IONBF, 0);
+
+    ret = process_tar(&st);
+
+    if (st.manifest != NULL) {
+        for (size_t i = 0; i < st.nmanifest; i++) {
+            if (!st.manifest[i].seen) {
+                fprintf(st.out, "%s: 归档中缺失\n", st.manifest[i].path);
+                st.mismatches++;
+            }
+            free(st.manifest[i].path);
+        }
+        free(st.manifest);
+        fprintf(stderr, "校验完成：成员%llu个，不一致%llu个\n", (unsigned long long)st.members,
+            (unsigned long long)st.mismatches);
+    }
+    else {
+        fprintf(stderr, "成员: %llu，内容字节数: %llu\n", (unsigned long long)st.members,
+            (unsigned long long)st.bytes);
+    }
+
+    if (st.in != stdin) fclose(st.in);
+    if (st.out != stdout && fclose(st.out) != 0) ret = -1;
+    free(st.buf);
+    free(st.pending);
+    free(st.names);
+    return (ret == 0 && st.mismatches == 0) ? 0 : 1;
+}
@@ -0,0 +1,180 @@
+// sm3tee.c - 管道数据透传并计算SM3摘要
+// 标准输入原样送到标准输出（或文件），同时输出流的摘要，用于shell管道中途校验
+// Linux下标准输入为管道时：tee(2)在内核中复制一份管道数据，透传数据由tee/splice直接送往输出，
+// 不经过用户态；只有用于计算摘要的那一份读入大缓冲。其他情况退化为读缓冲+写出
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+#include "sm3.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define TEE_BUF (1u << 20)          // 摘要计算缓冲大小，同时作为管道扩容目标
+
+// 通用路径：读入缓冲后计算摘要并写出
+static int tee_copy(FILE* in, FILE* out, SM3_CTX* ctx, unsigned char* buf, unsigned long long* total) {
+    size_t n;
+    while ((n = fread(buf, 1, TEE_BUF, in)) > 0) {
+        sm3_update(ctx, buf, n);
+        if (fwrite(buf, 1, n, out) != n) return -1;
+        *total += n;
+    }
+    if (ferror(in) || fflush(out) != 0) return -1;
+    return 0;
+}
+
+#ifdef __linux__
+// 从管道读取恰好n字节并吸收进摘要（这些数据已由tee确认在管道中）
+static int absorb(int fd, SM3_CTX* ctx, unsigned char* buf, size_t n) {
+    while (n > 0) {
+        ssize_t r = read(fd, buf, n < TEE_BUF ? n : TEE_BUF);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return -1;
+        sm3_update(ctx, buf, (size_t)r);
+        n -= (size_t)r;
+    }
+    return 0;
+}
+
+// 零拷贝路径：返回1表示标准输入不是管道、需退化为通用路径
+// 输出为管道时直接tee到输出；否则tee到内部管道，再把标准输入splice到输出文件，
+// 最后从内部管道读出摘要副本
+static int tee_splice(int out_fd, SM3_CTX* ctx, unsigned char* buf, unsigned long long* total) {
+    struct stat in_st, out_st;
+    int side[2] = { -1, -1 };
+    int ret = 0;
+
+    if (fstat(STDIN_FILENO, &in_st) != 0 || !S_ISFIFO(in_st.st_mode)) return 1;
+    if (fstat(out_fd, &out_st) != 0) return 1;
+    int out_is_pipe = S_ISFIFO(out_st.st_mode);
+    // splice不支持以O_APPEND打开的输出（如shell的>>重定向），返回EINVAL
+    int fl = fcntl(out_fd, F_GETFL);
+    if (!out_is_pipe && (fl < 0 || (fl & O_APPEND))) return 1;
+
+    // 扩大管道容量，减少系统调用次数（失败不影响正确性）
+    fcntl(STDIN_FILENO, F_SETPIPE_SZ, (int)TEE_BUF);
+    if (out_is_pipe) fcntl(out_fd, F_SETPIPE_SZ, (int)TEE_BUF);
+    else {
+        if (pipe(side) != 0) return 1;
+        fcntl(side[1], F_SETPIPE_SZ, (int)TEE_BUF);
+    }
+
+    for (;;) {
+        ssize_t n = tee(STDIN_FILENO, out_is_pipe ? out_fd : side[1], TEE_BUF, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            // 首次调用即不支持时（如输出不支持splice）退化为通用路径
+            ret = (*total == 0 && (errno == EINVAL || errno == ENOSYS)) ? 1 : -1;
+            break;
+        }
+        if (n == 0) break;
+
+        if (out_is_pipe) {
+            // 透传副本已进入输出管道，从标准输入读出的数据只用于摘要
+            if (absorb(STDIN_FILENO, ctx, buf, (size_t)n) != 0) {
+                ret = -1;
+                break;
+            }
+        }
+        else {
+            // 原始数据splice到输出文件，内部管道中的副本用于摘要
+            size_t left = (size_t)n;
+            while (left > 0) {
+                ssize_t s = splice(STDIN_FILENO, NULL, out_fd, NULL, left, SPLICE_F_MORE);
+                if (s < 0 && errno == EINTR) continue;
+                if (s <= 0) {
+                    // 输出不支持splice且尚未消耗标准输入时退化为通用路径（tee的副本只在内部管道中，随之丢弃）
+                    ret = (s < 0 && *total == 0 && left == (size_t)n && (errno == EINVAL || errno == ENOSYS)) ? 1 : -1;
+                    break;
+                }
+                left -= (size_t)s;
+            }
+            if (ret != 0) break;
+            if (absorb(side[0], ctx, buf, (size_t)n) != 0) {
+                ret = -1;
+                break;
+            }
+        }
+        *total += (unsigned long long)n;
+    }
+
+    if (side[0] >= 0) close(side[0]);
+    if (side[1] >= 0) close(side[1]);
+    return ret;
+}
+#endif
+
+static void print_usage(const char* program_name) {
+    printf("SM3管道透传摘要工具\n");
+    printf("用法: 命令1 | %s [选项] | 命令2\n", program_name);
+    printf("选项:\n");
+    printf("  -o <文件>     透传数据写入文件（默认标准输出）\n");
+    printf("  -d <文件>     摘要写入文件（默认标准错误，格式\"<摘要>  -\"）\n");
+    printf("  -h            显示此帮助信息\n");
+    printf("\n示例:\n");
+    printf("  tar cf - data | %s -d data.tar.sm3 | zstd > data.tar.zst\n", program_name);
+    printf("  curl -s $URL | %s -o image.iso\n", program_name);
+}
+
+int main(int argc, char* argv[]) {
+    const char* out_path = NULL;
+    const char* digest_path = NULL;
+    unsigned char digest[SM3_DIGEST_SIZE];
+    unsigned long long total = 0;
+    SM3_CTX ctx;
+    int ret = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "-d") == 0) && i + 1 >= argc) {
+            fprintf(stderr, "错误: %s选项需要参数\n", argv[i]);
+            return 1;
+        }
+        if (strcmp(argv[i], "-o") == 0) out_path = argv[++i];
+        else if (strcmp(argv[i], "-d") == 0) digest_path = argv[++i];
+        else if (strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else {
+            fprintf(stderr, "错误: 未知参数 %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    FILE* out = out_path ? fopen(out_path, "wb") : stdout;
+    unsigned char* buf = (unsigned char*)malloc(TEE_BUF);
+    if (out == NULL || buf == NULL) {
+        fprintf(stderr, "错误: 无法打开输出文件\n");
+        return 1;
+    }
+
+    sm3_init(&ctx);
+#ifdef __linux__
+    ret = tee_splice(fileno(out), &ctx, buf, &total);
+#endif
+    if (ret == 1) ret = tee_copy(stdin, out, &ctx, buf, &total);
+    if (out != stdout && fclose(out) != 0) ret = -1;
+    free(buf);
+    if (ret != 0) {
+        fprintf(stderr, "错误: 透传中断（已处理%llu字节），未输出摘要\n", total);
+        return 1;
+    }
+
+    sm3_final(&ctx, digest);
+    FILE* df = digest_path ? fopen(digest_path, "w") : stderr;
+    if (df == NULL) {
+        fprintf(stderr, "错误: 无法写入摘要文件 %s\n", digest_path);
+        return 1;
+    }
+    fprintf(df, "%s  %s\n", sm3_hash_to_string(digest), out_path ? out_path : "-");
+    if (df != stderr && fclose(df) != 0) return 1;
+    return 0;
+}